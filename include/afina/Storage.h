@@ -1,10 +1,89 @@
 #ifndef AFINA_STORAGE_H
 #define AFINA_STORAGE_H
 
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace Afina {
 
+/**
+ * Read-only handle of the stored value. Handle holds a reference to the memory value lives in, so
+ * bytes stay valid and unchanged as long as handle exists, even if the association gets overwritten
+ * or removed from the storage meanwhile.
+ *
+ * Handle could be moved but not copied, the reference is released on destruction. It could be done
+ * from any thread without holding any storage lock
+ */
+class Value {
+public:
+    // Drops the reference to the owner of value memory
+    typedef void (*Release)(void *owner);
+
+    Value() : _owner(nullptr), _release(nullptr), _data(nullptr), _size(0) {}
+
+    // Takes reference to the owner, which will be released by the given function
+    Value(void *owner, Release release, const char *data, std::size_t size)
+        : _owner(owner), _release(release), _data(data), _size(size) {}
+
+    // Handle of value not living in any storage, string is owned by the handle
+    explicit Value(std::string &&value) : _owner(new std::string(std::move(value))), _release(&release_string) {
+        const std::string *owned = static_cast<const std::string *>(_owner);
+        _data = owned->data();
+        _size = owned->size();
+    }
+
+    Value(Value &&other) noexcept
+        : _owner(other._owner), _release(other._release), _data(other._data), _size(other._size) {
+        other._owner = nullptr;
+        other._data = nullptr;
+        other._size = 0;
+    }
+
+    Value &operator=(Value &&other) noexcept {
+        if (this != &other) {
+            Reset();
+            std::swap(_owner, other._owner);
+            std::swap(_release, other._release);
+            std::swap(_data, other._data);
+            std::swap(_size, other._size);
+        }
+        return *this;
+    }
+
+    ~Value() { Reset(); }
+
+    const char *data() const { return _data; }
+    std::size_t size() const { return _size; }
+
+    // Checks if handle refers to any value, empty one doesn't
+    explicit operator bool() const { return _owner != nullptr; }
+
+    // Releases the reference, handle becomes empty
+    void Reset() {
+        if (_owner != nullptr) {
+            _release(_owner);
+        }
+        _owner = nullptr;
+        _data = nullptr;
+        _size = 0;
+    }
+
+private:
+    Value(const Value &) = delete;
+    Value &operator=(const Value &) = delete;
+
+    static void release_string(void *owner) { delete static_cast<std::string *>(owner); }
+
+    void *_owner;
+    Release _release;
+    const char *_data;
+    std::size_t _size;
+};
+
 /**
  *
  */
@@ -84,6 +163,288 @@ public:
      * @param value output parameter to copy value to
      */
     virtual bool Get(const std::string &key, std::string &value) = 0;
+
+    /**
+     * Same as Get, but instead of copying value returns handle referencing it, see Value. Handle stays
+     * valid whatever happens to the association later
+     *
+     * By default value is copied once into memory owned by the handle, implementations that could
+     * share stored bytes override this
+     *
+     * @param key to retrive value for
+     * @param value output parameter to put handle to
+     */
+    virtual bool GetValue(const std::string &key, Value &value) {
+        std::string copy;
+        if (!Get(key, copy)) {
+            return false;
+        }
+        value = Value(std::move(copy));
+        return true;
+    }
+
+    /**
+     * Retrives values for several keys at once. Implementations resolve the whole batch under a single
+     * lock acquisition and overlap memory accesses of different keys, which is much faster than calling
+     * GetValue for every key
+     *
+     * By default GetValue is called for every key
+     *
+     * @param keys to retrive values for
+     * @param values output parameter, resized to the number of keys. Handle of the i-th key is left
+     * empty if there is no association for it
+     * @return number of keys found
+     */
+    virtual std::size_t MultiGet(const std::vector<std::string> &keys, std::vector<Value> &values) {
+        values.clear();
+        values.resize(keys.size());
+        std::size_t found = 0;
+        for (std::size_t i = 0; i < keys.size(); i++) {
+            found += GetValue(keys[i], values[i]);
+        }
+        return found;
+    }
+
+    /**
+     * Same as Put, PutIfAbsent and Set, but association expires at the given time. Expired association
+     * is not visible to any method, as if it was deleted
+     *
+     * By default expiration time is ignored, implementations that support expiration override these
+     *
+     * @param key to be associated with value
+     * @param value to be assigned for the key
+     * @param exptime time in seconds since epoch, 0 means association never expires
+     */
+    virtual bool PutExpiring(const std::string &key, const std::string &value, uint32_t exptime) {
+        return Put(key, value);
+    }
+    virtual bool PutIfAbsentExpiring(const std::string &key, const std::string &value, uint32_t exptime) {
+        return PutIfAbsent(key, value);
+    }
+    virtual bool SetExpiring(const std::string &key, const std::string &value, uint32_t exptime) {
+        return Set(key, value);
+    }
+
+    /**
+     * Updates expiration time of the existing association without changing its value
+     * If requested key doesn't present in storage method returns false
+     *
+     * @param key to be updated
+     * @param exptime new expiration time, see PutExpiring
+     */
+    virtual bool Touch(const std::string &key, uint32_t exptime) {
+        std::string value;
+        return Get(key, value);
+    }
+
+    /**
+     * Same as Get, but also updates expiration time of the association as Touch does
+     *
+     * @param key to retrive value for
+     * @param value output parameter to copy value to
+     * @param exptime new expiration time, see PutExpiring
+     */
+    virtual bool GetAndTouch(const std::string &key, std::string &value, uint32_t exptime) { return Get(key, value); }
+
+    /**
+     * Receives current value of the association passed to Update along with its version, see GetCas,
+     * and puts the value to replace it with to new_value. Expiration time is the current one on call
+     * and could be changed. Returns false to leave association as is
+     */
+    typedef std::function<bool(const char *value, std::size_t size, uint64_t cas, std::string &new_value,
+                               uint32_t &exptime)>
+        Updater;
+
+    /**
+     * Replaces value of the existing association by the one updater makes of it. Key is looked up once
+     * and nobody could change association between the call of updater and the update, so conditional
+     * changes don't need to read value first and write it later. Updater could be called more than once
+     * by storages that read without locks, so it must not have any other side effects than its output
+     * parameters and state that is reset by every call
+     *
+     * By default value is read and stored back by SetExpiring, which is NOT atomic. Thread safe
+     * implementations must override this. Storage interface doesn't tell expiration time of the key,
+     * so by default updater gets 0 and the key never expires after update unless updater sets the
+     * time. Implementations supporting expiration override this to pass the current time
+     *
+     * @param key to be updated
+     * @param updater to make new value of the current one
+     * @return true if association has been updated, false if there is no such key, updater declined
+     * to change it or new value couldn't be stored
+     */
+    virtual bool Update(const std::string &key, const Updater &updater) {
+        std::string current;
+        if (!Get(key, current)) {
+            return false;
+        }
+        std::string value;
+        uint32_t exptime = 0;
+        if (!updater(current.data(), current.size(), value_cas(current.data(), current.size()), value, exptime)) {
+            return false;
+        }
+        return SetExpiring(key, value, exptime);
+    }
+
+    /**
+     * Same as GetValue, but also returns unique number of the association version. It changes every
+     * time value of the key is changed, so that client could update key by CompareAndSwap only if
+     * nobody has changed it since it was read
+     *
+     * By default version is derived from value bytes, implementations that keep versions in items
+     * override this
+     *
+     * @param key to retrive value for
+     * @param value output parameter to put handle to
+     * @param cas output parameter to put version to
+     */
+    virtual bool GetCas(const std::string &key, Value &value, uint64_t &cas) {
+        if (!GetValue(key, value)) {
+            return false;
+        }
+        cas = value_cas(value.data(), value.size());
+        return true;
+    }
+
+    /**
+     * Result of CompareAndSwap, named after memcached responses
+     */
+    enum class CasResult {
+        // Value is replaced
+        kStored,
+        // Version matches, but value couldn't be stored, such as too large one
+        kNotStored,
+        // Association has been changed since version was read
+        kExists,
+        // There is no association for the key
+        kNotFound
+    };
+
+    /**
+     * Replaces value of the existing association only if its version is still the given one, see
+     * GetCas. Check and update are atomic, implementations do both in a single key lookup
+     *
+     * By default it is done by Update, storages keeping versions in items override this
+     *
+     * @param key to be updated
+     * @param value to be assigned for the key
+     * @param cas version returned by GetCas
+     * @param exptime new expiration time, see PutExpiring
+     */
+    virtual CasResult CompareAndSwap(const std::string &key, const std::string &value, uint64_t cas,
+                                     uint32_t exptime) {
+        // Updater isn't called if there is no such key
+        CasResult result = CasResult::kNotFound;
+        bool stored = Update(key, [&](const char *, std::size_t, uint64_t current, std::string &new_value,
+                                      uint32_t &new_exptime) {
+            if (current != cas) {
+                result = CasResult::kExists;
+                return false;
+            }
+            result = CasResult::kNotStored;
+            new_value = value;
+            new_exptime = exptime;
+            return true;
+        });
+        return stored ? CasResult::kStored : result;
+    }
+
+    /**
+     * Adds data to the end (Append) or to the beginning (Prepend) of the value of existing association,
+     * expiration time is kept. If requested key doesn't present in storage or the resulting value is
+     * too large method returns false and doesn't change anything
+     *
+     * Implementations grow value in place when there is spare space, so that appending to a large value
+     * costs only the appended bytes. By default new value is made by Update
+     *
+     * @param key to be updated
+     * @param data to add to the value
+     */
+    virtual bool Append(const std::string &key, const std::string &data) {
+        return Update(key, [&data](const char *value, std::size_t size, uint64_t, std::string &new_value,
+                                   uint32_t &) {
+            new_value.reserve(size + data.size());
+            new_value.assign(value, size).append(data);
+            return true;
+        });
+    }
+    virtual bool Prepend(const std::string &key, const std::string &data) {
+        return Update(key, [&data](const char *value, std::size_t size, uint64_t, std::string &new_value,
+                                   uint32_t &) {
+            new_value.reserve(size + data.size());
+            new_value.assign(data).append(value, size);
+            return true;
+        });
+    }
+
+    /**
+     * Receives association visited by ForEach: key and value bytes with their sizes, and expiration time
+     */
+    typedef std::function<void(const char *key, std::size_t key_size, const char *value, std::size_t value_size,
+                               uint32_t exptime)>
+        Visitor;
+
+    /**
+     * Calls visitor for every association that isn't expired, from the least recently used to the most
+     * recently used one, so that putting them into an empty storage in that order restores the same
+     * state. Storage must not be changed by visitor
+     *
+     * By default storage can't be iterated, implementations that support it override this
+     *
+     * @param visitor to call for every association
+     * @return false if storage doesn't support iteration
+     */
+    virtual bool ForEach(const Visitor &visitor) { return false; }
+
+    /**
+     * Runs action while storage is in consistent state and no other thread could change it, that is
+     * under all of storage locks. Lets the process fork to iterate over storage copy in child process,
+     * without stopping request processing for the time iteration takes
+     *
+     * @param action to run, must not call storage methods
+     */
+    virtual void Freeze(const std::function<void()> &action) { action(); }
+
+    /**
+     * Operation started by Async, receives storage to run on
+     */
+    typedef std::function<void(Storage &storage)> Operation;
+
+    /**
+     * Runs operation without blocking the caller on slow storage work, such as reading cold tier, long
+     * eviction or waiting for the storage lock while snapshot is taken. Once operation is done, done
+     * is called on the thread that has run the operation, so it must only hand control back to the
+     * caller thread, for example wake up its event loop
+     *
+     * By default operation runs on the calling thread and done is called before Async returns,
+     * implementations that have threads of their own override this
+     *
+     * @param operation to run, results are passed back by the state it captures
+     * @param done to call once operation is finished
+     */
+    virtual void Async(Operation operation, std::function<void()> done) {
+        operation(*this);
+        done();
+    }
+
+    /**
+     * Appends implementation specific statistics to the given list as name/value pairs, so that
+     * they could be reported to clients by "stats" command. By default there are none
+     *
+     * @param stats output parameter to append statistics to
+     */
+    virtual void Stats(std::vector<std::pair<std::string, std::string>> &stats) {}
+
+protected:
+    /**
+     * Version of the value for storages that don't keep versions: FNV-1a hash of its bytes, never 0
+     */
+    static uint64_t value_cas(const char *data, std::size_t size) {
+        uint64_t hash = 14695981039346656037ULL;
+        for (std::size_t i = 0; i < size; i++) {
+            hash = (hash ^ uint8_t(data[i])) * 1099511628211ULL;
+        }
+        return hash != 0 ? hash : 1;
+    }
 };
 
 } // namespace Afina
@@ -7,6 +7,11 @@ namespace Allocator {
 // to avoid expensive macros calculations and increase compile speed
 class Simple;
 
+/**
+ * Handle of the memory block allocated by Simple. Pointer refers to the slot of allocator descriptor
+ * table rather than to the block itself, block could be moved by defragmentation and the slot gets
+ * updated, so all copies of the Pointer stay valid
+ */
 class Pointer {
 public:
     Pointer();
@@ -17,7 +22,16 @@ public:
     Pointer &operator=(const Pointer &);
     Pointer &operator=(Pointer &&);
 
-    void *get() const { return 0; }
+    // Current address of the block, nullptr if Pointer doesn't refer to any
+    void *get() const { return _slot != nullptr ? *_slot : nullptr; }
+
+private:
+    friend class Simple;
+
+    explicit Pointer(void **slot) : _slot(slot) {}
+
+    // Descriptor table slot, holds address of the block
+    void **_slot;
 };
 
 } // namespace Allocator
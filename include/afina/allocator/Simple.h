@@ -18,6 +18,15 @@ class Pointer;
  * Allocator instance doesn't take ownership of wrapped memmory and do not delete it
  * on destruction. So caller must take care of resource cleaup after allocator stop
  * being needs
+ *
+ * Blocks are placed one after another from the beginning of the area, each one is prefixed
+ * with a small header. Descriptor table grows from the end of the area towards blocks, every
+ * allocated block owns a slot of it holding the block address. Pointer refers to the slot, so
+ * blocks could be moved by defragmentation without invalidating any Pointer.
+ *
+ * Freed blocks are merged with free neighbours and kept in a free list, allocation takes the
+ * first free block large enough and falls back to the unused space between blocks and the
+ * descriptor table.
  */
 // TODO: Implements interface to allow usage as C++ allocators
 class Simple {
@@ -25,37 +34,93 @@ public:
     Simple(void *base, const size_t size);
 
     /**
-     * TODO: semantics
+     * Allocates block of at least N bytes
      * @param N size_t
+     * @throw AllocError(NoMemory) if there is no free space large enough, defrag() might help then
      */
     Pointer alloc(size_t N);
 
     /**
-     * TODO: semantics
+     * Changes size of the block keeping its content, as much of it as fits new size. Block is resized
+     * in place whenever possible, otherwise it gets moved and p keeps referring to it. Empty p gets
+     * allocated
      * @param p Pointer
      * @param N size_t
+     * @throw AllocError(NoMemory) if block can't grow, p is left intact then
      */
     void realloc(Pointer &p, size_t N);
 
     /**
-     * TODO: semantics
+     * Releases block, p becomes empty. Freeing empty pointer does nothing
      * @param p Pointer
+     * @throw AllocError(InvalidFree) if p doesn't refer to the block of this allocator
      */
     void free(Pointer &p);
 
     /**
-     * TODO: semantics
+     * Moves all allocated blocks to the beginning of the area, so that free space becomes contiguous
      */
     void defrag();
 
     /**
-     * TODO: semantics
+     * Does part of defrag() work, moving up to budget bytes of allocated blocks. Could be called
+     * between other operations to compact area incrementally
+     * @param budget size_t
+     * @return true if area is compact, no more work left
+     */
+    bool defrag_step(size_t budget);
+
+    /**
+     * Size of the largest block that could be allocated after defrag()
+     */
+    size_t available() const;
+
+    /**
+     * Layout of the area, one line per block
      */
     std::string dump() const;
 
 private:
+    struct Block;
+
+    Block *next(Block *block) const;
+    Block *prev(Block *block) const;
+
+    // Finds room for block of N bytes and binds it to the slot, new slot is acquired if none given.
+    // Returns nullptr if there is no room
+    Block *take(size_t N, void **slot);
+    // Cuts tail of the block exceeding N bytes off as a free block
+    void split(Block *block, size_t N);
+    // Returns block to the free list merging it with free neighbours
+    void make_free(Block *block);
+
+    void link_free(Block *block);
+    void unlink_free(Block *block);
+
+    void **acquire_slot();
+    void release_slot(void **slot);
+
     void *_base;
     const size_t _base_len;
+
+    // Blocks occupy [_begin, _top), descriptor table [_slots, _end)
+    char *_begin;
+    char *_top;
+    void **_slots;
+    void **_end;
+
+    // Block right below _top, never free, nullptr if there are no blocks
+    Block *_last;
+
+    // Head of the free slots chain, each free slot holds address of the next one
+    void **_free_slot;
+
+    // Free blocks and the total size they take, headers included
+    Block *_free_head;
+    size_t _free_size;
+
+    // Defragmentation progress, there are no free blocks below
+    char *_cursor;
 };
 
 } // namespace Allocator
@@ -1,10 +1,104 @@
 #ifndef AFINA_CONCURRENCY_CORE_LOCAL_H
 #define AFINA_CONCURRENCY_CORE_LOCAL_H
 
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#include <sched.h>
+#include <unistd.h>
+
 namespace Afina {
 namespace Concurrency {
 
-template <typename T> class CoreLocal {};
+/**
+ * # Per CPU container
+ * Holds a separate instance of T for every CPU, each one in cache lines of its own, so that threads
+ * running on different CPUs never share cache lines through it. Local() returns instance of the CPU
+ * calling thread is running on, as reported by sched_getcpu (glibc answers it from rseq area or vDSO
+ * without a syscall).
+ *
+ * Thread could be migrated to another CPU right after Local() returns, so instance is only "usually"
+ * private: it must still be safe to use concurrently, for example hold atomics or be protected by a
+ * lock that is almost never contended. Instances are created on construction, one per configured CPU,
+ * and are never moved
+ */
+template <typename T> class CoreLocal {
+public:
+    // Size of the cache line instances are aligned to
+    static constexpr std::size_t kCacheLine = 64;
+
+    CoreLocal() : CoreLocal(Cores()) {}
+
+    /**
+     * Creates given number of default constructed instances
+     */
+    explicit CoreLocal(std::size_t cores) : _size(cores == 0 ? 1 : cores) {
+        void *mem = nullptr;
+        if (posix_memalign(&mem, kCacheLine, _size * sizeof(Slot)) != 0) {
+            throw std::bad_alloc();
+        }
+        _slots = static_cast<Slot *>(mem);
+
+        std::size_t created = 0;
+        try {
+            for (; created < _size; created++) {
+                new (&_slots[created]) Slot();
+            }
+        } catch (...) {
+            destroy(created);
+            throw;
+        }
+    }
+
+    ~CoreLocal() { destroy(_size); }
+
+    /**
+     * Number of CPUs configured in the system
+     */
+    static std::size_t Cores() {
+        long cores = sysconf(_SC_NPROCESSORS_CONF);
+        return cores > 0 ? std::size_t(cores) : 1;
+    }
+
+    /**
+     * CPU calling thread is running on
+     */
+    static std::size_t Current() {
+        int cpu = sched_getcpu();
+        return cpu >= 0 ? std::size_t(cpu) : 0;
+    }
+
+    // Instance of the CPU calling thread is running on
+    T &Local() { return _slots[Current() % _size].value; }
+
+    // Instance of the given CPU
+    T &operator[](std::size_t core) { return _slots[core].value; }
+    const T &operator[](std::size_t core) const { return _slots[core].value; }
+
+    // Number of instances
+    std::size_t size() const { return _size; }
+
+private:
+    CoreLocal(const CoreLocal &) = delete;
+    CoreLocal &operator=(const CoreLocal &) = delete;
+
+    struct alignas(kCacheLine) Slot {
+        T value;
+    };
+
+    void destroy(std::size_t count) {
+        for (std::size_t i = 0; i < count; i++) {
+            _slots[i].~Slot();
+        }
+        std::free(_slots);
+    }
+
+    Slot *_slots;
+    const std::size_t _size;
+};
+
+template <typename T> constexpr std::size_t CoreLocal<T>::kCacheLine;
 
 } // namespace Concurrency
 } // namespace Afina
@@ -1,10 +1,215 @@
 #ifndef AFINA_CONCURRENCY_FLAT_COMBINE_H
 #define AFINA_CONCURRENCY_FLAT_COMBINE_H
 
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <new>
+#include <thread>
+#include <utility>
+#include <vector>
+
 namespace Afina {
 namespace Concurrency {
 
-template <typename Op> class FlatCombine {};
+/**
+ * # Flat combining
+ * Serializes operations on a sequential data structure without making every thread fight for its lock.
+ * Thread publishes operation into its own slot and tries to become combiner. Combiner collects
+ * operations from all slots and applies them in a single batch, the rest of threads just spin on their
+ * slots until operation is done. So data structure is touched by one core at a time and stays in its
+ * cache, while lock changes hands once per batch rather than once per operation.
+ *
+ * Op is anything apply function understands, it is owned by the caller and should carry result back.
+ * Slot is picked by sequential number of the thread, threads sharing slot take turns.
+ *
+ * Combiner role is a lock on its own: lock()/unlock() let rare operations run directly on the data
+ * structure, on the calling thread, with no combining at all
+ */
+template <typename Op> class FlatCombine {
+public:
+    // Applies batch of operations, called by combiner only
+    using Apply = std::function<void(Op *const *ops, std::size_t count)>;
+
+    // Size of the cache line slots are aligned to
+    static constexpr std::size_t kCacheLine = 64;
+
+    /**
+     * @param apply function to apply batch of operations with
+     * @param slots number of slots, threads above that share them
+     */
+    explicit FlatCombine(Apply apply, std::size_t slots = 128)
+        : _apply(std::move(apply)), _size(slots == 0 ? 1 : slots), _used(0), _locked(false) {
+        void *mem = nullptr;
+        if (posix_memalign(&mem, kCacheLine, _size * sizeof(Slot)) != 0) {
+            throw std::bad_alloc();
+        }
+        _slots = static_cast<Slot *>(mem);
+        for (std::size_t i = 0; i < _size; i++) {
+            new (&_slots[i]) Slot();
+        }
+        _batch.reserve(_size);
+        _requests.reserve(_size);
+        _indices.reserve(_size);
+    }
+
+    ~FlatCombine() {
+        for (std::size_t i = 0; i < _size; i++) {
+            _slots[i].~Slot();
+        }
+        std::free(_slots);
+    }
+
+    /**
+     * Applies operation and returns once it is done, by the calling thread or by someone else. Exception
+     * thrown by apply is rethrown to every thread which operation was in the failed batch
+     */
+    void Execute(Op &op) {
+        Request request;
+        request.op = &op;
+        request.done.store(false, std::memory_order_relaxed);
+
+        std::size_t index = thread_index() % _size;
+        std::size_t used = _used.load(std::memory_order_relaxed);
+        while (used <= index && !_used.compare_exchange_weak(used, index + 1)) {
+        }
+
+        // Publish, waiting for other thread of the same slot if needed
+        Slot &slot = _slots[index];
+        Request *expected = nullptr;
+        for (int i = 0; !slot.request.compare_exchange_weak(expected, &request); i++) {
+            expected = nullptr;
+            if (!try_combine()) {
+                backoff(i);
+            }
+        }
+
+        for (int i = 0; !request.done.load(std::memory_order_acquire); i++) {
+            if (!try_combine()) {
+                backoff(i);
+            }
+        }
+        if (request.error) {
+            std::rethrow_exception(request.error);
+        }
+    }
+
+    // Becomes combiner without applying anything
+    void lock() {
+        for (int i = 0; !try_lock(); i++) {
+            backoff(i);
+        }
+    }
+
+    bool try_lock() { return !_locked.load(std::memory_order_relaxed) && !_locked.exchange(true); }
+
+    void unlock() { _locked.store(false, std::memory_order_release); }
+
+    // Number of batches applied so far
+    std::size_t batches() const { return _batches.load(std::memory_order_relaxed); }
+
+    // Number of operations applied so far
+    std::size_t operations() const { return _operations.load(std::memory_order_relaxed); }
+
+private:
+    FlatCombine(const FlatCombine &) = delete;
+    FlatCombine &operator=(const FlatCombine &) = delete;
+
+    // Operation published into slot. Lives on the stack of the caller, which waits until it is done
+    struct Request {
+        Op *op;
+        std::atomic<bool> done;
+
+        // Exception thrown by the batch, rethrown to the caller
+        std::exception_ptr error;
+    };
+
+    struct alignas(kCacheLine) Slot {
+        std::atomic<Request *> request{nullptr};
+    };
+
+    // Sequential number of the calling thread, used to pick slot
+    static std::size_t thread_index() {
+        static std::atomic<std::size_t> next_index(0);
+        static thread_local std::size_t index = next_index.fetch_add(1);
+        return index;
+    }
+
+    static void backoff(int attempt) {
+        if (attempt < 64) {
+#if defined(__x86_64__) || defined(__i386__)
+            __builtin_ia32_pause();
+#endif
+        } else {
+            std::this_thread::yield();
+        }
+    }
+
+    // Applies everything published so far if combiner role is free, returns false otherwise
+    bool try_combine() {
+        if (!try_lock()) {
+            return false;
+        }
+
+        _batch.clear();
+        _requests.clear();
+        _indices.clear();
+        std::size_t used = _used.load(std::memory_order_acquire);
+        for (std::size_t i = 0; i < used; i++) {
+            Request *request = _slots[i].request.load(std::memory_order_acquire);
+            if (request != nullptr) {
+                _batch.push_back(request->op);
+                _requests.push_back(request);
+                _indices.push_back(i);
+            }
+        }
+
+        std::exception_ptr error;
+        if (!_batch.empty()) {
+            try {
+                _apply(_batch.data(), _batch.size());
+            } catch (...) {
+                error = std::current_exception();
+            }
+            _batches.fetch_add(1, std::memory_order_relaxed);
+            _operations.fetch_add(_batch.size(), std::memory_order_relaxed);
+        }
+
+        // Slot is freed before request is done, as the request is gone as soon as it is
+        for (std::size_t i = 0; i < _indices.size(); i++) {
+            _slots[_indices[i]].request.store(nullptr, std::memory_order_relaxed);
+        }
+        for (std::size_t i = 0; i < _requests.size(); i++) {
+            _requests[i]->error = error;
+            _requests[i]->done.store(true, std::memory_order_release);
+        }
+        unlock();
+        return true;
+    }
+
+    const Apply _apply;
+
+    Slot *_slots;
+    const std::size_t _size;
+
+    // Number of slots ever published to, combiner doesn't look further
+    std::atomic<std::size_t> _used;
+
+    // Held by combiner
+    std::atomic<bool> _locked;
+
+    // Batch being applied, used by combiner only
+    std::vector<Op *> _batch;
+    std::vector<Request *> _requests;
+    std::vector<std::size_t> _indices;
+
+    std::atomic<std::size_t> _batches{0};
+    std::atomic<std::size_t> _operations{0};
+};
+
+template <typename Op> constexpr std::size_t FlatCombine<Op>::kCacheLine;
 
 } // namespace Concurrency
 } // namespace Afina
@@ -1,10 +1,97 @@
 #ifndef AFINA_CONCURRENCY_THREAD_LOCAL_H
 #define AFINA_CONCURRENCY_THREAD_LOCAL_H
 
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include <pthread.h>
+
 namespace Afina {
 namespace Concurrency {
 
-template <typename T> class ThreadLocal {};
+/**
+ * # Per thread instance owned by an object
+ * Unlike thread_local variable, every ThreadLocal object has instances of its own, so several storages
+ * don't share them. Instance is value initialized on the first Get from the thread and destroyed
+ * once the thread exits, or together with ThreadLocal if thread outlives it.
+ *
+ * Get is lock free after the first call. ForEach lets another thread look at all instances, such as to
+ * sum up statistics, so anything it reads must be safe to read concurrently with the owner thread.
+ *
+ * ThreadLocal must not be destroyed while any thread still uses it
+ */
+template <typename T> class ThreadLocal {
+public:
+    ThreadLocal() {
+        if (pthread_key_create(&_key, &ThreadLocal::on_exit) != 0) {
+            throw std::runtime_error("Failed to create thread local key");
+        }
+    }
+
+    ~ThreadLocal() {
+        pthread_key_delete(_key);
+        for (Holder *holder : _holders) {
+            delete holder;
+        }
+    }
+
+    /**
+     * Instance of the calling thread
+     */
+    T &Get() {
+        Holder *holder = static_cast<Holder *>(pthread_getspecific(_key));
+        if (holder == nullptr) {
+            holder = new Holder(this);
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _holders.push_back(holder);
+            }
+            pthread_setspecific(_key, holder);
+        }
+        return holder->value;
+    }
+
+    /**
+     * Calls function for instance of every thread alive, instances don't go away until it returns
+     */
+    void ForEach(const std::function<void(T &)> &f) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (Holder *holder : _holders) {
+            f(holder->value);
+        }
+    }
+
+private:
+    ThreadLocal(const ThreadLocal &) = delete;
+    ThreadLocal &operator=(const ThreadLocal &) = delete;
+
+    struct Holder {
+        explicit Holder(ThreadLocal *owner) : owner(owner), value() {}
+
+        ThreadLocal *owner;
+        T value;
+    };
+
+    // Called by pthread for every thread which has instance once it exits
+    static void on_exit(void *ptr) {
+        Holder *holder = static_cast<Holder *>(ptr);
+        ThreadLocal *owner = holder->owner;
+        {
+            std::lock_guard<std::mutex> lock(owner->_mutex);
+            owner->_holders.erase(std::find(owner->_holders.begin(), owner->_holders.end(), holder));
+        }
+        delete holder;
+    }
+
+    pthread_key_t _key;
+
+    // Instances of all threads, guarded by the mutex
+    std::mutex _mutex;
+    std::vector<Holder *> _holders;
+};
 
 } // namespace Concurrency
 } // namespace Afina
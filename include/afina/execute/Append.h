@@ -12,7 +12,8 @@ namespace Execute {
 /**
  * # Append data for the key
  * Append new data to the end of value for the given key. If key wasn't found
- * then command does nothing
+ * then command does nothing. Flags and expiration time are ignored, existing
+ * ones are kept
  *
  * Command must write result to the output, which could be:
  * - "STORED", to indicate success.
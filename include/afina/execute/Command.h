@@ -1,11 +1,14 @@
 #ifndef AFINA_EXECUTE_COMMAND_H
 #define AFINA_EXECUTE_COMMAND_H
 
+#include <cstdint>
 #include <string>
+#include <vector>
 
 namespace Afina {
 
 class Storage;
+class Value;
 
 namespace Execute {
 
@@ -19,8 +22,21 @@ public:
     virtual ~Command() {}
 
     virtual void Execute(Storage &storage, const std::string &args, std::string &out) = 0;
+
+    /**
+     * Same as above, but response is built of chunks to be sent one after another, so that values could
+     * be sent straight from storage memory, e.g. by writev. By default response is a single chunk
+     */
+    virtual void Execute(Storage &storage, const std::string &args, std::vector<Value> &out);
 };
 
+/**
+ * Converts expiration time of memcached protocol into absolute time storage expects. Protocol value
+ * up to 30 days is an offset from now, bigger one is unix time already. 0 means never expire, and
+ * negative value means item is expired immediately
+ */
+uint32_t ExpireTime(int32_t expire);
+
 } // namespace Execute
 } // namespace Afina
 
@@ -41,6 +41,9 @@ public:
 
     void Execute(Storage &storage, const std::string &args, std::string &out) override;
 
+    // Values are not copied, response refers to them by handles
+    void Execute(Storage &storage, const std::string &args, std::vector<Value> &out) override;
+
 private:
     std::vector<std::string> _keys;
 };
@@ -0,0 +1,36 @@
+#ifndef AFINA_EXECUTE_GET_AND_TOUCH_H
+#define AFINA_EXECUTE_GET_AND_TOUCH_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Command.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Retrive values and update expiration time of the keys
+ * Same as Get, but every key found gets the new expiration time as Touch does. Output format is the
+ * same as for Get
+ */
+class GetAndTouch : public Command {
+public:
+    GetAndTouch(int32_t expire, const std::vector<std::string> &keys) : _expire(expire), _keys(keys) {}
+    ~GetAndTouch() {}
+
+    inline const int32_t expire() const { return _expire; }
+    inline const std::vector<std::string> &keys() const { return _keys; }
+
+    void Execute(Storage &storage, const std::string &args, std::string &out) override;
+
+private:
+    const int32_t _expire;
+    std::vector<std::string> _keys;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_GET_AND_TOUCH_H
@@ -0,0 +1,39 @@
+#ifndef AFINA_EXECUTE_GETS_H
+#define AFINA_EXECUTE_GETS_H
+
+#include <string>
+#include <vector>
+
+#include "Command.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Retrive values along with their versions
+ * Same as Get, but every item sent also carries unique version of the value, which client passes to
+ * Cas later to update key only if nobody has changed it meanwhile:
+ *
+ * VALUE <key> <flags> <bytes> <cas unique>\r\n
+ * <data>\r\n
+ */
+class Gets : public Command {
+public:
+    Gets(const std::vector<std::string> &keys) : _keys(keys) {}
+    ~Gets() {}
+
+    inline const std::vector<std::string> &keys() const { return _keys; }
+
+    void Execute(Storage &storage, const std::string &args, std::string &out) override;
+
+    // Values are not copied, response refers to them by handles
+    void Execute(Storage &storage, const std::string &args, std::vector<Value> &out) override;
+
+private:
+    std::vector<std::string> _keys;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_GETS_H
@@ -1,40 +1,367 @@
 #include <afina/allocator/Simple.h>
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <sstream>
+
+#include <afina/allocator/Error.h>
 #include <afina/allocator/Pointer.h>
 
 namespace Afina {
 namespace Allocator {
 
-Simple::Simple(void *base, size_t size) : _base(base), _base_len(size) {}
+/**
+ * Header of the block, data follows it
+ */
+struct Simple::Block {
+    // Size of the block data
+    size_t size;
+
+    // Size of the previous block data, 0 for the first block
+    size_t prev_size;
+
+    // Descriptor slot owned by the block, nullptr if block is free
+    void **slot;
+
+    char *data() { return reinterpret_cast<char *>(this + 1); }
+
+    // Free blocks keep links of the free list in their data
+    Block *&prev_free() { return reinterpret_cast<Block **>(data())[0]; }
+    Block *&next_free() { return reinterpret_cast<Block **>(data())[1]; }
+
+    static Block *Of(void *data) { return reinterpret_cast<Block *>(data) - 1; }
+};
+
+namespace {
+
+const size_t kAlign = sizeof(void *);
+
+// Block must be able to hold free list links once freed
+const size_t kMinSize = 2 * sizeof(void *);
+
+size_t align_up(size_t n) { return (n + kAlign - 1) & ~(kAlign - 1); }
+
+} // namespace
+
+Simple::Simple(void *base, size_t size) : _base(base), _base_len(size) {
+    uintptr_t begin = align_up(reinterpret_cast<uintptr_t>(base));
+    uintptr_t end = (reinterpret_cast<uintptr_t>(base) + size) & ~(kAlign - 1);
+
+    _begin = _top = reinterpret_cast<char *>(begin);
+    _slots = _end = reinterpret_cast<void **>(std::max(begin, end));
+    _last = nullptr;
+    _free_slot = nullptr;
+    _free_head = nullptr;
+    _free_size = 0;
+    _cursor = _begin;
+}
 
 /**
- * TODO: semantics
+ * Allocation takes the first free block large enough, splitting off the rest of it. If there is none,
+ * block is placed on the top of allocated ones
  * @param N size_t
  */
-Pointer Simple::alloc(size_t N) { return Pointer(); }
+Pointer Simple::alloc(size_t N) {
+    Block *block = N <= _base_len ? take(std::max(kMinSize, align_up(N)), nullptr) : nullptr;
+    if (block == nullptr) {
+        throw AllocError(AllocErrorType::NoMemory, "Not enough memory to allocate " + std::to_string(N) + " bytes");
+    }
+    return Pointer(block->slot);
+}
 
 /**
- * TODO: semantics
+ * Shrinking always happens in place. Growing block is extended in place if it is the top one or the
+ * next block is free and large enough, otherwise data is moved to a new block bound to the same slot
  * @param p Pointer
  * @param N size_t
  */
-void Simple::realloc(Pointer &p, size_t N) {}
+void Simple::realloc(Pointer &p, size_t N) {
+    if (p._slot == nullptr) {
+        p = alloc(N);
+        return;
+    }
+    if (N > _base_len) {
+        throw AllocError(AllocErrorType::NoMemory, "Not enough memory to allocate " + std::to_string(N) + " bytes");
+    }
+
+    size_t size = std::max(kMinSize, align_up(N));
+    Block *block = Block::Of(*p._slot);
+    if (size <= block->size) {
+        split(block, size);
+        return;
+    }
+
+    Block *following = next(block);
+    if (following == nullptr) {
+        if (static_cast<size_t>(reinterpret_cast<char *>(_slots) - _top) >= size - block->size) {
+            if (_cursor == _top) {
+                _cursor += size - block->size;
+            }
+            _top += size - block->size;
+            block->size = size;
+            return;
+        }
+    } else if (following->slot == nullptr && block->size + sizeof(Block) + following->size >= size) {
+        unlink_free(following);
+        block->size += sizeof(Block) + following->size;
+        if (Block *after = next(block)) {
+            after->prev_size = block->size;
+        }
+        if (_cursor == reinterpret_cast<char *>(following)) {
+            _cursor = block->data() + block->size;
+        }
+        split(block, size);
+        return;
+    }
+
+    Block *moved = take(size, p._slot);
+    if (moved == nullptr) {
+        throw AllocError(AllocErrorType::NoMemory, "Not enough memory to allocate " + std::to_string(N) + " bytes");
+    }
+    std::memcpy(moved->data(), block->data(), block->size);
+    make_free(block);
+}
 
 /**
- * TODO: semantics
+ * Block gets merged with free neighbours, its slot returns to the descriptor table
  * @param p Pointer
  */
-void Simple::free(Pointer &p) {}
+void Simple::free(Pointer &p) {
+    void **slot = p._slot;
+    if (slot == nullptr) {
+        return;
+    }
+
+    if (slot < _slots || slot >= _end) {
+        throw AllocError(AllocErrorType::InvalidFree, "Pointer doesn't belong to the allocator");
+    }
+    char *data = reinterpret_cast<char *>(*slot);
+    if (data < _begin + sizeof(Block) || data > _top || Block::Of(data)->slot != slot) {
+        throw AllocError(AllocErrorType::InvalidFree, "Pointer has been freed already");
+    }
+
+    make_free(Block::Of(data));
+    release_slot(slot);
+    p._slot = nullptr;
+}
 
 /**
- * TODO: semantics
+ * Allocated blocks slide down over free ones, slots are updated to new addresses
  */
-void Simple::defrag() {}
+void Simple::defrag() { defrag_step(std::numeric_limits<size_t>::max()); }
 
 /**
- * TODO: semantics
+ * Free space below the cursor is already compact. Step starts from the first free block above it and
+ * swaps it with the allocated block that follows, so free block floats up and merges with other free
+ * blocks on its way, until it reaches the top and gets released
+ * @param budget size_t
  */
-std::string Simple::dump() const { return ""; }
+bool Simple::defrag_step(size_t budget) {
+    while (_cursor < _top && reinterpret_cast<Block *>(_cursor)->slot != nullptr) {
+        Block *block = reinterpret_cast<Block *>(_cursor);
+        _cursor = block->data() + block->size;
+    }
+    if (_cursor == _top) {
+        return true;
+    }
+
+    Block *hole = reinterpret_cast<Block *>(_cursor);
+    for (size_t moved = 0;;) {
+        Block *following = next(hole);
+        if (following == nullptr) {
+            unlink_free(hole);
+            _top = _cursor = reinterpret_cast<char *>(hole);
+            _last = prev(hole);
+            return true;
+        }
+
+        if (following->slot == nullptr) {
+            unlink_free(hole);
+            unlink_free(following);
+            hole->size += sizeof(Block) + following->size;
+            link_free(hole);
+            if (Block *after = next(hole)) {
+                after->prev_size = hole->size;
+            }
+            continue;
+        }
+
+        if (moved >= budget) {
+            return false;
+        }
+
+        size_t hole_size = hole->size;
+        size_t prev_size = hole->prev_size;
+        size_t len = sizeof(Block) + following->size;
+        unlink_free(hole);
+        std::memmove(hole, following, len);
+
+        Block *block = hole;
+        block->prev_size = prev_size;
+        *block->slot = block->data();
+        if (_last == following) {
+            _last = block;
+        }
+
+        hole = reinterpret_cast<Block *>(block->data() + block->size);
+        hole->size = hole_size;
+        hole->prev_size = block->size;
+        if (Block *after = next(hole)) {
+            after->prev_size = hole_size;
+        }
+        link_free(hole);
+
+        _cursor = reinterpret_cast<char *>(hole);
+        moved += len;
+    }
+}
+
+size_t Simple::available() const {
+    size_t space = _free_size + (reinterpret_cast<char *>(_slots) - _top);
+    size_t overhead = sizeof(Block) + (_free_slot == nullptr ? sizeof(void *) : 0);
+    return space > overhead ? space - overhead : 0;
+}
+
+/**
+ * Line per block: offset from the beginning of area, data size and state
+ */
+std::string Simple::dump() const {
+    std::ostringstream out;
+    for (char *it = _begin; it < _top;) {
+        Block *block = reinterpret_cast<Block *>(it);
+        out << it - _begin << ' ' << block->size << (block->slot != nullptr ? " used" : " free") << '\n';
+        it = block->data() + block->size;
+    }
+    out << _top - _begin << ' ' << reinterpret_cast<char *>(_slots) - _top << " unused\n";
+    return out.str();
+}
+
+Simple::Block *Simple::next(Block *block) const {
+    char *it = block->data() + block->size;
+    return it < _top ? reinterpret_cast<Block *>(it) : nullptr;
+}
+
+Simple::Block *Simple::prev(Block *block) const {
+    char *it = reinterpret_cast<char *>(block);
+    return it > _begin ? reinterpret_cast<Block *>(it - sizeof(Block) - block->prev_size) : nullptr;
+}
+
+Simple::Block *Simple::take(size_t N, void **slot) {
+    size_t gap = reinterpret_cast<char *>(_slots) - _top;
+    size_t slot_size = slot == nullptr && _free_slot == nullptr ? sizeof(void *) : 0;
+
+    Block *block = nullptr;
+    if (gap >= slot_size) {
+        for (Block *it = _free_head; it != nullptr; it = it->next_free()) {
+            if (it->size >= N) {
+                block = it;
+                unlink_free(block);
+                break;
+            }
+        }
+    }
+
+    if (block == nullptr) {
+        if (gap < slot_size + sizeof(Block) + N) {
+            return nullptr;
+        }
+        block = reinterpret_cast<Block *>(_top);
+        block->size = N;
+        block->prev_size = _last != nullptr ? _last->size : 0;
+        _top += sizeof(Block) + N;
+        _last = block;
+    }
+
+    block->slot = slot != nullptr ? slot : acquire_slot();
+    *block->slot = block->data();
+    split(block, N);
+    return block;
+}
+
+void Simple::split(Block *block, size_t N) {
+    if (block->size < N + sizeof(Block) + kMinSize) {
+        return;
+    }
+
+    Block *rest = reinterpret_cast<Block *>(block->data() + N);
+    rest->size = block->size - N - sizeof(Block);
+    rest->prev_size = N;
+    rest->slot = nullptr;
+    block->size = N;
+    if (Block *after = next(rest)) {
+        after->prev_size = rest->size;
+    }
+    if (_last == block) {
+        _last = rest;
+    }
+    make_free(rest);
+}
+
+void Simple::make_free(Block *block) {
+    block->slot = nullptr;
+
+    Block *following = next(block);
+    if (following != nullptr && following->slot == nullptr) {
+        unlink_free(following);
+        block->size += sizeof(Block) + following->size;
+    }
+
+    Block *previous = prev(block);
+    if (previous != nullptr && previous->slot == nullptr) {
+        unlink_free(previous);
+        previous->size += sizeof(Block) + block->size;
+        block = previous;
+    }
+
+    following = next(block);
+    if (following == nullptr) {
+        _top = reinterpret_cast<char *>(block);
+        _last = prev(block);
+    } else {
+        following->prev_size = block->size;
+        link_free(block);
+    }
+    _cursor = std::min(_cursor, reinterpret_cast<char *>(block));
+}
+
+void Simple::link_free(Block *block) {
+    block->slot = nullptr;
+    block->prev_free() = nullptr;
+    block->next_free() = _free_head;
+    if (_free_head != nullptr) {
+        _free_head->prev_free() = block;
+    }
+    _free_head = block;
+    _free_size += sizeof(Block) + block->size;
+}
+
+void Simple::unlink_free(Block *block) {
+    if (block->prev_free() != nullptr) {
+        block->prev_free()->next_free() = block->next_free();
+    } else {
+        _free_head = block->next_free();
+    }
+    if (block->next_free() != nullptr) {
+        block->next_free()->prev_free() = block->prev_free();
+    }
+    _free_size -= sizeof(Block) + block->size;
+}
+
+void **Simple::acquire_slot() {
+    if (_free_slot != nullptr) {
+        void **slot = _free_slot;
+        _free_slot = reinterpret_cast<void **>(*slot);
+        return slot;
+    }
+    return --_slots;
+}
+
+void Simple::release_slot(void **slot) {
+    *slot = _free_slot;
+    _free_slot = slot;
+}
 
 } // namespace Allocator
 } // namespace Afina
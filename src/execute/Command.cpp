@@ -1 +1,38 @@
 #include <afina/execute/Command.h>
+
+#include <ctime>
+
+#include <afina/Storage.h>
+
+namespace Afina {
+namespace Execute {
+
+namespace {
+
+// Bigger expiration times are treated by memcached as unix time
+const int32_t max_relative_expire = 60 * 60 * 24 * 30;
+
+} // namespace
+
+// See Command.h
+void Command::Execute(Storage &storage, const std::string &args, std::vector<Value> &out) {
+    std::string result;
+    Execute(storage, args, result);
+    out.emplace_back(std::move(result));
+}
+
+// See Command.h
+uint32_t ExpireTime(int32_t expire) {
+    if (expire == 0) {
+        return 0;
+    } else if (expire < 0) {
+        // Any time in the past would do
+        return 1;
+    } else if (expire > max_relative_expire) {
+        return uint32_t(expire);
+    }
+    return uint32_t(std::time(nullptr)) + uint32_t(expire);
+}
+
+} // namespace Execute
+} // namespace Afina
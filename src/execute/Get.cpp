@@ -22,22 +22,36 @@ to indicate the end of response.
 */
 
 void Get::Execute(Storage &storage, const std::string &args, std::string &out) {
+    std::vector<Value> chunks;
+    Execute(storage, args, chunks);
+
+    out.clear();
+    for (auto &chunk : chunks) {
+        out.append(chunk.data(), chunk.size());
+    }
+}
+
+void Get::Execute(Storage &storage, const std::string &args, std::vector<Value> &out) {
     std::stringstream keyStream;
     copy(_keys.begin(), _keys.end(), std::ostream_iterator<std::string>(keyStream, " "));
     std::cout << "Get(" << keyStream.str() << ")" << std::endl;
 
-    std::stringstream outStream;
+    // Text between values is gathered into a single chunk: trailer of the previous item along with
+    // header of the next one
+    std::vector<Value> values;
+    storage.MultiGet(_keys, values);
 
-    std::string value;
-    for (auto &key : _keys) {
-        if (!storage.Get(key, value))
+    std::string text;
+    for (std::size_t i = 0; i < _keys.size(); i++) {
+        if (!values[i])
             continue;
-        outStream << "VALUE " << key << " 0 " << value.size() << "\r\n";
-        outStream << value << "\r\n";
+        text += "VALUE " + _keys[i] + " 0 " + std::to_string(values[i].size()) + "\r\n";
+        out.emplace_back(std::move(text));
+        out.push_back(std::move(values[i]));
+        text = "\r\n";
     }
-    outStream << "END"; // networking layer should add the last \r\n
-
-    out = outStream.str();
+    text += "END"; // networking layer should add the last \r\n
+    out.emplace_back(std::move(text));
 }
 
 } // namespace Execute
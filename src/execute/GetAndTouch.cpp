@@ -0,0 +1,34 @@
+#include <afina/Storage.h>
+#include <afina/execute/GetAndTouch.h>
+
+#include <iostream>
+#include <iterator>
+#include <sstream>
+
+namespace Afina {
+namespace Execute {
+
+// memcached protocol: "gat" is used to fetch items and update the expiration time of existing items,
+// response is the same as for "get"
+void GetAndTouch::Execute(Storage &storage, const std::string &args, std::string &out) {
+    std::stringstream keyStream;
+    copy(_keys.begin(), _keys.end(), std::ostream_iterator<std::string>(keyStream, " "));
+    std::cout << "GetAndTouch(" << _expire << ", " << keyStream.str() << ")" << std::endl;
+
+    uint32_t exptime = ExpireTime(_expire);
+    std::stringstream outStream;
+
+    std::string value;
+    for (auto &key : _keys) {
+        if (!storage.GetAndTouch(key, value, exptime))
+            continue;
+        outStream << "VALUE " << key << " 0 " << value.size() << "\r\n";
+        outStream << value << "\r\n";
+    }
+    outStream << "END"; // networking layer should add the last \r\n
+
+    out = outStream.str();
+}
+
+} // namespace Execute
+} // namespace Afina
@@ -0,0 +1,44 @@
+#include <afina/Storage.h>
+#include <afina/execute/Gets.h>
+
+#include <iostream>
+#include <iterator>
+#include <sstream>
+
+namespace Afina {
+namespace Execute {
+
+// memcached protocol: "gets" is the same as "get", but every item is followed by its cas unique
+void Gets::Execute(Storage &storage, const std::string &args, std::string &out) {
+    std::vector<Value> chunks;
+    Execute(storage, args, chunks);
+
+    out.clear();
+    for (auto &chunk : chunks) {
+        out.append(chunk.data(), chunk.size());
+    }
+}
+
+void Gets::Execute(Storage &storage, const std::string &args, std::vector<Value> &out) {
+    std::stringstream keyStream;
+    copy(_keys.begin(), _keys.end(), std::ostream_iterator<std::string>(keyStream, " "));
+    std::cout << "Gets(" << keyStream.str() << ")" << std::endl;
+
+    // Text between values is gathered into a single chunk, see Get
+    std::string text;
+    for (auto &key : _keys) {
+        Value value;
+        uint64_t cas;
+        if (!storage.GetCas(key, value, cas))
+            continue;
+        text += "VALUE " + key + " 0 " + std::to_string(value.size()) + " " + std::to_string(cas) + "\r\n";
+        out.emplace_back(std::move(text));
+        out.push_back(std::move(value));
+        text = "\r\n";
+    }
+    text += "END"; // networking layer should add the last \r\n
+    out.emplace_back(std::move(text));
+}
+
+} // namespace Execute
+} // namespace Afina
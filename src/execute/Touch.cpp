@@ -0,0 +1,17 @@
+#include <afina/Storage.h>
+#include <afina/execute/Touch.h>
+
+#include <iostream>
+
+namespace Afina {
+namespace Execute {
+
+// memcached protocol: "touch" is used to update the expiration time of an existing item without
+// fetching it.
+void Touch::Execute(Storage &storage, const std::string &args, std::string &out) {
+    std::cout << "Touch(" << _key << "): " << _expire << std::endl;
+    out = storage.Touch(_key, ExpireTime(_expire)) ? "TOUCHED" : "NOT_FOUND";
+}
+
+} // namespace Execute
+} // namespace Afina
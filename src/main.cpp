@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <chrono>
 #include <iostream>
 #include <memory>
@@ -5,7 +6,9 @@
 #include <atomic>
 #include <semaphore.h>
 #include <signal.h>
+#include <sys/wait.h>
 #include <thread>
+#include <unistd.h>
 
 #include <cxxopts.hpp>
 
@@ -22,8 +25,23 @@
 #include "network/st_coroutine/ServerImpl.h"
 #include "network/st_nonblocking/ServerImpl.h"
 
+#include "storage/ArenaLRU.h"
+#include "storage/AsyncStorage.h"
+#include "storage/ClockLRU.h"
+#include "storage/CombiningLRU.h"
+#include "storage/CuckooStorage.h"
+#include "storage/LoggedStorage.h"
+#include "storage/NearCache.h"
+#include "storage/PartitionedLRU.h"
+#include "storage/PolicyStorage.h"
+#include "storage/ShardedLRU.h"
 #include "storage/SimpleLRU.h"
+#include "storage/SlabLRU.h"
+#include "storage/Snapshot.h"
+#include "storage/ThreadSafe.h"
+#include "storage/ThreadSafeBufferedLRU.h"
 #include "storage/ThreadSafeSimpleLRU.h"
+#include "storage/WTinyLFU.h"
 
 using namespace Afina;
 
@@ -52,14 +70,115 @@ public:
             storage_type = options["storage"].as<std::string>();
         }
 
+        // Limit is given in megabytes, every storage type takes it as the number of bytes
+        size_t max_size = 64;
+        if (options.count("memory") > 0) {
+            max_size = options["memory"].as<size_t>();
+        }
+        if (max_size == 0) {
+            throw std::runtime_error("Memory limit must be positive");
+        }
+        max_size *= 1024 * 1024;
+
         if (storage_type == "st_lru") {
-            storage = std::make_shared<Afina::Backend::SimpleLRU>();
+            storage = std::make_shared<Afina::Backend::SimpleLRU>(max_size);
         } else if (storage_type == "mt_lru") {
-            storage = std::make_shared<Afina::Backend::ThreadSafeSimplLRU>();
+            storage = std::make_shared<Afina::Backend::ThreadSafeSimplLRU>(max_size);
+        } else if (storage_type == "st_tiered" || storage_type == "mt_tiered") {
+            // Cold tier is an order of magnitude larger than memory by default
+            std::string cold_file = "afina.cold";
+            size_t cold_size = 10 * max_size;
+            if (options.count("cold-file") > 0) {
+                cold_file = options["cold-file"].as<std::string>();
+            }
+            if (options.count("cold-size") > 0) {
+                cold_size = options["cold-size"].as<size_t>();
+            }
+            std::unique_ptr<Afina::Backend::ColdTier> cold(new Afina::Backend::ColdTier(cold_file, cold_size));
+            if (storage_type == "st_tiered") {
+                storage = std::make_shared<Afina::Backend::SimpleLRU>(max_size, std::move(cold));
+            } else {
+                storage = std::make_shared<Afina::Backend::ThreadSafeSimplLRU>(max_size, std::move(cold));
+            }
+        } else if (storage_type == "st_tinylfu") {
+            storage = std::make_shared<Afina::Backend::WTinyLFU>(max_size);
+        } else if (storage_type == "mt_tinylfu") {
+            storage = std::make_shared<Afina::Backend::ThreadSafe<Afina::Backend::WTinyLFU>>(max_size);
+        } else if (storage_type == "st_slru") {
+            storage = std::make_shared<Afina::Backend::PolicyStorage<Afina::Backend::SLRUPolicy>>(max_size);
+        } else if (storage_type == "mt_slru") {
+            storage = std::make_shared<Afina::Backend::ThreadSafeBasicLRU<Afina::Backend::SLRUPolicy>>(max_size);
+        } else if (storage_type == "st_2q") {
+            storage = std::make_shared<Afina::Backend::PolicyStorage<Afina::Backend::TwoQPolicy>>(max_size);
+        } else if (storage_type == "mt_2q") {
+            storage = std::make_shared<Afina::Backend::ThreadSafeBasicLRU<Afina::Backend::TwoQPolicy>>(max_size);
+        } else if (storage_type == "st_arc") {
+            storage = std::make_shared<Afina::Backend::PolicyStorage<Afina::Backend::ARCPolicy>>(max_size);
+        } else if (storage_type == "mt_arc") {
+            storage = std::make_shared<Afina::Backend::ThreadSafeBasicLRU<Afina::Backend::ARCPolicy>>(max_size);
+        } else if (storage_type == "st_slab") {
+            storage = std::make_shared<Afina::Backend::SlabLRU>(max_size);
+        } else if (storage_type == "mt_slab") {
+            storage = std::make_shared<Afina::Backend::ThreadSafe<Afina::Backend::SlabLRU>>(max_size);
+        } else if (storage_type == "st_arena") {
+            storage = std::make_shared<Afina::Backend::ArenaLRU>(max_size);
+        } else if (storage_type == "mt_arena") {
+            storage = std::make_shared<Afina::Backend::ThreadSafe<Afina::Backend::ArenaLRU>>(max_size);
+        } else if (storage_type == "sharded_lru") {
+            size_t shards = 8;
+            if (options.count("shards") > 0) {
+                shards = options["shards"].as<size_t>();
+            }
+            storage = std::make_shared<Afina::Backend::ShardedLRU>(max_size, shards);
+        } else if (storage_type == "partitioned_lru") {
+            storage = std::make_shared<Afina::Backend::PartitionedLRU>(max_size);
+        } else if (storage_type == "buffered_lru") {
+            storage = std::make_shared<Afina::Backend::ThreadSafeBufferedLRU>(max_size);
+        } else if (storage_type == "clock_lru") {
+            storage = std::make_shared<Afina::Backend::ClockLRU>(max_size);
+        } else if (storage_type == "combining_lru") {
+            storage = std::make_shared<Afina::Backend::CombiningLRU>(max_size);
+        } else if (storage_type == "cuckoo_hash") {
+            storage = std::make_shared<Afina::Backend::CuckooStorage>(max_size);
         } else {
             throw std::runtime_error("Unknown storage type");
         }
 
+        // Snapshot and append log rewrite iterate over storage, storage is empty yet so that costs nothing
+        if ((options.count("snapshot") > 0 || options.count("append-log") > 0) &&
+            !storage->ForEach([](const char *, size_t, const char *, size_t, uint32_t) {})) {
+            throw std::runtime_error("Storage type supports neither snapshot nor append log");
+        }
+        if (options.count("snapshot") > 0) {
+            snapshot_path = options["snapshot"].as<std::string>();
+        }
+
+        // Changes are logged by the wrapper, while snapshot and log are loaded into the wrapped storage
+        if (options.count("append-log") > 0) {
+            logged_storage = std::make_shared<Afina::Backend::LoggedStorage>(
+                storage, options["append-log"].as<std::string>(), options.count("append-log-sync") > 0);
+            storage = logged_storage;
+        }
+        if (storage_type.compare(0, 3, "st_") != 0) {
+            replay_threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        // Hot keys are read from caches of network threads, changes invalidate them
+        if (options.count("near-cache") > 0) {
+            if (storage_type.compare(0, 3, "st_") == 0) {
+                throw std::runtime_error("Near cache requires thread safe storage type");
+            }
+            storage = std::make_shared<Afina::Backend::NearCache>(storage, options["near-cache"].as<size_t>());
+        }
+
+        // Operations started by nonblocking network servers run on storage threads
+        if (options.count("async-threads") > 0) {
+            if (storage_type.compare(0, 3, "st_") == 0) {
+                throw std::runtime_error("Async storage requires thread safe storage type");
+            }
+            storage = std::make_shared<Afina::Backend::AsyncStorage>(storage, options["async-threads"].as<size_t>());
+        }
+
         // Step 2: Configure network
         std::string network_type = "st_block";
         if (options.count("network") > 0) {
@@ -92,6 +211,21 @@ public:
         log->warn("Start storage");
         storage->Start();
 
+        Afina::Storage &backend = logged_storage ? logged_storage->Wrapped() : *storage;
+        if (!snapshot_path.empty() && access(snapshot_path.c_str(), F_OK) == 0) {
+            try {
+                size_t threads = std::max(1u, std::thread::hardware_concurrency());
+                size_t loaded = Afina::Backend::LoadSnapshot(backend, snapshot_path, threads);
+                log->warn("Loaded {} items from snapshot {}", loaded, snapshot_path);
+            } catch (std::runtime_error &ex) {
+                log->error("Failed to load snapshot: {}", ex.what());
+            }
+        }
+        if (logged_storage) {
+            size_t replayed = logged_storage->Replay(replay_threads);
+            log->warn("Replayed {} changes from append log", replayed);
+        }
+
         // TODO: configure network service
         const uint16_t port = 8080;
         log->warn("Start network on {}", port);
@@ -105,21 +239,89 @@ public:
         server->Stop();
         server->Join();
 
+        // Nobody changes storage anymore, so the final snapshot is written right here
+        if (!snapshot_path.empty()) {
+            if (snapshot_pid > 0) {
+                waitpid(snapshot_pid, nullptr, 0);
+                snapshot_pid = -1;
+            }
+            try {
+                Afina::Backend::WriteSnapshot(*storage, snapshot_path);
+                log->warn("Snapshot written to {}", snapshot_path);
+            } catch (std::runtime_error &ex) {
+                log->error("Failed to write snapshot: {}", ex.what());
+            }
+        }
+
         storage->Stop();
         logService->Stop();
     }
 
+    // Writes snapshot in background, from a forked process
+    void Snapshot() {
+        auto log = logService->select("root");
+        if (snapshot_path.empty()) {
+            log->warn("Snapshot file isn't configured");
+            return;
+        }
+        if (snapshot_pid > 0 && waitpid(snapshot_pid, nullptr, WNOHANG) == 0) {
+            log->warn("Previous snapshot is still being written");
+            return;
+        }
+
+        try {
+            snapshot_pid = Afina::Backend::ForkSnapshot(*storage, snapshot_path);
+            log->warn("Snapshot is being written to {} by process {}", snapshot_path, snapshot_pid);
+        } catch (std::runtime_error &ex) {
+            snapshot_pid = -1;
+            log->error("Failed to start snapshot: {}", ex.what());
+        }
+    }
+
+    // Rewrites append log in background, from a forked process
+    void RewriteLog() {
+        auto log = logService->select("root");
+        if (!logged_storage) {
+            log->warn("Append log isn't configured");
+            return;
+        }
+
+        try {
+            if (logged_storage->Rewrite()) {
+                log->warn("Append log is being rewritten");
+            } else {
+                log->warn("Append log is being rewritten already");
+            }
+        } catch (std::runtime_error &ex) {
+            log->error("Failed to start append log rewrite: {}", ex.what());
+        }
+    }
+
 private:
     std::shared_ptr<Logging::Config> logConfig;
     std::shared_ptr<Logging::Service> logService;
 
     std::shared_ptr<Afina::Storage> storage;
     std::shared_ptr<Network::Server> server;
+
+    // Storage is loaded from that file on start and saved to it on stop and on SIGUSR1
+    std::string snapshot_path;
+
+    // Same storage when changes are logged, see LoggedStorage
+    std::shared_ptr<Afina::Backend::LoggedStorage> logged_storage;
+
+    // Single threaded storages are restored by single thread
+    size_t replay_threads = 1;
+
+    // Process writing snapshot in background
+    pid_t snapshot_pid = -1;
 };
 
 // Signal set that to notify application about time to stop
 sem_t stop_semaphore;
 volatile sig_atomic_t stop_reason = 0;
+volatile sig_atomic_t snapshot_requested = 0;
+volatile sig_atomic_t rewrite_requested = 0;
 
 // Catch user desire to stop the server
 void on_term(int signum, siginfo_t *siginfo, void *data) {
@@ -127,6 +329,18 @@ void on_term(int signum, siginfo_t *siginfo, void *data) {
     sem_post(&stop_semaphore);
 }
 
+// Catch user desire to save storage snapshot
+void on_snapshot(int signum, siginfo_t *siginfo, void *data) {
+    snapshot_requested = 1;
+    sem_post(&stop_semaphore);
+}
+
+// Catch user desire to compact append log
+void on_rewrite(int signum, siginfo_t *siginfo, void *data) {
+    rewrite_requested = 1;
+    sem_post(&stop_semaphore);
+}
+
 int main(int argc, char **argv) {
     // Command line arguments parsing
     cxxopts::Options options("afina", "Simple memory caching server");
@@ -134,7 +348,22 @@ int main(int argc, char **argv) {
         // TODO: use custom cxxopts::value to print options possible values in help message
         // and simplify validation below
         options.add_options()("s,storage", "Type of storage service to use", cxxopts::value<std::string>());
+        options.add_options()("m,memory", "Memory limit of the storage in megabytes, 64 by default",
+                              cxxopts::value<size_t>());
+        options.add_options()("shards", "Number of shards for sharded_lru storage", cxxopts::value<size_t>());
+        options.add_options()("cold-file", "File of the cold tier for st_tiered and mt_tiered storages",
+                              cxxopts::value<std::string>());
+        options.add_options()("cold-size", "Size of the cold tier file in bytes", cxxopts::value<size_t>());
         options.add_options()("n,network", "Type of network service to use", cxxopts::value<std::string>());
+        options.add_options()("snapshot", "File to load storage from on start and save it to on stop",
+                              cxxopts::value<std::string>());
+        options.add_options()("append-log", "File to log storage changes to and to restore storage from on start",
+                              cxxopts::value<std::string>());
+        options.add_options()("append-log-sync", "Reply to change once it is synced to the append log");
+        options.add_options()("async-threads", "Number of threads running storage operations of parked connections",
+                              cxxopts::value<size_t>());
+        options.add_options()("near-cache", "Number of hot keys cached by every thread reading storage",
+                              cxxopts::value<size_t>());
         options.add_options()("h,help", "Print usage info");
         options.parse(argc, argv);
 
@@ -167,6 +396,12 @@ int main(int argc, char **argv) {
 
         sigaction(SIGINT, &act, NULL);
         sigaction(SIGTERM, &act, NULL);
+
+        act.sa_sigaction = on_snapshot;
+        sigaction(SIGUSR1, &act, NULL);
+
+        act.sa_sigaction = on_rewrite;
+        sigaction(SIGUSR2, &act, NULL);
     }
 
     // Run app
@@ -174,9 +409,19 @@ int main(int argc, char **argv) {
         // Start services
         app.Start();
 
-        // Freeze main thread until one of signals arrive
-        while (stop_reason == 0 && ((sem_wait(&stop_semaphore) == -1) && (errno == EINTR))) {
-            continue;
+        // Freeze main thread until one of stop signals arrive, serving snapshot and rewrite requests meanwhile
+        while (stop_reason == 0) {
+            if (sem_wait(&stop_semaphore) == -1 && errno != EINTR) {
+                break;
+            }
+            if (snapshot_requested != 0) {
+                snapshot_requested = 0;
+                app.Snapshot();
+            }
+            if (rewrite_requested != 0) {
+                rewrite_requested = 0;
+                app.RewriteLog();
+            }
         }
 
         // Stop services
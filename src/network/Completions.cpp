@@ -0,0 +1,55 @@
+#include "Completions.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace Afina {
+namespace Network {
+
+CompletionQueue::CompletionQueue() {
+    _event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (_event_fd == -1) {
+        throw std::runtime_error("Failed to create completion eventfd: " + std::string(strerror(errno)));
+    }
+}
+
+CompletionQueue::~CompletionQueue() { close(_event_fd); }
+
+// See Completions.h
+void CompletionQueue::Post(std::function<void()> resume) {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _posted.push_back(std::move(resume));
+    }
+    // Counter overflow is the only possible error, loop is going to wake up anyway then
+    eventfd_write(_event_fd, 1);
+}
+
+// See Completions.h
+void CompletionQueue::Drain() {
+    eventfd_t count;
+    eventfd_read(_event_fd, &count);
+
+    std::vector<std::function<void()>> posted;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        posted.swap(_posted);
+    }
+    for (auto &resume : posted) {
+        resume();
+    }
+}
+
+// See Completions.h
+void CompletionQueue::Submit(Afina::Storage &storage, Afina::Storage::Operation operation,
+                             std::function<void()> resume) {
+    storage.Async(std::move(operation), [this, resume]() { Post(resume); });
+}
+
+} // namespace Network
+} // namespace Afina
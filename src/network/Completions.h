@@ -0,0 +1,59 @@
+#ifndef AFINA_NETWORK_COMPLETIONS_H
+#define AFINA_NETWORK_COMPLETIONS_H
+
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include <afina/Storage.h>
+
+namespace Afina {
+namespace Network {
+
+/**
+ * # Queue of finished storage operations
+ * Lets event loop start storage operation with Storage::Async and go on serving other connections. Once
+ * operation is done, the thread that has run it posts resume function here and wakes up the loop with
+ * eventfd, loop watches Fd() along with sockets and runs resume functions on its own thread by Drain.
+ * Resume typically rearms the parked connection in epoll or unblocks the coroutine serving it.
+ *
+ * Post could be called from any thread, Drain must only be called by the loop. Queue must outlive all
+ * operations submitted through it
+ */
+class CompletionQueue {
+public:
+    /**
+     * @throw std::runtime_error if eventfd could not be created
+     */
+    CompletionQueue();
+    ~CompletionQueue();
+
+    // Descriptor to watch for EPOLLIN, it is readable while there are resume functions to run
+    int Fd() const { return _event_fd; }
+
+    // Adds resume function and wakes up the loop
+    void Post(std::function<void()> resume);
+
+    // Runs all resume functions posted so far, in the order they have been posted
+    void Drain();
+
+    /**
+     * Starts operation on the storage, see Storage::Async, resume is posted once operation is done. If
+     * storage runs operation on the calling thread, resume is still called by the next Drain only
+     */
+    void Submit(Afina::Storage &storage, Afina::Storage::Operation operation, std::function<void()> resume);
+
+private:
+    CompletionQueue(const CompletionQueue &) = delete;
+    CompletionQueue &operator=(const CompletionQueue &) = delete;
+
+    int _event_fd;
+
+    std::mutex _mutex;
+    std::vector<std::function<void()>> _posted;
+};
+
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_COMPLETIONS_H
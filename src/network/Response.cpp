@@ -0,0 +1,45 @@
+#include "Response.h"
+
+#include <algorithm>
+#include <cerrno>
+
+#include <limits.h>
+#include <sys/uio.h>
+
+namespace Afina {
+namespace Network {
+
+// See Response.h
+bool SendResponse(int socket, const std::vector<Value> &chunks) {
+    std::vector<struct iovec> iov;
+    iov.reserve(chunks.size());
+    for (auto &chunk : chunks) {
+        if (chunk.size() > 0) {
+            iov.push_back({const_cast<char *>(chunk.data()), chunk.size()});
+        }
+    }
+
+    for (std::size_t first = 0; first < iov.size();) {
+        ssize_t sent = writev(socket, &iov[first], std::min<std::size_t>(iov.size() - first, IOV_MAX));
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        } else if (sent <= 0) {
+            return false;
+        }
+
+        // Skip chunks sent completely, the last one could be sent partially
+        std::size_t left = sent;
+        while (first < iov.size() && left >= iov[first].iov_len) {
+            left -= iov[first].iov_len;
+            first++;
+        }
+        if (left > 0) {
+            iov[first].iov_base = static_cast<char *>(iov[first].iov_base) + left;
+            iov[first].iov_len -= left;
+        }
+    }
+    return true;
+}
+
+} // namespace Network
+} // namespace Afina
@@ -0,0 +1,20 @@
+#ifndef AFINA_NETWORK_RESPONSE_H
+#define AFINA_NETWORK_RESPONSE_H
+
+#include <vector>
+
+#include <afina/Storage.h>
+
+namespace Afina {
+namespace Network {
+
+/**
+ * Sends response built of chunks by Command::Execute into blocking socket with writev, so that values
+ * go to the socket straight from storage memory. Returns false if socket fails before everything is sent
+ */
+bool SendResponse(int socket, const std::vector<Value> &chunks);
+
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_RESPONSE_H
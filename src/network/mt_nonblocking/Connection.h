@@ -2,9 +2,12 @@
 #define AFINA_NETWORK_MT_NONBLOCKING_CONNECTION_H
 
 #include <cstring>
+#include <utility>
 
 #include <sys/epoll.h>
 
+#include <afina/Storage.h>
+
 namespace Afina {
 namespace Network {
 namespace MTnonblock {
@@ -26,12 +29,22 @@ protected:
     void DoRead();
     void DoWrite();
 
+    /**
+     * Parks connection until storage operation is done: once current event is processed, server starts
+     * operation with Storage::Async and stops watching the socket, so that other connections are served
+     * meanwhile. Connection is watched again with the events it asked for after operation is done
+     */
+    void Park(Afina::Storage::Operation operation) { _operation = std::move(operation); }
+
 private:
     friend class Worker;
     friend class ServerImpl;
 
     int _socket;
     struct epoll_event _event;
+
+    // Operation connection is parked for, empty if there is none
+    Afina::Storage::Operation _operation;
 };
 
 } // namespace MTnonblock
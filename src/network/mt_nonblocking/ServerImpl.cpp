@@ -21,6 +21,8 @@
 #include <afina/Storage.h>
 #include <afina/logging/Service.h>
 
+#include "network/Completions.h"
+
 #include "Connection.h"
 #include "Utils.h"
 #include "Worker.h"
@@ -94,10 +96,18 @@ void ServerImpl::Start(uint16_t port, uint32_t n_acceptors, uint32_t n_workers)
         throw std::runtime_error("Failed to add eventfd descriptor to epoll");
     }
 
+    _completions.reset(new CompletionQueue());
+    struct epoll_event completions_event;
+    completions_event.events = EPOLLIN;
+    completions_event.data.ptr = _completions.get();
+    if (epoll_ctl(_data_epoll_fd, EPOLL_CTL_ADD, _completions->Fd(), &completions_event)) {
+        throw std::runtime_error("Failed to add completion queue descriptor to epoll");
+    }
+
     _workers.reserve(n_workers);
     for (int i = 0; i < n_workers; i++) {
         _workers.emplace_back(pStorage, pLogging);
-        _workers.back().Start(_data_epoll_fd);
+        _workers.back().Start(_data_epoll_fd, _completions.get());
     }
 
     // Start acceptors
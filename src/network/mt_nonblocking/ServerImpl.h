@@ -1,6 +1,7 @@
 #ifndef AFINA_NETWORK_MT_NONBLOCKING_SERVER_H
 #define AFINA_NETWORK_MT_NONBLOCKING_SERVER_H
 
+#include <memory>
 #include <thread>
 #include <vector>
 
@@ -12,6 +13,10 @@ class logger;
 
 namespace Afina {
 namespace Network {
+
+// Forward declaration, see network/Completions.h
+class CompletionQueue;
+
 namespace MTnonblock {
 
 // Forward declaration, see Worker.h
@@ -61,6 +66,9 @@ private:
     // Curstom event "device" used to wakeup workers
     int _event_fd;
 
+    // Finished storage operations, shared between workers
+    std::unique_ptr<CompletionQueue> _completions;
+
     // threads serving read/write requests
     std::vector<Worker> _workers;
 };
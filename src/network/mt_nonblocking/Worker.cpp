@@ -13,6 +13,8 @@
 
 #include <afina/logging/Service.h>
 
+#include "network/Completions.h"
+
 #include "Connection.h"
 #include "Utils.h"
 
@@ -22,7 +24,7 @@ namespace MTnonblock {
 
 // See Worker.h
 Worker::Worker(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Afina::Logging::Service> pl)
-    : _pStorage(ps), _pLogging(pl), isRunning(false), _epoll_fd(-1) {
+    : _pStorage(ps), _pLogging(pl), isRunning(false), _epoll_fd(-1), _completions(nullptr) {
     // TODO: implementation here
 }
 
@@ -41,16 +43,18 @@ Worker &Worker::operator=(Worker &&other) {
     _logger = std::move(other._logger);
     _thread = std::move(other._thread);
     _epoll_fd = other._epoll_fd;
+    _completions = other._completions;
 
     other._epoll_fd = -1;
     return *this;
 }
 
 // See Worker.h
-void Worker::Start(int epoll_fd) {
+void Worker::Start(int epoll_fd, CompletionQueue *completions) {
     if (isRunning.exchange(true) == false) {
         assert(_epoll_fd == -1);
         _epoll_fd = epoll_fd;
+        _completions = completions;
         _logger = _pLogging->select("network.worker");
         _thread = std::thread(&Worker::OnRun, this);
     }
@@ -90,6 +94,12 @@ void Worker::OnRun() {
                 continue;
             }
 
+            // Some storage operations are done, their connections are rearmed
+            if (current_event.data.ptr == _completions) {
+                _completions->Drain();
+                continue;
+            }
+
             // Some connection gets new data
             Connection *pconn = static_cast<Connection *>(current_event.data.ptr);
             if ((current_event.events & EPOLLERR) || (current_event.events & EPOLLHUP)) {
@@ -110,15 +120,16 @@ void Worker::OnRun() {
                 }
             }
 
+            // Parked connection is rearmed once its operation is done, it must not be touched after
+            // the operation is started as it could be done and drained by another worker at once
+            if (pconn->isAlive() && pconn->_operation) {
+                Afina::Storage::Operation operation;
+                operation.swap(pconn->_operation);
+                _completions->Submit(*_pStorage, std::move(operation), [this, pconn]() { rearm(pconn); });
+            }
             // Rearm connection
-            if (pconn->isAlive()) {
-                pconn->_event.events |= EPOLLONESHOT;
-                int epoll_ctl_retval;
-                if ((epoll_ctl_retval = epoll_ctl(_epoll_fd, EPOLL_CTL_MOD, pconn->_socket, &pconn->_event))) {
-                    _logger->debug("epoll_ctl failed during connection rearm: error {}", epoll_ctl_retval);
-                    pconn->OnError();
-                    delete pconn;
-                }
+            else if (pconn->isAlive()) {
+                rearm(pconn);
             }
             // Or delete closed one
             else {
@@ -133,6 +144,16 @@ void Worker::OnRun() {
     _logger->warn("Worker stopped");
 }
 
+void Worker::rearm(Connection *pconn) {
+    pconn->_event.events |= EPOLLONESHOT;
+    int epoll_ctl_retval;
+    if ((epoll_ctl_retval = epoll_ctl(_epoll_fd, EPOLL_CTL_MOD, pconn->_socket, &pconn->_event))) {
+        _logger->debug("epoll_ctl failed during connection rearm: error {}", epoll_ctl_retval);
+        pconn->OnError();
+        delete pconn;
+    }
+}
+
 } // namespace MTnonblock
 } // namespace Network
 } // namespace Afina
@@ -18,8 +18,15 @@ class Service;
 }
 
 namespace Network {
+
+// Forward declaration, see network/Completions.h
+class CompletionQueue;
+
 namespace MTnonblock {
 
+// Forward declaration, see Connection.h
+class Connection;
+
 /**
  * # Thread running epoll
  * On Start spaws background thread that is doing epoll on the given server
@@ -37,8 +44,11 @@ public:
      * Spaws new background thread that is doing epoll on the given server
      * socket. Once connection accepted it must be registered and being processed
      * on this thread
+     *
+     * Completion queue is registered in the same epoll and shared by all workers, parked connections
+     * are rearmed by whatever worker drains it
      */
-    void Start(int epoll_fd);
+    void Start(int epoll_fd, CompletionQueue *completions);
 
     /**
      * Signal background thread to stop. After that signal thread must stop to
@@ -61,6 +71,9 @@ protected:
     void OnRun();
 
 private:
+    // Rearms connection in epoll, connection is deleted if that fails
+    void rearm(Connection *pconn);
+
     Worker(Worker &) = delete;
     Worker &operator=(Worker &) = delete;
 
@@ -81,6 +94,9 @@ private:
 
     // EPOLL descriptor using for events processing
     int _epoll_fd;
+
+    // Finished storage operations of parked connections
+    CompletionQueue *_completions;
 };
 
 } // namespace MTnonblock
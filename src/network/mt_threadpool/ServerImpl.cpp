@@ -22,6 +22,7 @@
 #include <afina/execute/Command.h>
 #include <afina/logging/Service.h>
 
+#include "network/Response.h"
 #include "protocol/Parser.h"
 
 namespace Afina {
@@ -223,12 +224,12 @@ void ServerImpl::Worker(int client_socket) {
                         assert(argument_for_command.size() > 2);
                         argument_for_command.resize(argument_for_command.size() - 2);
                     }
-                    std::string result;
+                    std::vector<Value> result;
                     command_to_execute->Execute(*pStorage, argument_for_command, result);
 
                     // Send response
-                    result += "\r\n";
-                    if (send(client_socket, result.data(), result.size(), 0) <= 0) {
+                    result.emplace_back(std::string("\r\n"));
+                    if (!SendResponse(client_socket, result)) {
                         throw std::runtime_error("Failed to send response");
                     }
 
@@ -21,6 +21,7 @@
 #include <afina/execute/Command.h>
 #include <afina/logging/Service.h>
 
+#include "network/Response.h"
 #include "protocol/Parser.h"
 
 namespace Afina {
@@ -219,15 +220,15 @@ void ServerImpl::OnRun() {
                     if (command_to_execute && arg_remains == 0) {
                         _logger->debug("Start command execution");
 
-                        std::string result;
+                        std::vector<Value> result;
                         if (argument_for_command.size()) {
                             argument_for_command.resize(argument_for_command.size() - 2);
                         }
                         command_to_execute->Execute(*pStorage, argument_for_command, result);
 
                         // Send response
-                        result += "\r\n";
-                        if (send(client_socket, result.data(), result.size(), 0) <= 0) {
+                        result.emplace_back(std::string("\r\n"));
+                        if (!SendResponse(client_socket, result)) {
                             throw std::runtime_error("Failed to send response");
                         }
 
@@ -21,6 +21,8 @@
 #include <afina/Storage.h>
 #include <afina/logging/Service.h>
 
+#include "network/Completions.h"
+
 #include "Connection.h"
 #include "Utils.h"
 
@@ -79,6 +81,7 @@ void ServerImpl::Start(uint16_t port, uint32_t n_acceptors, uint32_t n_workers)
     if (_event_fd == -1) {
         throw std::runtime_error("Failed to create epoll file descriptor: " + std::string(strerror(errno)));
     }
+    _completions.reset(new CompletionQueue());
 
     _work_thread = std::thread(&ServerImpl::OnRun, this);
 }
@@ -121,6 +124,13 @@ void ServerImpl::OnRun() {
         throw std::runtime_error("Failed to add file descriptor to epoll");
     }
 
+    struct epoll_event event3;
+    event3.events = EPOLLIN;
+    event3.data.fd = _completions->Fd();
+    if (epoll_ctl(epoll_descr, EPOLL_CTL_ADD, _completions->Fd(), &event3)) {
+        throw std::runtime_error("Failed to add file descriptor to epoll");
+    }
+
     bool run = true;
     std::array<struct epoll_event, 64> mod_list;
     while (run) {
@@ -136,6 +146,10 @@ void ServerImpl::OnRun() {
             } else if (current_event.data.fd == _server_socket) {
                 OnNewConnection(epoll_descr);
                 continue;
+            } else if (current_event.data.fd == _completions->Fd()) {
+                // Resume parked connections
+                _completions->Drain();
+                continue;
             }
 
             // That is some connection!
@@ -166,6 +180,25 @@ void ServerImpl::OnRun() {
                 pc->OnClose();
 
                 delete pc;
+            } else if (pc->_operation) {
+                // Connection isn't watched until its operation is done, even for errors, so that it
+                // stays alive while operation uses it
+                if (epoll_ctl(epoll_descr, EPOLL_CTL_DEL, pc->_socket, &pc->_event)) {
+                    _logger->error("Failed to park connection");
+                }
+
+                Afina::Storage::Operation operation;
+                operation.swap(pc->_operation);
+                _completions->Submit(*pStorage, std::move(operation), [this, pc, epoll_descr]() {
+                    if (epoll_ctl(epoll_descr, EPOLL_CTL_ADD, pc->_socket, &pc->_event)) {
+                        _logger->error("Failed to resume connection");
+
+                        close(pc->_socket);
+                        pc->OnClose();
+
+                        delete pc;
+                    }
+                });
             } else if (pc->_event.events != old_mask) {
                 if (epoll_ctl(epoll_descr, EPOLL_CTL_MOD, pc->_socket, &pc->_event)) {
                     _logger->error("Failed to change connection event mask");
@@ -1,6 +1,7 @@
 #ifndef AFINA_NETWORK_ST_COROUTINE_SERVER_H
 #define AFINA_NETWORK_ST_COROUTINE_SERVER_H
 
+#include <memory>
 #include <thread>
 #include <vector>
 
@@ -12,6 +13,10 @@ class logger;
 
 namespace Afina {
 namespace Network {
+
+// Forward declaration, see network/Completions.h
+class CompletionQueue;
+
 namespace STcoroutine {
 
 // Forward declaration, see Worker.h
@@ -54,6 +59,9 @@ private:
     // Curstom event "device" used to wakeup workers
     int _event_fd;
 
+    // Finished storage operations of parked connections
+    std::unique_ptr<CompletionQueue> _completions;
+
     // IO thread
     std::thread _work_thread;
 };
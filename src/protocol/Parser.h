@@ -59,10 +59,24 @@ private:
     /**
      * State of the command parser. Prefixes are:
      * - s: state for PUT and GET commands
-     * - sp: for PUT commands only
-     * - sg: for GET commands only
+     * - sp: for PUT commands only, TOUCH and GAT commands read expiration time the same way
+     * - sg: for GET commands only, GAT keys as well
+     * - st: for TOUCH command only
+     * - sc: for CAS command only, the rest is read as for PUT commands
      */
-    enum State : uint16_t { sCR, sLF, sName, spKey, spFlags, spExprTimeStart, spExprTime, spBytes, sgKey };
+    enum State : uint16_t {
+        sCR,
+        sLF,
+        sName,
+        spKey,
+        spFlags,
+        spExprTimeStart,
+        spExprTime,
+        spBytes,
+        sgKey,
+        stKey,
+        scUnique
+    };
 
     // Current parser state
     State state;
@@ -88,6 +102,10 @@ private:
     // it's followed by an empty data block).
     uint32_t bytes;
 
+    // <cas unique> is a unique 64-bit value of an existing entry. Clients should use the value returned
+    // from the "gets" command when issuing "cas" updates.
+    uint64_t cas_unique;
+
     bool negative;
     std::string curKey;
     bool parse_complete;
@@ -0,0 +1,540 @@
+#include "AppendLog.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <functional>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "Snapshot.h"
+
+namespace Afina {
+namespace Backend {
+
+namespace {
+
+const char magic[8] = {'A', 'F', 'I', 'N', 'A', 'L', 'O', 'G'};
+const uint32_t version = 1;
+
+// Block is closed once its payload exceeds that size
+const std::size_t block_size = 64 * 1024;
+
+// Log is rewritten once it is that large and has doubled since the last rewrite
+const std::size_t rewrite_min_size = 64 * 1024 * 1024;
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+};
+
+struct BlockHeader {
+    uint32_t size;
+    uint32_t records;
+    uint32_t crc;
+};
+
+struct RecordHeader {
+    uint32_t op;
+    uint32_t key_size;
+    uint32_t value_size;
+    uint32_t exptime;
+};
+
+std::runtime_error io_error(const std::string &what, const std::string &path) {
+    return std::runtime_error(what + " " + path + ": " + std::strerror(errno));
+}
+
+void write_all(int fd, const char *data, std::size_t size, const std::string &path) {
+    while (size > 0) {
+        ssize_t written = ::write(fd, data, size);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        } else if (written < 0) {
+            throw io_error("Failed to write", path);
+        }
+        data += written;
+        size -= written;
+    }
+}
+
+void write_header(int fd, const std::string &path) {
+    FileHeader header = {{}, version, 0};
+    std::memcpy(header.magic, magic, sizeof(magic));
+    write_all(fd, reinterpret_cast<const char *>(&header), sizeof(header), path);
+}
+
+// Block of the mapped log file along with offsets of its records, partitioned between replaying threads
+struct Block {
+    const char *data;
+    BlockHeader header;
+    std::vector<std::vector<uint32_t>> owned;
+};
+
+// Checks that block is intact and records take exactly the whole payload, assigns records to threads
+bool verify(Block &block, std::size_t threads) {
+    if (Crc32c(block.data, block.header.size) != block.header.crc) {
+        return false;
+    }
+
+    std::hash<std::string> hash;
+    std::string key;
+    block.owned.resize(threads);
+    std::size_t offset = 0;
+    for (uint32_t i = 0; i < block.header.records; i++) {
+        RecordHeader header;
+        if (block.header.size - offset < sizeof(header)) {
+            return false;
+        }
+        std::memcpy(&header, block.data + offset, sizeof(header));
+        if (header.op < AppendLog::kPut || header.op > AppendLog::kPrepend ||
+            block.header.size - offset - sizeof(header) < std::size_t(header.key_size) + header.value_size) {
+            return false;
+        }
+
+        std::size_t owner = 0;
+        if (threads > 1) {
+            key.assign(block.data + offset + sizeof(header), header.key_size);
+            owner = hash(key) % threads;
+        }
+        block.owned[owner].push_back(uint32_t(offset));
+        offset += sizeof(header) + header.key_size + header.value_size;
+    }
+    return offset == block.header.size;
+}
+
+// Applies record to the storage, change that has already expired removes the key
+void apply(Afina::Storage &storage, const char *record, uint32_t now) {
+    RecordHeader header;
+    std::memcpy(&header, record, sizeof(header));
+    std::string key(record + sizeof(header), header.key_size);
+
+    bool expired = header.exptime != 0 && header.exptime <= now;
+    if (header.op == AppendLog::kDelete || expired) {
+        storage.Delete(key);
+    } else if (header.op == AppendLog::kPut) {
+        std::string value(record + sizeof(header) + header.key_size, header.value_size);
+        storage.PutExpiring(key, value, header.exptime);
+    } else if (header.op == AppendLog::kAppend) {
+        storage.Append(key, std::string(record + sizeof(header) + header.key_size, header.value_size));
+    } else if (header.op == AppendLog::kPrepend) {
+        storage.Prepend(key, std::string(record + sizeof(header) + header.key_size, header.value_size));
+    } else {
+        storage.Touch(key, header.exptime);
+    }
+}
+
+} // namespace
+
+void AppendLog::Batch::Add(Op op, const char *key, std::size_t key_size, const char *value, std::size_t value_size,
+                           uint32_t exptime) {
+    if (block == std::string::npos) {
+        block = data.size();
+        data.append(sizeof(BlockHeader), '\0');
+    }
+
+    RecordHeader header = {op, uint32_t(key_size), uint32_t(value_size), exptime};
+    data.append(reinterpret_cast<const char *>(&header), sizeof(header));
+    data.append(key, key_size);
+    data.append(value, value_size);
+    block_records++;
+    records++;
+
+    if (data.size() - block - sizeof(BlockHeader) >= block_size) {
+        Close();
+    }
+}
+
+void AppendLog::Batch::Close() {
+    if (block == std::string::npos) {
+        return;
+    }
+    const char *payload = data.data() + block + sizeof(BlockHeader);
+    std::size_t size = data.size() - block - sizeof(BlockHeader);
+    BlockHeader header = {uint32_t(size), block_records, Crc32c(payload, size)};
+    std::memcpy(&data[block], &header, sizeof(header));
+    block = std::string::npos;
+    block_records = 0;
+}
+
+void AppendLog::Batch::Clear() {
+    data.clear();
+    records = 0;
+    block = std::string::npos;
+    block_records = 0;
+}
+
+AppendLog::AppendLog(const std::string &path, std::chrono::milliseconds interval)
+    : _path(path), _interval(interval), _fd(-1), _size(0), _rewritten_size(0), _rewrite_wanted(false),
+      _running(false), _writing(false), _appended(0), _synced(0), _waiters(0), _rewrite_pid(-1), _batches(0),
+      _rewrites(0), _errors(0) {}
+
+AppendLog::~AppendLog() { Stop(); }
+
+// See AppendLog.h
+std::size_t AppendLog::Replay(Afina::Storage &storage, std::size_t threads) {
+    int fd = ::open(_path.c_str(), O_RDONLY);
+    if (fd < 0 && errno == ENOENT) {
+        return 0;
+    } else if (fd < 0) {
+        throw io_error("Failed to open", _path);
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw io_error("Failed to stat", _path);
+    }
+    std::size_t size = st.st_size;
+    if (size == 0) {
+        ::close(fd);
+        return 0;
+    }
+    void *mapped = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        throw io_error("Failed to map", _path);
+    }
+    const char *data = static_cast<const char *>(mapped);
+
+    FileHeader file = {};
+    std::memcpy(&file, data, std::min(size, sizeof(file)));
+    if (size < sizeof(file) || std::memcmp(file.magic, magic, sizeof(magic)) != 0 || file.version != version) {
+        ::munmap(mapped, size);
+        throw std::runtime_error("File " + _path + " isn't an append log");
+    }
+
+    // Last block might be cut short by a crash
+    std::vector<Block> blocks;
+    std::size_t offset = sizeof(file);
+    while (size - offset >= sizeof(BlockHeader)) {
+        BlockHeader header;
+        std::memcpy(&header, data + offset, sizeof(header));
+        if (size - offset - sizeof(header) < header.size) {
+            break;
+        }
+        blocks.push_back({data + offset + sizeof(header), header, {}});
+        offset += sizeof(header) + header.size;
+    }
+
+    // Blocks are verified and their records are partitioned in parallel, everything after the first
+    // broken block is dropped
+    threads = std::max<std::size_t>(1, threads);
+    std::vector<char> intact(blocks.size(), 0);
+    {
+        std::atomic<std::size_t> next(0);
+        auto work = [&blocks, &intact, &next, threads]() {
+            for (std::size_t i; (i = next.fetch_add(1)) < blocks.size();) {
+                intact[i] = verify(blocks[i], threads);
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for (std::size_t i = 1; i < std::min(threads, blocks.size()); i++) {
+            workers.emplace_back(work);
+        }
+        work();
+        for (auto &worker : workers) {
+            worker.join();
+        }
+    }
+    std::size_t valid = std::find(intact.begin(), intact.end(), 0) - intact.begin();
+    std::size_t length = valid > 0 ? blocks[valid - 1].data + blocks[valid - 1].header.size - data : sizeof(file);
+    blocks.resize(valid);
+
+    // Changes of the same key belong to the same thread, so they are applied in the log order
+    uint32_t now = uint32_t(std::time(nullptr));
+    std::atomic<std::size_t> applied(0);
+    auto work = [&blocks, &storage, &applied, now](std::size_t thread) {
+        std::size_t count = 0;
+        for (const Block &block : blocks) {
+            for (uint32_t record : block.owned[thread]) {
+                apply(storage, block.data + record, now);
+            }
+            count += block.owned[thread].size();
+        }
+        applied += count;
+    };
+
+    std::vector<std::thread> workers;
+    for (std::size_t i = 1; i < threads; i++) {
+        workers.emplace_back(work, i);
+    }
+    work(0);
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    ::munmap(mapped, size);
+
+    if (length < size && ::truncate(_path.c_str(), length) != 0) {
+        throw io_error("Failed to truncate", _path);
+    }
+    return applied.load();
+}
+
+// See AppendLog.h
+void AppendLog::Start() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_running) {
+        return;
+    }
+
+    _fd = ::open(_path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (_fd < 0) {
+        throw io_error("Failed to open", _path);
+    }
+    struct stat st;
+    if (::fstat(_fd, &st) != 0) {
+        ::close(_fd);
+        _fd = -1;
+        throw io_error("Failed to stat", _path);
+    }
+    _size = st.st_size;
+    if (_size == 0) {
+        write_header(_fd, _path);
+        _size = sizeof(FileHeader);
+    }
+    _rewritten_size = _size;
+
+    _running = true;
+    _writing = true;
+    _thread = std::thread(&AppendLog::writer, this);
+}
+
+// See AppendLog.h
+void AppendLog::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_running) {
+            return;
+        }
+        _running = false;
+    }
+    _wakeup.notify_one();
+    _thread.join();
+
+    ::close(_fd);
+    _fd = -1;
+}
+
+// See AppendLog.h
+uint64_t AppendLog::Append(Op op, const std::string &key, const std::string &value, uint32_t exptime) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _pending.Add(op, key.data(), key.size(), value.data(), value.size(), exptime);
+    if (_rewrite_pid > 0) {
+        _rewrite.Add(op, key.data(), key.size(), value.data(), value.size(), exptime);
+    }
+    return ++_appended;
+}
+
+// See AppendLog.h
+void AppendLog::Sync(uint64_t seq) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (_synced >= seq || !_writing) {
+        return;
+    }
+    _waiters++;
+    _wakeup.notify_one();
+    _synced_cv.wait(lock, [this, seq]() { return _synced >= seq || !_writing; });
+    _waiters--;
+}
+
+// See AppendLog.h
+bool AppendLog::Rewrite(Afina::Storage &storage) {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_running || _rewrite_pid > 0) {
+            return false;
+        }
+        _rewrite_wanted.store(false, std::memory_order_relaxed);
+    }
+
+    pid_t pid = -1;
+    storage.Freeze([&pid]() { pid = ::fork(); });
+    if (pid < 0) {
+        throw std::runtime_error(std::string("Failed to fork: ") + std::strerror(errno));
+    } else if (pid == 0) {
+        // Child is the only thread left, it must not touch anything but storage and its own file
+        int status = 0;
+        try {
+            dump(storage, _path + ".rewrite");
+        } catch (...) {
+            status = 1;
+        }
+        ::_exit(status);
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _rewrite_pid = pid;
+    _rewrite.Clear();
+    return true;
+}
+
+// See AppendLog.h
+void AppendLog::Stats(std::vector<std::pair<std::string, std::string>> &stats) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    stats.emplace_back("log_size", std::to_string(_size));
+    stats.emplace_back("log_batches", std::to_string(_batches));
+    stats.emplace_back("log_rewrites", std::to_string(_rewrites));
+    stats.emplace_back("log_rewrite_in_progress", _rewrite_pid > 0 ? "1" : "0");
+    stats.emplace_back("log_errors", std::to_string(_errors));
+}
+
+void AppendLog::dump(Afina::Storage &storage, const std::string &path) {
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw io_error("Failed to create", path);
+    }
+
+    try {
+        write_header(fd, path);
+
+        Batch batch;
+        if (!storage.ForEach([fd, &path, &batch](const char *key, std::size_t key_size, const char *value,
+                                                 std::size_t value_size, uint32_t exptime) {
+                batch.Add(kPut, key, key_size, value, value_size, exptime);
+                if (batch.block == std::string::npos) {
+                    write_all(fd, batch.data.data(), batch.data.size(), path);
+                    batch.Clear();
+                }
+            })) {
+            throw std::runtime_error("Storage doesn't support iteration");
+        }
+        batch.Close();
+        write_all(fd, batch.data.data(), batch.data.size(), path);
+
+        if (::fsync(fd) != 0) {
+            throw io_error("Failed to sync", path);
+        }
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+    ::close(fd);
+}
+
+void AppendLog::writer() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (true) {
+        _wakeup.wait_for(lock, _interval, [this]() { return !_running || (_waiters > 0 && _synced < _appended); });
+        bool stopping = !_running;
+
+        // Everything appended so far goes with a single write and fsync
+        uint64_t seq = _appended;
+        if (!_pending.data.empty()) {
+            Batch batch;
+            std::swap(batch, _pending);
+            batch.Close();
+
+            lock.unlock();
+            bool written = true;
+            try {
+                write_all(_fd, batch.data.data(), batch.data.size(), _path);
+                if (::fdatasync(_fd) != 0) {
+                    throw io_error("Failed to sync", _path);
+                }
+            } catch (std::runtime_error &) {
+                written = false;
+            }
+            lock.lock();
+
+            _batches++;
+            if (written) {
+                _size += batch.data.size();
+            } else {
+                _errors++;
+            }
+            if (_size >= rewrite_min_size && _size >= 2 * _rewritten_size) {
+                _rewrite_wanted.store(true, std::memory_order_relaxed);
+            }
+        }
+        _synced = seq;
+        _synced_cv.notify_all();
+
+        if (_rewrite_pid > 0) {
+            finish_rewrite(stopping, lock);
+        }
+        if (stopping && _pending.data.empty()) {
+            break;
+        }
+    }
+
+    _writing = false;
+    _synced_cv.notify_all();
+}
+
+void AppendLog::finish_rewrite(bool wait, std::unique_lock<std::mutex> &lock) {
+    int status = 0;
+    pid_t done = ::waitpid(_rewrite_pid, &status, wait ? 0 : WNOHANG);
+    if (done == 0) {
+        return;
+    }
+    _rewrite_pid = -1;
+
+    std::string path = _path + ".rewrite";
+    if (done < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        // Next attempt is made once log doubles again
+        _errors++;
+        _rewritten_size = _size;
+        _rewrite.Clear();
+        ::unlink(path.c_str());
+        return;
+    }
+
+    // Changes appended since the last batch go into the old file as well, so that nothing is lost if
+    // the new one could not replace it
+    Batch tail, rest;
+    std::swap(tail, _rewrite);
+    std::swap(rest, _pending);
+    tail.Close();
+    rest.Close();
+    uint64_t seq = _appended;
+
+    lock.unlock();
+    int fd = -1;
+    struct stat st;
+    bool replaced = false;
+    try {
+        write_all(_fd, rest.data.data(), rest.data.size(), _path);
+        if ((fd = ::open(path.c_str(), O_WRONLY | O_APPEND)) < 0) {
+            throw io_error("Failed to open", path);
+        }
+        write_all(fd, tail.data.data(), tail.data.size(), path);
+        if (::fdatasync(fd) != 0 || ::fstat(fd, &st) != 0) {
+            throw io_error("Failed to sync", path);
+        }
+        if (::rename(path.c_str(), _path.c_str()) != 0) {
+            throw io_error("Failed to replace", _path);
+        }
+        replaced = true;
+    } catch (std::runtime_error &) {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        ::unlink(path.c_str());
+        ::fdatasync(_fd);
+    }
+    lock.lock();
+
+    if (replaced) {
+        ::close(_fd);
+        _fd = fd;
+        _size = _rewritten_size = st.st_size;
+        _rewrites++;
+    } else {
+        _size += rest.data.size();
+        _rewritten_size = _size;
+        _errors++;
+    }
+    _synced = seq;
+    _synced_cv.notify_all();
+}
+
+} // namespace Backend
+} // namespace Afina
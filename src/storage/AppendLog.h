@@ -0,0 +1,160 @@
+#ifndef AFINA_STORAGE_APPEND_LOG_H
+#define AFINA_STORAGE_APPEND_LOG_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <sys/types.h>
+
+#include <afina/Storage.h>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Append-only log of storage changes
+ * Every change is appended to the in-memory batch, which dedicated thread writes into the file and
+ * syncs once per interval, so the disk latency is paid once per batch rather than once per change.
+ * Caller that needs the change to be durable waits for it with Sync, all the waiters of the same
+ * batch are released by a single fsync.
+ *
+ * File has the same layout as snapshot, see Snapshot.h, but there is no end marker and every record
+ * starts with operation code:
+ *
+ * [ magic | version ][ size | records | crc ][ record ... ] ...
+ *
+ * Record is [ op | key size | value size | exptime ][ key ][ value ], append and prepend records hold
+ * only the added data as value. Block is written for every batch
+ * or every 64KB of it. Block torn by a crash is detected by its CRC and dropped on replay with the rest
+ * of the file.
+ *
+ * Log keeps growing as keys are overwritten, so once it doubles since the last rewrite it could be
+ * rewritten from the live dataset: forked child writes current associations into the new file while
+ * changes made meanwhile are kept in memory, writer thread appends them to the new file once the child
+ * is done and replaces the log with it.
+ */
+class AppendLog {
+public:
+    enum Op : uint32_t { kPut = 1, kDelete, kTouch, kAppend, kPrepend };
+
+    AppendLog(const std::string &path, std::chrono::milliseconds interval = std::chrono::milliseconds(10));
+    ~AppendLog();
+
+    /**
+     * Applies the log to the storage, must be called before Start. Changes are partitioned by key hash
+     * between the given number of threads, so storage must be thread safe if there are more than one.
+     * Tail of the file after the first broken block is cut off. Returns number of applied records
+     * @throw std::runtime_error if file could not be read or isn't a log
+     */
+    std::size_t Replay(Afina::Storage &storage, std::size_t threads = 1);
+
+    /**
+     * Opens the file, creating it if needed, and starts writer thread
+     * @throw std::runtime_error if file could not be opened
+     */
+    void Start();
+
+    /**
+     * Writes all the pending changes, waits for the rewrite in progress and stops writer thread
+     */
+    void Stop();
+
+    /**
+     * Appends change to the current batch, returns its sequence number to pass into Sync
+     */
+    uint64_t Append(Op op, const std::string &key, const std::string &value, uint32_t exptime);
+
+    /**
+     * Blocks until change with the given sequence number is written and synced
+     */
+    void Sync(uint64_t seq);
+
+    /**
+     * Starts log rewrite from the storage. Caller must guarantee storage isn't changed by anyone else
+     * and all of its changes are already appended, until the method returns. Returns false if rewrite
+     * is already in progress
+     * @throw std::runtime_error if process could not be forked
+     */
+    bool Rewrite(Afina::Storage &storage);
+
+    // Checks if log has grown large enough to be rewritten
+    bool RewriteWanted() const { return _rewrite_wanted.load(std::memory_order_relaxed); }
+
+    // Appends log statistics, see Storage::Stats
+    void Stats(std::vector<std::pair<std::string, std::string>> &stats);
+
+private:
+    // Records split into blocks, each one prefixed with its header
+    struct Batch {
+        std::string data;
+
+        // Total number of records
+        std::size_t records = 0;
+
+        // Offset of the open block, npos if there is none, and number of records in it
+        std::size_t block = std::string::npos;
+        uint32_t block_records = 0;
+
+        void Add(Op op, const char *key, std::size_t key_size, const char *value, std::size_t value_size,
+                 uint32_t exptime);
+
+        // Fills header of the open block
+        void Close();
+
+        void Clear();
+    };
+
+    // Writes all associations of the storage into the new log file, runs in the forked child
+    static void dump(Afina::Storage &storage, const std::string &path);
+
+    // Writer thread loop
+    void writer();
+
+    // Checks if rewrite child has finished and swaps rewritten file in then, waits for it if asked to.
+    // Lock must be held, it is released while file is written
+    void finish_rewrite(bool wait, std::unique_lock<std::mutex> &lock);
+
+    const std::string _path;
+    const std::chrono::milliseconds _interval;
+
+    // Log file, owned by writer thread while it runs
+    int _fd;
+    std::size_t _size;
+    std::size_t _rewritten_size;
+    std::atomic<bool> _rewrite_wanted;
+
+    std::mutex _mutex;
+    std::condition_variable _wakeup;
+    std::condition_variable _synced_cv;
+    std::thread _thread;
+    bool _running;
+    bool _writing;
+
+    // Changes appended but not written yet, and sequence numbers of the last appended and synced ones
+    Batch _pending;
+    uint64_t _appended;
+    uint64_t _synced;
+    std::size_t _waiters;
+
+    // Rewriting child and changes made since it has been forked
+    pid_t _rewrite_pid;
+    Batch _rewrite;
+
+    // Statistics
+    std::size_t _batches;
+    std::size_t _rewrites;
+    std::size_t _errors;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_APPEND_LOG_H
@@ -0,0 +1,321 @@
+#include "ArenaLRU.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#include <afina/allocator/Error.h>
+
+namespace Afina {
+namespace Backend {
+
+namespace {
+
+// Compaction moves up to that many bytes per every byte written, but at least a page per write
+const std::size_t defrag_ratio = 2;
+const std::size_t defrag_min = 4096;
+
+// Number of compaction steps write does before it evicts, if free space is there but scattered
+const std::size_t reserve_defrag_steps = 4;
+
+// Number of nodes at the tail of the list a single write operation checks for expiration
+const std::size_t reclaim_slice = 8;
+
+} // namespace
+
+ArenaLRU::ArenaLRU(size_t max_size)
+    : _max_size(max_size), _region(new char[max_size]), _arena(_region.get(), max_size) {}
+
+ArenaLRU::~ArenaLRU() {
+    // Data goes away along with the region
+    _index.Clear();
+    while (_head != nullptr) {
+        Node *node = _head;
+        _head = node->next;
+        delete node;
+    }
+}
+
+// See ArenaLRU.h
+bool ArenaLRU::Put(const std::string &key, const std::string &value) { return ArenaLRU::PutExpiring(key, value, 0); }
+
+// See ArenaLRU.h
+bool ArenaLRU::PutIfAbsent(const std::string &key, const std::string &value) {
+    return ArenaLRU::PutIfAbsentExpiring(key, value, 0);
+}
+
+// See ArenaLRU.h
+bool ArenaLRU::Set(const std::string &key, const std::string &value) { return ArenaLRU::SetExpiring(key, value, 0); }
+
+// See ArenaLRU.h
+bool ArenaLRU::Delete(const std::string &key) {
+    reclaim(reclaim_slice);
+    Node *node = lookup(key, _index.Hash(key));
+    if (node == nullptr) {
+        return false;
+    }
+    remove(node);
+    return true;
+}
+
+// See ArenaLRU.h
+bool ArenaLRU::Get(const std::string &key, std::string &value) {
+    Node *node = lookup(key, _index.Hash(key));
+    if (node == nullptr) {
+        return false;
+    }
+    value.assign(node->value(), node->value_size);
+    to_head(node);
+    return true;
+}
+
+// See ArenaLRU.h
+bool ArenaLRU::PutExpiring(const std::string &key, const std::string &value, uint32_t exptime) {
+    reclaim(reclaim_slice);
+    std::size_t hash = _index.Hash(key);
+    Node *node = lookup(key, hash);
+    if (node == nullptr) {
+        return put(key, value, hash, exptime);
+    }
+    return set(node, value, exptime);
+}
+
+// See ArenaLRU.h
+bool ArenaLRU::PutIfAbsentExpiring(const std::string &key, const std::string &value, uint32_t exptime) {
+    reclaim(reclaim_slice);
+    std::size_t hash = _index.Hash(key);
+    if (lookup(key, hash) != nullptr) {
+        return false;
+    }
+    return put(key, value, hash, exptime);
+}
+
+// See ArenaLRU.h
+bool ArenaLRU::SetExpiring(const std::string &key, const std::string &value, uint32_t exptime) {
+    reclaim(reclaim_slice);
+    Node *node = lookup(key, _index.Hash(key));
+    if (node == nullptr) {
+        return false;
+    }
+    return set(node, value, exptime);
+}
+
+// See ArenaLRU.h
+bool ArenaLRU::Touch(const std::string &key, uint32_t exptime) {
+    reclaim(reclaim_slice);
+    Node *node = lookup(key, _index.Hash(key));
+    if (node == nullptr) {
+        return false;
+    }
+    node->exptime = exptime;
+    to_head(node);
+    return true;
+}
+
+// See ArenaLRU.h
+bool ArenaLRU::GetAndTouch(const std::string &key, std::string &value, uint32_t exptime) {
+    reclaim(reclaim_slice);
+    Node *node = lookup(key, _index.Hash(key));
+    if (node == nullptr) {
+        return false;
+    }
+    value.assign(node->value(), node->value_size);
+    node->exptime = exptime;
+    to_head(node);
+    return true;
+}
+
+// See ArenaLRU.h
+bool ArenaLRU::Update(const std::string &key, const Updater &updater) {
+    reclaim(reclaim_slice);
+    Node *node = lookup(key, _index.Hash(key));
+    if (node == nullptr) {
+        return false;
+    }
+    std::string value;
+    uint32_t exptime = node->exptime;
+    if (!updater(node->value(), node->value_size, node->cas, value, exptime)) {
+        return false;
+    }
+    return set(node, value, exptime);
+}
+
+// See ArenaLRU.h
+bool ArenaLRU::GetCas(const std::string &key, Value &value, uint64_t &cas) {
+    Node *node = lookup(key, _index.Hash(key));
+    if (node == nullptr) {
+        return false;
+    }
+    value = Value(std::string(node->value(), node->value_size));
+    cas = node->cas;
+    to_head(node);
+    return true;
+}
+
+// See ArenaLRU.h
+ArenaLRU::CasResult ArenaLRU::CompareAndSwap(const std::string &key, const std::string &value, uint64_t cas,
+                                             uint32_t exptime) {
+    reclaim(reclaim_slice);
+    Node *node = lookup(key, _index.Hash(key));
+    if (node == nullptr) {
+        return CasResult::kNotFound;
+    }
+    if (node->cas != cas) {
+        return CasResult::kExists;
+    }
+    return set(node, value, exptime) ? CasResult::kStored : CasResult::kNotStored;
+}
+
+// See ArenaLRU.h
+void ArenaLRU::Stats(std::vector<std::pair<std::string, std::string>> &stats) {
+    stats.emplace_back("curr_items", std::to_string(_index.Size()));
+    stats.emplace_back("bytes", std::to_string(footprint()));
+    stats.emplace_back("limit_maxbytes", std::to_string(_max_size));
+    stats.emplace_back("index_bytes", std::to_string(_index.MemoryUsage()));
+    stats.emplace_back("evictions", std::to_string(_evictions));
+    stats.emplace_back("arena_available", std::to_string(_arena.available()));
+    stats.emplace_back("arena_defrag_stalls", std::to_string(_defrag_stalls));
+}
+
+void ArenaLRU::push_front(Node *node) {
+    node->prev = nullptr;
+    node->next = _head;
+    if (_head != nullptr) {
+        _head->prev = node;
+    } else {
+        _tail = node;
+    }
+    _head = node;
+}
+
+void ArenaLRU::unlink(Node *node) {
+    if (node->prev != nullptr) {
+        node->prev->next = node->next;
+    } else {
+        _head = node->next;
+    }
+    if (node->next != nullptr) {
+        node->next->prev = node->prev;
+    } else {
+        _tail = node->prev;
+    }
+}
+
+void ArenaLRU::to_head(Node *node) {
+    unlink(node);
+    push_front(node);
+}
+
+ArenaLRU::Node *ArenaLRU::lookup(const std::string &key, std::size_t hash) {
+    Node *node = _index.Find(key, hash);
+    if (node != nullptr && node->Expired()) {
+        remove(node);
+        return nullptr;
+    }
+    return node;
+}
+
+void ArenaLRU::reclaim(std::size_t limit) {
+    Node *node = _tail;
+    for (std::size_t i = 0; i < limit && node != nullptr; i++) {
+        Node *prev = node->prev;
+        if (node->Expired()) {
+            remove(node);
+        }
+        node = prev;
+    }
+}
+
+void ArenaLRU::remove(Node *node) {
+    bool erased = _index.Erase(node, node->hash);
+    assert(erased);
+    unlink(node);
+    _arena.free(node->data);
+    delete node;
+}
+
+bool ArenaLRU::set(Node *node, const std::string &value, uint32_t exptime) {
+    // Node goes first, so that eviction never meets it
+    to_head(node);
+    if (!reserve(node, node->key_size + value.size())) {
+        return false;
+    }
+
+    std::memcpy(node->value(), value.data(), value.size());
+    node->value_size = value.size();
+    node->cas = ++_cas;
+    node->exptime = exptime;
+    compact(value.size());
+    return true;
+}
+
+bool ArenaLRU::put(const std::string &key, const std::string &value, std::size_t hash, uint32_t exptime) {
+    // Node holds no data yet, but the index and the node itself are charged before the data
+    std::unique_ptr<Node> node(new Node());
+    node->hash = hash;
+    node->exptime = exptime;
+    _index.Insert(node.get(), hash);
+    if (!reserve(node.get(), key.size() + value.size())) {
+        _index.Erase(node.get(), hash);
+        return false;
+    }
+
+    node->key_size = key.size();
+    node->value_size = value.size();
+    std::memcpy(node->key(), key.data(), key.size());
+    std::memcpy(node->value(), value.data(), value.size());
+    node->cas = ++_cas;
+    push_front(node.release());
+    compact(key.size() + value.size());
+    return true;
+}
+
+bool ArenaLRU::reserve(Node *node, std::size_t size) {
+    if (size > _max_size) {
+        return false;
+    }
+
+    std::size_t held = node->key_size + node->value_size;
+    std::size_t steps = 0;
+    bool compacted = false;
+    for (;;) {
+        bool fits = footprint() - held + size <= _max_size;
+        if (fits) {
+            try {
+                _arena.realloc(node->data, size);
+                return true;
+            } catch (Allocator::AllocError &) {
+            }
+        }
+
+        // Free space is there, just scattered. Compaction work is bounded as long as there is something
+        // to evict, eviction frees space as well
+        bool last = _tail == nullptr || _tail == node;
+        if (fits && !compacted && (steps < reserve_defrag_steps || last) && _arena.available() >= size) {
+            if (steps++ == 0) {
+                _defrag_stalls++;
+            }
+            compacted = _arena.defrag_step(std::max(defrag_min, defrag_ratio * size));
+            continue;
+        }
+
+        if (last) {
+            return false;
+        }
+        remove(_tail);
+        _evictions++;
+
+        // Space of the evicted item could be next to other free space, one more step might join them
+        steps = std::min(steps, reserve_defrag_steps - 1);
+        compacted = false;
+    }
+}
+
+std::size_t ArenaLRU::footprint() const {
+    return _max_size - _arena.available() + _index.Size() * sizeof(Node) + _index.MemoryUsage();
+}
+
+void ArenaLRU::compact(std::size_t size) { _arena.defrag_step(std::max(defrag_min, defrag_ratio * size)); }
+
+} // namespace Backend
+} // namespace Afina
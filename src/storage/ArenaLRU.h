@@ -0,0 +1,170 @@
+#ifndef AFINA_STORAGE_ARENA_LRU_H
+#define AFINA_STORAGE_ARENA_LRU_H
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <afina/Storage.h>
+#include <afina/allocator/Pointer.h>
+#include <afina/allocator/Simple.h>
+
+#include "HashIndex.h"
+#include "TimingWheel.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # LRU over compacting arena
+ * Keys and values live in a single region allocated on construction and managed by Allocator::Simple,
+ * only list nodes and hash index stay on the heap. Node refers to its data by Allocator::Pointer, so
+ * data could be moved around the region. Value changing its size gets reallocated within the region,
+ * which never grows.
+ *
+ * Region is compacted incrementally: every write moves a bounded amount of data towards the beginning
+ * of region, in proportion to the data written. Write that finds free space scattered does a few more
+ * compaction steps of its own, and evicts items from the tail if that is still not enough, so that no
+ * write ever stops to compact the whole region.
+ *
+ * Expired items are invisible at once. Every write looks at a few items at the tail of LRU list and
+ * removes expired ones, the rest of them go away as they reach the tail.
+ *
+ * Memory of nodes and index is accounted in max_size, write evicts items until data, nodes and index
+ * fit into it together. Arena never gets all of its region then.
+ *
+ * That is NOT thread safe implementaiton!!
+ */
+class ArenaLRU : public Afina::Storage {
+public:
+    ArenaLRU(size_t max_size = 1024);
+    ~ArenaLRU();
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutExpiring(const std::string &key, const std::string &value, uint32_t exptime) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsentExpiring(const std::string &key, const std::string &value, uint32_t exptime) override;
+
+    // Implements Afina::Storage interface
+    bool SetExpiring(const std::string &key, const std::string &value, uint32_t exptime) override;
+
+    // Implements Afina::Storage interface
+    bool Touch(const std::string &key, uint32_t exptime) override;
+
+    // Implements Afina::Storage interface
+    bool GetAndTouch(const std::string &key, std::string &value, uint32_t exptime) override;
+
+    // Implements Afina::Storage interface, key is looked up once
+    bool Update(const std::string &key, const Updater &updater) override;
+
+    // Implements Afina::Storage interface, version is kept in the node, value is copied as by Get
+    bool GetCas(const std::string &key, Value &value, uint64_t &cas) override;
+
+    // Implements Afina::Storage interface, key is looked up once
+    CasResult CompareAndSwap(const std::string &key, const std::string &value, uint64_t cas,
+                             uint32_t exptime) override;
+
+    // Reports memory usage, evictions and compaction work
+    void Stats(std::vector<std::pair<std::string, std::string>> &stats) override;
+
+private:
+    // LRU list node, key followed by value is stored in the arena
+    struct Node {
+        Node *prev;
+        Node *next;
+        std::size_t hash;
+        std::size_t key_size;
+        std::size_t value_size;
+
+        // Version of the value, see Storage::GetCas
+        uint64_t cas;
+
+        // Expiration time, 0 means never
+        uint32_t exptime;
+
+        Allocator::Pointer data;
+
+        bool Expired() const { return exptime != 0 && exptime <= TimingWheel::Now(); }
+
+        char *key() const { return static_cast<char *>(data.get()); }
+        char *value() const { return key() + key_size; }
+    };
+
+    // Tells HashIndex how to deal with nodes
+    struct node_traits {
+        static bool Equal(const Node *node, const std::string &key) {
+            return node->key_size == key.size() && key.compare(0, key.size(), node->key(), node->key_size) == 0;
+        }
+        static std::size_t Hash(const Node *node) { return node->hash; }
+    };
+
+    void push_front(Node *node);
+    void unlink(Node *node);
+
+    // Moves node to the head of the list
+    void to_head(Node *node);
+
+    // Returns node for the key, expired one is removed and never returned
+    Node *lookup(const std::string &key, std::size_t hash);
+
+    // Looks at up to limit nodes at the tail of the list and removes expired ones
+    void reclaim(std::size_t limit);
+
+    // Removes node from list and index, its data goes back to arena
+    void remove(Node *node);
+
+    // Updates value of existing node
+    bool set(Node *node, const std::string &value, uint32_t exptime);
+
+    // Stores new association
+    bool put(const std::string &key, const std::string &value, std::size_t hash, uint32_t exptime);
+
+    // Allocates or resizes data block, evicting items unless node is the only one left. Node must be in
+    // the index already. Returns false if there is no room even then
+    bool reserve(Node *node, std::size_t size);
+
+    // Number of bytes taken by data in arena, nodes and index
+    std::size_t footprint() const;
+
+    // Does portion of compaction work for the size bytes written
+    void compact(std::size_t size);
+
+    const std::size_t _max_size;
+
+    std::unique_ptr<char[]> _region;
+    Allocator::Simple _arena;
+
+    // Most recently used node goes first
+    Node *_head = nullptr;
+    Node *_tail = nullptr;
+
+    HashIndex<Node, node_traits> _index;
+
+    // Last version given to a node
+    uint64_t _cas = 0;
+
+    std::size_t _evictions = 0;
+    std::size_t _defrag_stalls = 0;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_ARENA_LRU_H
@@ -0,0 +1,49 @@
+#include "AsyncStorage.h"
+
+namespace Afina {
+namespace Backend {
+
+AsyncStorage::AsyncStorage(std::shared_ptr<Afina::Storage> storage, std::size_t threads, std::size_t max_queue)
+    : _storage(std::move(storage)), _executor(threads, threads, max_queue, std::chrono::milliseconds(1000)),
+      _pending(0), _completed(0), _inline(0) {}
+
+// See AsyncStorage.h
+void AsyncStorage::Start() {
+    _storage->Start();
+    _executor.Start();
+}
+
+// See AsyncStorage.h
+void AsyncStorage::Stop() {
+    _executor.Stop(true);
+    _storage->Stop();
+}
+
+// See AsyncStorage.h
+void AsyncStorage::Async(Operation operation, std::function<void()> done) {
+    _pending++;
+    bool queued = _executor.Execute([this, operation, done]() {
+        operation(*_storage);
+        _pending--;
+        _completed++;
+        done();
+    });
+    if (!queued) {
+        _inline++;
+        operation(*_storage);
+        _pending--;
+        _completed++;
+        done();
+    }
+}
+
+// See AsyncStorage.h
+void AsyncStorage::Stats(std::vector<std::pair<std::string, std::string>> &stats) {
+    _storage->Stats(stats);
+    stats.emplace_back("async_pending", std::to_string(_pending.load()));
+    stats.emplace_back("async_completed", std::to_string(_completed.load()));
+    stats.emplace_back("async_inline", std::to_string(_inline.load()));
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,138 @@
+#ifndef AFINA_STORAGE_ASYNC_STORAGE_H
+#define AFINA_STORAGE_ASYNC_STORAGE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <afina/Storage.h>
+#include <afina/concurrency/Executor.h>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Storage with asynchronous operations
+ * Wraps thread safe storage and runs operations passed to Async on a pool of its own threads, so that
+ * network thread could park the connection and keep serving other ones while operation waits for the
+ * storage. Operation runs on the wrapped storage, done is called on the pool thread right after it.
+ *
+ * Once the queue is full or the pool is stopped, operation runs on the calling thread as if storage was
+ * synchronous, so the caller is slowed down instead of losing the operation. Other methods go straight
+ * to the wrapped storage.
+ */
+class AsyncStorage : public Afina::Storage {
+public:
+    /**
+     * @param storage to wrap, must be thread safe
+     * @param threads number of threads running operations
+     * @param max_queue number of operations waiting for a thread, next ones run on the caller thread
+     */
+    AsyncStorage(std::shared_ptr<Afina::Storage> storage, std::size_t threads, std::size_t max_queue = 1024);
+    ~AsyncStorage() {}
+
+    // Starts wrapped storage and the pool
+    void Start() override;
+
+    // Waits for all operations started to finish, then stops wrapped storage
+    void Stop() override;
+
+    // Implements Afina::Storage interface
+    void Async(Operation operation, std::function<void()> done) override;
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override { return _storage->Put(key, value); }
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override {
+        return _storage->PutIfAbsent(key, value);
+    }
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override { return _storage->Set(key, value); }
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override { return _storage->Delete(key); }
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override { return _storage->Get(key, value); }
+
+    // Implements Afina::Storage interface
+    bool GetValue(const std::string &key, Value &value) override { return _storage->GetValue(key, value); }
+
+    // Implements Afina::Storage interface
+    std::size_t MultiGet(const std::vector<std::string> &keys, std::vector<Value> &values) override {
+        return _storage->MultiGet(keys, values);
+    }
+
+    // Implements Afina::Storage interface
+    bool PutExpiring(const std::string &key, const std::string &value, uint32_t exptime) override {
+        return _storage->PutExpiring(key, value, exptime);
+    }
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsentExpiring(const std::string &key, const std::string &value, uint32_t exptime) override {
+        return _storage->PutIfAbsentExpiring(key, value, exptime);
+    }
+
+    // Implements Afina::Storage interface
+    bool SetExpiring(const std::string &key, const std::string &value, uint32_t exptime) override {
+        return _storage->SetExpiring(key, value, exptime);
+    }
+
+    // Implements Afina::Storage interface
+    bool Touch(const std::string &key, uint32_t exptime) override { return _storage->Touch(key, exptime); }
+
+    // Implements Afina::Storage interface
+    bool GetAndTouch(const std::string &key, std::string &value, uint32_t exptime) override {
+        return _storage->GetAndTouch(key, value, exptime);
+    }
+
+    // Implements Afina::Storage interface
+    bool Update(const std::string &key, const Updater &updater) override { return _storage->Update(key, updater); }
+
+    // Implements Afina::Storage interface
+    bool GetCas(const std::string &key, Value &value, uint64_t &cas) override {
+        return _storage->GetCas(key, value, cas);
+    }
+
+    // Implements Afina::Storage interface
+    CasResult CompareAndSwap(const std::string &key, const std::string &value, uint64_t cas,
+                             uint32_t exptime) override {
+        return _storage->CompareAndSwap(key, value, cas, exptime);
+    }
+
+    // Implements Afina::Storage interface
+    bool Append(const std::string &key, const std::string &data) override { return _storage->Append(key, data); }
+
+    // Implements Afina::Storage interface
+    bool Prepend(const std::string &key, const std::string &data) override { return _storage->Prepend(key, data); }
+
+    // Implements Afina::Storage interface
+    bool ForEach(const Visitor &visitor) override { return _storage->ForEach(visitor); }
+
+    // Implements Afina::Storage interface
+    void Freeze(const std::function<void()> &action) override { _storage->Freeze(action); }
+
+    // Implements Afina::Storage interface, pool statistics follow ones of the wrapped storage
+    void Stats(std::vector<std::pair<std::string, std::string>> &stats) override;
+
+private:
+    std::shared_ptr<Afina::Storage> _storage;
+    Afina::Concurrency::Executor _executor;
+
+    // Statistics
+    std::atomic<std::size_t> _pending;
+    std::atomic<std::size_t> _completed;
+    std::atomic<std::size_t> _inline;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_ASYNC_STORAGE_H
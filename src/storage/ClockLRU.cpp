@@ -0,0 +1,416 @@
+#include "ClockLRU.h"
+
+#include <cassert>
+#include <mutex>
+
+namespace Afina {
+namespace Backend {
+
+namespace {
+
+// Maximum number of expired items reclaimed by a single write operation, see SimpleLRU
+const std::size_t reclaim_slice = 8;
+
+// Number of keys batch lookup prefetches index memory ahead for
+const std::size_t prefetch_distance = 8;
+
+} // namespace
+
+ClockLRU::~ClockLRU() {
+    _index.Clear();
+    while (_hand != nullptr) {
+        Item *item = _hand;
+        unlink(item);
+        Item::Destroy(item);
+    }
+}
+
+// See ClockLRU.h
+bool ClockLRU::Put(const std::string &key, const std::string &value) { return ClockLRU::PutExpiring(key, value, 0); }
+
+// See ClockLRU.h
+bool ClockLRU::PutIfAbsent(const std::string &key, const std::string &value) {
+    return ClockLRU::PutIfAbsentExpiring(key, value, 0);
+}
+
+// See ClockLRU.h
+bool ClockLRU::Set(const std::string &key, const std::string &value) { return ClockLRU::SetExpiring(key, value, 0); }
+
+// See ClockLRU.h
+bool ClockLRU::Delete(const std::string &key) {
+    std::size_t hash = _index.Hash(key);
+    std::lock_guard<Concurrency::SharedMutex> lock(_lock);
+    reclaim(reclaim_slice);
+    Item *item = lookup(key, hash);
+    if (item == nullptr) {
+        return false;
+    }
+    remove(item);
+    return true;
+}
+
+// See ClockLRU.h
+bool ClockLRU::Get(const std::string &key, std::string &value) {
+    std::size_t hash = _index.Hash(key);
+    Concurrency::SharedLock lock(_lock);
+    Item *item = find(key, hash);
+    if (item == nullptr) {
+        return false;
+    }
+    value.assign(item->value(), item->value_size);
+    return true;
+}
+
+// See ClockLRU.h
+bool ClockLRU::GetValue(const std::string &key, Value &value) {
+    std::size_t hash = _index.Hash(key);
+    Concurrency::SharedLock lock(_lock);
+    Item *item = find(key, hash);
+    if (item == nullptr) {
+        return false;
+    }
+    value = item->Share();
+    return true;
+}
+
+// See ClockLRU.h
+std::size_t ClockLRU::MultiGet(const std::vector<std::string> &keys, std::vector<Value> &values) {
+    std::vector<std::size_t> hashes(keys.size());
+    for (std::size_t i = 0; i < keys.size(); i++) {
+        hashes[i] = _index.Hash(keys[i]);
+    }
+    values.clear();
+    values.resize(keys.size());
+
+    std::size_t found = 0;
+    Concurrency::SharedLock lock(_lock);
+    for (std::size_t i = 0; i < keys.size() && i < prefetch_distance; i++) {
+        _index.Prefetch(hashes[i]);
+    }
+    for (std::size_t i = 0; i < keys.size(); i++) {
+        if (i + prefetch_distance < keys.size()) {
+            _index.Prefetch(hashes[i + prefetch_distance]);
+        }
+        Item *item = find(keys[i], hashes[i]);
+        if (item != nullptr) {
+            values[i] = item->Share();
+            found++;
+        }
+    }
+    return found;
+}
+
+// See ClockLRU.h
+bool ClockLRU::PutExpiring(const std::string &key, const std::string &value, uint32_t exptime) {
+    if (Item::Footprint(key.size(), value.size()) > _max_size) {
+        return false;
+    }
+    std::size_t hash = _index.Hash(key);
+    std::lock_guard<Concurrency::SharedMutex> lock(_lock);
+    reclaim(reclaim_slice);
+    Item *item = lookup(key, hash);
+    if (item == nullptr) {
+        return put(key, value, hash, exptime);
+    }
+    return set(item, value, exptime);
+}
+
+// See ClockLRU.h
+bool ClockLRU::PutIfAbsentExpiring(const std::string &key, const std::string &value, uint32_t exptime) {
+    if (Item::Footprint(key.size(), value.size()) > _max_size) {
+        return false;
+    }
+    std::size_t hash = _index.Hash(key);
+    std::lock_guard<Concurrency::SharedMutex> lock(_lock);
+    reclaim(reclaim_slice);
+    if (lookup(key, hash) != nullptr) {
+        return false;
+    }
+    return put(key, value, hash, exptime);
+}
+
+// See ClockLRU.h
+bool ClockLRU::SetExpiring(const std::string &key, const std::string &value, uint32_t exptime) {
+    if (Item::Footprint(key.size(), value.size()) > _max_size) {
+        return false;
+    }
+    std::size_t hash = _index.Hash(key);
+    std::lock_guard<Concurrency::SharedMutex> lock(_lock);
+    reclaim(reclaim_slice);
+    Item *item = lookup(key, hash);
+    if (item == nullptr) {
+        return false;
+    }
+    return set(item, value, exptime);
+}
+
+// See ClockLRU.h
+bool ClockLRU::Touch(const std::string &key, uint32_t exptime) {
+    std::size_t hash = _index.Hash(key);
+    std::lock_guard<Concurrency::SharedMutex> lock(_lock);
+    reclaim(reclaim_slice);
+    Item *item = lookup(key, hash);
+    if (item == nullptr) {
+        return false;
+    }
+    expire(item, exptime);
+    item->mark.store(1, std::memory_order_relaxed);
+    return true;
+}
+
+// See ClockLRU.h
+bool ClockLRU::GetAndTouch(const std::string &key, std::string &value, uint32_t exptime) {
+    std::size_t hash = _index.Hash(key);
+    std::lock_guard<Concurrency::SharedMutex> lock(_lock);
+    reclaim(reclaim_slice);
+    Item *item = lookup(key, hash);
+    if (item == nullptr) {
+        return false;
+    }
+    value.assign(item->value(), item->value_size);
+    expire(item, exptime);
+    item->mark.store(1, std::memory_order_relaxed);
+    return true;
+}
+
+// See ClockLRU.h
+bool ClockLRU::Update(const std::string &key, const Updater &updater) {
+    std::size_t hash = _index.Hash(key);
+    std::lock_guard<Concurrency::SharedMutex> lock(_lock);
+    reclaim(reclaim_slice);
+    Item *item = lookup(key, hash);
+    if (item == nullptr) {
+        return false;
+    }
+    std::string value;
+    uint32_t exptime = item->exptime;
+    if (!updater(item->value(), item->value_size, item->cas, value, exptime) ||
+        Item::Footprint(key.size(), value.size()) > _max_size) {
+        return false;
+    }
+    return set(item, value, exptime);
+}
+
+// See ClockLRU.h
+bool ClockLRU::GetCas(const std::string &key, Value &value, uint64_t &cas) {
+    std::size_t hash = _index.Hash(key);
+    Concurrency::SharedLock lock(_lock);
+    Item *item = find(key, hash);
+    if (item == nullptr) {
+        return false;
+    }
+    value = item->Share();
+    cas = item->cas;
+    return true;
+}
+
+// See ClockLRU.h
+ClockLRU::CasResult ClockLRU::CompareAndSwap(const std::string &key, const std::string &value, uint64_t cas,
+                                             uint32_t exptime) {
+    std::size_t hash = _index.Hash(key);
+    std::lock_guard<Concurrency::SharedMutex> lock(_lock);
+    reclaim(reclaim_slice);
+    Item *item = lookup(key, hash);
+    if (item == nullptr) {
+        return CasResult::kNotFound;
+    }
+    if (item->cas != cas) {
+        return CasResult::kExists;
+    }
+    if (Item::Footprint(key.size(), value.size()) > _max_size) {
+        return CasResult::kNotStored;
+    }
+    return set(item, value, exptime) ? CasResult::kStored : CasResult::kNotStored;
+}
+
+// See ClockLRU.h
+void ClockLRU::Stats(std::vector<std::pair<std::string, std::string>> &stats) {
+    Concurrency::SharedLock lock(_lock);
+    std::size_t items = _index.Size();
+    stats.emplace_back("curr_items", std::to_string(items));
+    stats.emplace_back("bytes", std::to_string(_curr_size));
+    stats.emplace_back("limit_maxbytes", std::to_string(_max_size));
+    stats.emplace_back("payload_bytes", std::to_string(_payload_size));
+    stats.emplace_back("index_bytes", std::to_string(_index.MemoryUsage()));
+    stats.emplace_back("overhead_per_item", std::to_string(items > 0 ? (_curr_size - _payload_size) / items : 0));
+    stats.emplace_back("evictions", std::to_string(_evictions));
+}
+
+// See ClockLRU.h
+bool ClockLRU::Append(const std::string &key, const std::string &data) { return concat(key, data, false); }
+
+// See ClockLRU.h
+bool ClockLRU::Prepend(const std::string &key, const std::string &data) { return concat(key, data, true); }
+
+void ClockLRU::link(Item *item) {
+    if (_hand == nullptr) {
+        item->prev = item->next = item;
+        _hand = item;
+    } else {
+        item->next = _hand;
+        item->prev = _hand->prev;
+        _hand->prev->next = item;
+        _hand->prev = item;
+    }
+}
+
+void ClockLRU::unlink(Item *item) {
+    if (item->next == item) {
+        _hand = nullptr;
+        return;
+    }
+    if (_hand == item) {
+        _hand = item->next;
+    }
+    item->prev->next = item->next;
+    item->next->prev = item->prev;
+}
+
+void ClockLRU::reclaim(std::size_t limit) {
+    uint32_t now = TimingWheel::Now();
+    Item *item;
+    for (std::size_t i = 0; i < limit && (item = _timers.Expired(now)) != nullptr; i++) {
+        remove(item);
+    }
+}
+
+Item *ClockLRU::lookup(const std::string &key, std::size_t hash) {
+    Item *item = _index.Find(key, hash);
+    if (item != nullptr && TimingWheel::Expired(item)) {
+        remove(item);
+        return nullptr;
+    }
+    return item;
+}
+
+Item *ClockLRU::find(const std::string &key, std::size_t hash) const {
+    Item *item = _index.Find(key, hash);
+    if (item == nullptr || TimingWheel::Expired(item)) {
+        return nullptr;
+    }
+    // Avoid dirtying cache line of hot items over and over again
+    if (!item->mark.load(std::memory_order_relaxed)) {
+        item->mark.store(1, std::memory_order_relaxed);
+    }
+    return item;
+}
+
+void ClockLRU::remove(Item *item) {
+    bool erased = _index.Erase(item, item->hash);
+    assert(erased);
+    unlink(item);
+    _timers.Cancel(item);
+    _curr_size -= item->Footprint();
+    _payload_size -= item->key_size + item->value_size;
+    Item::Destroy(item);
+}
+
+void ClockLRU::expire(Item *item, uint32_t exptime) {
+    _timers.Cancel(item);
+    item->exptime = exptime;
+    if (exptime != 0) {
+        _timers.Schedule(item);
+    }
+}
+
+void ClockLRU::evict(std::size_t size) {
+    while (_curr_size + size > _max_size) {
+        assert(_hand != nullptr);
+        Item *item = _hand;
+        if (item->mark.load(std::memory_order_relaxed) && !TimingWheel::Expired(item)) {
+            item->mark.store(0, std::memory_order_relaxed);
+            _hand = item->next;
+        } else {
+            remove(item);
+            _evictions++;
+        }
+    }
+}
+
+bool ClockLRU::set(Item *item, const std::string &value, uint32_t exptime) {
+    item->mark.store(1, std::memory_order_relaxed);
+    if (item->FitsInPlace(value.size()) && !item->Shared()) {
+        _payload_size += value.size() - item->value_size;
+        item->SetValue(value);
+        item->cas = ++_cas;
+        expire(item, exptime);
+        return true;
+    }
+    return replace(item, Item::Create(item->key(), item->key_size, value.data(), value.size(), item->hash), exptime);
+}
+
+bool ClockLRU::replace(Item *item, Item *new_item, uint32_t exptime) {
+    std::size_t old_footprint = item->Footprint();
+    std::size_t new_footprint = new_item->Footprint();
+    if (new_footprint > _max_size) {
+        Item::Destroy(new_item);
+        return false;
+    }
+
+    // Take item out of the circle, so that the hand can't evict it while making space for the new value
+    unlink(item);
+    if (new_footprint > old_footprint) {
+        evict(new_footprint - old_footprint);
+    }
+
+    new_item->flags = item->flags;
+    new_item->cas = ++_cas;
+    new_item->mark.store(1, std::memory_order_relaxed);
+    _index.Replace(item, new_item, item->hash);
+    link(new_item);
+    _timers.Cancel(item);
+    expire(new_item, exptime);
+    _curr_size += new_footprint - old_footprint;
+    _payload_size += new_item->value_size - item->value_size;
+    Item::Destroy(item);
+    return true;
+}
+
+bool ClockLRU::concat(const std::string &key, const std::string &data, bool prepend) {
+    std::size_t hash = _index.Hash(key);
+    std::lock_guard<Concurrency::SharedMutex> lock(_lock);
+    reclaim(reclaim_slice);
+    Item *item = lookup(key, hash);
+    if (item == nullptr) {
+        return false;
+    }
+    std::size_t value_size = item->value_size + data.size();
+    if (Item::Footprint(item->key_size, value_size) > _max_size) {
+        return false;
+    }
+    item->mark.store(1, std::memory_order_relaxed);
+    if (item->Fits(value_size) && !item->Shared()) {
+        item->ConcatValue(data.data(), data.size(), prepend);
+        item->cas = ++_cas;
+        _payload_size += data.size();
+        return true;
+    }
+
+    // Spare space as large as the value is reserved for following concatenations, see SimpleLRU
+    std::size_t reserve = 2 * value_size;
+    if (Item::Footprint(item->key_size, reserve) > _max_size) {
+        reserve = value_size;
+    }
+    return replace(item, Item::Concat(item, data.data(), data.size(), prepend, reserve), item->exptime);
+}
+
+bool ClockLRU::put(const std::string &key, const std::string &value, std::size_t hash, uint32_t exptime) {
+    Item *item = Item::Create(key, value, hash);
+    std::size_t footprint = item->Footprint();
+    if (footprint > _max_size) {
+        Item::Destroy(item);
+        return false;
+    }
+    evict(footprint);
+
+    item->cas = ++_cas;
+    _index.Insert(item, hash);
+    link(item);
+    expire(item, exptime);
+    _curr_size += footprint;
+    _payload_size += key.size() + value.size();
+    return true;
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,171 @@
+#ifndef AFINA_STORAGE_CLOCK_LRU_H
+#define AFINA_STORAGE_CLOCK_LRU_H
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <afina/Storage.h>
+#include <afina/concurrency/SharedMutex.h>
+
+#include "HashIndex.h"
+#include "Item.h"
+#include "TimingWheel.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # CLOCK approximation of LRU
+ * Items are kept in a circular list swept by the clock hand. Hit on an item only sets its reference
+ * bit, so Get changes no shared structure and runs under shared lock concurrently with other reads.
+ * Writes take the lock exclusively.
+ *
+ * When space is needed hand moves over the circle: referenced item gets its bit cleared and a second
+ * chance, not referenced one is evicted. New items are inserted just behind the hand, so they get the
+ * whole turn to be referenced.
+ *
+ * Values are shared with readers by GetValue and MultiGet, so item referenced by a handle is never
+ * changed in place, new value gets a new item.
+ *
+ * Expired items are invisible to reads at once, writes remove them from the index and reclaim a small
+ * slice of them ordered by the timing wheel, same as SimpleLRU does. Hand evicts expired item without
+ * giving it a second chance.
+ */
+class ClockLRU : public Afina::Storage {
+public:
+    ClockLRU(size_t max_size = 1024) : _max_size(max_size), _timers(TimingWheel::Now()) {}
+    ~ClockLRU();
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override;
+
+    // Implements Afina::Storage interface, value is shared rather than copied
+    bool GetValue(const std::string &key, Value &value) override;
+
+    // Implements Afina::Storage interface, whole batch is looked up under a single shared lock
+    std::size_t MultiGet(const std::vector<std::string> &keys, std::vector<Value> &values) override;
+
+    // Implements Afina::Storage interface
+    bool PutExpiring(const std::string &key, const std::string &value, uint32_t exptime) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsentExpiring(const std::string &key, const std::string &value, uint32_t exptime) override;
+
+    // Implements Afina::Storage interface
+    bool SetExpiring(const std::string &key, const std::string &value, uint32_t exptime) override;
+
+    // Implements Afina::Storage interface, takes the lock exclusively
+    bool Touch(const std::string &key, uint32_t exptime) override;
+
+    // Implements Afina::Storage interface, takes the lock exclusively
+    bool GetAndTouch(const std::string &key, std::string &value, uint32_t exptime) override;
+
+    // Implements Afina::Storage interface, key is looked up once under exclusive lock
+    bool Update(const std::string &key, const Updater &updater) override;
+
+    // Implements Afina::Storage interface, version is kept in the item, value is shared as by GetValue
+    bool GetCas(const std::string &key, Value &value, uint64_t &cas) override;
+
+    // Implements Afina::Storage interface, key is looked up once under exclusive lock
+    CasResult CompareAndSwap(const std::string &key, const std::string &value, uint64_t cas,
+                             uint32_t exptime) override;
+
+    // Implements Afina::Storage interface, value grows in place while there is spare capacity
+    bool Append(const std::string &key, const std::string &data) override;
+
+    // Implements Afina::Storage interface, value grows in place while there is spare capacity
+    bool Prepend(const std::string &key, const std::string &data) override;
+
+    // Reports memory usage as SimpleLRU does, and evictions. Reads don't count hits, so that they write
+    // nothing shared
+    void Stats(std::vector<std::pair<std::string, std::string>> &stats) override;
+
+private:
+    // Tells HashIndex how to deal with items
+    struct item_traits {
+        static bool Equal(const Item *item, const std::string &key) { return item->KeyEquals(key); }
+        static std::size_t Hash(const Item *item) { return item->hash; }
+    };
+
+    // Inserts item into the circle just behind the hand
+    void link(Item *item);
+
+    // Removes item from the circle, moving hand forward if it points to the item
+    void unlink(Item *item);
+
+    // Removes at most limit expired items. Call only under exclusive lock
+    void reclaim(std::size_t limit);
+
+    // Returns item for the key, expired one is removed and never returned. Call only under exclusive lock
+    Item *lookup(const std::string &key, std::size_t hash);
+
+    // Returns item for the key unless it is expired, marks it referenced. Could be called under shared lock
+    Item *find(const std::string &key, std::size_t hash) const;
+
+    // Removes item from the circle, index and timing wheel, and releases its memory
+    void remove(Item *item);
+
+    // Changes expiration time of the item. Call only under exclusive lock
+    void expire(Item *item, uint32_t exptime);
+
+    // Sweeps the hand until there is enough space for the given number of bytes
+    void evict(std::size_t size);
+
+    // Updates existing association, returns false if the new value doesn't fit. Call only under exclusive
+    // lock
+    bool set(Item *item, const std::string &value, uint32_t exptime);
+
+    // Replaces item by the new one with the same key, returns false and destroys the new item if it
+    // doesn't fit. Call only under exclusive lock
+    bool replace(Item *item, Item *new_item, uint32_t exptime);
+
+    // Adds data to the value of existing association, see Append and Prepend
+    bool concat(const std::string &key, const std::string &data, bool prepend);
+
+    // Stores new association, returns false if it doesn't fit. Call only under exclusive lock
+    bool put(const std::string &key, const std::string &value, std::size_t hash, uint32_t exptime);
+
+    // Maximum number of bytes could be stored in this cache, see SimpleLRU
+    const std::size_t _max_size;
+
+    // Number of bytes storing in the cache
+    std::size_t _curr_size = 0;
+
+    // Number of key and value bytes, the rest of _curr_size is overhead
+    std::size_t _payload_size = 0;
+
+    std::size_t _evictions = 0;
+
+    // Last version given to an item. Call only under exclusive lock
+    uint64_t _cas = 0;
+
+    // Clock hand, next item to check for eviction. Circle owns all items
+    Item *_hand = nullptr;
+
+    // Index of items from the circle above
+    HashIndex<Item, item_traits> _index;
+
+    // Items having expiration time, ordered by it
+    TimingWheel _timers;
+
+    // Get holds it shared, everything else exclusively
+    Concurrency::SharedMutex _lock;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_CLOCK_LRU_H
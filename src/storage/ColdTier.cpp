@@ -0,0 +1,256 @@
+#include "ColdTier.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "TimingWheel.h"
+
+namespace Afina {
+namespace Backend {
+
+namespace {
+
+// Bounds of the segment size, file is split into 16 segments when possible
+const std::size_t min_segment_size = 4 * 1024;
+const std::size_t max_segment_size = 16 * 1024 * 1024;
+
+// Batch is written once it exceeds that size
+const std::size_t max_batch_size = 1024 * 1024;
+
+bool expired(uint32_t exptime) { return exptime != 0 && exptime <= TimingWheel::Now(); }
+
+} // namespace
+
+ColdTier::ColdTier(const std::string &path, std::size_t max_size)
+    : _path(path), _head(0), _batch_offset(0), _batch_first(0), _bytes(0), _hits(0), _writes(0), _dropped(0),
+      _errors(0) {
+    _segment_size = std::min(max_segment_size, std::max(min_segment_size, max_size / 16));
+    _segments = std::max<std::size_t>(2, max_size / _segment_size);
+    _batch_size = std::min(max_batch_size, _segment_size / 4);
+    _segment_end = _segment_size;
+    _segment_hashes.resize(_segments);
+
+    _fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (_fd < 0) {
+        throw std::runtime_error("Failed to create " + path + ": " + std::strerror(errno));
+    }
+    _batch.reserve(_batch_size + _segment_size / 4);
+}
+
+ColdTier::~ColdTier() {
+    ::close(_fd);
+    ::unlink(_path.c_str());
+}
+
+// See ColdTier.h
+bool ColdTier::Add(const Item *item) {
+    std::size_t size = sizeof(RecordHeader) + item->key_size + item->value_size;
+    if (size > _segment_size) {
+        return false;
+    }
+    if (_head + size > _segment_end) {
+        next_segment();
+    }
+
+    RecordHeader header = {item->key_size, item->value_size, item->exptime};
+    _batch.append(reinterpret_cast<const char *>(&header), sizeof(header));
+    _batch.append(item->key(), item->key_size);
+    _batch.append(item->value(), item->value_size);
+
+    auto it = _index.find(item->hash);
+    if (it != _index.end()) {
+        erase(it);
+    }
+    _index.emplace(item->hash, Location{_head, uint32_t(size), item->exptime});
+    _segment_hashes[(_head / _segment_size) % _segments].push_back(item->hash);
+    _bytes += size;
+    _head += size;
+
+    if (_batch.size() >= _batch_size) {
+        flush();
+    }
+    return true;
+}
+
+// See ColdTier.h
+bool ColdTier::Take(const std::string &key, std::size_t hash, std::string &value, uint32_t &exptime) {
+    auto it = _index.find(hash);
+    if (it == _index.end()) {
+        return false;
+    }
+    if (expired(it->second.exptime)) {
+        erase(it);
+        return false;
+    }
+
+    std::string record;
+    if (!read(it->second, key, record)) {
+        return false;
+    }
+    RecordHeader header;
+    std::memcpy(&header, record.data(), sizeof(header));
+    value.assign(record, sizeof(header) + header.key_size, header.value_size);
+    exptime = header.exptime;
+    erase(it);
+    _hits++;
+    return true;
+}
+
+// See ColdTier.h
+bool ColdTier::Erase(const std::string &key, std::size_t hash) {
+    auto it = _index.find(hash);
+    if (it == _index.end()) {
+        return false;
+    }
+    std::string record;
+    if (!read(it->second, key, record)) {
+        return false;
+    }
+    bool alive = !expired(it->second.exptime);
+    erase(it);
+    return alive;
+}
+
+// See ColdTier.h
+void ColdTier::Forget(std::size_t hash) {
+    auto it = _index.find(hash);
+    if (it != _index.end()) {
+        erase(it);
+    }
+}
+
+// See ColdTier.h
+void ColdTier::ForEach(const Afina::Storage::Visitor &visitor) {
+    std::vector<Location> locations;
+    locations.reserve(_index.size());
+    for (auto &entry : _index) {
+        if (!expired(entry.second.exptime)) {
+            locations.push_back(entry.second);
+        }
+    }
+    std::sort(locations.begin(), locations.end(),
+              [](const Location &a, const Location &b) { return a.offset < b.offset; });
+
+    std::string record;
+    for (const Location &location : locations) {
+        if (!load(location, record)) {
+            continue;
+        }
+        RecordHeader header;
+        std::memcpy(&header, record.data(), sizeof(header));
+        const char *key = record.data() + sizeof(header);
+        visitor(key, header.key_size, key + header.key_size, header.value_size, header.exptime);
+    }
+}
+
+// See ColdTier.h
+void ColdTier::Stats(std::vector<std::pair<std::string, std::string>> &stats) const {
+    stats.emplace_back("cold_items", std::to_string(_index.size()));
+    stats.emplace_back("cold_bytes", std::to_string(_bytes));
+    stats.emplace_back("cold_hits", std::to_string(_hits));
+    stats.emplace_back("cold_writes", std::to_string(_writes));
+    stats.emplace_back("cold_dropped", std::to_string(_dropped));
+    stats.emplace_back("cold_errors", std::to_string(_errors));
+}
+
+bool ColdTier::load(const Location &location, std::string &record) {
+    record.resize(location.size);
+    if (location.offset >= _batch_offset) {
+        std::memcpy(&record[0], _batch.data() + (location.offset - _batch_offset), location.size);
+        return true;
+    }
+
+    off_t position = location.offset % (_segments * _segment_size);
+    for (std::size_t done = 0; done < location.size;) {
+        ssize_t n = ::pread(_fd, &record[done], location.size - done, position + done);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n <= 0) {
+            _errors++;
+            return false;
+        }
+        done += n;
+    }
+    return true;
+}
+
+bool ColdTier::read(const Location &location, const std::string &key, std::string &record) {
+    if (!load(location, record)) {
+        return false;
+    }
+    RecordHeader header;
+    std::memcpy(&header, record.data(), sizeof(header));
+    return header.key_size == key.size() && std::memcmp(record.data() + sizeof(header), key.data(), key.size()) == 0;
+}
+
+void ColdTier::erase(std::unordered_map<std::size_t, Location>::iterator it) {
+    _bytes -= it->second.size;
+    _index.erase(it);
+}
+
+void ColdTier::next_segment() {
+    flush();
+    _head = _segment_end;
+    _segment_end += _segment_size;
+    _batch_offset = _head;
+
+    // Items of the previous lap are lost once the segment gets overwritten
+    std::vector<std::size_t> &hashes = _segment_hashes[(_head / _segment_size) % _segments];
+    for (std::size_t hash : hashes) {
+        auto it = _index.find(hash);
+        if (it != _index.end() && it->second.offset < _head &&
+            (it->second.offset / _segment_size) % _segments == (_head / _segment_size) % _segments) {
+            erase(it);
+            _dropped++;
+        }
+    }
+    hashes.clear();
+    _batch_first = 0;
+}
+
+void ColdTier::flush() {
+    if (_batch.empty()) {
+        return;
+    }
+
+    // Batch never crosses segment boundary, so it is written at once
+    off_t position = _batch_offset % (_segments * _segment_size);
+    const char *data = _batch.data();
+    std::size_t size = _batch.size();
+    while (size > 0) {
+        ssize_t written = ::pwrite(_fd, data, size, position);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        } else if (written < 0) {
+            break;
+        }
+        data += written;
+        size -= written;
+        position += written;
+    }
+
+    std::vector<std::size_t> &hashes = _segment_hashes[(_batch_offset / _segment_size) % _segments];
+    if (size > 0) {
+        // Items of the batch are lost
+        for (std::size_t i = _batch_first; i < hashes.size(); i++) {
+            auto it = _index.find(hashes[i]);
+            if (it != _index.end() && it->second.offset >= _batch_offset) {
+                erase(it);
+            }
+        }
+        _errors++;
+    }
+
+    _writes++;
+    _batch_first = hashes.size();
+    _batch_offset = _head;
+    _batch.clear();
+}
+
+} // namespace Backend
+} // namespace Afina
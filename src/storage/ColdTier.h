@@ -0,0 +1,136 @@
+#ifndef AFINA_STORAGE_COLD_TIER_H
+#define AFINA_STORAGE_COLD_TIER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <afina/Storage.h>
+
+#include "Item.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # File backed second tier of the storage
+ * Keeps items evicted from memory in a file of fixed size, so that they could be brought back on the
+ * next access instead of being lost. File is written as a circular log split into segments: evicted
+ * items are collected in memory and written with a single sequential write once the batch is large
+ * enough. When log wraps around, segment about to be overwritten is dropped with all items still
+ * living in it, so the cold tier evicts in FIFO order.
+ *
+ * Only the index is kept in memory, it maps key hash to the record location and costs a few dozen
+ * bytes per item whatever the item size is. Keys with the same hash share an index entry, so storing
+ * one of them drops the other one, which only makes it a miss. Record is read with a single pread and
+ * its key is checked against the requested one.
+ *
+ * Item lives in a single tier at a time: Take removes it from the cold tier, and storage must Forget
+ * the key when it stores a new one. File is created on construction and removed on destruction, its
+ * content isn't meant to survive restart. That is NOT thread safe implementation
+ */
+class ColdTier {
+public:
+    /**
+     * @param path of the file to create
+     * @param max_size of the file in bytes
+     * @throw std::runtime_error if file could not be created
+     */
+    ColdTier(const std::string &path, std::size_t max_size);
+    ~ColdTier();
+
+    /**
+     * Stores copy of the item evicted from memory, returns false if it doesn't fit into a segment
+     */
+    bool Add(const Item *item);
+
+    /**
+     * Removes association for the key from the cold tier, copying its value and expiration time to the
+     * output parameters. Expired association is removed, but isn't returned
+     */
+    bool Take(const std::string &key, std::size_t hash, std::string &value, uint32_t &exptime);
+
+    /**
+     * Removes association for the key, returns false if there is none. Reads record to check the key
+     */
+    bool Erase(const std::string &key, std::size_t hash);
+
+    /**
+     * Drops index entry of the hash without checking the key, no I/O is done
+     */
+    void Forget(std::size_t hash);
+
+    /**
+     * Calls visitor for every association that isn't expired, from the oldest to the most recently
+     * evicted one, see Storage::ForEach
+     */
+    void ForEach(const Afina::Storage::Visitor &visitor);
+
+    // Appends cold tier statistics, see Storage::Stats
+    void Stats(std::vector<std::pair<std::string, std::string>> &stats) const;
+
+private:
+    struct RecordHeader {
+        uint32_t key_size;
+        uint32_t value_size;
+        uint32_t exptime;
+    };
+
+    // Location of the record, offset grows monotonically and is wrapped by the file size
+    struct Location {
+        uint64_t offset;
+        uint32_t size;
+        uint32_t exptime;
+    };
+
+    // Reads record into the buffer, returns false if it could not be read
+    bool load(const Location &location, std::string &record);
+
+    // Same as load, but also checks that record belongs to the key
+    bool read(const Location &location, const std::string &key, std::string &record);
+
+    // Removes index entry, dropping its record
+    void erase(std::unordered_map<std::size_t, Location>::iterator it);
+
+    // Moves write position to the beginning of the next segment, dropping items living there
+    void next_segment();
+
+    // Writes the batch into the file
+    void flush();
+
+    const std::string _path;
+    int _fd;
+
+    std::size_t _segment_size;
+    std::size_t _segments;
+    std::size_t _batch_size;
+
+    std::unordered_map<std::size_t, Location> _index;
+
+    // Hashes of items written into every segment, used to drop them once segment is overwritten
+    std::vector<std::vector<std::size_t>> _segment_hashes;
+
+    // Write position, end of the current segment, and offset of the records still kept in the batch
+    uint64_t _head;
+    uint64_t _segment_end;
+    uint64_t _batch_offset;
+    std::string _batch;
+
+    // Number of hashes of the current segment written before the batch
+    std::size_t _batch_first;
+
+    // Statistics
+    std::size_t _bytes;
+    std::size_t _hits;
+    std::size_t _writes;
+    std::size_t _dropped;
+    std::size_t _errors;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_COLD_TIER_H
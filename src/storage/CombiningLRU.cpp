@@ -0,0 +1,91 @@
+#include "CombiningLRU.h"
+
+namespace Afina {
+namespace Backend {
+
+CombiningLRU::CombiningLRU(size_t max_size)
+    : SimpleLRU(max_size),
+      _combine([this](Operation *const *ops, std::size_t count) { apply(ops, count); }) {}
+
+// See CombiningLRU.h
+bool CombiningLRU::Put(const std::string &key, const std::string &value) {
+    Operation op;
+    op.kind = Operation::Kind::kPut;
+    op.key = &key;
+    op.value = &value;
+    op.out = nullptr;
+    _combine.Execute(op);
+    return op.result;
+}
+
+// See CombiningLRU.h
+bool CombiningLRU::Delete(const std::string &key) {
+    Operation op;
+    op.kind = Operation::Kind::kDelete;
+    op.key = &key;
+    op.value = nullptr;
+    op.out = nullptr;
+    _combine.Execute(op);
+    return op.result;
+}
+
+// See CombiningLRU.h
+bool CombiningLRU::Get(const std::string &key, std::string &value) {
+    Operation op;
+    op.kind = Operation::Kind::kGet;
+    op.key = &key;
+    op.value = nullptr;
+    op.out = &value;
+    _combine.Execute(op);
+    return op.result;
+}
+
+// See CombiningLRU.h
+std::size_t CombiningLRU::MultiGet(const std::vector<std::string> &keys, std::vector<Value> &values) {
+    std::vector<std::size_t> hashes(keys.size());
+    std::vector<std::size_t> positions(keys.size());
+    for (std::size_t i = 0; i < keys.size(); i++) {
+        hashes[i] = key_hash(keys[i]);
+        positions[i] = i;
+    }
+    values.clear();
+    values.resize(keys.size());
+
+    std::lock_guard<Combiner> lock(_combine);
+    return get_many(keys, hashes, positions, values);
+}
+
+// See CombiningLRU.h
+void CombiningLRU::Stats(std::vector<std::pair<std::string, std::string>> &stats) {
+    {
+        std::lock_guard<Combiner> lock(_combine);
+        SimpleLRU::Stats(stats);
+    }
+    stats.emplace_back("combine_batches", std::to_string(_combine.batches()));
+    stats.emplace_back("combine_operations", std::to_string(_combine.operations()));
+}
+
+void CombiningLRU::apply(Operation *const *ops, std::size_t count) {
+    // Index memory of all the keys is being loaded while the first ones are applied
+    for (std::size_t i = 0; count > 1 && i < count; i++) {
+        prefetch(key_hash(*ops[i]->key));
+    }
+
+    for (std::size_t i = 0; i < count; i++) {
+        Operation &op = *ops[i];
+        switch (op.kind) {
+        case Operation::Kind::kPut:
+            op.result = SimpleLRU::Put(*op.key, *op.value);
+            break;
+        case Operation::Kind::kGet:
+            op.result = SimpleLRU::Get(*op.key, *op.out);
+            break;
+        case Operation::Kind::kDelete:
+            op.result = SimpleLRU::Delete(*op.key);
+            break;
+        }
+    }
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,165 @@
+#ifndef AFINA_STORAGE_COMBINING_LRU_H
+#define AFINA_STORAGE_COMBINING_LRU_H
+
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <afina/concurrency/FlatCombine.h>
+
+#include "SimpleLRU.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # SimpleLRU thread safe version with flat combining
+ * Put, Get and Delete are published to FlatCombine and applied in batches by whichever thread became
+ * combiner, so under contention LRU list and index are touched by one core at a time instead of
+ * bouncing between caches of all threads waiting for the mutex. Index memory of the whole batch is
+ * prefetched before the first operation is applied.
+ *
+ * The rest of operations are rare and take combiner role as a lock, running on the calling thread
+ */
+class CombiningLRU : public SimpleLRU {
+public:
+    CombiningLRU(size_t max_size = 1024);
+    ~CombiningLRU() {}
+
+    // see SimpleLRU.h, applied by combiner
+    bool Put(const std::string &key, const std::string &value) override;
+
+    // see SimpleLRU.h
+    bool PutIfAbsent(const std::string &key, const std::string &value) override {
+        std::lock_guard<Combiner> lock(_combine);
+        return SimpleLRU::PutIfAbsent(key, value);
+    }
+
+    // see SimpleLRU.h
+    bool Set(const std::string &key, const std::string &value) override {
+        std::lock_guard<Combiner> lock(_combine);
+        return SimpleLRU::Set(key, value);
+    }
+
+    // see SimpleLRU.h, applied by combiner
+    bool Delete(const std::string &key) override;
+
+    // see SimpleLRU.h, applied by combiner
+    bool Get(const std::string &key, std::string &value) override;
+
+    // see SimpleLRU.h
+    bool GetValue(const std::string &key, Value &value) override {
+        std::lock_guard<Combiner> lock(_combine);
+        return SimpleLRU::GetValue(key, value);
+    }
+
+    // see SimpleLRU.h, keys are hashed before combiner role is taken
+    std::size_t MultiGet(const std::vector<std::string> &keys, std::vector<Value> &values) override;
+
+    // see SimpleLRU.h
+    bool ForEach(const Visitor &visitor) override {
+        std::lock_guard<Combiner> lock(_combine);
+        return SimpleLRU::ForEach(visitor);
+    }
+
+    // see SimpleLRU.h, adds number of combined batches and operations
+    void Stats(std::vector<std::pair<std::string, std::string>> &stats) override;
+
+    // see Afina::Storage
+    void Freeze(const std::function<void()> &action) override {
+        std::lock_guard<Combiner> lock(_combine);
+        action();
+    }
+
+    // see SimpleLRU.h
+    bool PutExpiring(const std::string &key, const std::string &value, uint32_t exptime) override {
+        std::lock_guard<Combiner> lock(_combine);
+        return SimpleLRU::PutExpiring(key, value, exptime);
+    }
+
+    // see SimpleLRU.h
+    bool PutIfAbsentExpiring(const std::string &key, const std::string &value, uint32_t exptime) override {
+        std::lock_guard<Combiner> lock(_combine);
+        return SimpleLRU::PutIfAbsentExpiring(key, value, exptime);
+    }
+
+    // see SimpleLRU.h
+    bool SetExpiring(const std::string &key, const std::string &value, uint32_t exptime) override {
+        std::lock_guard<Combiner> lock(_combine);
+        return SimpleLRU::SetExpiring(key, value, exptime);
+    }
+
+    // see SimpleLRU.h
+    bool Touch(const std::string &key, uint32_t exptime) override {
+        std::lock_guard<Combiner> lock(_combine);
+        return SimpleLRU::Touch(key, exptime);
+    }
+
+    // see SimpleLRU.h
+    bool GetAndTouch(const std::string &key, std::string &value, uint32_t exptime) override {
+        std::lock_guard<Combiner> lock(_combine);
+        return SimpleLRU::GetAndTouch(key, value, exptime);
+    }
+
+    // see SimpleLRU.h
+    bool Update(const std::string &key, const Updater &updater) override {
+        std::lock_guard<Combiner> lock(_combine);
+        return SimpleLRU::Update(key, updater);
+    }
+
+    // see SimpleLRU.h
+    bool GetCas(const std::string &key, Value &value, uint64_t &cas) override {
+        std::lock_guard<Combiner> lock(_combine);
+        return SimpleLRU::GetCas(key, value, cas);
+    }
+
+    // see SimpleLRU.h
+    CasResult CompareAndSwap(const std::string &key, const std::string &value, uint64_t cas,
+                             uint32_t exptime) override {
+        std::lock_guard<Combiner> lock(_combine);
+        return SimpleLRU::CompareAndSwap(key, value, cas, exptime);
+    }
+
+    // see SimpleLRU.h
+    bool Append(const std::string &key, const std::string &data) override {
+        std::lock_guard<Combiner> lock(_combine);
+        return SimpleLRU::Append(key, data);
+    }
+
+    // see SimpleLRU.h
+    bool Prepend(const std::string &key, const std::string &data) override {
+        std::lock_guard<Combiner> lock(_combine);
+        return SimpleLRU::Prepend(key, data);
+    }
+
+private:
+    // Operation published to the combiner, result is written back into it
+    struct Operation {
+        enum class Kind { kPut, kGet, kDelete };
+
+        Kind kind;
+        const std::string *key;
+
+        // Value to put
+        const std::string *value;
+
+        // Value to get into
+        std::string *out;
+        bool result;
+    };
+
+    using Combiner = Afina::Concurrency::FlatCombine<Operation>;
+
+    // Applies batch of operations, called by combiner only
+    void apply(Operation *const *ops, std::size_t count);
+
+    Combiner _combine;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_COMBINING_LRU_H
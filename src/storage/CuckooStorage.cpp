@@ -0,0 +1,833 @@
+#include "CuckooStorage.h"
+
+#include <algorithm>
+#include <iterator>
+#include <thread>
+
+namespace Afina {
+namespace Backend {
+
+namespace {
+
+// Number of buckets table starts with
+const std::size_t initial_buckets = 16;
+
+// Retired memory is reclaimed once that many items are waiting
+const std::size_t reclaim_batch = 64;
+
+// Number of old table buckets every write moves to the bigger table while it grows
+const std::size_t move_buckets = 2;
+
+// Allocates new item expiring at the given time
+Item *create(const std::string &key, const std::string &value, std::size_t hash, uint32_t exptime) {
+    Item *item = Item::Create(key, value, hash);
+    item->exptime = exptime;
+    return item;
+}
+
+void backoff(int attempt) {
+    if (attempt < 64) {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#endif
+    } else {
+        std::this_thread::yield();
+    }
+}
+
+} // namespace
+
+constexpr std::size_t CuckooStorage::kSlots;
+constexpr std::size_t CuckooStorage::kLocks;
+constexpr std::size_t CuckooStorage::kSearchLimit;
+
+CuckooStorage::CuckooStorage(size_t max_size)
+    : _max_size(max_size), _curr_size(0), _curr_items(0), _cas(0), _old(nullptr), _move_next(0), _moved(0), _hand(0),
+      _epoch(1) {
+    // Table at most half full when memory is filled by the smallest items
+    std::size_t max_items = max_size / Item::Footprint(0, 0) + 1;
+    _max_buckets = 2;
+    while (_max_buckets * kSlots < 2 * max_items) {
+        _max_buckets *= 2;
+    }
+    _table.store(new Table(std::min(initial_buckets, _max_buckets)));
+}
+
+CuckooStorage::~CuckooStorage() {
+    for (Table *table : {_table.load(), _old.load()}) {
+        if (table == nullptr) {
+            continue;
+        }
+        for (std::size_t b = 0; b < table->size(); b++) {
+            for (std::size_t s = 0; s < kSlots; s++) {
+                Item *item = table->buckets[b].items[s].load();
+                if (item != nullptr) {
+                    Item::Destroy(item);
+                }
+            }
+        }
+        delete table;
+    }
+
+    // Old tables are retired once all their items are moved
+    for (auto &retired : _retired_items) {
+        Item::Destroy(retired.second);
+    }
+    for (auto &retired : _retired_tables) {
+        delete retired.second;
+    }
+}
+
+CuckooStorage::Guard::Guard(CuckooStorage &storage) : _reader(storage._readers.Get()) {
+    _reader.epoch.store(storage._epoch.load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+    // Epoch must be visible to writers before anything is read from the table
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+// See CuckooStorage.h
+bool CuckooStorage::Put(const std::string &key, const std::string &value) {
+    return CuckooStorage::PutExpiring(key, value, 0);
+}
+
+// See CuckooStorage.h
+bool CuckooStorage::PutIfAbsent(const std::string &key, const std::string &value) {
+    return CuckooStorage::PutIfAbsentExpiring(key, value, 0);
+}
+
+// See CuckooStorage.h
+bool CuckooStorage::Set(const std::string &key, const std::string &value) {
+    return CuckooStorage::SetExpiring(key, value, 0);
+}
+
+// See CuckooStorage.h
+bool CuckooStorage::Delete(const std::string &key) {
+    Guard guard(*this);
+    std::size_t hash = std::hash<std::string>()(key);
+    for (;;) {
+        Table *table = _table.load(std::memory_order_acquire);
+        move_key(hash);
+        std::size_t b1 = primary(table, hash);
+        std::size_t b2 = alternative(table, b1, hash);
+        lock(b1, b2);
+        if (_table.load(std::memory_order_relaxed) != table) {
+            unlock(b1, b2);
+            continue;
+        }
+
+        Position position;
+        if (!find(table, b1, b2, key, hash, position)) {
+            unlock(b1, b2);
+            return false;
+        }
+        Item *item = remove(table, position);
+        unlock(b1, b2);
+        bool expired = TimingWheel::Expired(item);
+        retire(item);
+        return !expired;
+    }
+}
+
+// See CuckooStorage.h
+bool CuckooStorage::Get(const std::string &key, std::string &value) {
+    Guard guard(*this);
+    return read(key, std::hash<std::string>()(key),
+                [&value](const Item *item) { value.assign(item->value(), item->value_size); });
+}
+
+// See CuckooStorage.h
+bool CuckooStorage::GetValue(const std::string &key, Value &value) {
+    Guard guard(*this);
+    return read(key, std::hash<std::string>()(key), [&value](const Item *item) {
+        value = Value(std::string(item->value(), item->value_size));
+    });
+}
+
+// See CuckooStorage.h
+bool CuckooStorage::GetCas(const std::string &key, Value &value, uint64_t &cas) {
+    Guard guard(*this);
+    return read(key, std::hash<std::string>()(key), [&value, &cas](const Item *item) {
+        value = Value(std::string(item->value(), item->value_size));
+        cas = item->cas;
+    });
+}
+
+// See CuckooStorage.h
+bool CuckooStorage::PutExpiring(const std::string &key, const std::string &value, uint32_t exptime) {
+    if (Item::Footprint(key.size(), value.size()) > _max_size) {
+        return false;
+    }
+    Guard guard(*this);
+    return insert(create(key, value, std::hash<std::string>()(key), exptime), key, Mode::kPut) ==
+           CasResult::kStored;
+}
+
+// See CuckooStorage.h
+bool CuckooStorage::PutIfAbsentExpiring(const std::string &key, const std::string &value, uint32_t exptime) {
+    if (Item::Footprint(key.size(), value.size()) > _max_size) {
+        return false;
+    }
+    Guard guard(*this);
+    std::size_t hash = std::hash<std::string>()(key);
+    if (read(key, hash, [](const Item *) {})) {
+        return false;
+    }
+    return insert(create(key, value, hash, exptime), key, Mode::kPutIfAbsent) == CasResult::kStored;
+}
+
+// See CuckooStorage.h
+bool CuckooStorage::SetExpiring(const std::string &key, const std::string &value, uint32_t exptime) {
+    if (Item::Footprint(key.size(), value.size()) > _max_size) {
+        return false;
+    }
+    Guard guard(*this);
+    std::size_t hash = std::hash<std::string>()(key);
+    if (!read(key, hash, [](const Item *) {})) {
+        return false;
+    }
+    return insert(create(key, value, hash, exptime), key, Mode::kSet) == CasResult::kStored;
+}
+
+// See CuckooStorage.h
+bool CuckooStorage::Touch(const std::string &key, uint32_t exptime) { return touch(key, exptime, nullptr); }
+
+// See CuckooStorage.h
+bool CuckooStorage::GetAndTouch(const std::string &key, std::string &value, uint32_t exptime) {
+    return touch(key, exptime, &value);
+}
+
+// See CuckooStorage.h
+CuckooStorage::CasResult CuckooStorage::CompareAndSwap(const std::string &key, const std::string &value,
+                                                       uint64_t cas, uint32_t exptime) {
+    if (Item::Footprint(key.size(), value.size()) > _max_size) {
+        return CasResult::kNotStored;
+    }
+    Guard guard(*this);
+    return insert(create(key, value, std::hash<std::string>()(key), exptime), key, Mode::kCas, cas);
+}
+
+// See CuckooStorage.h
+bool CuckooStorage::Update(const std::string &key, const Updater &updater) {
+    std::size_t hash = std::hash<std::string>()(key);
+    Guard guard(*this);
+    for (;;) {
+        std::string value;
+        uint64_t cas;
+        uint32_t exptime;
+        bool accepted;
+        if (!read(key, hash, [&](const Item *item) {
+                exptime = item->exptime;
+                value.clear();
+                cas = item->cas;
+                accepted = updater(item->value(), item->value_size, cas, value, exptime);
+            })) {
+            return false;
+        }
+        if (!accepted || Item::Footprint(key.size(), value.size()) > _max_size) {
+            return false;
+        }
+        CasResult result = insert(create(key, value, hash, exptime), key, Mode::kCas, cas);
+        if (result != CasResult::kExists) {
+            return result == CasResult::kStored;
+        }
+    }
+}
+
+// See CuckooStorage.h
+std::size_t CuckooStorage::MultiGet(const std::vector<std::string> &keys, std::vector<Value> &values) {
+    values.clear();
+    values.resize(keys.size());
+
+    Guard guard(*this);
+    std::size_t found = 0;
+    for (std::size_t i = 0; i < keys.size(); i++) {
+        Value &value = values[i];
+        found += read(keys[i], std::hash<std::string>()(keys[i]), [&value](const Item *item) {
+            value = Value(std::string(item->value(), item->value_size));
+        });
+    }
+    return found;
+}
+
+// See CuckooStorage.h
+bool CuckooStorage::ForEach(const Visitor &visitor) {
+    lock_all();
+    try {
+        // Every item is moved between tables under the locks, so it is in one of them
+        for (Table *table : {_old.load(std::memory_order_relaxed), _table.load(std::memory_order_relaxed)}) {
+            for (std::size_t b = 0; table != nullptr && b < table->size(); b++) {
+                for (std::size_t s = 0; s < kSlots; s++) {
+                    const Item *item = table->buckets[b].items[s].load(std::memory_order_relaxed);
+                    if (item != nullptr && !TimingWheel::Expired(item)) {
+                        visitor(item->key(), item->key_size, item->value(), item->value_size, item->exptime);
+                    }
+                }
+            }
+        }
+    } catch (...) {
+        unlock_all();
+        throw;
+    }
+    unlock_all();
+    return true;
+}
+
+// See CuckooStorage.h
+void CuckooStorage::Freeze(const std::function<void()> &action) {
+    lock_all();
+    try {
+        action();
+    } catch (...) {
+        unlock_all();
+        throw;
+    }
+    unlock_all();
+}
+
+// See CuckooStorage.h
+void CuckooStorage::Stats(std::vector<std::pair<std::string, std::string>> &stats) {
+    stats.emplace_back("curr_items", std::to_string(_curr_items.load()));
+    stats.emplace_back("bytes", std::to_string(_curr_size.load()));
+    stats.emplace_back("limit_maxbytes", std::to_string(_max_size));
+    stats.emplace_back("table_buckets", std::to_string(_table.load()->size()));
+    Table *old = _old.load();
+    stats.emplace_back("table_old_buckets", std::to_string(old != nullptr ? old->size() : 0));
+}
+
+void CuckooStorage::lock(std::size_t bucket) {
+    Lock &stripe = lock_of(bucket);
+    for (int i = 0;; i++) {
+        uint32_t version = stripe.version.load(std::memory_order_relaxed);
+        if ((version & 1) == 0 &&
+            stripe.version.compare_exchange_weak(version, version + 1, std::memory_order_acquire)) {
+            // Readers must see the stripe locked before any change under it
+            std::atomic_thread_fence(std::memory_order_release);
+            return;
+        }
+        backoff(i);
+    }
+}
+
+void CuckooStorage::unlock(std::size_t bucket) { lock_of(bucket).version.fetch_add(1, std::memory_order_release); }
+
+void CuckooStorage::lock(std::size_t first, std::size_t second) {
+    std::size_t s1 = first & (kLocks - 1), s2 = second & (kLocks - 1);
+    if (s1 == s2) {
+        lock(s1);
+    } else {
+        lock(std::min(s1, s2));
+        lock(std::max(s1, s2));
+    }
+}
+
+void CuckooStorage::unlock(std::size_t first, std::size_t second) {
+    std::size_t s1 = first & (kLocks - 1), s2 = second & (kLocks - 1);
+    unlock(s1);
+    if (s1 != s2) {
+        unlock(s2);
+    }
+}
+
+void CuckooStorage::lock(std::size_t first, std::size_t second, std::size_t third) {
+    std::size_t stripes[] = {first & (kLocks - 1), second & (kLocks - 1), third & (kLocks - 1)};
+    std::sort(std::begin(stripes), std::end(stripes));
+    for (std::size_t i = 0; i < 3; i++) {
+        if (i == 0 || stripes[i] != stripes[i - 1]) {
+            lock(stripes[i]);
+        }
+    }
+}
+
+void CuckooStorage::unlock(std::size_t first, std::size_t second, std::size_t third) {
+    std::size_t stripes[] = {first & (kLocks - 1), second & (kLocks - 1), third & (kLocks - 1)};
+    std::sort(std::begin(stripes), std::end(stripes));
+    for (std::size_t i = 0; i < 3; i++) {
+        if (i == 0 || stripes[i] != stripes[i - 1]) {
+            unlock(stripes[i]);
+        }
+    }
+}
+
+void CuckooStorage::lock_all() {
+    for (std::size_t i = 0; i < kLocks; i++) {
+        lock(i);
+    }
+}
+
+void CuckooStorage::unlock_all() {
+    for (std::size_t i = 0; i < kLocks; i++) {
+        unlock(i);
+    }
+}
+
+bool CuckooStorage::read(const std::string &key, std::size_t hash, const std::function<void(const Item *)> &found) {
+    uint8_t tag = tag_of(hash);
+    for (int attempt = 0;; attempt++) {
+        Table *table = _table.load(std::memory_order_acquire);
+        Table *old = _old.load(std::memory_order_acquire);
+
+        // Buckets of the current table go first, then the ones of the old table if it is still there
+        std::size_t buckets[4];
+        buckets[0] = primary(table, hash);
+        buckets[1] = alternative(table, buckets[0], hash);
+        std::size_t count = 2;
+        if (old != nullptr) {
+            buckets[2] = primary(old, hash);
+            buckets[3] = alternative(old, buckets[2], hash);
+            count = 4;
+        }
+
+        uint32_t versions[4];
+        bool locked = false;
+        for (std::size_t i = 0; i < count; i++) {
+            versions[i] = lock_of(buckets[i]).version.load(std::memory_order_acquire);
+            locked = locked || (versions[i] & 1) != 0;
+        }
+        if (locked) {
+            backoff(attempt);
+            continue;
+        }
+
+        Item *item = nullptr;
+        for (std::size_t i = 0; i < count && item == nullptr; i++) {
+            Bucket &bucket = (i < 2 ? table : old)->buckets[buckets[i]];
+            for (std::size_t s = 0; s < kSlots && item == nullptr; s++) {
+                if (bucket.tags[s].load(std::memory_order_relaxed) != tag) {
+                    continue;
+                }
+                Item *candidate = bucket.items[s].load(std::memory_order_acquire);
+                if (candidate != nullptr && candidate->hash == hash && candidate->KeyEquals(key)) {
+                    item = candidate;
+                }
+            }
+        }
+
+        // Item could have been moved between buckets or tables while they were looked at
+        std::atomic_thread_fence(std::memory_order_acquire);
+        bool changed = _table.load(std::memory_order_relaxed) != table || _old.load(std::memory_order_relaxed) != old;
+        for (std::size_t i = 0; i < count && !changed; i++) {
+            changed = lock_of(buckets[i]).version.load(std::memory_order_relaxed) != versions[i];
+        }
+        if (changed) {
+            continue;
+        }
+        if (item == nullptr || TimingWheel::Expired(item)) {
+            return false;
+        }
+
+        // Items are never changed in place, so found one is consistent even if it is removed by now
+        found(item);
+        if (item->mark.load(std::memory_order_relaxed) == 0) {
+            item->mark.store(1, std::memory_order_relaxed);
+        }
+        return true;
+    }
+}
+
+bool CuckooStorage::find(const Table *table, std::size_t b1, std::size_t b2, const std::string &key,
+                         std::size_t hash, Position &position) {
+    uint8_t tag = tag_of(hash);
+    for (std::size_t b : {b1, b2}) {
+        Bucket &bucket = table->buckets[b];
+        for (std::size_t s = 0; s < kSlots; s++) {
+            Item *item = bucket.items[s].load(std::memory_order_relaxed);
+            if (bucket.tags[s].load(std::memory_order_relaxed) == tag && item != nullptr && item->hash == hash &&
+                item->KeyEquals(key)) {
+                position.bucket = b;
+                position.slot = s;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+CuckooStorage::CasResult CuckooStorage::insert(Item *item, const std::string &key, Mode mode, uint64_t cas) {
+    std::size_t footprint = item->Footprint();
+    std::size_t hash = item->hash;
+    if (_old.load(std::memory_order_relaxed) != nullptr) {
+        move(move_buckets);
+    }
+
+    // Plain put always stores, other modes look at the key first so that nothing is evicted for nothing
+    bool reserved = mode == Mode::kPut;
+    if (reserved) {
+        reserve(footprint);
+    }
+    for (;;) {
+        Table *table = _table.load(std::memory_order_acquire);
+        move_key(hash);
+        std::size_t b1 = primary(table, hash);
+        std::size_t b2 = alternative(table, b1, hash);
+        lock(b1, b2);
+        if (_table.load(std::memory_order_relaxed) != table) {
+            unlock(b1, b2);
+            continue;
+        }
+
+        Position position;
+        Item *old = nullptr;
+        if (find(table, b1, b2, key, hash, position)) {
+            old = table->buckets[position.bucket].items[position.slot].load(std::memory_order_relaxed);
+        }
+
+        // Expired item is as good as missing, but it still takes the slot
+        bool found = old != nullptr && !TimingWheel::Expired(old);
+        CasResult result = CasResult::kStored;
+        bool versioned = mode == Mode::kCas || mode == Mode::kTouch;
+        if (found && (mode == Mode::kPutIfAbsent || (versioned && old->cas != cas))) {
+            result = CasResult::kExists;
+        } else if (!found && (mode == Mode::kSet || versioned)) {
+            result = CasResult::kNotFound;
+        }
+        if (result != CasResult::kStored) {
+            if (old != nullptr && !found) {
+                remove(table, position);
+            }
+            unlock(b1, b2);
+            if (old != nullptr && !found) {
+                retire(old);
+            }
+            if (reserved) {
+                _curr_size.fetch_sub(footprint);
+            }
+            Item::Destroy(item);
+            return result;
+        }
+        if (!reserved) {
+            // Key is looked up once again as eviction could change it meanwhile
+            unlock(b1, b2);
+            reserve(footprint);
+            reserved = true;
+            continue;
+        }
+
+        item->cas = mode == Mode::kTouch ? old->cas : _cas.fetch_add(1, std::memory_order_relaxed) + 1;
+        if (old != nullptr) {
+            table->buckets[position.bucket].items[position.slot].store(item, std::memory_order_release);
+            unlock(b1, b2);
+            _curr_size.fetch_sub(old->Footprint());
+            retire(old);
+            return CasResult::kStored;
+        }
+
+        for (std::size_t b : {b1, b2}) {
+            Bucket &bucket = table->buckets[b];
+            for (std::size_t s = 0; s < kSlots; s++) {
+                if (bucket.items[s].load(std::memory_order_relaxed) == nullptr) {
+                    bucket.tags[s].store(tag_of(hash), std::memory_order_relaxed);
+                    bucket.items[s].store(item, std::memory_order_release);
+                    unlock(b1, b2);
+                    _curr_items.fetch_add(1);
+                    return CasResult::kStored;
+                }
+            }
+        }
+        unlock(b1, b2);
+        make_room(table, hash);
+    }
+}
+
+bool CuckooStorage::touch(const std::string &key, uint32_t exptime, std::string *value) {
+    std::size_t hash = std::hash<std::string>()(key);
+    Guard guard(*this);
+    for (;;) {
+        Item *copy = nullptr;
+        uint64_t cas;
+        if (!read(key, hash, [&](const Item *item) {
+                copy = Item::Create(item->key(), item->key_size, item->value(), item->value_size, hash);
+                copy->flags = item->flags;
+                copy->exptime = exptime;
+                cas = item->cas;
+            })) {
+            return false;
+        }
+        if (value != nullptr) {
+            value->assign(copy->value(), copy->value_size);
+        }
+        CasResult result = insert(copy, key, Mode::kTouch, cas);
+        if (result != CasResult::kExists) {
+            return result == CasResult::kStored;
+        }
+    }
+}
+
+void CuckooStorage::make_room(Table *table, std::size_t hash) {
+    std::lock_guard<std::mutex> lock(_cuckoo_mutex);
+    if (_table.load(std::memory_order_relaxed) != table) {
+        return;
+    }
+
+    std::size_t b1 = primary(table, hash);
+    std::size_t b2 = alternative(table, b1, hash);
+    if (displace(table, b1, b2)) {
+        return;
+    }
+    if (table->size() < _max_buckets) {
+        grow(table);
+        return;
+    }
+
+    // Table is as large as it could be, so an item of the first bucket has to go
+    Position position{b1, (hash >> 8) % kSlots};
+    this->lock(b1);
+    Item *item = nullptr;
+    if (table->buckets[b1].items[position.slot].load(std::memory_order_relaxed) != nullptr) {
+        item = remove(table, position);
+    }
+    unlock(b1);
+    if (item != nullptr) {
+        retire(item);
+    }
+}
+
+bool CuckooStorage::displace(Table *table, std::size_t b1, std::size_t b2) {
+    // Bucket reached by moving item from the slot of the parent bucket
+    struct Node {
+        std::size_t bucket;
+        std::size_t parent;
+        std::size_t slot;
+        Item *item;
+    };
+    const std::size_t root = std::size_t(-1);
+
+    std::vector<Node> nodes;
+    nodes.reserve(kSearchLimit);
+    nodes.push_back(Node{b1, root, 0, nullptr});
+    nodes.push_back(Node{b2, root, 0, nullptr});
+    for (std::size_t n = 0; n < nodes.size(); n++) {
+        Bucket &bucket = table->buckets[nodes[n].bucket];
+        for (std::size_t s = 0; s < kSlots; s++) {
+            Item *item = bucket.items[s].load(std::memory_order_acquire);
+            if (item != nullptr) {
+                if (nodes.size() < kSearchLimit) {
+                    nodes.push_back(Node{alternative(table, nodes[n].bucket, item->hash), n, s, item});
+                }
+                continue;
+            }
+
+            // Free slot is found, items are moved starting from the end of the path so that every one of
+            // them stays in the table all the time
+            std::size_t free_slot = s;
+            for (std::size_t current = n; nodes[current].parent != root; current = nodes[current].parent) {
+                const Node &node = nodes[current];
+                Bucket &from = table->buckets[nodes[node.parent].bucket];
+                Bucket &to = table->buckets[node.bucket];
+
+                lock(nodes[node.parent].bucket, node.bucket);
+                if (from.items[node.slot].load(std::memory_order_relaxed) != node.item ||
+                    to.items[free_slot].load(std::memory_order_relaxed) != nullptr) {
+                    // Path has been changed by other writers, caller would look at buckets again
+                    unlock(nodes[node.parent].bucket, node.bucket);
+                    return true;
+                }
+                to.tags[free_slot].store(from.tags[node.slot].load(std::memory_order_relaxed),
+                                         std::memory_order_relaxed);
+                to.items[free_slot].store(node.item, std::memory_order_release);
+                from.items[node.slot].store(nullptr, std::memory_order_relaxed);
+                from.tags[node.slot].store(0, std::memory_order_relaxed);
+                unlock(nodes[node.parent].bucket, node.bucket);
+                free_slot = node.slot;
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+void CuckooStorage::grow(Table *table) {
+    // Previous growth isn't over yet, which happens only if the table fills up right after it has grown
+    Table *old = _old.load(std::memory_order_relaxed);
+    while (old != nullptr && _old.load(std::memory_order_relaxed) == old) {
+        move_bucket(old, _move_next++);
+    }
+
+    std::unique_ptr<Table> bigger(new Table(table->size() * 2));
+    table->moved.reset(new std::atomic<bool>[table->size()]());
+    _move_next = _moved = 0;
+
+    // Writers check the table under stripe locks, so none of them is in the middle of a change now
+    lock_all();
+    _old.store(table, std::memory_order_release);
+    _table.store(bigger.release(), std::memory_order_release);
+    unlock_all();
+}
+
+void CuckooStorage::move_key(std::size_t hash) {
+    Table *old = _old.load(std::memory_order_acquire);
+    if (old == nullptr) {
+        return;
+    }
+    std::size_t b1 = primary(old, hash);
+    std::size_t b2 = alternative(old, b1, hash);
+    if (old->moved[b1].load(std::memory_order_acquire) && old->moved[b2].load(std::memory_order_acquire)) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(_cuckoo_mutex);
+    if (_old.load(std::memory_order_relaxed) != old) {
+        return;
+    }
+    move_bucket(old, b1);
+    // Table could be done with the first bucket
+    if (_old.load(std::memory_order_relaxed) == old) {
+        move_bucket(old, b2);
+    }
+}
+
+bool CuckooStorage::move(std::size_t buckets) {
+    std::lock_guard<std::mutex> lock(_cuckoo_mutex);
+    Table *old = _old.load(std::memory_order_relaxed);
+    if (old == nullptr) {
+        return false;
+    }
+    for (std::size_t i = 0; i < buckets && _old.load(std::memory_order_relaxed) == old; i++) {
+        move_bucket(old, _move_next++);
+    }
+    return true;
+}
+
+void CuckooStorage::move_bucket(Table *old, std::size_t bucket) {
+    if (bucket >= old->size() || old->moved[bucket].load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    // Writers don't touch the old table, so items could change places only here
+    Bucket &from = old->buckets[bucket];
+    Table *table = _table.load(std::memory_order_relaxed);
+    for (std::size_t s = 0; s < kSlots; s++) {
+        Item *item = from.items[s].load(std::memory_order_relaxed);
+        while (item != nullptr) {
+            std::size_t b1 = primary(table, item->hash);
+            std::size_t b2 = alternative(table, b1, item->hash);
+            lock(bucket, b1, b2);
+            for (std::size_t b : {b1, b2}) {
+                Bucket &to = table->buckets[b];
+                for (std::size_t t = 0; t < kSlots && item != nullptr; t++) {
+                    if (to.items[t].load(std::memory_order_relaxed) == nullptr) {
+                        to.tags[t].store(from.tags[s].load(std::memory_order_relaxed), std::memory_order_relaxed);
+                        to.items[t].store(item, std::memory_order_release);
+                        from.items[s].store(nullptr, std::memory_order_relaxed);
+                        from.tags[s].store(0, std::memory_order_relaxed);
+                        item = nullptr;
+                    }
+                }
+            }
+            unlock(bucket, b1, b2);
+
+            // Both buckets are full, table is too small already for the item, so it is evicted
+            if (item != nullptr && !displace(table, b1, b2)) {
+                this->lock(bucket);
+                remove(old, Position{bucket, s});
+                unlock(bucket);
+                retire(item);
+                item = nullptr;
+            }
+        }
+    }
+
+    old->moved[bucket].store(true, std::memory_order_release);
+    if (++_moved == old->size()) {
+        _old.store(nullptr, std::memory_order_release);
+        retire(old);
+    }
+}
+
+void CuckooStorage::reserve(std::size_t footprint) {
+    _curr_size.fetch_add(footprint);
+    // Items of the old table get evictable once they are moved
+    while (_curr_size.load() > _max_size && (evict() || move(move_buckets))) {
+    }
+}
+
+bool CuckooStorage::evict() {
+    std::lock_guard<std::mutex> lock(_evict_mutex);
+    Table *table = _table.load(std::memory_order_acquire);
+
+    // Two turns are enough: the first one clears all the reference bits at worst
+    for (std::size_t step = 0; step < 2 * table->size() * kSlots; step++) {
+        std::size_t position = _hand++ % (table->size() * kSlots);
+        Position victim{position / kSlots, position % kSlots};
+        Bucket &bucket = table->buckets[victim.bucket];
+        Item *item = bucket.items[victim.slot].load(std::memory_order_acquire);
+        if (item == nullptr) {
+            continue;
+        }
+        if (item->mark.load(std::memory_order_relaxed) != 0 && !TimingWheel::Expired(item)) {
+            item->mark.store(0, std::memory_order_relaxed);
+            continue;
+        }
+
+        this->lock(victim.bucket);
+        if (_table.load(std::memory_order_relaxed) != table ||
+            bucket.items[victim.slot].load(std::memory_order_relaxed) != item) {
+            unlock(victim.bucket);
+            table = _table.load(std::memory_order_acquire);
+            continue;
+        }
+        remove(table, victim);
+        unlock(victim.bucket);
+        retire(item);
+        return true;
+    }
+    return false;
+}
+
+Item *CuckooStorage::remove(Table *table, const Position &position) {
+    Bucket &bucket = table->buckets[position.bucket];
+    Item *item = bucket.items[position.slot].load(std::memory_order_relaxed);
+    bucket.items[position.slot].store(nullptr, std::memory_order_relaxed);
+    bucket.tags[position.slot].store(0, std::memory_order_relaxed);
+    _curr_items.fetch_sub(1);
+    _curr_size.fetch_sub(item->Footprint());
+    return item;
+}
+
+void CuckooStorage::retire(Item *item) {
+    std::lock_guard<std::mutex> lock(_retire_mutex);
+    _retired_items.emplace_back(_epoch.load(), item);
+    if (_retired_items.size() >= reclaim_batch) {
+        reclaim();
+    }
+}
+
+void CuckooStorage::retire(Table *table) {
+    std::lock_guard<std::mutex> lock(_retire_mutex);
+    _retired_tables.emplace_back(_epoch.load(), table);
+    reclaim();
+}
+
+void CuckooStorage::reclaim() {
+    // Threads entering from now on can't see anything retired so far
+    uint64_t oldest = _epoch.fetch_add(1) + 1;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    _readers.ForEach([&oldest](Reader &reader) {
+        uint64_t epoch = reader.epoch.load(std::memory_order_acquire);
+        if (epoch != 0 && epoch < oldest) {
+            oldest = epoch;
+        }
+    });
+
+    std::size_t kept = 0;
+    for (auto &retired : _retired_items) {
+        if (retired.first < oldest) {
+            Item::Destroy(retired.second);
+        } else {
+            _retired_items[kept++] = retired;
+        }
+    }
+    _retired_items.resize(kept);
+
+    kept = 0;
+    for (auto &retired : _retired_tables) {
+        if (retired.first < oldest) {
+            delete retired.second;
+        } else {
+            _retired_tables[kept++] = retired;
+        }
+    }
+    _retired_tables.resize(kept);
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,296 @@
+#ifndef AFINA_STORAGE_CUCKOO_STORAGE_H
+#define AFINA_STORAGE_CUCKOO_STORAGE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <afina/Storage.h>
+#include <afina/concurrency/ThreadLocal.h>
+
+#include "Item.h"
+#include "TimingWheel.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Concurrent cuckoo hash
+ * Items live in a bucketized cuckoo hash table: every key has two candidate buckets of four slots, and
+ * it is in one of them or nowhere. Slot keeps a one byte tag of the key hash next to the item pointer,
+ * so most of the slots are skipped without touching items.
+ *
+ * Buckets are covered by striped locks, each of them is a version counter as well: writer makes it odd
+ * while holding the lock and even again on release. Reader takes no lock at all: it remembers versions
+ * of both stripes, looks the key up and checks versions are the same, retrying otherwise. So reading
+ * changes no shared memory, except for the reference bit of an item not marked yet.
+ *
+ * Writer locks stripes of the two buckets of the key. If both are full, a path of items moving to
+ * their alternative buckets and ending with a free slot is searched breadth first, then items are
+ * moved one by one from its end, locking stripes of the two buckets of every move. Table doubles once
+ * there is no such path and memory limit allows more items.
+ *
+ * Growth doesn't rehash everything at once: bigger table is installed empty and the old one is kept
+ * until all its buckets are moved. Writer moves both old buckets of its key before touching the key, so
+ * the key is never in both tables for it, and a couple of other buckets besides. Every item is moved
+ * under stripe locks of its old and new buckets, readers look at both tables meanwhile.
+ *
+ * Item and table memory is released only when no reader could still look at it: every operation marks
+ * its thread as active in the current epoch, memory removed from the table waits until all threads
+ * active before its removal are done.
+ *
+ * Once the size limit is reached, items are evicted by CLOCK: hand goes over slots, item read since the
+ * last visit gets a second chance. Items are never changed in place, new value is a new item.
+ *
+ * Expired items are invisible at once. Hand evicts them without a second chance, and writer replaces
+ * or removes expired item of its key. Touch makes a copy of the item with the new expiration time, so
+ * it is never changed in place either.
+ */
+class CuckooStorage : public Afina::Storage {
+public:
+    CuckooStorage(size_t max_size = 1024);
+    ~CuckooStorage();
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override;
+
+    // Implements Afina::Storage interface, value is copied as item could be released any time
+    bool GetValue(const std::string &key, Value &value) override;
+
+    // Implements Afina::Storage interface, whole batch is looked up in a single epoch
+    std::size_t MultiGet(const std::vector<std::string> &keys, std::vector<Value> &values) override;
+
+    // Implements Afina::Storage interface, value is copied as by GetValue
+    bool GetCas(const std::string &key, Value &value, uint64_t &cas) override;
+
+    // Implements Afina::Storage interface
+    bool PutExpiring(const std::string &key, const std::string &value, uint32_t exptime) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsentExpiring(const std::string &key, const std::string &value, uint32_t exptime) override;
+
+    // Implements Afina::Storage interface
+    bool SetExpiring(const std::string &key, const std::string &value, uint32_t exptime) override;
+
+    // Implements Afina::Storage interface, copy of the item with the new expiration time is swapped in as
+    // by CompareAndSwap, version is kept
+    bool Touch(const std::string &key, uint32_t exptime) override;
+
+    // Implements Afina::Storage interface, same as Touch
+    bool GetAndTouch(const std::string &key, std::string &value, uint32_t exptime) override;
+
+    // Implements Afina::Storage interface, version is checked under the locks of key buckets
+    CasResult CompareAndSwap(const std::string &key, const std::string &value, uint64_t cas,
+                             uint32_t exptime) override;
+
+    // Implements Afina::Storage interface. Items are never changed in place as readers take no locks, so
+    // new item is built from the value read and swapped in as by CompareAndSwap, until nobody interferes
+    bool Update(const std::string &key, const Updater &updater) override;
+
+    // Implements Afina::Storage interface, items are visited in the table order under all the locks
+    bool ForEach(const Visitor &visitor) override;
+
+    // Implements Afina::Storage interface
+    void Freeze(const std::function<void()> &action) override;
+
+    // Implements Afina::Storage interface, reports memory usage and table size, including the old table
+    // while it is being moved
+    void Stats(std::vector<std::pair<std::string, std::string>> &stats) override;
+
+private:
+    // Number of slots in a bucket
+    static constexpr std::size_t kSlots = 4;
+
+    // Number of lock stripes, power of 2
+    static constexpr std::size_t kLocks = 1024;
+
+    // Maximum number of buckets path search looks at
+    static constexpr std::size_t kSearchLimit = 512;
+
+    struct Bucket {
+        std::atomic<uint8_t> tags[kSlots];
+        std::atomic<Item *> items[kSlots];
+    };
+
+    struct Table {
+        explicit Table(std::size_t size) : mask(size - 1), buckets(new Bucket[size]()) {}
+
+        std::size_t size() const { return mask + 1; }
+
+        const std::size_t mask;
+        std::unique_ptr<Bucket[]> buckets;
+
+        // Marks buckets whose items are moved to the bigger table already, allocated once table is
+        // replaced by the bigger one
+        std::unique_ptr<std::atomic<bool>[]> moved;
+    };
+
+    // Lock and version of the buckets stripe, odd while locked
+    struct Lock {
+        std::atomic<uint32_t> version{0};
+
+        // Keeps different stripes on different cache lines
+        char padding[64 - sizeof(std::atomic<uint32_t>)];
+    };
+
+    // Epoch thread is active in, 0 if it isn't in the table now
+    struct Reader {
+        std::atomic<uint64_t> epoch{0};
+        char padding[64 - sizeof(std::atomic<uint64_t>)];
+    };
+
+    // Marks the calling thread active for its lifetime
+    class Guard {
+    public:
+        explicit Guard(CuckooStorage &storage);
+        ~Guard() { _reader.epoch.store(0, std::memory_order_release); }
+
+    private:
+        Reader &_reader;
+    };
+
+    // What insert does if key is there already or isn't there. Touch is the same as Cas, but version of
+    // the item is kept
+    enum class Mode { kPut, kPutIfAbsent, kSet, kCas, kTouch };
+
+    // Slot of the bucket holding the key
+    struct Position {
+        std::size_t bucket;
+        std::size_t slot;
+    };
+
+    static uint8_t tag_of(std::size_t hash) { return uint8_t(hash >> 56) | 1; }
+
+    static std::size_t primary(const Table *table, std::size_t hash) { return hash & table->mask; }
+
+    // The other bucket of the key, two buckets are alternatives of each other
+    static std::size_t alternative(const Table *table, std::size_t bucket, std::size_t hash) {
+        return bucket ^ (((hash >> 32) | 1) & table->mask);
+    }
+
+    Lock &lock_of(std::size_t bucket) { return _locks[bucket & (kLocks - 1)]; }
+
+    void lock(std::size_t bucket);
+    void unlock(std::size_t bucket);
+
+    // Locks stripes of both buckets in order, once if they are the same
+    void lock(std::size_t first, std::size_t second);
+    void unlock(std::size_t first, std::size_t second);
+
+    // Locks stripes of three buckets in order, duplicates are locked once
+    void lock(std::size_t first, std::size_t second, std::size_t third);
+    void unlock(std::size_t first, std::size_t second, std::size_t third);
+
+    // Locks all the stripes, table doesn't change until unlock_all
+    void lock_all();
+    void unlock_all();
+
+    // Looks key up without locks, calls found with the item. Call only in Guard
+    bool read(const std::string &key, std::size_t hash, const std::function<void(const Item *)> &found);
+
+    // Finds the key in both buckets, call under their locks
+    bool find(const Table *table, std::size_t b1, std::size_t b2, const std::string &key, std::size_t hash,
+              Position &position);
+
+    // Stores new item as the mode says, takes item in any case. Item replaces the existing one in kCas
+    // mode only if that has the given version. Memory is reserved only once item is known to be stored
+    CasResult insert(Item *item, const std::string &key, Mode mode, uint64_t cas = 0);
+
+    // Changes expiration time as Touch does, copies value to the given string unless it is nullptr
+    bool touch(const std::string &key, uint32_t exptime, std::string *value);
+
+    // Makes a free slot in one of the buckets of the hash, by moving items away or growing table
+    void make_room(Table *table, std::size_t hash);
+
+    // Searches for a path to a free slot and moves items along it, returns false if there is none
+    bool displace(Table *table, std::size_t b1, std::size_t b2);
+
+    // Installs table of the double size, items are moved there later. Call with _cuckoo_mutex held
+    void grow(Table *table);
+
+    // Makes sure items of both old table buckets of the hash are in the current table
+    void move_key(std::size_t hash);
+
+    // Moves the given number of old table buckets, returns false if there is no old table
+    bool move(std::size_t buckets);
+
+    // Moves items of the old table bucket to the current one, call with _cuckoo_mutex held
+    void move_bucket(Table *old, std::size_t bucket);
+
+    // Evicts items until there is space for the given number of bytes more
+    void reserve(std::size_t footprint);
+
+    // Evicts one item by CLOCK, returns false if nothing could be evicted
+    bool evict();
+
+    // Removes item from the slot and returns it, call under the stripe lock. Item must be retired once
+    // the lock is released
+    Item *remove(Table *table, const Position &position);
+
+    // Releases item once no reader could see it
+    void retire(Item *item);
+    void retire(Table *table);
+
+    // Frees retired memory nobody could look at anymore
+    void reclaim();
+
+    // Maximum number of bytes could be stored, see SimpleLRU
+    const std::size_t _max_size;
+
+    // Table won't grow over that, it is enough for the smallest items to fill the memory limit
+    std::size_t _max_buckets;
+
+    std::atomic<std::size_t> _curr_size;
+    std::atomic<std::size_t> _curr_items;
+
+    // Last version given to an item
+    std::atomic<uint64_t> _cas;
+
+    std::atomic<Table *> _table;
+    Lock _locks[kLocks];
+
+    // Table items are moved from while the current one grows, nullptr otherwise
+    std::atomic<Table *> _old;
+
+    // Next bucket of the old table to move and number of moved ones. Call only with _cuckoo_mutex held
+    std::size_t _move_next;
+    std::size_t _moved;
+
+    // Serializes moves of items between buckets and tables, and table growth
+    std::mutex _cuckoo_mutex;
+
+    // Serializes eviction, hand is the next slot to look at
+    std::mutex _evict_mutex;
+    std::size_t _hand;
+
+    // Epochs, memory removed in an epoch is released once no thread is active in it
+    std::atomic<uint64_t> _epoch;
+    Afina::Concurrency::ThreadLocal<Reader> _readers;
+
+    std::mutex _retire_mutex;
+    std::vector<std::pair<uint64_t, Item *>> _retired_items;
+    std::vector<std::pair<uint64_t, Table *>> _retired_tables;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_CUCKOO_STORAGE_H
@@ -0,0 +1,311 @@
+#ifndef AFINA_STORAGE_EVICTION_POLICY_H
+#define AFINA_STORAGE_EVICTION_POLICY_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "GhostList.h"
+#include "Item.h"
+#include "ItemList.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Eviction policies of BasicLRU
+ * Policy decides which item has to go once storage runs out of space. It is a template parameter of
+ * BasicLRU, so that calls on the hot path are inlined. Storage owns the items and reports every event
+ * to the policy, which links items into its own lists using Item::prev/next and Item::queue:
+ *
+ *  - Policy(max_size): max_size is the storage capacity in bytes of item footprints
+ *  - Insert(item): new key has been stored
+ *  - Access(item): key has been read or updated
+ *  - Replace(old, item): item has been reallocated, new one takes the place of the old
+ *  - Remove(item): key has been deleted or expired
+ *  - Evict(keep): unlinks and returns item to be evicted, which is never the item to keep. Returns
+ *    nullptr if there is no item other than the one to keep
+ *  - ForEach(visitor): calls visitor for every item, the ones closer to eviction go first. Visitor
+ *    could destroy the item
+ *  - Overhead(): number of bytes policy takes in memory besides the items, such as history of evicted
+ *    keys, it counts against the storage capacity as well
+ *  - ForgetHistory(): drops everything policy keeps besides the items, so that Overhead gets back to 0
+ */
+
+/**
+ * # Least recently used
+ * Policy of SimpleLRU
+ */
+class LRUPolicy {
+public:
+    explicit LRUPolicy(std::size_t) {}
+
+    void Insert(Item *item) { _list.PushFront(item); }
+    void Access(Item *item) { _list.MoveToFront(item); }
+    void Replace(Item *old, Item *item) { _list.Replace(old, item); }
+    void Remove(Item *item) { _list.Remove(item); }
+
+    Item *Evict(const Item *keep) {
+        Item *victim = _list.Last(keep);
+        if (victim != nullptr) {
+            _list.Remove(victim);
+        }
+        return victim;
+    }
+
+    template <typename F> void ForEach(F &&visitor) const { _list.ForEach(visitor); }
+
+    std::size_t Overhead() const { return 0; }
+
+    void ForgetHistory() {}
+
+private:
+    ItemList _list;
+};
+
+/**
+ * # Segmented LRU
+ * New items get into probation segment, items accessed again move into protected segment, which takes
+ * up to 80% of space. Overflow of protected segment goes back to the head of probation. Victims are
+ * taken from probation first, so a scan can't push out items used more than once
+ */
+class SLRUPolicy {
+public:
+    explicit SLRUPolicy(std::size_t max_size) : _protected_max(max_size / 5 * 4) {}
+
+    void Insert(Item *item) {
+        item->queue = kProbation;
+        _queues[kProbation].PushFront(item);
+    }
+
+    void Access(Item *item) {
+        if (item->queue == kProtected) {
+            _queues[kProtected].MoveToFront(item);
+            return;
+        }
+
+        _queues[kProbation].Remove(item);
+        item->queue = kProtected;
+        _queues[kProtected].PushFront(item);
+        while (_queues[kProtected].size > _protected_max) {
+            Item *demoted = _queues[kProtected].tail;
+            _queues[kProtected].Remove(demoted);
+            demoted->queue = kProbation;
+            _queues[kProbation].PushFront(demoted);
+        }
+    }
+
+    void Replace(Item *old, Item *item) {
+        item->queue = old->queue;
+        _queues[old->queue].Replace(old, item);
+    }
+
+    void Remove(Item *item) { _queues[item->queue].Remove(item); }
+
+    Item *Evict(const Item *keep) {
+        Item *victim = _queues[kProbation].Last(keep);
+        if (victim == nullptr) {
+            victim = _queues[kProtected].Last(keep);
+        }
+        if (victim != nullptr) {
+            Remove(victim);
+        }
+        return victim;
+    }
+
+    template <typename F> void ForEach(F &&visitor) const {
+        _queues[kProbation].ForEach(visitor);
+        _queues[kProtected].ForEach(visitor);
+    }
+
+    std::size_t Overhead() const { return 0; }
+
+    void ForgetHistory() {}
+
+private:
+    enum Queue : uint8_t { kProbation = 0, kProtected, kQueues };
+
+    const std::size_t _protected_max;
+    ItemList _queues[kQueues];
+};
+
+/**
+ * # Full 2Q
+ * New items get into FIFO queue A1in, which takes about 25% of space. Items evicted from A1in are
+ * remembered in A1out ghost queue, keys of the size up to a half of space. Key coming back while it
+ * is still remembered in A1out is considered hot and gets into main LRU queue Am.
+ *
+ * Accesses to items in A1in are ignored: correlated references right after the first one don't make
+ * key hot
+ */
+class TwoQPolicy {
+public:
+    explicit TwoQPolicy(std::size_t max_size) : _in_max(max_size / 4), _out_max(max_size / 2) {}
+
+    void Insert(Item *item) {
+        item->queue = _out.Erase(item->hash) > 0 ? kMain : kIn;
+        _queues[item->queue].PushFront(item);
+    }
+
+    void Access(Item *item) {
+        if (item->queue == kMain) {
+            _queues[kMain].MoveToFront(item);
+        }
+    }
+
+    void Replace(Item *old, Item *item) {
+        item->queue = old->queue;
+        _queues[old->queue].Replace(old, item);
+    }
+
+    void Remove(Item *item) { _queues[item->queue].Remove(item); }
+
+    Item *Evict(const Item *keep) {
+        Item *victim = nullptr;
+        if (_queues[kIn].size <= _in_max && !_queues[kMain].Empty()) {
+            victim = _queues[kMain].Last(keep);
+        }
+        if (victim == nullptr) {
+            victim = _queues[kIn].Last(keep);
+        }
+        if (victim == nullptr) {
+            victim = _queues[kMain].Last(keep);
+        }
+        if (victim == nullptr) {
+            return nullptr;
+        }
+
+        Remove(victim);
+        if (victim->queue == kIn) {
+            _out.PushFront(victim->hash, victim->Footprint());
+            while (_out.size > _out_max) {
+                _out.PopBack();
+            }
+        }
+        return victim;
+    }
+
+    template <typename F> void ForEach(F &&visitor) const {
+        _queues[kIn].ForEach(visitor);
+        _queues[kMain].ForEach(visitor);
+    }
+
+    std::size_t Overhead() const { return _out.MemoryUsage(); }
+
+    void ForgetHistory() { _out.Clear(); }
+
+private:
+    enum Queue : uint8_t { kIn = 0, kMain, kQueues };
+
+    const std::size_t _in_max;
+    const std::size_t _out_max;
+    ItemList _queues[kQueues];
+    GhostList _out;
+};
+
+/**
+ * # Adaptive replacement cache
+ * Items seen once live in T1, items seen at least twice in T2, both are LRU. Keys evicted from T1 and
+ * T2 are remembered in ghost lists B1 and B2. Target size of T1 is adapted on ghost hits: key found
+ * in B1 means T1 is too small, key found in B2 means T2 is. Victim is taken from T1 while it exceeds
+ * the target, from T2 otherwise.
+ *
+ * Sizes are in bytes of item footprint rather than in number of items: T1 with B1 are limited by the
+ * storage capacity, and all four lists by twice of it
+ */
+class ARCPolicy {
+public:
+    explicit ARCPolicy(std::size_t max_size) : _max_size(max_size), _target(0) {}
+
+    void Insert(Item *item) {
+        std::size_t footprint = item->Footprint();
+        std::size_t b1 = _ghosts[kT1].size;
+        std::size_t b2 = _ghosts[kT2].size;
+
+        item->queue = kT2;
+        if (_ghosts[kT1].Erase(item->hash) > 0) {
+            std::size_t delta = footprint * std::max<std::size_t>(1, b2 / b1);
+            _target = std::min(_max_size, _target + delta);
+        } else if (_ghosts[kT2].Erase(item->hash) > 0) {
+            std::size_t delta = footprint * std::max<std::size_t>(1, b1 / b2);
+            _target = _target > delta ? _target - delta : 0;
+        } else {
+            item->queue = kT1;
+        }
+        _queues[item->queue].PushFront(item);
+    }
+
+    void Access(Item *item) {
+        if (item->queue == kT2) {
+            _queues[kT2].MoveToFront(item);
+            return;
+        }
+        _queues[kT1].Remove(item);
+        item->queue = kT2;
+        _queues[kT2].PushFront(item);
+    }
+
+    void Replace(Item *old, Item *item) {
+        item->queue = old->queue;
+        _queues[old->queue].Replace(old, item);
+    }
+
+    void Remove(Item *item) { _queues[item->queue].Remove(item); }
+
+    Item *Evict(const Item *keep) {
+        uint8_t from = kT2;
+        if (!_queues[kT1].Empty() && (_queues[kT1].size > _target || _queues[kT2].Empty())) {
+            from = kT1;
+        }
+        Item *victim = _queues[from].Last(keep);
+        if (victim == nullptr) {
+            from = from == kT1 ? kT2 : kT1;
+            victim = _queues[from].Last(keep);
+        }
+        if (victim == nullptr) {
+            return nullptr;
+        }
+
+        _queues[from].Remove(victim);
+        _ghosts[from].PushFront(victim->hash, victim->Footprint());
+
+        while (!_ghosts[kT1].Empty() && _queues[kT1].size + _ghosts[kT1].size > _max_size) {
+            _ghosts[kT1].PopBack();
+        }
+        while ((!_ghosts[kT1].Empty() || !_ghosts[kT2].Empty()) &&
+               _queues[kT1].size + _queues[kT2].size + _ghosts[kT1].size + _ghosts[kT2].size > 2 * _max_size) {
+            _ghosts[_ghosts[kT2].Empty() ? kT1 : kT2].PopBack();
+        }
+        return victim;
+    }
+
+    template <typename F> void ForEach(F &&visitor) const {
+        _queues[kT1].ForEach(visitor);
+        _queues[kT2].ForEach(visitor);
+    }
+
+    std::size_t Overhead() const { return _ghosts[kT1].MemoryUsage() + _ghosts[kT2].MemoryUsage(); }
+
+    void ForgetHistory() {
+        _ghosts[kT1].Clear();
+        _ghosts[kT2].Clear();
+    }
+
+    // Current target size of T1
+    std::size_t Target() const { return _target; }
+
+private:
+    enum Queue : uint8_t { kT1 = 0, kT2, kQueues };
+
+    const std::size_t _max_size;
+    std::size_t _target;
+
+    // Resident items and ghosts of evicted ones, B1 is _ghosts[kT1] and B2 is _ghosts[kT2]
+    ItemList _queues[kQueues];
+    GhostList _ghosts[kQueues];
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_EVICTION_POLICY_H
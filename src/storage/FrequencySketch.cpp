@@ -0,0 +1,110 @@
+#include "FrequencySketch.h"
+
+#include <algorithm>
+
+namespace Afina {
+namespace Backend {
+
+namespace {
+
+// Seeds of the hash functions, one per counter of the key
+const uint64_t seeds[] = {0xc3a5c85c97cb3127ULL, 0xb492b66fbe98f273ULL, 0x9ae16a3b2f90404fULL,
+                          0xcbf29ce484222325ULL};
+
+// Minimal number of words in the table
+const std::size_t min_width = 64;
+
+const uint64_t reset_mask = 0x7777777777777777ULL;
+const uint64_t one_mask = 0x1111111111111111ULL;
+
+// Mixes bits of the hash, as std::hash of some types is just an identity
+uint64_t spread(uint64_t x) {
+    x = ((x >> 16) ^ x) * 0x45d9f3bULL;
+    x = ((x >> 16) ^ x) * 0x45d9f3bULL;
+    return (x >> 16) ^ x;
+}
+
+} // namespace
+
+// See FrequencySketch.h
+void FrequencySketch::EnsureCapacity(std::size_t keys) {
+    std::size_t width = std::max(_table.size(), min_width);
+    while (width < keys) {
+        width <<= 1;
+    }
+    if (width == _table.size()) {
+        return;
+    }
+
+    // Word index is hash masked by width, so after doubling a counter maps either to the same
+    // word or to the one just width words further. Copying table keeps all estimates unchanged
+    _table.reserve(width);
+    if (_table.empty()) {
+        _table.assign(width, 0);
+    }
+    while (_table.size() < width) {
+        std::size_t old = _table.size();
+        _table.resize(2 * old);
+        std::copy_n(_table.begin(), old, _table.begin() + old);
+    }
+    _mask = width - 1;
+    _sample_size = 10 * width;
+}
+
+// See FrequencySketch.h
+void FrequencySketch::Increment(std::size_t hash) {
+    if (_table.empty()) {
+        return;
+    }
+    uint64_t h = spread(hash);
+    unsigned start = (h & 3) << 2;
+
+    bool added = false;
+    for (unsigned i = 0; i < 4; i++) {
+        uint64_t &word = _table[index_of(h, i)];
+        unsigned offset = (start + i) << 2;
+        if (((word >> offset) & 0xF) != 0xF) {
+            word += 1ULL << offset;
+            added = true;
+        }
+    }
+
+    if (added && ++_additions == _sample_size) {
+        reset();
+    }
+}
+
+// See FrequencySketch.h
+unsigned FrequencySketch::Frequency(std::size_t hash) const {
+    if (_table.empty()) {
+        return 0;
+    }
+    uint64_t h = spread(hash);
+    unsigned start = (h & 3) << 2;
+
+    unsigned frequency = 0xF;
+    for (unsigned i = 0; i < 4; i++) {
+        unsigned offset = (start + i) << 2;
+        frequency = std::min(frequency, unsigned((_table[index_of(h, i)] >> offset) & 0xF));
+    }
+    return frequency;
+}
+
+void FrequencySketch::reset() {
+    std::size_t odd = 0;
+    for (uint64_t &word : _table) {
+        odd += __builtin_popcountll(word & one_mask);
+        word = (word >> 1) & reset_mask;
+    }
+    // Each odd counter lost a half of increment, 4 counters per key
+    _additions = (_additions >> 1) - (odd >> 2);
+}
+
+std::size_t FrequencySketch::index_of(uint64_t hash, unsigned i) const {
+    uint64_t h = (hash + seeds[i]) * seeds[i];
+    h += h >> 32;
+    return h & _mask;
+}
+
+} // namespace Backend
+} // namespace Afina
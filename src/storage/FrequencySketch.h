@@ -0,0 +1,60 @@
+#ifndef AFINA_STORAGE_FREQUENCY_SKETCH_H
+#define AFINA_STORAGE_FREQUENCY_SKETCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Count-min sketch of access frequency
+ * Each key is counted by 4 saturating 4-bit counters, 16 counters are packed into a 64-bit word.
+ * Estimated frequency is the minimum of key counters, so it could only be overestimated by
+ * collisions.
+ *
+ * Once number of increments reaches sample size all counters are halved, so that frequency reflects
+ * recent history rather than the whole lifetime.
+ *
+ * That is NOT thread safe implementation
+ */
+class FrequencySketch {
+public:
+    FrequencySketch() : _mask(0), _sample_size(0), _additions(0) {}
+
+    /**
+     * Makes sketch wide enough to count the given number of keys without too many collisions,
+     * accumulated counters are preserved. Sketch takes 8 bytes per key
+     */
+    void EnsureCapacity(std::size_t keys);
+
+    // Counts one more access to the key with the given hash
+    void Increment(std::size_t hash);
+
+    // Returns estimated number of recent accesses to the key, at most 15
+    unsigned Frequency(std::size_t hash) const;
+
+    // Number of bytes allocated by sketch
+    std::size_t MemoryUsage() const { return _table.size() * sizeof(uint64_t); }
+
+private:
+    // Halves all counters
+    void reset();
+
+    // Index of the word for the i-th counter of the hash
+    std::size_t index_of(uint64_t hash, unsigned i) const;
+
+    // Counters, 16 per word
+    std::vector<uint64_t> _table;
+    std::size_t _mask;
+
+    // Number of increments between resets and number of increments since the last one
+    std::size_t _sample_size;
+    std::size_t _additions;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_FREQUENCY_SKETCH_H
@@ -0,0 +1,85 @@
+#ifndef AFINA_STORAGE_GHOST_LIST_H
+#define AFINA_STORAGE_GHOST_LIST_H
+
+#include <cstddef>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+#include "Item.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # History of evicted keys
+ * Remembers hashes of recently evicted items along with their footprints, without keys and values.
+ * Head holds the most recently added entry. List tracks total footprint of the items it remembers,
+ * so that history could be bounded in the same units as the cache itself.
+ *
+ * Keys with the same hash share an entry, which only makes policy to mistake one key for another
+ */
+class GhostList {
+public:
+    // Sum of footprints of all remembered items
+    std::size_t size = 0;
+
+    bool Empty() const { return _entries.empty(); }
+
+    // Number of bytes entries take in memory: nodes of the list and the index, and index buckets
+    std::size_t MemoryUsage() const {
+        if (_index.empty()) {
+            return 0;
+        }
+        const std::size_t list_node = Item::MallocSize(2 * sizeof(void *) + sizeof(Entry));
+        const std::size_t index_node = Item::MallocSize(sizeof(void *) + sizeof(std::pair<std::size_t, void *>));
+        return _index.size() * (list_node + index_node) + _index.bucket_count() * sizeof(void *);
+    }
+
+    // Forgets all entries
+    void Clear() {
+        _entries.clear();
+        // Buckets are released only with the index itself
+        decltype(_index)().swap(_index);
+        size = 0;
+    }
+
+    void PushFront(std::size_t hash, std::size_t footprint) {
+        Erase(hash);
+        _entries.emplace_front(hash, footprint);
+        _index[hash] = _entries.begin();
+        size += footprint;
+    }
+
+    // Forgets the oldest entry
+    void PopBack() {
+        _index.erase(_entries.back().first);
+        size -= _entries.back().second;
+        _entries.pop_back();
+    }
+
+    // Forgets entry of the given hash, returns its footprint or 0 if there was no such entry
+    std::size_t Erase(std::size_t hash) {
+        auto it = _index.find(hash);
+        if (it == _index.end()) {
+            return 0;
+        }
+        std::size_t footprint = it->second->second;
+        size -= footprint;
+        _entries.erase(it->second);
+        _index.erase(it);
+        return footprint;
+    }
+
+private:
+    // Hash of the key and footprint of the item
+    typedef std::pair<std::size_t, std::size_t> Entry;
+
+    std::list<Entry> _entries;
+    std::unordered_map<std::size_t, std::list<Entry>::iterator> _index;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_GHOST_LIST_H
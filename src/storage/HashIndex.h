@@ -0,0 +1,394 @@
+#ifndef AFINA_STORAGE_HASH_INDEX_H
+#define AFINA_STORAGE_HASH_INDEX_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <new>
+#include <string>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * Upper bound of the index memory per item: every slot takes control byte and pointer, and table is at
+ * least 7/16 full once it has grown. Old table kept while index grows isn't counted, it is gone after a
+ * few operations
+ */
+constexpr std::size_t kIndexBytesPerItem = (sizeof(int8_t) + sizeof(void *)) * 16 / 7 + 1;
+
+/**
+ * # Open addressing hash index
+ * Maps keys to items owned by someone else, in the spirit of "swiss tables": every slot has one
+ * control byte which is either empty, deleted or holds 7 low bits of the item hash with the high bit
+ * set. Empty byte is 0, so new table comes zeroed by calloc, which maps large ones as fresh pages
+ * instead of filling them inside a single Insert. Control bytes
+ * are grouped by 16, so the whole group is matched against the hash in a couple of SSE2
+ * instructions and item itself is touched only when those 7 bits are equal.
+ *
+ * Index stores only pointer per item, hash is never computed inside, caller must pass it to each
+ * operation. Traits must provide:
+ * - static bool Equal(const T *item, const std::string &key): check item key
+ * - static std::size_t Hash(const T *item): hash of the item key, used on rehash only
+ *
+ * Table grows incrementally: new table is allocated and items are inserted there, while the old one is
+ * kept until all its items are moved. Each Insert and Erase moves a couple of groups of the old table,
+ * so no single operation pays for rehashing the whole index. Meanwhile lookups probe both tables.
+ *
+ * That is NOT thread safe implementation
+ */
+template <typename T, typename Traits> class HashIndex {
+public:
+    HashIndex()
+        : _ctrl(nullptr), _slots(nullptr), _capacity(0), _size(0), _deleted(0), _old_ctrl(nullptr),
+          _old_slots(nullptr), _old_capacity(0), _old_size(0), _migrated(0) {}
+    ~HashIndex() { release(); }
+
+    /**
+     * Hash function for keys. Items must be indexed by exactly the same hash
+     */
+    static std::size_t Hash(const std::string &key) { return std::hash<std::string>()(key); }
+
+    /**
+     * Returns item for the key or nullptr if there is no such
+     */
+    T *Find(const std::string &key, std::size_t hash) const {
+        auto equal = [&key](const T *item) { return Traits::Equal(item, key); };
+        std::size_t slot = locate(_ctrl, _slots, _capacity, hash, equal);
+        if (slot != kNone) {
+            return _slots[slot];
+        }
+        slot = locate(_old_ctrl, _old_slots, _old_capacity, hash, equal);
+        return slot != kNone ? _old_slots[slot] : nullptr;
+    }
+
+    /**
+     * Hints CPU to load the first group probed for the hash, so that Find issued a bit later doesn't
+     * stall on memory. Batch lookups prefetch several keys ahead to overlap cache misses
+     */
+    void Prefetch(std::size_t hash) const {
+        if (_capacity == 0) {
+            return;
+        }
+        std::size_t slot = (h1(hash) & group_mask(_capacity)) * kGroupSize;
+        __builtin_prefetch(_ctrl + slot);
+        __builtin_prefetch(_slots + slot);
+        if (_old_capacity != 0) {
+            slot = (h1(hash) & group_mask(_old_capacity)) * kGroupSize;
+            __builtin_prefetch(_old_ctrl + slot);
+            __builtin_prefetch(_old_slots + slot);
+        }
+    }
+
+    /**
+     * Adds item into index, there must be no item with the same key yet
+     */
+    void Insert(T *item, std::size_t hash) {
+        migrate(kMigrateGroups);
+        if ((_size - _old_size + _deleted + 1) * 8 > _capacity * 7) {
+            // Table either too small or polluted by tombstones, in the later case it is rebuilt with the
+            // same capacity
+            rehash(_size * 2 < _capacity ? _capacity : std::max(2 * _capacity, kGroupSize));
+        }
+        place(item, hash);
+        _size++;
+    }
+
+    /**
+     * Removes given item from index. Returns false if item wasn't there
+     */
+    bool Erase(const T *item, std::size_t hash) {
+        migrate(kMigrateGroups);
+        auto same = [item](const T *other) { return other == item; };
+        std::size_t slot = locate(_ctrl, _slots, _capacity, hash, same);
+        if (slot != kNone) {
+            _deleted += erase(_ctrl, slot);
+            _size--;
+            return true;
+        }
+
+        // Tombstones of the old table are never reused, so they aren't counted
+        slot = locate(_old_ctrl, _old_slots, _old_capacity, hash, same);
+        if (slot != kNone) {
+            erase(_old_ctrl, slot);
+            _old_size--;
+            _size--;
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * Puts new item in place of the old one, both must have the same key. Returns false if old
+     * item wasn't there
+     */
+    bool Replace(const T *old, T *item, std::size_t hash) {
+        auto same = [old](const T *other) { return other == old; };
+        std::size_t slot = locate(_ctrl, _slots, _capacity, hash, same);
+        if (slot != kNone) {
+            _slots[slot] = item;
+            return true;
+        }
+        slot = locate(_old_ctrl, _old_slots, _old_capacity, hash, same);
+        if (slot != kNone) {
+            _old_slots[slot] = item;
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * Removes all items from index, memory is released
+     */
+    void Clear() {
+        release();
+        _ctrl = _old_ctrl = nullptr;
+        _slots = _old_slots = nullptr;
+        _capacity = _size = _deleted = _old_capacity = _old_size = _migrated = 0;
+    }
+
+    // Number of items in the index
+    std::size_t Size() const { return _size; }
+
+    // Number of slots in the index, the old table isn't counted while index grows
+    std::size_t Capacity() const { return _capacity; }
+
+    // Checks if items of the old table are still being moved to the new one
+    bool Rehashing() const { return _old_capacity != 0; }
+
+    // Number of bytes allocated by index, including the old table while index grows
+    std::size_t MemoryUsage() const { return (_capacity + _old_capacity) * (sizeof(int8_t) + sizeof(T *)); }
+
+private:
+    HashIndex(const HashIndex &) = delete;
+    HashIndex &operator=(const HashIndex &) = delete;
+
+    static constexpr std::size_t kGroupSize = 16;
+    static constexpr int8_t kEmpty = 0;
+    static constexpr int8_t kDeleted = 1;
+
+    // Control bytes are loaded by groups, malloc alignment is enough for that
+    static_assert(alignof(std::max_align_t) >= kGroupSize, "control bytes must be aligned by group size");
+
+    // Number of groups of the old table moved by every Insert and Erase. Old table of N groups is empty
+    // after N/2 inserts at most, by then new one is far from 7/8 full, so growth never overlaps
+    static constexpr std::size_t kMigrateGroups = 2;
+
+    // Slot that isn't found
+    static constexpr std::size_t kNone = std::size_t(-1);
+
+    // Position of the first group to probe
+    static std::size_t h1(std::size_t hash) { return hash >> 7; }
+
+    // Part of hash stored in the control byte, with the high bit marking slot as full
+    static int8_t h2(std::size_t hash) { return int8_t(0x80 | (hash & 0x7F)); }
+
+    static bool full(int8_t ctrl) { return ctrl < 0; }
+
+    static std::size_t group_mask(std::size_t capacity) { return capacity / kGroupSize - 1; }
+
+    /**
+     * Returns slot of the table holding item the predicate is true for, kNone if there is no such
+     */
+    template <typename Pred>
+    static std::size_t locate(const int8_t *ctrl, T *const *slots, std::size_t capacity, std::size_t hash,
+                              Pred pred) {
+        if (capacity == 0) {
+            return kNone;
+        }
+        const std::size_t mask = group_mask(capacity);
+        std::size_t group = h1(hash) & mask;
+        for (std::size_t step = 1;; step++) {
+            const int8_t *group_ctrl = ctrl + group * kGroupSize;
+            for (uint32_t bits = match(group_ctrl, h2(hash)); bits != 0; bits &= bits - 1) {
+                std::size_t slot = group * kGroupSize + __builtin_ctz(bits);
+                if (pred(slots[slot])) {
+                    return slot;
+                }
+            }
+            if (match(group_ctrl, kEmpty) != 0) {
+                return kNone;
+            }
+            group = (group + step) & mask;
+        }
+    }
+
+    /**
+     * Frees the slot, returns 1 if it has become a tombstone and 0 if it is empty
+     */
+    static std::size_t erase(int8_t *ctrl, std::size_t slot) {
+        // Group with an empty slot has never been full, so no probe sequence goes through it and slot
+        // could be made empty again. Otherwise leave tombstone
+        if (match(ctrl + slot / kGroupSize * kGroupSize, kEmpty) != 0) {
+            ctrl[slot] = kEmpty;
+            return 0;
+        }
+        ctrl[slot] = kDeleted;
+        return 1;
+    }
+
+    /**
+     * Returns bitmask of control bytes in the group that are equal to the given value
+     */
+    static uint32_t match(const int8_t *ctrl, int8_t value) {
+#ifdef __SSE2__
+        __m128i group = _mm_load_si128(reinterpret_cast<const __m128i *>(ctrl));
+        return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(value), group));
+#else
+        uint32_t result = 0;
+        for (std::size_t i = 0; i < kGroupSize; i++) {
+            result |= uint32_t(ctrl[i] == value) << i;
+        }
+        return result;
+#endif
+    }
+
+    /**
+     * Returns bitmask of empty or deleted control bytes in the group, both have the sign bit clear
+     */
+    static uint32_t match_free(const int8_t *ctrl) {
+#ifdef __SSE2__
+        return ~_mm_movemask_epi8(_mm_load_si128(reinterpret_cast<const __m128i *>(ctrl))) & 0xFFFF;
+#else
+        uint32_t result = 0;
+        for (std::size_t i = 0; i < kGroupSize; i++) {
+            result |= uint32_t(!full(ctrl[i])) << i;
+        }
+        return result;
+#endif
+    }
+
+    /**
+     * Returns first empty or deleted slot on the probe sequence of the hash
+     */
+    std::size_t find_free(std::size_t hash) const {
+        const std::size_t mask = group_mask(_capacity);
+        std::size_t group = h1(hash) & mask;
+        for (std::size_t step = 1;; step++) {
+            uint32_t bits = match_free(_ctrl + group * kGroupSize);
+            if (bits != 0) {
+                return group * kGroupSize + __builtin_ctz(bits);
+            }
+            group = (group + step) & mask;
+        }
+    }
+
+    /**
+     * Puts item into the first free slot of the current table, without counting it
+     */
+    void place(T *item, std::size_t hash) {
+        std::size_t slot = find_free(hash);
+        if (_ctrl[slot] == kDeleted) {
+            _deleted--;
+        }
+        _ctrl[slot] = h2(hash);
+        _slots[slot] = item;
+    }
+
+    /**
+     * Allocates new table of the given capacity, current one becomes old and its items are moved later
+     * by migrate. Tombstones are dropped on the way
+     */
+    void rehash(std::size_t capacity) {
+        // Previous growth isn't over yet, which happens only if table is rebuilt right after it has grown
+        migrate(_old_capacity / kGroupSize);
+
+        void *ctrl = std::calloc(capacity, sizeof(int8_t));
+        if (ctrl == nullptr) {
+            throw std::bad_alloc();
+        }
+        T **slots = new (std::nothrow) T *[capacity];
+        if (slots == nullptr) {
+            std::free(ctrl);
+            throw std::bad_alloc();
+        }
+
+        _old_ctrl = _ctrl;
+        _old_slots = _slots;
+        _old_capacity = _capacity;
+        _old_size = _size;
+        _migrated = 0;
+
+        _ctrl = static_cast<int8_t *>(ctrl);
+        _slots = slots;
+        _capacity = capacity;
+        _deleted = 0;
+        migrate(0);
+    }
+
+    /**
+     * Moves items of the given number of old table groups to the current table, old table is released
+     * once it is empty
+     */
+    void migrate(std::size_t groups) {
+        if (_old_capacity == 0) {
+            return;
+        }
+        std::size_t end = std::min(_old_capacity, (_migrated + groups) * kGroupSize);
+        for (std::size_t i = _migrated * kGroupSize; i < end; i++) {
+            if (full(_old_ctrl[i])) {
+                place(_old_slots[i], Traits::Hash(_old_slots[i]));
+                _old_ctrl[i] = kDeleted;
+                _old_size--;
+            }
+        }
+        _migrated = end / kGroupSize;
+
+        if (_migrated * kGroupSize == _old_capacity || _old_size == 0) {
+            std::free(_old_ctrl);
+            delete[] _old_slots;
+            _old_ctrl = nullptr;
+            _old_slots = nullptr;
+            _old_capacity = _old_size = _migrated = 0;
+        }
+    }
+
+    void release() {
+        std::free(_ctrl);
+        delete[] _slots;
+        std::free(_old_ctrl);
+        delete[] _old_slots;
+    }
+
+    // Control bytes, aligned by group size
+    int8_t *_ctrl;
+
+    // Items, slot i is valid if _ctrl[i] is full
+    T **_slots;
+
+    // Number of slots, either 0 or power of 2 not less than group size
+    std::size_t _capacity;
+
+    // Number of items in the index
+    std::size_t _size;
+
+    // Number of tombstones
+    std::size_t _deleted;
+
+    // Table items are being moved from, with the same layout. Groups before _migrated are moved already,
+    // and _old_size items are still there
+    int8_t *_old_ctrl;
+    T **_old_slots;
+    std::size_t _old_capacity;
+    std::size_t _old_size;
+    std::size_t _migrated;
+};
+
+template <typename T, typename Traits> constexpr std::size_t HashIndex<T, Traits>::kGroupSize;
+template <typename T, typename Traits> constexpr int8_t HashIndex<T, Traits>::kEmpty;
+template <typename T, typename Traits> constexpr int8_t HashIndex<T, Traits>::kDeleted;
+template <typename T, typename Traits> constexpr std::size_t HashIndex<T, Traits>::kMigrateGroups;
+template <typename T, typename Traits> constexpr std::size_t HashIndex<T, Traits>::kNone;
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_HASH_INDEX_H
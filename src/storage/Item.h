@@ -0,0 +1,244 @@
+#ifndef AFINA_STORAGE_ITEM_H
+#define AFINA_STORAGE_ITEM_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+
+#include <malloc.h>
+
+#include <afina/Storage.h>
+
+#include "HashIndex.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Cache item
+ * Header, key and value of the item live in a single allocation, key bytes follow the header
+ * immediately and value bytes follow the key:
+ *
+ * [ prev | next | hash | cas | sizes | flags | exptime | timer position | refs | marks ][ key ][ value ][ spare ]
+ *
+ * Capacity is the number of bytes reserved for key and value together, value could be replaced in
+ * place as long as it fits into capacity. Capacity of allocated item includes all usable bytes of the
+ * allocation, so the memory item takes is known without a field of its own.
+ *
+ * Header takes 64 bytes: fields used by a few storages only are packed into single bytes, and item is
+ * linked into the timing wheel by its 32-bit position in the slot rather than by pointers.
+ *
+ * Item is reference counted: storage holds one reference, and every Value handle of the item value
+ * holds another one. Memory is released when the last reference is dropped, so the value could outlive
+ * removal of the item from storage.
+ */
+struct Item {
+    // Timing wheel slot of the item that isn't scheduled
+    static constexpr uint16_t kNoTimer = UINT16_MAX;
+
+    // Links of the list item belongs to, the list itself is managed by the storage
+    Item *prev;
+    Item *next;
+
+    // Hash of the key, computed once when item gets created
+    std::size_t hash;
+
+    // Version of the value, see Storage::GetCas. Storage assigns new one on every change of the value
+    uint64_t cas;
+
+    uint32_t key_size;
+    uint32_t value_size;
+
+    // Number of bytes available for key and value
+    uint32_t capacity;
+
+    // Opaque client flags
+    uint32_t flags;
+
+    // Expiration time, 0 means never
+    uint32_t exptime;
+
+    // Position of the item in the timing wheel slot it is scheduled in, see TimingWheel
+    uint32_t timer_index;
+
+    // Number of references, see above. Handles are taken under storage lock, but could be dropped
+    // concurrently from any thread
+    std::atomic<uint32_t> refs{1};
+
+    // Timing wheel slot item is scheduled in, kNoTimer if it isn't
+    uint16_t timer_slot = kNoTimer;
+
+    // Identifies list item belongs to, for storages that keep several of them
+    uint8_t queue;
+
+    // Access mark of storages that don't keep strict LRU order, such as referenced bit of CLOCK or
+    // promotion period of buffered LRU. Could be updated by readers concurrently
+    std::atomic<uint8_t> mark;
+
+    char *key() { return reinterpret_cast<char *>(this + 1); }
+    const char *key() const { return reinterpret_cast<const char *>(this + 1); }
+
+    char *value() { return key() + key_size; }
+    const char *value() const { return key() + key_size; }
+
+    bool KeyEquals(const std::string &other) const {
+        return other.size() == key_size && std::memcmp(key(), other.data(), key_size) == 0;
+    }
+
+    /**
+     * Number of bytes item costs in memory: allocation with the allocator rounding and a share of the
+     * hash index, so that storage limit is a limit of the real memory usage. Storages limit the sum of
+     * footprints of their items
+     */
+    std::size_t Footprint() const { return sizeof(Item) + capacity + sizeof(std::size_t) + kIndexBytesPerItem; }
+
+    /**
+     * Number of bytes item with the given sizes of key and value is expected to cost in memory, before
+     * it is allocated. Allocator could hand out a larger chunk than expected, so storages account the
+     * footprint of the allocated item
+     */
+    static std::size_t Footprint(std::size_t key_size, std::size_t value_size) {
+        return MallocSize(Size(key_size, value_size)) + kIndexBytesPerItem;
+    }
+
+    // Number of bytes to allocate for item with the given sizes of key and value
+    static std::size_t Size(std::size_t key_size, std::size_t value_size) {
+        return sizeof(Item) + DataCapacity(key_size, value_size);
+    }
+
+    /**
+     * Number of bytes malloc is expected to take for allocation of the given size, as glibc does it: size
+     * header is added and chunk is rounded to 16 bytes, but it is 32 bytes at least. Large allocations
+     * are mapped by whole pages
+     */
+    static std::size_t MallocSize(std::size_t size) {
+        const std::size_t min_chunk = 32;
+        const std::size_t chunk_align = 16;
+        const std::size_t mmap_threshold = 128 * 1024;
+        const std::size_t page_size = 4096;
+        if (size + sizeof(std::size_t) >= mmap_threshold) {
+            return (size + 2 * sizeof(std::size_t) + page_size - 1) & ~(page_size - 1);
+        }
+        return std::max(min_chunk, (size + sizeof(std::size_t) + chunk_align - 1) & ~(chunk_align - 1));
+    }
+
+    // Capacity reserved for key and value, rounded so that items stay aligned
+    static std::size_t DataCapacity(std::size_t key_size, std::size_t value_size) {
+        return (key_size + value_size + alignof(Item) - 1) & ~(alignof(Item) - 1);
+    }
+
+    // Checks if value of the given size could be written in place without wasting too much memory
+    bool FitsInPlace(std::size_t new_value_size) const {
+        std::size_t need = DataCapacity(key_size, new_value_size);
+        return need <= capacity && 2 * need >= capacity;
+    }
+
+    // Checks if value of the given size could be written into capacity, however much is left spare
+    bool Fits(std::size_t new_value_size) const { return DataCapacity(key_size, new_value_size) <= capacity; }
+
+    // Checks if there are handles referencing value, then it must not be changed in place. Handle could
+    // be dropped by another thread that has just read the value, acquire orders that read before the write
+    bool Shared() const { return refs.load(std::memory_order_acquire) > 1; }
+
+    // Returns handle of the value, item stays alive until the handle is gone
+    Value Share() {
+        refs.fetch_add(1, std::memory_order_relaxed);
+        return Value(this, &release, value(), value_size);
+    }
+
+    // Replaces value, call only if it FitsInPlace and isn't Shared
+    void SetValue(const std::string &new_value) {
+        value_size = new_value.size();
+        std::memcpy(value(), new_value.data(), value_size);
+    }
+
+    // Adds data to the end of value, or to its beginning if prepend is set. Call only if the resulting
+    // value Fits and isn't Shared
+    void ConcatValue(const char *data, std::size_t size, bool prepend) {
+        if (prepend) {
+            std::memmove(value() + size, value(), value_size);
+            std::memcpy(value(), data, size);
+        } else {
+            std::memcpy(value() + value_size, data, size);
+        }
+        value_size += size;
+    }
+
+    /**
+     * Allocates new item with a copy of given key and value. Links are left uninitialized
+     */
+    static Item *Create(const char *key, std::size_t key_size, const char *value, std::size_t value_size,
+                        std::size_t hash) {
+        std::size_t capacity = DataCapacity(key_size, value_size);
+        void *mem = std::malloc(sizeof(Item) + capacity);
+        if (mem == nullptr) {
+            throw std::bad_alloc();
+        }
+        return Init(mem, Usable(mem), key, key_size, value, value_size, hash);
+    }
+
+    static Item *Create(const std::string &key, const std::string &value, std::size_t hash) {
+        return Create(key.data(), key.size(), value.data(), value.size(), hash);
+    }
+
+    /**
+     * Allocates new item with the key of the given one and its value concatenated with data as by
+     * ConcatValue. Capacity is enough for value of reserve bytes, so that following concatenations
+     * could be done in place. Links are left uninitialized
+     */
+    static Item *Concat(const Item *item, const char *data, std::size_t size, bool prepend, std::size_t reserve) {
+        std::size_t value_size = item->value_size + size;
+        std::size_t capacity = DataCapacity(item->key_size, std::max(value_size, reserve));
+        void *mem = std::malloc(sizeof(Item) + capacity);
+        if (mem == nullptr) {
+            throw std::bad_alloc();
+        }
+        const char *head = prepend ? data : item->value();
+        std::size_t head_size = prepend ? size : item->value_size;
+        Item *result = Init(mem, Usable(mem), item->key(), item->key_size, head, head_size, item->hash);
+        std::memcpy(result->value() + head_size, prepend ? item->value() : data, value_size - head_size);
+        result->value_size = value_size;
+        return result;
+    }
+
+    /**
+     * Constructs item in the given memory, which has capacity bytes for key and value after the header.
+     * For storages that manage memory themselves, such item must not be passed to Destroy. Memory is
+     * supposed to be taken by the item exactly
+     */
+    static Item *Init(void *mem, std::size_t capacity, const char *key, std::size_t key_size, const char *value,
+                      std::size_t value_size, std::size_t hash) {
+        Item *item = new (mem) Item();
+        item->hash = hash;
+        item->key_size = key_size;
+        item->value_size = value_size;
+        item->capacity = capacity;
+        std::memcpy(item->key(), key, key_size);
+        std::memcpy(item->value(), value, value_size);
+        return item;
+    }
+
+    /**
+     * Drops reference of the storage, item gets released unless there are handles of its value left
+     */
+    static void Destroy(Item *item) {
+        if (item->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            item->~Item();
+            std::free(item);
+        }
+    }
+
+    static void release(void *owner) { Destroy(static_cast<Item *>(owner)); }
+
+    // Number of bytes for key and value in the allocation, malloc could give more than requested
+    static std::size_t Usable(void *mem) { return malloc_usable_size(mem) - sizeof(Item); }
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_ITEM_H
@@ -0,0 +1,93 @@
+#ifndef AFINA_STORAGE_ITEM_LIST_H
+#define AFINA_STORAGE_ITEM_LIST_H
+
+#include <cstddef>
+
+#include "Item.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Intrusive list of items
+ * Links items through Item::prev/next, item could be in one list at a time. Head holds the most
+ * recently added item, tail the oldest one. List also tracks total footprint of its items.
+ *
+ * List doesn't own items
+ */
+struct ItemList {
+    Item *head = nullptr;
+    Item *tail = nullptr;
+
+    // Sum of footprints of all items in the list
+    std::size_t size = 0;
+
+    bool Empty() const { return head == nullptr; }
+
+    // Oldest item other than the given one, nullptr if there is no such
+    Item *Last(const Item *keep) const { return tail != keep || tail == nullptr ? tail : tail->prev; }
+
+    // Calls visitor for every item from the oldest one, visitor could unlink the item it is called for
+    template <typename F> void ForEach(F &&visitor) const {
+        for (Item *item = tail; item != nullptr;) {
+            Item *prev = item->prev;
+            visitor(item);
+            item = prev;
+        }
+    }
+
+    void PushFront(Item *item) {
+        item->prev = nullptr;
+        item->next = head;
+        if (head != nullptr) {
+            head->prev = item;
+        } else {
+            tail = item;
+        }
+        head = item;
+        size += item->Footprint();
+    }
+
+    void Remove(Item *item) {
+        if (item->prev != nullptr) {
+            item->prev->next = item->next;
+        } else {
+            head = item->next;
+        }
+        if (item->next != nullptr) {
+            item->next->prev = item->prev;
+        } else {
+            tail = item->prev;
+        }
+        size -= item->Footprint();
+    }
+
+    void MoveToFront(Item *item) {
+        if (item != head) {
+            Remove(item);
+            PushFront(item);
+        }
+    }
+
+    // Puts new item at the position of the old one, which must be in this list
+    void Replace(Item *old, Item *item) {
+        item->prev = old->prev;
+        item->next = old->next;
+        if (old->prev != nullptr) {
+            old->prev->next = item;
+        } else {
+            head = item;
+        }
+        if (old->next != nullptr) {
+            old->next->prev = item;
+        } else {
+            tail = item;
+        }
+        size += item->Footprint() - old->Footprint();
+    }
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_ITEM_LIST_H
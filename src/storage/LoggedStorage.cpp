@@ -0,0 +1,167 @@
+#include "LoggedStorage.h"
+
+#include <stdexcept>
+
+namespace Afina {
+namespace Backend {
+
+namespace {
+
+const std::string no_value;
+
+} // namespace
+
+LoggedStorage::LoggedStorage(std::shared_ptr<Afina::Storage> storage, const std::string &path, bool sync,
+                             std::chrono::milliseconds interval)
+    : _storage(std::move(storage)), _log(path, interval), _sync(sync) {}
+
+template <typename F>
+bool LoggedStorage::change(const std::string &key, AppendLog::Op op, const std::string &value,
+                           const uint32_t &exptime, F apply) {
+    uint64_t seq;
+    {
+        std::lock_guard<std::mutex> lock(_stripes[std::hash<std::string>()(key) % stripes]);
+        if (!apply()) {
+            return false;
+        }
+        seq = _log.Append(op, key, value, exptime);
+    }
+
+    if (_sync) {
+        _log.Sync(seq);
+    }
+    if (_log.RewriteWanted()) {
+        // Failed rewrite is reported by log statistics, the change itself is done anyway
+        try {
+            Rewrite();
+        } catch (std::runtime_error &) {
+        }
+    }
+    return true;
+}
+
+// See LoggedStorage.h
+void LoggedStorage::Start() {
+    _storage->Start();
+    _log.Start();
+}
+
+// See LoggedStorage.h
+void LoggedStorage::Stop() {
+    _log.Stop();
+    _storage->Stop();
+}
+
+// See LoggedStorage.h
+bool LoggedStorage::Rewrite() {
+    for (std::mutex &stripe : _stripes) {
+        stripe.lock();
+    }
+    bool started = false;
+    try {
+        started = _log.Rewrite(*_storage);
+    } catch (...) {
+        for (std::mutex &stripe : _stripes) {
+            stripe.unlock();
+        }
+        throw;
+    }
+    for (std::mutex &stripe : _stripes) {
+        stripe.unlock();
+    }
+    return started;
+}
+
+// See LoggedStorage.h
+bool LoggedStorage::Put(const std::string &key, const std::string &value) {
+    return change(key, AppendLog::kPut, value, 0, [&]() { return _storage->Put(key, value); });
+}
+
+// See LoggedStorage.h
+bool LoggedStorage::PutIfAbsent(const std::string &key, const std::string &value) {
+    return change(key, AppendLog::kPut, value, 0, [&]() { return _storage->PutIfAbsent(key, value); });
+}
+
+// See LoggedStorage.h
+bool LoggedStorage::Set(const std::string &key, const std::string &value) {
+    return change(key, AppendLog::kPut, value, 0, [&]() { return _storage->Set(key, value); });
+}
+
+// See LoggedStorage.h
+bool LoggedStorage::Delete(const std::string &key) {
+    return change(key, AppendLog::kDelete, no_value, 0, [&]() { return _storage->Delete(key); });
+}
+
+// See LoggedStorage.h
+bool LoggedStorage::PutExpiring(const std::string &key, const std::string &value, uint32_t exptime) {
+    return change(key, AppendLog::kPut, value, exptime, [&]() { return _storage->PutExpiring(key, value, exptime); });
+}
+
+// See LoggedStorage.h
+bool LoggedStorage::PutIfAbsentExpiring(const std::string &key, const std::string &value, uint32_t exptime) {
+    return change(key, AppendLog::kPut, value, exptime,
+                  [&]() { return _storage->PutIfAbsentExpiring(key, value, exptime); });
+}
+
+// See LoggedStorage.h
+bool LoggedStorage::SetExpiring(const std::string &key, const std::string &value, uint32_t exptime) {
+    return change(key, AppendLog::kPut, value, exptime, [&]() { return _storage->SetExpiring(key, value, exptime); });
+}
+
+// See LoggedStorage.h
+bool LoggedStorage::Touch(const std::string &key, uint32_t exptime) {
+    return change(key, AppendLog::kTouch, no_value, exptime, [&]() { return _storage->Touch(key, exptime); });
+}
+
+// See LoggedStorage.h
+bool LoggedStorage::GetAndTouch(const std::string &key, std::string &value, uint32_t exptime) {
+    return change(key, AppendLog::kTouch, no_value, exptime,
+                  [&]() { return _storage->GetAndTouch(key, value, exptime); });
+}
+
+// See LoggedStorage.h
+bool LoggedStorage::Update(const std::string &key, const Updater &updater) {
+    std::string value;
+    uint32_t exptime = 0;
+    return change(key, AppendLog::kPut, value, exptime, [&]() {
+        return _storage->Update(key, [&](const char *current, std::size_t size, uint64_t cas, std::string &new_value,
+                                         uint32_t &new_exptime) {
+            if (!updater(current, size, cas, new_value, new_exptime)) {
+                return false;
+            }
+            value = new_value;
+            exptime = new_exptime;
+            return true;
+        });
+    });
+}
+
+// See LoggedStorage.h
+LoggedStorage::CasResult LoggedStorage::CompareAndSwap(const std::string &key, const std::string &value,
+                                                       uint64_t cas, uint32_t exptime) {
+    CasResult result;
+    change(key, AppendLog::kPut, value, exptime, [&]() {
+        result = _storage->CompareAndSwap(key, value, cas, exptime);
+        return result == CasResult::kStored;
+    });
+    return result;
+}
+
+// See LoggedStorage.h
+bool LoggedStorage::Append(const std::string &key, const std::string &data) {
+    return change(key, AppendLog::kAppend, data, 0, [&]() { return _storage->Append(key, data); });
+}
+
+// See LoggedStorage.h
+bool LoggedStorage::Prepend(const std::string &key, const std::string &data) {
+    return change(key, AppendLog::kPrepend, data, 0, [&]() { return _storage->Prepend(key, data); });
+}
+
+// See LoggedStorage.h
+void LoggedStorage::Stats(std::vector<std::pair<std::string, std::string>> &stats) {
+    _storage->Stats(stats);
+    _log.Stats(stats);
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,143 @@
+#ifndef AFINA_STORAGE_LOGGED_STORAGE_H
+#define AFINA_STORAGE_LOGGED_STORAGE_H
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <afina/Storage.h>
+
+#include "AppendLog.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Durable storage
+ * Wraps any storage and appends every successful change to AppendLog, so that the storage could be
+ * restored by replaying the log after a crash. Change and its record are made under the lock of the key
+ * stripe, so records of the same key are in the log in the same order as changes have been applied.
+ * Reads go straight to the wrapped storage.
+ *
+ * By default change returns once it is appended to the batch, which gets synced within the log interval:
+ * crash loses changes of the last interval at most. In sync mode change returns once it is synced, all
+ * changes made meanwhile by other threads share the same fsync.
+ *
+ * Log is rewritten from the wrapped storage when it grows too large, which requires storage to support
+ * ForEach and Freeze.
+ */
+class LoggedStorage : public Afina::Storage {
+public:
+    LoggedStorage(std::shared_ptr<Afina::Storage> storage, const std::string &path, bool sync = false,
+                  std::chrono::milliseconds interval = std::chrono::milliseconds(10));
+    ~LoggedStorage() {}
+
+    // Starts wrapped storage and log writer
+    void Start() override;
+
+    // Writes all the changes and stops the log, then the wrapped storage
+    void Stop() override;
+
+    /**
+     * Restores wrapped storage from the log, see AppendLog::Replay. Changes are not logged again
+     */
+    std::size_t Replay(std::size_t threads = 1) { return _log.Replay(*_storage, threads); }
+
+    /**
+     * Starts log rewrite, see AppendLog::Rewrite. Changes are blocked until the process is forked
+     */
+    bool Rewrite();
+
+    // Wrapped storage, changes made to it directly are not logged
+    Afina::Storage &Wrapped() { return *_storage; }
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override { return _storage->Get(key, value); }
+
+    // Implements Afina::Storage interface
+    bool GetValue(const std::string &key, Value &value) override { return _storage->GetValue(key, value); }
+
+    // Implements Afina::Storage interface
+    std::size_t MultiGet(const std::vector<std::string> &keys, std::vector<Value> &values) override {
+        return _storage->MultiGet(keys, values);
+    }
+
+    // Implements Afina::Storage interface
+    bool PutExpiring(const std::string &key, const std::string &value, uint32_t exptime) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsentExpiring(const std::string &key, const std::string &value, uint32_t exptime) override;
+
+    // Implements Afina::Storage interface
+    bool SetExpiring(const std::string &key, const std::string &value, uint32_t exptime) override;
+
+    // Implements Afina::Storage interface
+    bool Touch(const std::string &key, uint32_t exptime) override;
+
+    // Implements Afina::Storage interface
+    bool GetAndTouch(const std::string &key, std::string &value, uint32_t exptime) override;
+
+    // Implements Afina::Storage interface, logged as put of the new value
+    bool Update(const std::string &key, const Updater &updater) override;
+
+    // Implements Afina::Storage interface
+    bool GetCas(const std::string &key, Value &value, uint64_t &cas) override {
+        return _storage->GetCas(key, value, cas);
+    }
+
+    // Implements Afina::Storage interface, logged as put once value is stored
+    CasResult CompareAndSwap(const std::string &key, const std::string &value, uint64_t cas,
+                             uint32_t exptime) override;
+
+    // Implements Afina::Storage interface, only the added data is logged
+    bool Append(const std::string &key, const std::string &data) override;
+
+    // Implements Afina::Storage interface, only the added data is logged
+    bool Prepend(const std::string &key, const std::string &data) override;
+
+    // Implements Afina::Storage interface
+    bool ForEach(const Visitor &visitor) override { return _storage->ForEach(visitor); }
+
+    // Implements Afina::Storage interface
+    void Freeze(const std::function<void()> &action) override { _storage->Freeze(action); }
+
+    // Implements Afina::Storage interface, log statistics follow ones of the wrapped storage
+    void Stats(std::vector<std::pair<std::string, std::string>> &stats) override;
+
+private:
+    static const std::size_t stripes = 64;
+
+    // Makes change under the key stripe lock and appends record if it succeeds, waits for sync if needed.
+    // Value and exptime are read once change is applied, so apply could fill them
+    template <typename F>
+    bool change(const std::string &key, AppendLog::Op op, const std::string &value, const uint32_t &exptime,
+                F apply);
+
+    std::shared_ptr<Afina::Storage> _storage;
+    AppendLog _log;
+    const bool _sync;
+
+    std::mutex _stripes[stripes];
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_LOGGED_STORAGE_H
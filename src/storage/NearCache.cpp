@@ -0,0 +1,309 @@
+#include "NearCache.h"
+
+#include <algorithm>
+
+#include <time.h>
+
+namespace Afina {
+namespace Backend {
+
+namespace {
+
+// Read counters of a thread are halved after that many reads per counter
+const std::size_t aging_period = 16;
+
+} // namespace
+
+constexpr std::size_t NearCache::kStripes;
+constexpr std::size_t NearCache::kCounters;
+
+NearCache::NearCache(std::shared_ptr<Afina::Storage> storage, std::size_t capacity, std::size_t threshold,
+                     std::chrono::milliseconds lifetime)
+    : _storage(std::move(storage)), _capacity(std::max<std::size_t>(capacity, 1)),
+      _threshold(uint8_t(std::min<std::size_t>(std::max<std::size_t>(threshold, 1), 255))),
+      _lifetime(uint32_t(lifetime.count())) {}
+
+NearCache::Local::~Local() {
+    for (auto &entry : entries) {
+        if (entry.blob != nullptr) {
+            release_blob(entry.blob);
+        }
+    }
+}
+
+// See NearCache.h
+bool NearCache::Put(const std::string &key, const std::string &value) {
+    bool result = _storage->Put(key, value);
+    changed(key);
+    return result;
+}
+
+// See NearCache.h
+bool NearCache::PutIfAbsent(const std::string &key, const std::string &value) {
+    bool result = _storage->PutIfAbsent(key, value);
+    changed(key);
+    return result;
+}
+
+// See NearCache.h
+bool NearCache::Set(const std::string &key, const std::string &value) {
+    bool result = _storage->Set(key, value);
+    changed(key);
+    return result;
+}
+
+// See NearCache.h
+bool NearCache::Delete(const std::string &key) {
+    bool result = _storage->Delete(key);
+    changed(key);
+    return result;
+}
+
+// See NearCache.h
+bool NearCache::Get(const std::string &key, std::string &value) {
+    std::size_t hash = std::hash<std::string>()(key);
+    Local &cache = local();
+    Entry *entry = lookup(cache, key, hash);
+    if (entry != nullptr) {
+        value = entry->blob->data;
+        return true;
+    }
+    if (!hot(cache, hash)) {
+        return _storage->Get(key, value);
+    }
+
+    uint64_t version = stripe(hash).version.load(std::memory_order_acquire);
+    if (!_storage->Get(key, value)) {
+        return false;
+    }
+    fill(cache, key, hash, version, value.data(), value.size());
+    return true;
+}
+
+// See NearCache.h
+bool NearCache::GetValue(const std::string &key, Value &value) {
+    std::size_t hash = std::hash<std::string>()(key);
+    Local &cache = local();
+    Entry *entry = lookup(cache, key, hash);
+    if (entry != nullptr) {
+        entry->blob->refs.fetch_add(1, std::memory_order_relaxed);
+        value = Value(entry->blob, &release_blob, entry->blob->data.data(), entry->blob->data.size());
+        return true;
+    }
+    if (!hot(cache, hash)) {
+        return _storage->GetValue(key, value);
+    }
+
+    uint64_t version = stripe(hash).version.load(std::memory_order_acquire);
+    if (!_storage->GetValue(key, value)) {
+        return false;
+    }
+    fill(cache, key, hash, version, value.data(), value.size());
+    return true;
+}
+
+// See NearCache.h
+std::size_t NearCache::MultiGet(const std::vector<std::string> &keys, std::vector<Value> &values) {
+    Local &cache = local();
+    values.clear();
+    values.resize(keys.size());
+
+    // Keys which are not in the cache, hot ones are remembered with the version they are read at
+    std::size_t found = 0;
+    std::vector<std::size_t> hashes(keys.size());
+    std::vector<std::size_t> missing;
+    std::vector<std::pair<std::size_t, uint64_t>> filling;
+    for (std::size_t i = 0; i < keys.size(); i++) {
+        hashes[i] = std::hash<std::string>()(keys[i]);
+        Entry *entry = lookup(cache, keys[i], hashes[i]);
+        if (entry != nullptr) {
+            entry->blob->refs.fetch_add(1, std::memory_order_relaxed);
+            values[i] = Value(entry->blob, &release_blob, entry->blob->data.data(), entry->blob->data.size());
+            found++;
+            continue;
+        }
+        if (hot(cache, hashes[i])) {
+            filling.emplace_back(missing.size(), stripe(hashes[i]).version.load(std::memory_order_acquire));
+        }
+        missing.push_back(i);
+    }
+    if (missing.empty()) {
+        return found;
+    }
+
+    std::vector<Value> looked_up;
+    if (missing.size() == keys.size()) {
+        found = _storage->MultiGet(keys, looked_up);
+    } else {
+        std::vector<std::string> missing_keys;
+        missing_keys.reserve(missing.size());
+        for (std::size_t i : missing) {
+            missing_keys.push_back(keys[i]);
+        }
+        found += _storage->MultiGet(missing_keys, looked_up);
+    }
+
+    for (auto &fill_at : filling) {
+        const Value &value = looked_up[fill_at.first];
+        std::size_t i = missing[fill_at.first];
+        if (value) {
+            fill(cache, keys[i], hashes[i], fill_at.second, value.data(), value.size());
+        }
+    }
+    for (std::size_t j = 0; j < missing.size(); j++) {
+        values[missing[j]] = std::move(looked_up[j]);
+    }
+    return found;
+}
+
+// See NearCache.h
+bool NearCache::PutExpiring(const std::string &key, const std::string &value, uint32_t exptime) {
+    bool result = _storage->PutExpiring(key, value, exptime);
+    changed(key);
+    return result;
+}
+
+// See NearCache.h
+bool NearCache::PutIfAbsentExpiring(const std::string &key, const std::string &value, uint32_t exptime) {
+    bool result = _storage->PutIfAbsentExpiring(key, value, exptime);
+    changed(key);
+    return result;
+}
+
+// See NearCache.h
+bool NearCache::SetExpiring(const std::string &key, const std::string &value, uint32_t exptime) {
+    bool result = _storage->SetExpiring(key, value, exptime);
+    changed(key);
+    return result;
+}
+
+// See NearCache.h
+bool NearCache::Touch(const std::string &key, uint32_t exptime) {
+    bool result = _storage->Touch(key, exptime);
+    changed(key);
+    return result;
+}
+
+// See NearCache.h
+bool NearCache::GetAndTouch(const std::string &key, std::string &value, uint32_t exptime) {
+    bool result = _storage->GetAndTouch(key, value, exptime);
+    changed(key);
+    return result;
+}
+
+// See NearCache.h
+bool NearCache::Update(const std::string &key, const Updater &updater) {
+    bool result = _storage->Update(key, updater);
+    changed(key);
+    return result;
+}
+
+// See NearCache.h
+NearCache::CasResult NearCache::CompareAndSwap(const std::string &key, const std::string &value, uint64_t cas,
+                                               uint32_t exptime) {
+    CasResult result = _storage->CompareAndSwap(key, value, cas, exptime);
+    changed(key);
+    return result;
+}
+
+// See NearCache.h
+bool NearCache::Append(const std::string &key, const std::string &data) {
+    bool result = _storage->Append(key, data);
+    changed(key);
+    return result;
+}
+
+// See NearCache.h
+bool NearCache::Prepend(const std::string &key, const std::string &data) {
+    bool result = _storage->Prepend(key, data);
+    changed(key);
+    return result;
+}
+
+// See NearCache.h
+void NearCache::Stats(std::vector<std::pair<std::string, std::string>> &stats) {
+    _storage->Stats(stats);
+
+    std::size_t hits = 0, misses = 0;
+    _locals.ForEach([&hits, &misses](Local &cache) {
+        hits += cache.hits.load(std::memory_order_relaxed);
+        misses += cache.misses.load(std::memory_order_relaxed);
+    });
+    stats.emplace_back("near_cache_hits", std::to_string(hits));
+    stats.emplace_back("near_cache_misses", std::to_string(misses));
+}
+
+uint32_t NearCache::now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    return uint32_t(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+void NearCache::release_blob(void *owner) {
+    Blob *blob = static_cast<Blob *>(owner);
+    if (blob->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        delete blob;
+    }
+}
+
+NearCache::Local &NearCache::local() {
+    Local &cache = _locals.Get();
+    if (cache.entries.empty()) {
+        cache.entries.resize(_capacity);
+    }
+    return cache;
+}
+
+NearCache::Entry *NearCache::lookup(Local &cache, const std::string &key, std::size_t hash) {
+    Entry &entry = cache.entries[hash % _capacity];
+    if (entry.blob == nullptr || entry.hash != hash || entry.key != key) {
+        cache.misses.store(cache.misses.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    // Changed since it has been cached or has been there for too long
+    if (entry.version != stripe(hash).version.load(std::memory_order_acquire) ||
+        int32_t(entry.expires - now_ms()) <= 0) {
+        release_blob(entry.blob);
+        entry.blob = nullptr;
+        cache.misses.store(cache.misses.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    cache.hits.store(cache.hits.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    return &entry;
+}
+
+bool NearCache::hot(Local &cache, std::size_t hash) {
+    if (++cache.reads == aging_period * kCounters) {
+        cache.reads = 0;
+        for (auto &counter : cache.counters) {
+            counter /= 2;
+        }
+    }
+
+    uint8_t &counter = cache.counters[(hash >> 16) & (kCounters - 1)];
+    if (counter < 255) {
+        counter++;
+    }
+    return counter >= _threshold;
+}
+
+void NearCache::fill(Local &cache, const std::string &key, std::size_t hash, uint64_t version, const char *data,
+                     std::size_t size) {
+    Entry &entry = cache.entries[hash % _capacity];
+    if (entry.blob != nullptr) {
+        release_blob(entry.blob);
+    }
+
+    Blob *blob = new Blob();
+    blob->refs.store(1, std::memory_order_relaxed);
+    blob->data.assign(data, size);
+    entry.key = key;
+    entry.hash = hash;
+    entry.version = version;
+    entry.expires = now_ms() + _lifetime;
+    entry.blob = blob;
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,199 @@
+#ifndef AFINA_STORAGE_NEAR_CACHE_H
+#define AFINA_STORAGE_NEAR_CACHE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <afina/Storage.h>
+#include <afina/concurrency/ThreadLocal.h>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Storage with per thread cache of hot keys
+ * Wraps thread safe storage and keeps a small cache of its own in every thread reading it. Thread counts
+ * reads of every key in a tiny sketch, and once key is read often enough its value is copied into the
+ * cache of the thread. Next reads of that key are served from the cache with no lock and no write to
+ * any memory shared with other threads.
+ *
+ * Every change of a key increments version of its stripe after the wrapped storage is changed, cached
+ * value remembers version of the stripe it has been read at and is valid while that version is current.
+ * Checking it is a read of the cache line, which stays shared between cores as long as keys of the
+ * stripe aren't changed. Keys evicted or expired by the wrapped storage itself don't change versions,
+ * so cached value lives no longer than the given lifetime.
+ *
+ * Get and MultiGet are cached, everything else goes straight to the wrapped storage
+ */
+class NearCache : public Afina::Storage {
+public:
+    /**
+     * @param storage to wrap, must be thread safe
+     * @param capacity number of keys each thread caches
+     * @param threshold number of reads after which key is considered hot
+     * @param lifetime for how long value is cached at most
+     */
+    NearCache(std::shared_ptr<Afina::Storage> storage, std::size_t capacity = 64, std::size_t threshold = 8,
+              std::chrono::milliseconds lifetime = std::chrono::milliseconds(1000));
+    ~NearCache() {}
+
+    // Starts wrapped storage
+    void Start() override { _storage->Start(); }
+
+    // Stops wrapped storage
+    void Stop() override { _storage->Stop(); }
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override;
+
+    // Implements Afina::Storage interface, hot keys are read from the cache of the thread
+    bool Get(const std::string &key, std::string &value) override;
+
+    // Implements Afina::Storage interface, hot keys are read from the cache of the thread
+    bool GetValue(const std::string &key, Value &value) override;
+
+    // Implements Afina::Storage interface, keys missing in the cache of the thread are looked up at once
+    std::size_t MultiGet(const std::vector<std::string> &keys, std::vector<Value> &values) override;
+
+    // Implements Afina::Storage interface
+    bool PutExpiring(const std::string &key, const std::string &value, uint32_t exptime) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsentExpiring(const std::string &key, const std::string &value, uint32_t exptime) override;
+
+    // Implements Afina::Storage interface
+    bool SetExpiring(const std::string &key, const std::string &value, uint32_t exptime) override;
+
+    // Implements Afina::Storage interface
+    bool Touch(const std::string &key, uint32_t exptime) override;
+
+    // Implements Afina::Storage interface
+    bool GetAndTouch(const std::string &key, std::string &value, uint32_t exptime) override;
+
+    // Implements Afina::Storage interface
+    bool Update(const std::string &key, const Updater &updater) override;
+
+    // Implements Afina::Storage interface, version is known to the wrapped storage only
+    bool GetCas(const std::string &key, Value &value, uint64_t &cas) override {
+        return _storage->GetCas(key, value, cas);
+    }
+
+    // Implements Afina::Storage interface
+    CasResult CompareAndSwap(const std::string &key, const std::string &value, uint64_t cas,
+                             uint32_t exptime) override;
+
+    // Implements Afina::Storage interface
+    bool Append(const std::string &key, const std::string &data) override;
+
+    // Implements Afina::Storage interface
+    bool Prepend(const std::string &key, const std::string &data) override;
+
+    // Implements Afina::Storage interface
+    bool ForEach(const Visitor &visitor) override { return _storage->ForEach(visitor); }
+
+    // Implements Afina::Storage interface
+    void Freeze(const std::function<void()> &action) override { _storage->Freeze(action); }
+
+    // Implements Afina::Storage interface, cache statistics of all threads follow ones of the wrapped storage
+    void Stats(std::vector<std::pair<std::string, std::string>> &stats) override;
+
+private:
+    // Number of version stripes, power of 2
+    static constexpr std::size_t kStripes = 1024;
+
+    // Number of read counters of each thread, power of 2
+    static constexpr std::size_t kCounters = 1024;
+
+    // Cached value, shared with the handles given out
+    struct Blob {
+        std::atomic<std::size_t> refs;
+        std::string data;
+    };
+
+    struct Entry {
+        std::string key;
+        std::size_t hash = 0;
+        uint64_t version = 0;
+        uint32_t expires = 0;
+        Blob *blob = nullptr;
+    };
+
+    // Version of the keys with the same hash bits
+    struct Stripe {
+        std::atomic<uint64_t> version{0};
+
+        // Keeps versions of different stripes on different cache lines
+        char padding[64 - sizeof(std::atomic<uint64_t>)];
+    };
+
+    // Cache of a single thread
+    struct Local {
+        Local() : counters(kCounters, 0), reads(0), hits(0), misses(0) {}
+        ~Local();
+
+        // Direct mapped by key hash
+        std::vector<Entry> entries;
+
+        // Lossy read counters of keys, halved once in a while so that key has to stay hot
+        std::vector<uint8_t> counters;
+        std::size_t reads;
+
+        // Statistics, written by the owner thread only
+        std::atomic<std::size_t> hits;
+        std::atomic<std::size_t> misses;
+    };
+
+    // Current coarse monotonic time in milliseconds
+    static uint32_t now_ms();
+
+    static void release_blob(void *owner);
+
+    Stripe &stripe(std::size_t hash) { return _stripes[hash & (kStripes - 1)]; }
+
+    // Marks change of the key, call once the wrapped storage is changed
+    void changed(const std::string &key) {
+        stripe(std::hash<std::string>()(key)).version.fetch_add(1, std::memory_order_release);
+    }
+
+    // Cache of the calling thread, created on first use
+    Local &local();
+
+    // Returns valid entry of the key, nullptr if key isn't cached
+    Entry *lookup(Local &local, const std::string &key, std::size_t hash);
+
+    // Counts read of the key, returns true if it is hot
+    bool hot(Local &local, std::size_t hash);
+
+    // Caches value read at the given stripe version
+    void fill(Local &local, const std::string &key, std::size_t hash, uint64_t version, const char *data,
+              std::size_t size);
+
+    std::shared_ptr<Afina::Storage> _storage;
+    const std::size_t _capacity;
+    const uint8_t _threshold;
+    const uint32_t _lifetime;
+
+    Stripe _stripes[kStripes];
+    Afina::Concurrency::ThreadLocal<Local> _locals;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_NEAR_CACHE_H
@@ -0,0 +1,411 @@
+#include "PartitionedLRU.h"
+
+#include <algorithm>
+#include <map>
+#include <stdexcept>
+
+#include <pthread.h>
+#include <sched.h>
+
+namespace Afina {
+namespace Backend {
+
+namespace {
+
+// Number of times owner checks its empty inbox before going to sleep, and caller checks its request
+// before yielding CPU
+const int spins = 1000;
+
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+std::once_flag atfork_once;
+
+// CPUs the process is allowed to run on
+std::vector<int> allowed_cpus() {
+    std::vector<int> cpus;
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET(cpu, &allowed)) {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+    return cpus;
+}
+
+} // namespace
+
+bool PartitionedLRU::forked = false;
+
+PartitionedLRU::PartitionedLRU(size_t max_size, size_t partitions)
+    : _owners(partitions != 0 ? partitions : std::max<std::size_t>(1, allowed_cpus().size())) {
+    if (max_size / _owners.size() < Item::Footprint(0, 0)) {
+        throw std::invalid_argument("Partition budget is less than footprint of an empty item");
+    }
+    std::call_once(atfork_once, []() { pthread_atfork(nullptr, nullptr, &PartitionedLRU::on_fork); });
+
+    // Owners are pinned only when every one could get a CPU of its own, owner stays unpinned if the
+    // kernel refuses
+    std::vector<int> cpus = allowed_cpus();
+    for (std::size_t i = 0; i < _owners.size(); i++) {
+        Owner &owner = _owners[i];
+        owner.partition.reset(new Partition(max_size / _owners.size()));
+        owner.thread = std::thread(&PartitionedLRU::serve, std::ref(owner));
+        if (_owners.size() <= cpus.size()) {
+            cpu_set_t cpu;
+            CPU_ZERO(&cpu);
+            CPU_SET(cpus[i], &cpu);
+            if (pthread_setaffinity_np(owner.thread.native_handle(), sizeof(cpu), &cpu) == 0) {
+                owner.cpu = cpus[i];
+            }
+        }
+    }
+}
+
+PartitionedLRU::~PartitionedLRU() {
+    for (std::size_t i = 0; i < _owners.size(); i++) {
+        Owner &owner = _owners[i];
+        {
+            std::lock_guard<std::mutex> lock(owner.mutex);
+            owner.stopping = true;
+        }
+        owner.wakeup.notify_one();
+        owner.thread.join();
+    }
+}
+
+// See PartitionedLRU.h
+bool PartitionedLRU::Put(const std::string &key, const std::string &value) {
+    bool result;
+    run(partition_of(key), [&](Partition &partition) { result = partition.Put(key, value); });
+    return result;
+}
+
+// See PartitionedLRU.h
+bool PartitionedLRU::PutIfAbsent(const std::string &key, const std::string &value) {
+    bool result;
+    run(partition_of(key), [&](Partition &partition) { result = partition.PutIfAbsent(key, value); });
+    return result;
+}
+
+// See PartitionedLRU.h
+bool PartitionedLRU::Set(const std::string &key, const std::string &value) {
+    bool result;
+    run(partition_of(key), [&](Partition &partition) { result = partition.Set(key, value); });
+    return result;
+}
+
+// See PartitionedLRU.h
+bool PartitionedLRU::Delete(const std::string &key) {
+    bool result;
+    run(partition_of(key), [&](Partition &partition) { result = partition.Delete(key); });
+    return result;
+}
+
+// See PartitionedLRU.h
+bool PartitionedLRU::Get(const std::string &key, std::string &value) {
+    bool result;
+    run(partition_of(key), [&](Partition &partition) { result = partition.Get(key, value); });
+    return result;
+}
+
+// See PartitionedLRU.h
+bool PartitionedLRU::GetValue(const std::string &key, Value &value) {
+    bool result;
+    run(partition_of(key), [&](Partition &partition) { result = partition.GetValue(key, value); });
+    return result;
+}
+
+// See PartitionedLRU.h
+std::size_t PartitionedLRU::MultiGet(const std::vector<std::string> &keys, std::vector<Value> &values) {
+    std::vector<std::size_t> hashes(keys.size());
+    std::vector<std::vector<std::size_t>> positions(_owners.size());
+    for (std::size_t i = 0; i < keys.size(); i++) {
+        hashes[i] = std::hash<std::string>()(keys[i]);
+        positions[partition_of(hashes[i])].push_back(i);
+    }
+
+    values.clear();
+    values.resize(keys.size());
+    if (forked) {
+        std::size_t found = 0;
+        for (std::size_t i = 0; i < _owners.size(); i++) {
+            found += _owners[i].partition->get_many(keys, hashes, positions[i], values);
+        }
+        return found;
+    }
+
+    // Every owner fills its own positions of values, all of them at once
+    std::vector<std::size_t> found(_owners.size(), 0);
+    std::vector<std::function<void(Partition &)>> lookups(_owners.size());
+    std::unique_ptr<Request[]> requests(new Request[_owners.size()]);
+    for (std::size_t i = 0; i < _owners.size(); i++) {
+        if (!positions[i].empty()) {
+            lookups[i] = [&, i](Partition &partition) {
+                found[i] = partition.get_many(keys, hashes, positions[i], values);
+            };
+            prepare(requests[i], lookups[i]);
+            post(_owners[i], requests[i]);
+        }
+    }
+
+    std::size_t total = 0;
+    for (std::size_t i = 0; i < _owners.size(); i++) {
+        if (!positions[i].empty()) {
+            wait(requests[i]);
+            total += found[i];
+        }
+    }
+    return total;
+}
+
+// See PartitionedLRU.h
+bool PartitionedLRU::ForEach(const Visitor &visitor) {
+    for (std::size_t i = 0; i < _owners.size(); i++) {
+        run(i, [&](Partition &partition) { partition.ForEach(visitor); });
+    }
+    return true;
+}
+
+// See PartitionedLRU.h
+void PartitionedLRU::Freeze(const std::function<void()> &action) {
+    if (forked) {
+        action();
+        return;
+    }
+
+    // Owners parked by concurrent freezes in different order would wait for each other forever
+    std::lock_guard<std::mutex> lock(_freeze_mutex);
+
+    // Every owner parks on its request until action is done
+    std::atomic<std::size_t> parked(0);
+    std::atomic<bool> released(false);
+    auto park = [&](Partition &) {
+        parked.fetch_add(1);
+        while (!released.load(std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+    };
+
+    std::unique_ptr<Request[]> requests(new Request[_owners.size()]);
+    for (std::size_t i = 0; i < _owners.size(); i++) {
+        prepare(requests[i], park);
+        post(_owners[i], requests[i]);
+    }
+    while (parked.load() < _owners.size()) {
+        std::this_thread::yield();
+    }
+
+    try {
+        action();
+    } catch (...) {
+        released.store(true, std::memory_order_release);
+        for (std::size_t i = 0; i < _owners.size(); i++) {
+            wait(requests[i]);
+        }
+        throw;
+    }
+    if (forked) {
+        // Action has forked and this is the child, there are no owners to release
+        return;
+    }
+    released.store(true, std::memory_order_release);
+    for (std::size_t i = 0; i < _owners.size(); i++) {
+        wait(requests[i]);
+    }
+}
+
+// See PartitionedLRU.h
+bool PartitionedLRU::PutExpiring(const std::string &key, const std::string &value, uint32_t exptime) {
+    bool result;
+    run(partition_of(key), [&](Partition &partition) { result = partition.PutExpiring(key, value, exptime); });
+    return result;
+}
+
+// See PartitionedLRU.h
+bool PartitionedLRU::PutIfAbsentExpiring(const std::string &key, const std::string &value, uint32_t exptime) {
+    bool result;
+    run(partition_of(key),
+        [&](Partition &partition) { result = partition.PutIfAbsentExpiring(key, value, exptime); });
+    return result;
+}
+
+// See PartitionedLRU.h
+bool PartitionedLRU::SetExpiring(const std::string &key, const std::string &value, uint32_t exptime) {
+    bool result;
+    run(partition_of(key), [&](Partition &partition) { result = partition.SetExpiring(key, value, exptime); });
+    return result;
+}
+
+// See PartitionedLRU.h
+bool PartitionedLRU::Touch(const std::string &key, uint32_t exptime) {
+    bool result;
+    run(partition_of(key), [&](Partition &partition) { result = partition.Touch(key, exptime); });
+    return result;
+}
+
+// See PartitionedLRU.h
+bool PartitionedLRU::GetAndTouch(const std::string &key, std::string &value, uint32_t exptime) {
+    bool result;
+    run(partition_of(key), [&](Partition &partition) { result = partition.GetAndTouch(key, value, exptime); });
+    return result;
+}
+
+// See PartitionedLRU.h
+bool PartitionedLRU::Update(const std::string &key, const Updater &updater) {
+    bool result;
+    run(partition_of(key), [&](Partition &partition) { result = partition.Update(key, updater); });
+    return result;
+}
+
+// See PartitionedLRU.h
+bool PartitionedLRU::GetCas(const std::string &key, Value &value, uint64_t &cas) {
+    bool result;
+    run(partition_of(key), [&](Partition &partition) { result = partition.GetCas(key, value, cas); });
+    return result;
+}
+
+// See PartitionedLRU.h
+PartitionedLRU::CasResult PartitionedLRU::CompareAndSwap(const std::string &key, const std::string &value,
+                                                         uint64_t cas, uint32_t exptime) {
+    CasResult result;
+    run(partition_of(key), [&](Partition &partition) { result = partition.CompareAndSwap(key, value, cas, exptime); });
+    return result;
+}
+
+// See PartitionedLRU.h
+bool PartitionedLRU::Append(const std::string &key, const std::string &data) {
+    bool result;
+    run(partition_of(key), [&](Partition &partition) { result = partition.Append(key, data); });
+    return result;
+}
+
+// See PartitionedLRU.h
+bool PartitionedLRU::Prepend(const std::string &key, const std::string &data) {
+    bool result;
+    run(partition_of(key), [&](Partition &partition) { result = partition.Prepend(key, data); });
+    return result;
+}
+
+// See PartitionedLRU.h
+void PartitionedLRU::Stats(std::vector<std::pair<std::string, std::string>> &stats) {
+    std::vector<std::string> names;
+    std::map<std::string, std::size_t> sums;
+    std::size_t batches = 0;
+    for (std::size_t i = 0; i < _owners.size(); i++) {
+        std::vector<std::pair<std::string, std::string>> partition_stats;
+        run(i, [&](Partition &partition) {
+            partition.Stats(partition_stats);
+            batches += _owners[i].batches;
+        });
+        for (auto &stat : partition_stats) {
+            if (sums.count(stat.first) == 0) {
+                names.push_back(stat.first);
+            }
+            sums[stat.first] += std::stoull(stat.second);
+        }
+    }
+
+    // Per item overhead isn't additive, it is computed for all partitions together
+    std::size_t items = sums["curr_items"];
+    sums["overhead_per_item"] = items > 0 ? (sums["bytes"] - sums["payload_bytes"]) / items : 0;
+    for (auto &name : names) {
+        stats.emplace_back(name, std::to_string(sums[name]));
+    }
+    stats.emplace_back("partitions", std::to_string(_owners.size()));
+    stats.emplace_back("partition_batches", std::to_string(batches));
+}
+
+bool PartitionedLRU::acquire_inline(Owner &owner) {
+    bool local = owner.cpu >= 0 && std::size_t(owner.cpu) == Afina::Concurrency::CoreLocal<Owner>::Current();
+    if (!local && !owner.sleeping.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    return !owner.busy.load(std::memory_order_relaxed) && !owner.busy.exchange(true, std::memory_order_acquire);
+}
+
+void PartitionedLRU::post(Owner &owner, Request &request) {
+    Request *head = owner.inbox.load(std::memory_order_relaxed);
+    do {
+        request.next = head;
+    } while (!owner.inbox.compare_exchange_weak(head, &request));
+
+    // Pairs with the owner setting sleeping flag before checking the inbox for the last time
+    if (owner.sleeping.load()) {
+        std::lock_guard<std::mutex> lock(owner.mutex);
+        owner.wakeup.notify_one();
+    }
+}
+
+void PartitionedLRU::wait(Request &request) {
+    for (int i = 0; !request.done.load(std::memory_order_acquire); i++) {
+        if (i < spins) {
+            cpu_relax();
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void PartitionedLRU::serve(Owner &owner) {
+    for (;;) {
+        Request *batch = owner.inbox.exchange(nullptr, std::memory_order_acquire);
+        if (batch == nullptr) {
+            for (int i = 0; i < spins && owner.inbox.load(std::memory_order_relaxed) == nullptr; i++) {
+                cpu_relax();
+            }
+            if (owner.inbox.load(std::memory_order_relaxed) != nullptr) {
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(owner.mutex);
+            owner.sleeping.store(true);
+            owner.wakeup.wait(lock, [&owner]() { return owner.stopping || owner.inbox.load() != nullptr; });
+            owner.sleeping.store(false);
+            if (owner.stopping && owner.inbox.load() == nullptr) {
+                return;
+            }
+            continue;
+        }
+
+        // Caller applying operation itself finishes shortly
+        for (int i = 0; owner.busy.exchange(true, std::memory_order_acquire); i++) {
+            if (i < spins) {
+                cpu_relax();
+            } else {
+                std::this_thread::yield();
+            }
+        }
+
+        // Inbox is a stack, requests are applied in the order they were pushed
+        Request *ordered = nullptr;
+        while (batch != nullptr) {
+            Request *next = batch->next;
+            batch->next = ordered;
+            ordered = batch;
+            batch = next;
+        }
+        while (ordered != nullptr) {
+            // Request is gone as soon as it is done
+            Request *next = ordered->next;
+            try {
+                ordered->call(ordered->context, *owner.partition);
+            } catch (...) {
+                ordered->error = std::current_exception();
+            }
+            ordered->done.store(true, std::memory_order_release);
+            ordered = next;
+        }
+        owner.batches++;
+        owner.busy.store(false, std::memory_order_release);
+    }
+}
+
+} // namespace Backend
+} // namespace Afina
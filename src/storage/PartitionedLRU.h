@@ -0,0 +1,228 @@
+#ifndef AFINA_STORAGE_PARTITIONED_LRU_H
+#define AFINA_STORAGE_PARTITIONED_LRU_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <afina/Storage.h>
+#include <afina/concurrency/CoreLocal.h>
+
+#include "SimpleLRU.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Shared nothing LRU
+ * Keyspace is split by hash into partitions, one per CPU by default. Every partition is a plain SimpleLRU
+ * owned by a thread pinned to its CPU, and only that thread ever touches it: there are no data locks, and
+ * list and index of the partition stay in the cache of a single core.
+ *
+ * Caller routes operation to the owner of the key: request is pushed onto lock free inbox of the owner
+ * and caller spins until it is done. Owner takes all requests pushed so far at once and applies them in
+ * order, then sleeps once its inbox stays empty for a while. Caller running on the CPU of the owner, or
+ * finding the owner asleep, applies operation itself instead, provided the owner isn't busy with a batch:
+ * data stays in the cache of the owner CPU then, or nobody is using it anyway. Budget is split between
+ * partitions evenly, LRU order is maintained per partition only.
+ *
+ * In a process forked inside Freeze, such as snapshot child, partitions are accessed directly, as the
+ * calling thread is the only one left
+ */
+class PartitionedLRU : public Afina::Storage {
+public:
+    /**
+     * @param max_size memory budget of all partitions together
+     * @param partitions number of partitions, 0 means one per CPU process is allowed to run on. Owners
+     * are pinned to those CPUs if there are enough of them
+     */
+    PartitionedLRU(size_t max_size = 1024, size_t partitions = 0);
+    ~PartitionedLRU();
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool GetValue(const std::string &key, Value &value) override;
+
+    // Implements Afina::Storage interface, partitions look up their keys in parallel
+    std::size_t MultiGet(const std::vector<std::string> &keys, std::vector<Value> &values) override;
+
+    // Implements Afina::Storage interface, partitions are visited one after another
+    bool ForEach(const Visitor &visitor) override;
+
+    // Implements Afina::Storage interface, all owners are parked while action runs
+    void Freeze(const std::function<void()> &action) override;
+
+    // Implements Afina::Storage interface
+    bool PutExpiring(const std::string &key, const std::string &value, uint32_t exptime) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsentExpiring(const std::string &key, const std::string &value, uint32_t exptime) override;
+
+    // Implements Afina::Storage interface
+    bool SetExpiring(const std::string &key, const std::string &value, uint32_t exptime) override;
+
+    // Implements Afina::Storage interface
+    bool Touch(const std::string &key, uint32_t exptime) override;
+
+    // Implements Afina::Storage interface
+    bool GetAndTouch(const std::string &key, std::string &value, uint32_t exptime) override;
+
+    // Implements Afina::Storage interface
+    bool Update(const std::string &key, const Updater &updater) override;
+
+    // Implements Afina::Storage interface
+    bool GetCas(const std::string &key, Value &value, uint64_t &cas) override;
+
+    // Implements Afina::Storage interface
+    CasResult CompareAndSwap(const std::string &key, const std::string &value, uint64_t cas,
+                             uint32_t exptime) override;
+
+    // Implements Afina::Storage interface
+    bool Append(const std::string &key, const std::string &data) override;
+
+    // Implements Afina::Storage interface
+    bool Prepend(const std::string &key, const std::string &data) override;
+
+    // Implements Afina::Storage interface, sums up statistics of partitions
+    void Stats(std::vector<std::pair<std::string, std::string>> &stats) override;
+
+private:
+    // Partition opens batch lookup for the owner
+    class Partition : public SimpleLRU {
+    public:
+        explicit Partition(size_t max_size) : SimpleLRU(max_size) {}
+        using SimpleLRU::get_many;
+    };
+
+    // Operation to be run by the owner. Lives on the stack of the caller, which waits until it is done
+    struct Request {
+        void (*call)(void *context, Partition &partition);
+        void *context;
+        Request *next;
+        std::atomic<bool> done;
+
+        // Exception thrown by the operation, rethrown to the caller
+        std::exception_ptr error;
+    };
+
+    // Partition with its thread, placed into cache lines of its own
+    struct Owner {
+        std::unique_ptr<Partition> partition;
+
+        // Requests pushed since the last batch, the most recent one first
+        std::atomic<Request *> inbox{nullptr};
+
+        // Set while partition is used by the owner or by a caller applying operation itself
+        std::atomic<bool> busy{false};
+
+        // CPU owner thread is pinned to, -1 if it isn't
+        int cpu = -1;
+
+        // Owner sleeps on the condition once inbox stays empty
+        std::atomic<bool> sleeping{false};
+        bool stopping = false;
+        std::mutex mutex;
+        std::condition_variable wakeup;
+
+        std::thread thread;
+
+        // Number of batches applied, used by owner only
+        std::size_t batches = 0;
+    };
+
+    template <typename F> static void call(void *context, Partition &partition) {
+        (*static_cast<F *>(context))(partition);
+    }
+
+    // Runs function on the partition by its owner and waits until it is done
+    template <typename F> void run(std::size_t index, F f) {
+        if (forked) {
+            f(*_owners[index].partition);
+            return;
+        }
+        Owner &owner = _owners[index];
+        if (acquire_inline(owner)) {
+            Release release(owner);
+            f(*owner.partition);
+            return;
+        }
+        Request request;
+        prepare(request, f);
+        post(owner, request);
+        wait(request);
+        if (request.error) {
+            std::rethrow_exception(request.error);
+        }
+    }
+
+    template <typename F> static void prepare(Request &request, F &f) {
+        request.call = &call<F>;
+        request.context = &f;
+        request.done.store(false, std::memory_order_relaxed);
+        request.error = nullptr;
+    }
+
+    // Partition responsible for the key hash
+    std::size_t partition_of(std::size_t hash) const {
+        // Index uses low bits of the same hash, so partition is taken from the high ones
+        return (hash >> (sizeof(std::size_t) * 4)) % _owners.size();
+    }
+
+    std::size_t partition_of(const std::string &key) const { return partition_of(std::hash<std::string>()(key)); }
+
+    // Takes partition for the caller to apply operation itself, if it is worth doing, see above
+    static bool acquire_inline(Owner &owner);
+
+    // Gives partition taken by acquire_inline back
+    struct Release {
+        explicit Release(Owner &owner) : owner(owner) {}
+        ~Release() { owner.busy.store(false, std::memory_order_release); }
+        Owner &owner;
+    };
+
+    // Pushes request to the inbox of the owner, wakes it up if needed
+    static void post(Owner &owner, Request &request);
+
+    // Waits until request is done
+    static void wait(Request &request);
+
+    // Main loop of the owner thread
+    static void serve(Owner &owner);
+
+    // Set in the child process once it is forked, owner threads aren't there
+    static bool forked;
+    static void on_fork() { forked = true; }
+
+    Afina::Concurrency::CoreLocal<Owner> _owners;
+
+    // Serializes Freeze calls
+    std::mutex _freeze_mutex;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_PARTITIONED_LRU_H
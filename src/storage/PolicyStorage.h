@@ -0,0 +1,23 @@
+#ifndef AFINA_STORAGE_POLICY_STORAGE_H
+#define AFINA_STORAGE_POLICY_STORAGE_H
+
+#include "EvictionPolicy.h"
+#include "SimpleLRU.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Storage with pluggable eviction policy
+ * SimpleLRU which evicts items chosen by Policy, see EvictionPolicy.h. Everything else, such as
+ * expiration, versions, cold tier and shared values, works the same as for SimpleLRU. Stats report hit
+ * ratio, so that policies could be compared on the real load.
+ *
+ * That is NOT thread safe implementaiton!! ThreadSafeBasicLRU takes a policy as well
+ */
+template <typename Policy> using PolicyStorage = BasicLRU<Policy>;
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_POLICY_STORAGE_H
@@ -0,0 +1,154 @@
+#include "ShardedLRU.h"
+
+#include <map>
+#include <stdexcept>
+
+#include "Item.h"
+
+namespace Afina {
+namespace Backend {
+
+ShardedLRU::ShardedLRU(size_t max_size, size_t n_shards) {
+    if (n_shards == 0) {
+        throw std::invalid_argument("Number of shards must be positive");
+    }
+    if (max_size / n_shards < Item::Footprint(0, 0)) {
+        throw std::invalid_argument("Shard budget is less than footprint of an empty item");
+    }
+    _shards.reserve(n_shards);
+    for (size_t i = 0; i < n_shards; i++) {
+        _shards.emplace_back(new ThreadSafeSimplLRU(max_size / n_shards));
+    }
+}
+
+// See ShardedLRU.h
+bool ShardedLRU::Put(const std::string &key, const std::string &value) { return shard(key).Put(key, value); }
+
+// See ShardedLRU.h
+bool ShardedLRU::PutIfAbsent(const std::string &key, const std::string &value) {
+    return shard(key).PutIfAbsent(key, value);
+}
+
+// See ShardedLRU.h
+bool ShardedLRU::Set(const std::string &key, const std::string &value) { return shard(key).Set(key, value); }
+
+// See ShardedLRU.h
+bool ShardedLRU::Delete(const std::string &key) { return shard(key).Delete(key); }
+
+// See ShardedLRU.h
+bool ShardedLRU::Get(const std::string &key, std::string &value) { return shard(key).Get(key, value); }
+
+// See ShardedLRU.h
+bool ShardedLRU::GetValue(const std::string &key, Value &value) { return shard(key).GetValue(key, value); }
+
+// See ShardedLRU.h
+std::size_t ShardedLRU::MultiGet(const std::vector<std::string> &keys, std::vector<Value> &values) {
+    // Shards are chosen by the same hash as the index uses, so it is computed once
+    std::vector<std::size_t> hashes(keys.size());
+    std::vector<std::vector<std::size_t>> positions(_shards.size());
+    for (std::size_t i = 0; i < keys.size(); i++) {
+        hashes[i] = std::hash<std::string>()(keys[i]);
+        positions[shard_of(hashes[i])].push_back(i);
+    }
+
+    values.clear();
+    values.resize(keys.size());
+    std::size_t found = 0;
+    for (std::size_t i = 0; i < _shards.size(); i++) {
+        if (!positions[i].empty()) {
+            found += _shards[i]->MultiGet(keys, hashes, positions[i], values);
+        }
+    }
+    return found;
+}
+
+// See ShardedLRU.h
+bool ShardedLRU::ForEach(const Visitor &visitor) {
+    for (auto &shard : _shards) {
+        shard->ForEach(visitor);
+    }
+    return true;
+}
+
+// See ShardedLRU.h
+void ShardedLRU::Freeze(const std::function<void()> &action) { freeze(0, action); }
+
+// See ShardedLRU.h
+bool ShardedLRU::PutExpiring(const std::string &key, const std::string &value, uint32_t exptime) {
+    return shard(key).PutExpiring(key, value, exptime);
+}
+
+// See ShardedLRU.h
+bool ShardedLRU::PutIfAbsentExpiring(const std::string &key, const std::string &value, uint32_t exptime) {
+    return shard(key).PutIfAbsentExpiring(key, value, exptime);
+}
+
+// See ShardedLRU.h
+bool ShardedLRU::SetExpiring(const std::string &key, const std::string &value, uint32_t exptime) {
+    return shard(key).SetExpiring(key, value, exptime);
+}
+
+// See ShardedLRU.h
+bool ShardedLRU::Touch(const std::string &key, uint32_t exptime) { return shard(key).Touch(key, exptime); }
+
+// See ShardedLRU.h
+bool ShardedLRU::GetAndTouch(const std::string &key, std::string &value, uint32_t exptime) {
+    return shard(key).GetAndTouch(key, value, exptime);
+}
+
+// See ShardedLRU.h
+bool ShardedLRU::Update(const std::string &key, const Updater &updater) {
+    return shard(key).Update(key, updater);
+}
+
+// See ShardedLRU.h
+bool ShardedLRU::GetCas(const std::string &key, Value &value, uint64_t &cas) {
+    return shard(key).GetCas(key, value, cas);
+}
+
+// See ShardedLRU.h
+ShardedLRU::CasResult ShardedLRU::CompareAndSwap(const std::string &key, const std::string &value, uint64_t cas,
+                                                 uint32_t exptime) {
+    return shard(key).CompareAndSwap(key, value, cas, exptime);
+}
+
+// See ShardedLRU.h
+bool ShardedLRU::Append(const std::string &key, const std::string &data) { return shard(key).Append(key, data); }
+
+// See ShardedLRU.h
+bool ShardedLRU::Prepend(const std::string &key, const std::string &data) { return shard(key).Prepend(key, data); }
+
+// See ShardedLRU.h
+void ShardedLRU::Stats(std::vector<std::pair<std::string, std::string>> &stats) {
+    std::vector<std::string> names;
+    std::map<std::string, std::size_t> sums;
+    for (auto &shard : _shards) {
+        std::vector<std::pair<std::string, std::string>> shard_stats;
+        shard->Stats(shard_stats);
+        for (auto &stat : shard_stats) {
+            if (sums.count(stat.first) == 0) {
+                names.push_back(stat.first);
+            }
+            sums[stat.first] += std::stoull(stat.second);
+        }
+    }
+
+    // Per item overhead isn't additive, it is computed for all shards together
+    std::size_t items = sums["curr_items"];
+    sums["overhead_per_item"] = items > 0 ? (sums["bytes"] - sums["payload_bytes"]) / items : 0;
+    for (auto &name : names) {
+        stats.emplace_back(name, std::to_string(sums[name]));
+    }
+    stats.emplace_back("shards", std::to_string(_shards.size()));
+}
+
+void ShardedLRU::freeze(std::size_t from, const std::function<void()> &action) {
+    if (from == _shards.size()) {
+        action();
+        return;
+    }
+    _shards[from]->Freeze([this, from, &action]() { freeze(from + 1, action); });
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,112 @@
+#ifndef AFINA_STORAGE_SHARDED_LRU_H
+#define AFINA_STORAGE_SHARDED_LRU_H
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <afina/Storage.h>
+
+#include "ThreadSafeSimpleLRU.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Lock striped LRU
+ * Keys are distributed by hash across a number of independent shards. Each shard is ThreadSafeSimplLRU
+ * with its own lock, its own eviction list and max_size / n_shards bytes of budget, so that operations
+ * on different shards never contend with each other.
+ *
+ * Note that LRU order is maintained per shard only, and an item larger than the budget of a single
+ * shard could not be stored at all. Number of shards that leaves a shard no room even for an empty
+ * item is rejected.
+ */
+class ShardedLRU : public Afina::Storage {
+public:
+    ShardedLRU(size_t max_size = 1024, size_t n_shards = 8);
+    ~ShardedLRU() {}
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool GetValue(const std::string &key, Value &value) override;
+
+    // Implements Afina::Storage interface, each shard is locked once per batch
+    std::size_t MultiGet(const std::vector<std::string> &keys, std::vector<Value> &values) override;
+
+    // Implements Afina::Storage interface, shards are visited one after another
+    bool ForEach(const Visitor &visitor) override;
+
+    // Implements Afina::Storage interface, locks all shards
+    void Freeze(const std::function<void()> &action) override;
+
+    // Implements Afina::Storage interface
+    bool PutExpiring(const std::string &key, const std::string &value, uint32_t exptime) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsentExpiring(const std::string &key, const std::string &value, uint32_t exptime) override;
+
+    // Implements Afina::Storage interface
+    bool SetExpiring(const std::string &key, const std::string &value, uint32_t exptime) override;
+
+    // Implements Afina::Storage interface
+    bool Touch(const std::string &key, uint32_t exptime) override;
+
+    // Implements Afina::Storage interface
+    bool GetAndTouch(const std::string &key, std::string &value, uint32_t exptime) override;
+
+    // Implements Afina::Storage interface
+    bool Update(const std::string &key, const Updater &updater) override;
+
+    // Implements Afina::Storage interface
+    bool GetCas(const std::string &key, Value &value, uint64_t &cas) override;
+
+    // Implements Afina::Storage interface
+    CasResult CompareAndSwap(const std::string &key, const std::string &value, uint64_t cas,
+                             uint32_t exptime) override;
+
+    // Implements Afina::Storage interface
+    bool Append(const std::string &key, const std::string &data) override;
+
+    // Implements Afina::Storage interface
+    bool Prepend(const std::string &key, const std::string &data) override;
+
+    // Implements Afina::Storage interface, stats of shards are added up
+    void Stats(std::vector<std::pair<std::string, std::string>> &stats) override;
+
+private:
+    // Runs action with shards from the given one to the last locked
+    void freeze(std::size_t from, const std::function<void()> &action);
+
+    // Returns number of shard responsible for the key with the given hash
+    std::size_t shard_of(std::size_t hash) const {
+        // Index uses low bits of the same hash, so shard is taken from the high ones
+        return (hash >> (sizeof(std::size_t) * 4)) % _shards.size();
+    }
+
+    // Returns shard responsible for the given key
+    ThreadSafeSimplLRU &shard(const std::string &key) { return *_shards[shard_of(std::hash<std::string>()(key))]; }
+
+    std::vector<std::unique_ptr<ThreadSafeSimplLRU>> _shards;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_SHARDED_LRU_H
@@ -1,152 +1,425 @@
 #include "SimpleLRU.h"
+
+#include <algorithm>
 #include <cassert>
 
 namespace Afina {
 namespace Backend {
 
+namespace {
+
+// Maximum number of expired items reclaimed by a single write operation
+const std::size_t reclaim_slice = 8;
+
+} // namespace
+
+template <typename Policy> constexpr std::size_t BasicLRU<Policy>::kPrefetchDistance;
+
 // See MapBasedGlobalLockImpl.h
-bool SimpleLRU::Put(const std::string &key, const std::string &value) {
-    if (key.size() + value.size() > _max_size) {
-        return false;
-    }
-    auto it = _lru_index.find(std::cref(key));
-    if (it == _lru_index.end()) {
-        put(key, value);
-    } else {
-        set(&(it->second.get()), value);
+template <typename Policy> bool BasicLRU<Policy>::Put(const std::string &key, const std::string &value) {
+    return BasicLRU::PutExpiring(key, value, 0);
+}
+
+// See MapBasedGlobalLockImpl.h
+template <typename Policy> bool BasicLRU<Policy>::PutIfAbsent(const std::string &key, const std::string &value) {
+    return BasicLRU::PutIfAbsentExpiring(key, value, 0);
+}
+
+// See MapBasedGlobalLockImpl.h
+template <typename Policy> bool BasicLRU<Policy>::Set(const std::string &key, const std::string &value) {
+    return BasicLRU::SetExpiring(key, value, 0);
+}
+
+// See MapBasedGlobalLockImpl.h
+template <typename Policy> bool BasicLRU<Policy>::Delete(const std::string &key) {
+    Reclaim(reclaim_slice);
+    std::size_t hash = _lru_index.Hash(key);
+    Item *item = lookup(key, hash);
+    if (item == nullptr) {
+        return _cold != nullptr && _cold->Erase(key, hash);
     }
+    remove(item);
     return true;
 }
 
 // See MapBasedGlobalLockImpl.h
-bool SimpleLRU::PutIfAbsent(const std::string &key, const std::string &value) {
-    if (key.size() + value.size() > _max_size) {
+template <typename Policy> bool BasicLRU<Policy>::Get(const std::string &key, std::string &value) {
+    Item *item = fetch(key, _lru_index.Hash(key));
+    if (item == nullptr) {
+        _misses++;
         return false;
     }
-    if (_lru_index.find(std::cref(key)) != _lru_index.end()) {
+    _hits++;
+    value.assign(item->value(), item->value_size);
+    access(item);
+    return true;
+}
+
+// See SimpleLRU.h
+template <typename Policy> bool BasicLRU<Policy>::GetValue(const std::string &key, Value &value) {
+    Item *item = fetch(key, _lru_index.Hash(key));
+    if (item == nullptr) {
+        _misses++;
         return false;
     }
-    put(key, value);
+    _hits++;
+    value = item->Share();
+    access(item);
     return true;
 }
 
-// See MapBasedGlobalLockImpl.h
-bool SimpleLRU::Set(const std::string &key, const std::string &value) {
-    if (key.size() + value.size() > _max_size) {
-        return false;
+// See SimpleLRU.h
+template <typename Policy>
+std::size_t BasicLRU<Policy>::MultiGet(const std::vector<std::string> &keys, std::vector<Value> &values) {
+    std::vector<std::size_t> hashes(keys.size());
+    std::vector<std::size_t> positions(keys.size());
+    for (std::size_t i = 0; i < keys.size(); i++) {
+        hashes[i] = key_hash(keys[i]);
+        positions[i] = i;
     }
-    auto it = _lru_index.find(std::cref(key));
-    if (it == _lru_index.end()) {
-        return false;
+    values.clear();
+    values.resize(keys.size());
+    return get_many(keys, hashes, positions, values);
+}
+
+// See SimpleLRU.h
+template <typename Policy> bool BasicLRU<Policy>::ForEach(const Visitor &visitor) {
+    if (_cold != nullptr) {
+        _cold->ForEach(visitor);
     }
-    set(&(it->second.get()), value);
+    _policy.ForEach([&visitor](Item *item) {
+        if (!TimingWheel::Expired(item)) {
+            visitor(item->key(), item->key_size, item->value(), item->value_size, item->exptime);
+        }
+    });
     return true;
 }
 
-// See MapBasedGlobalLockImpl.h
-bool SimpleLRU::Delete(const std::string &key) {
-    auto it = _lru_index.find(std::cref(key));
-    if (it == _lru_index.end()) {
+// See SimpleLRU.h
+template <typename Policy>
+bool BasicLRU<Policy>::PutExpiring(const std::string &key, const std::string &value, uint32_t exptime) {
+    if (Item::Footprint(key.size(), value.size()) > _max_size) {
         return false;
     }
-    lru_node *node_ptr = &(it->second.get());
-    _lru_index.erase(it);
-    if (node_ptr == _lru_head.get()) {
-        node_ptr->next->prev = node_ptr->prev;
-        _lru_head = std::move(node_ptr->next);
-    } else {
-        if (node_ptr->next) {
-            node_ptr->next->prev = node_ptr->prev;
-        } else {
-            _lru_head->prev = node_ptr->prev;
+    Reclaim(reclaim_slice);
+    std::size_t hash = _lru_index.Hash(key);
+    Item *item = _lru_index.Find(key, hash);
+    if (item == nullptr) {
+        // Stale copy in the cold tier must not come back once the new one gets evicted
+        if (_cold != nullptr) {
+            _cold->Forget(hash);
         }
-        node_ptr->prev->next = std::move(node_ptr->next);
+        return put(key, value, hash, exptime) != nullptr;
     }
+    return set(item, value, exptime);
+}
+
+// See SimpleLRU.h
+template <typename Policy>
+bool BasicLRU<Policy>::PutIfAbsentExpiring(const std::string &key, const std::string &value, uint32_t exptime) {
+    if (Item::Footprint(key.size(), value.size()) > _max_size) {
+        return false;
+    }
+    Reclaim(reclaim_slice);
+    std::size_t hash = _lru_index.Hash(key);
+    if (fetch(key, hash) != nullptr) {
+        return false;
+    }
+    return put(key, value, hash, exptime) != nullptr;
+}
+
+// See SimpleLRU.h
+template <typename Policy>
+bool BasicLRU<Policy>::SetExpiring(const std::string &key, const std::string &value, uint32_t exptime) {
+    if (Item::Footprint(key.size(), value.size()) > _max_size) {
+        return false;
+    }
+    Reclaim(reclaim_slice);
+    Item *item = fetch(key, _lru_index.Hash(key));
+    if (item == nullptr) {
+        return false;
+    }
+    return set(item, value, exptime);
+}
+
+// See SimpleLRU.h
+template <typename Policy> bool BasicLRU<Policy>::Touch(const std::string &key, uint32_t exptime) {
+    Reclaim(reclaim_slice);
+    Item *item = fetch(key, _lru_index.Hash(key));
+    if (item == nullptr) {
+        return false;
+    }
+    expire(item, exptime);
+    access(item);
     return true;
 }
 
-// See MapBasedGlobalLockImpl.h
-bool SimpleLRU::Get(const std::string &key, std::string &value) {
-    auto it = _lru_index.find(std::cref(key));
-    if (it == _lru_index.end()) {
+// See SimpleLRU.h
+template <typename Policy>
+bool BasicLRU<Policy>::GetAndTouch(const std::string &key, std::string &value, uint32_t exptime) {
+    Reclaim(reclaim_slice);
+    Item *item = fetch(key, _lru_index.Hash(key));
+    if (item == nullptr) {
         return false;
     }
-    value = it->second.get().value;
-    to_head(&(it->second.get()));
+    value.assign(item->value(), item->value_size);
+    expire(item, exptime);
+    access(item);
     return true;
 }
 
-void SimpleLRU::to_head(lru_node *node_ptr) {
-    if (node_ptr != _lru_head.get()) {
-        if (!node_ptr->next) {
-            node_ptr->next = std::move(_lru_head);
-            _lru_head = std::move(node_ptr->prev->next);
-            node_ptr->prev->next = nullptr;
-        } else {
-            node_ptr->next->prev = node_ptr->prev;
-            std::unique_ptr<lru_node> new_head = std::move(node_ptr->prev->next);
-            node_ptr->prev->next = std::move(node_ptr->next);
-            node_ptr->next = std::move(_lru_head);
-            _lru_head = std::move(new_head);
-            new_head = nullptr;
-            node_ptr->prev = node_ptr->next->prev;
-            node_ptr->next->prev = node_ptr;
-        }
+// See SimpleLRU.h
+template <typename Policy> bool BasicLRU<Policy>::Update(const std::string &key, const Updater &updater) {
+    Reclaim(reclaim_slice);
+    Item *item = fetch(key, _lru_index.Hash(key));
+    if (item == nullptr) {
+        return false;
+    }
+    std::string value;
+    uint32_t exptime = item->exptime;
+    if (!updater(item->value(), item->value_size, item->cas, value, exptime) ||
+        Item::Footprint(key.size(), value.size()) > _max_size) {
+        return false;
+    }
+    return set(item, value, exptime);
+}
+
+// See SimpleLRU.h
+template <typename Policy> bool BasicLRU<Policy>::GetCas(const std::string &key, Value &value, uint64_t &cas) {
+    Item *item = fetch(key, _lru_index.Hash(key));
+    if (item == nullptr) {
+        return false;
+    }
+    value = item->Share();
+    cas = item->cas;
+    access(item);
+    return true;
+}
+
+// See SimpleLRU.h
+template <typename Policy>
+typename BasicLRU<Policy>::CasResult BasicLRU<Policy>::CompareAndSwap(const std::string &key, const std::string &value,
+                                                                      uint64_t cas, uint32_t exptime) {
+    Reclaim(reclaim_slice);
+    Item *item = fetch(key, _lru_index.Hash(key));
+    if (item == nullptr) {
+        return CasResult::kNotFound;
+    }
+    if (item->cas != cas) {
+        return CasResult::kExists;
+    }
+    if (Item::Footprint(key.size(), value.size()) > _max_size) {
+        return CasResult::kNotStored;
+    }
+    return set(item, value, exptime) ? CasResult::kStored : CasResult::kNotStored;
+}
+
+// See SimpleLRU.h
+template <typename Policy>
+bool BasicLRU<Policy>::Append(const std::string &key, const std::string &data) { return concat(key, data, false); }
+
+// See SimpleLRU.h
+template <typename Policy>
+bool BasicLRU<Policy>::Prepend(const std::string &key, const std::string &data) { return concat(key, data, true); }
+
+// See SimpleLRU.h
+template <typename Policy> void BasicLRU<Policy>::Stats(std::vector<std::pair<std::string, std::string>> &stats) {
+    std::size_t items = _lru_index.Size();
+    std::size_t bytes = _curr_size + _policy.Overhead();
+    stats.emplace_back("curr_items", std::to_string(items));
+    stats.emplace_back("bytes", std::to_string(bytes));
+    stats.emplace_back("limit_maxbytes", std::to_string(_max_size));
+    stats.emplace_back("payload_bytes", std::to_string(_payload_size));
+    stats.emplace_back("index_bytes", std::to_string(_lru_index.MemoryUsage()));
+    stats.emplace_back("overhead_per_item", std::to_string(items > 0 ? (bytes - _payload_size) / items : 0));
+    stats.emplace_back("get_hits", std::to_string(_hits));
+    stats.emplace_back("get_misses", std::to_string(_misses));
+    stats.emplace_back("evictions", std::to_string(_evictions));
+    if (_cold != nullptr) {
+        _cold->Stats(stats);
+    }
+}
+
+// See SimpleLRU.h
+template <typename Policy> std::size_t BasicLRU<Policy>::Reclaim(std::size_t limit) {
+    uint32_t now = TimingWheel::Now();
+    std::size_t reclaimed = 0;
+    Item *item;
+    while (reclaimed < limit && (item = _timers.Expired(now)) != nullptr) {
+        remove(item);
+        reclaimed++;
     }
+    return reclaimed;
 }
 
-void SimpleLRU::set(lru_node *node_ptr, const std::string &value) {
-    to_head(node_ptr);
-    _curr_size -= node_ptr->value.size();
-    if (value.size() > _max_size - _curr_size) {
-        lru_node *last_deleted = _lru_head.get();
-        while (value.size() > _max_size - _curr_size) {
-            last_deleted = last_deleted->prev;
-            last_deleted->next.reset();
-            auto it = _lru_index.find(std::cref(last_deleted->key));
-            assert(it != _lru_index.end());
-            _lru_index.erase(it);
-            _curr_size -= last_deleted->key.size() + last_deleted->value.size();
+template <typename Policy>
+std::size_t BasicLRU<Policy>::get_many(const std::vector<std::string> &keys, const std::vector<std::size_t> &hashes,
+                                       const std::vector<std::size_t> &positions, std::vector<Value> &values) {
+    return get_many(keys, hashes, positions, values, [this](const std::string &key, std::size_t hash) {
+        Item *item = fetch(key, hash);
+        if (item == nullptr) {
+            _misses++;
+            return item;
         }
-        _lru_head->prev = last_deleted->prev;
-        last_deleted->prev->next.reset();
+        _hits++;
+        access(item);
+        return item;
+    });
+}
+
+template <typename Policy> Item *BasicLRU<Policy>::lookup(const std::string &key, std::size_t hash) {
+    Item *item = _lru_index.Find(key, hash);
+    if (item != nullptr && TimingWheel::Expired(item)) {
+        remove(item);
+        return nullptr;
+    }
+    return item;
+}
+
+template <typename Policy> Item *BasicLRU<Policy>::fetch(const std::string &key, std::size_t hash) {
+    Item *item = lookup(key, hash);
+    if (item != nullptr || _cold == nullptr) {
+        return item;
+    }
+
+    std::string value;
+    uint32_t exptime;
+    if (!_cold->Take(key, hash, value, exptime) || Item::Footprint(key.size(), value.size()) > _max_size) {
+        return nullptr;
+    }
+    return put(key, value, hash, exptime);
+}
+
+template <typename Policy> void BasicLRU<Policy>::remove(Item *item) {
+    _policy.Remove(item);
+    drop(item);
+}
+
+template <typename Policy> void BasicLRU<Policy>::drop(Item *item) {
+    bool erased = _lru_index.Erase(item, item->hash);
+    assert(erased);
+    _timers.Cancel(item);
+    _curr_size -= item->Footprint();
+    _payload_size -= item->key_size + item->value_size;
+    Item::Destroy(item);
+}
+
+template <typename Policy> void BasicLRU<Policy>::expire(Item *item, uint32_t exptime) {
+    _timers.Cancel(item);
+    item->exptime = exptime;
+    if (exptime != 0) {
+        _timers.Schedule(item);
     }
-    _curr_size += value.size();
-    node_ptr->value = value;
 }
 
-void SimpleLRU::put(const std::string &key, const std::string &value) {
-    if (key.size() + value.size() > _max_size - _curr_size) {
-        lru_node *last_deleted = _lru_head.get();
-        while (key.size() + value.size() > _max_size - _curr_size) {
-            last_deleted = last_deleted->prev;
-            last_deleted->next.reset();
-            _lru_index.erase(_lru_index.find(std::cref(last_deleted->key)));
-            _curr_size -= last_deleted->key.size() + last_deleted->value.size();
+template <typename Policy> void BasicLRU<Policy>::evict(std::size_t size, const Item *keep) {
+    while (_curr_size + _policy.Overhead() + size > _max_size) {
+        Item *victim = _policy.Evict(keep);
+        if (victim == nullptr) {
+            // Only the history of the policy is left, there is enough space without it as the new
+            // footprint is less than _max_size
+            _policy.ForgetHistory();
+            assert(_curr_size + size <= _max_size);
+            return;
         }
-        if (last_deleted == _lru_head.get()) {
-            _lru_head = nullptr;
-        } else {
-            _lru_head->prev = last_deleted->prev;
-            last_deleted->prev->next.reset();
+        if (_cold != nullptr && !TimingWheel::Expired(victim)) {
+            _cold->Add(victim);
         }
+        drop(victim);
+        _evictions++;
+    }
+}
+
+template <typename Policy> bool BasicLRU<Policy>::set(Item *item, const std::string &value, uint32_t exptime) {
+    access(item);
+    // Handles of the old value must keep seeing it
+    if (item->FitsInPlace(value.size()) && !item->Shared()) {
+        _payload_size += value.size() - item->value_size;
+        item->SetValue(value);
+        item->cas = ++_cas;
+        expire(item, exptime);
+        return true;
+    }
+    return replace(item, Item::Create(item->key(), item->key_size, value.data(), value.size(), item->hash), exptime);
+}
+
+template <typename Policy> bool BasicLRU<Policy>::replace(Item *item, Item *new_item, uint32_t exptime) {
+    std::size_t old_footprint = item->Footprint();
+    std::size_t new_footprint = new_item->Footprint();
+    if (new_footprint > _max_size) {
+        Item::Destroy(new_item);
+        return false;
+    }
+
+    // Item is kept by eviction, so there will be enough space before all other items are gone, as new
+    // footprint is less than _max_size
+    if (new_footprint > old_footprint) {
+        evict(new_footprint - old_footprint, item);
+    }
+
+    new_item->flags = item->flags;
+    new_item->cas = ++_cas;
+    _lru_index.Replace(item, new_item, item->hash);
+    _policy.Replace(item, new_item);
+    _timers.Cancel(item);
+    expire(new_item, exptime);
+    _curr_size += new_footprint - old_footprint;
+    _payload_size += new_item->value_size - item->value_size;
+    Item::Destroy(item);
+    return true;
+}
+
+template <typename Policy>
+bool BasicLRU<Policy>::concat(const std::string &key, const std::string &data, bool prepend) {
+    Reclaim(reclaim_slice);
+    Item *item = fetch(key, _lru_index.Hash(key));
+    if (item == nullptr) {
+        return false;
     }
-    _curr_size += key.size() + value.size();
-    if (!_lru_head) {
-        _lru_head = std::unique_ptr<lru_node>(new lru_node(key));
-        _lru_head->value = value;
-        _lru_head->prev = _lru_head.get();
-        _lru_head->next = nullptr;
-    } else {
-        std::unique_ptr<lru_node> new_node = std::unique_ptr<lru_node>(new lru_node(key));
-        new_node->value = value;
-        new_node->prev = _lru_head->prev;
-        _lru_head->prev = new_node.get();
-        new_node->next = std::move(_lru_head);
-        _lru_head = std::move(new_node);
-    }
-    _lru_index.emplace(std::cref(_lru_head->key), std::ref(*_lru_head));
+    std::size_t value_size = item->value_size + data.size();
+    if (Item::Footprint(item->key_size, value_size) > _max_size) {
+        return false;
+    }
+    access(item);
+    if (item->Fits(value_size) && !item->Shared()) {
+        item->ConcatValue(data.data(), data.size(), prepend);
+        item->cas = ++_cas;
+        _payload_size += data.size();
+        return true;
+    }
+
+    // Value that is concatenated once is likely to be concatenated again, so the new item reserves as
+    // much spare space as the value takes, unless it doesn't fit into the storage then
+    std::size_t reserve = 2 * value_size;
+    if (Item::Footprint(item->key_size, reserve) > _max_size) {
+        reserve = value_size;
+    }
+    return replace(item, Item::Concat(item, data.data(), data.size(), prepend, reserve), item->exptime);
+}
+
+template <typename Policy>
+Item *BasicLRU<Policy>::put(const std::string &key, const std::string &value, std::size_t hash, uint32_t exptime) {
+    Item *item = Item::Create(key, value, hash);
+    std::size_t footprint = item->Footprint();
+    if (footprint > _max_size) {
+        Item::Destroy(item);
+        return nullptr;
+    }
+    evict(footprint);
+
+    item->cas = ++_cas;
+    _lru_index.Insert(item, hash);
+    _policy.Insert(item);
+    expire(item, exptime);
+    _curr_size += footprint;
+    _payload_size += key.size() + value.size();
+    return item;
 }
 
+template class BasicLRU<LRUPolicy>;
+template class BasicLRU<SLRUPolicy>;
+template class BasicLRU<TwoQPolicy>;
+template class BasicLRU<ARCPolicy>;
+
 } // namespace Backend
 } // namespace Afina
@@ -1,34 +1,40 @@
 #ifndef AFINA_STORAGE_SIMPLE_LRU_H
 #define AFINA_STORAGE_SIMPLE_LRU_H
 
-#include <map>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <vector>
 
 #include <afina/Storage.h>
 
+#include "ColdTier.h"
+#include "EvictionPolicy.h"
+#include "HashIndex.h"
+#include "Item.h"
+#include "TimingWheel.h"
+
 namespace Afina {
 namespace Backend {
 
 /**
- * # Map based implementation
+ * # Hash index based implementation
  * That is NOT thread safe implementaiton!!
+ *
+ * If cold tier is given, items evicted from the tail go there instead of being lost, and key missing
+ * in memory is looked up there and promoted back to the head of the list, see ColdTier
+ *
+ * Items are evicted in the order Policy chooses, see EvictionPolicy.h. Methods are defined in
+ * SimpleLRU.cpp, which instantiates the storage for every policy there
  */
-class SimpleLRU : public Afina::Storage {
+template <typename Policy> class BasicLRU : public Afina::Storage {
 public:
-    SimpleLRU(size_t max_size = 1024) : _max_size(max_size) {}
-
-    ~SimpleLRU() {
-        _lru_index.clear();
-        if (_lru_head) {
-            lru_node *to_del = _lru_head->prev;
-            while (to_del != _lru_head.get()) {
-                to_del = to_del->prev;
-                to_del->next.reset();
-            }
-            _lru_head.reset();
-        }
+    BasicLRU(size_t max_size = 1024, std::unique_ptr<ColdTier> cold = nullptr)
+        : _max_size(max_size), _timers(TimingWheel::Now()), _cold(std::move(cold)), _policy(max_size) {}
+
+    ~BasicLRU() {
+        _lru_index.Clear();
+        _policy.ForEach([](Item *item) { Item::Destroy(item); });
     }
 
     // Implements Afina::Storage interface
@@ -46,43 +52,186 @@ public:
     // Implements Afina::Storage interface
     bool Get(const std::string &key, std::string &value) override;
 
+    // Implements Afina::Storage interface, value bytes are shared with the item
+    bool GetValue(const std::string &key, Value &value) override;
+
+    // Implements Afina::Storage interface
+    std::size_t MultiGet(const std::vector<std::string> &keys, std::vector<Value> &values) override;
+
+    // Implements Afina::Storage interface, items of the cold tier go first
+    bool ForEach(const Visitor &visitor) override;
+
+    // Implements Afina::Storage interface
+    bool PutExpiring(const std::string &key, const std::string &value, uint32_t exptime) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsentExpiring(const std::string &key, const std::string &value, uint32_t exptime) override;
+
+    // Implements Afina::Storage interface
+    bool SetExpiring(const std::string &key, const std::string &value, uint32_t exptime) override;
+
+    // Implements Afina::Storage interface
+    bool Touch(const std::string &key, uint32_t exptime) override;
+
+    // Implements Afina::Storage interface
+    bool GetAndTouch(const std::string &key, std::string &value, uint32_t exptime) override;
+
+    // Implements Afina::Storage interface, key is looked up once
+    bool Update(const std::string &key, const Updater &updater) override;
+
+    // Implements Afina::Storage interface, version is kept in the item
+    bool GetCas(const std::string &key, Value &value, uint64_t &cas) override;
+
+    // Implements Afina::Storage interface, key is looked up once
+    CasResult CompareAndSwap(const std::string &key, const std::string &value, uint64_t cas,
+                             uint32_t exptime) override;
+
+    // Implements Afina::Storage interface, value grows in place while there is spare capacity. Once it
+    // runs out, the item is reallocated with capacity doubled, so appends cost appended bytes on average
+    bool Append(const std::string &key, const std::string &data) override;
+
+    // Implements Afina::Storage interface, same as Append but value bytes are moved in place
+    bool Prepend(const std::string &key, const std::string &data) override;
+
+    // Implements Afina::Storage interface, reports memory usage, hit ratio and cold tier if there is one
+    void Stats(std::vector<std::pair<std::string, std::string>> &stats) override;
+
+    /**
+     * Removes at most limit expired items, returns number of removed ones. Every write operation
+     * reclaims a small slice of expired items this way, so memory gets back without latency spikes
+     */
+    std::size_t Reclaim(std::size_t limit);
+
+protected:
+    // Hash of the key as used by index
+    static std::size_t key_hash(const std::string &key) { return HashIndex<Item, item_traits>::Hash(key); }
+
+    // Returns item for the key without touching LRU order, nullptr if there is no such. Item could be
+    // expired already
+    Item *find(const std::string &key, std::size_t hash) const { return _lru_index.Find(key, hash); }
+
+    // Tells eviction policy the item has been used
+    void access(Item *item) { _policy.Access(item); }
+
+    // Starts loading index memory for the hash, see HashIndex::Prefetch
+    void prefetch(std::size_t hash) const { _lru_index.Prefetch(hash); }
+
+    // Looks up keys at given positions, puts handles of the found values to the same positions of
+    // values. Index memory is prefetched a few keys ahead
+    std::size_t get_many(const std::vector<std::string> &keys, const std::vector<std::size_t> &hashes,
+                         const std::vector<std::size_t> &positions, std::vector<Value> &values);
+
+    // Same as get_many, but items are looked up by find(key, hash), which returns nullptr for missing
+    // ones. Nothing else is done to the found items, so it could be called under a shared lock
+    template <typename Find>
+    std::size_t get_many(const std::vector<std::string> &keys, const std::vector<std::size_t> &hashes,
+                         const std::vector<std::size_t> &positions, std::vector<Value> &values, Find &&find) {
+        for (std::size_t i = 0; i < positions.size() && i < kPrefetchDistance; i++) {
+            prefetch(hashes[positions[i]]);
+        }
+
+        std::size_t found = 0;
+        for (std::size_t i = 0; i < positions.size(); i++) {
+            if (i + kPrefetchDistance < positions.size()) {
+                prefetch(hashes[positions[i + kPrefetchDistance]]);
+            }
+            std::size_t k = positions[i];
+            Item *item = find(keys[k], hashes[k]);
+            if (item != nullptr) {
+                values[k] = item->Share();
+                found++;
+            }
+        }
+        return found;
+    }
+
+    // Adds lookups done without the storage counters, such as under a shared lock, see Stats
+    void count_gets(std::size_t hits, std::size_t misses) {
+        _hits += hits;
+        _misses += misses;
+    }
+
 private:
-    // LRU cache node
-    using lru_node = struct lru_node {
-        const std::string key;
-        std::string value;
-        lru_node *prev;
-        std::unique_ptr<lru_node> next;
-        lru_node(const std::string &key) : key(key) {}
+    // Number of keys batch lookup prefetches index memory ahead for
+    static constexpr std::size_t kPrefetchDistance = 8;
+
+    // Tells HashIndex how to deal with items
+    struct item_traits {
+        static bool Equal(const Item *item, const std::string &key) { return item->KeyEquals(key); }
+        static std::size_t Hash(const Item *item) { return item->hash; }
     };
 
-    // Moves node to the head of the list
-    void to_head(lru_node *node_ptr);
+    // Same as find, but expired item is removed and never returned
+    Item *lookup(const std::string &key, std::size_t hash);
+
+    // Same as lookup, but item missing in memory is promoted from the cold tier
+    Item *fetch(const std::string &key, std::size_t hash);
 
-    // Updates existing association. Call only when it could be updated
-    void set(lru_node *node_ptr, const std::string &value);
+    // Removes item from the policy, index and timing wheel, and releases its memory
+    void remove(Item *item);
 
-    // Stores new association. Call only when it is new could be stored
-    void put(const std::string &key, const std::string &value);
+    // Same as remove, for item policy has already unlinked
+    void drop(Item *item);
+
+    // Changes expiration time of the item
+    void expire(Item *item, uint32_t exptime);
+
+    // Evicts items chosen by the policy until there is enough space for the given number of bytes, they
+    // are moved to the cold tier if there is one. Item to keep is never evicted
+    void evict(std::size_t size, const Item *keep = nullptr);
+
+    // Updates existing association, returns false if the new value doesn't fit into the storage
+    bool set(Item *item, const std::string &value, uint32_t exptime);
+
+    // Replaces item by the new one with the same key, which takes its place in the index and the policy.
+    // Returns false and destroys the new item if it doesn't fit into the storage
+    bool replace(Item *item, Item *new_item, uint32_t exptime);
+
+    // Adds data to the value of existing association, see Append and Prepend
+    bool concat(const std::string &key, const std::string &data, bool prepend);
+
+    // Stores new association. Call only when it is new, returns nullptr if it doesn't fit into the storage
+    Item *put(const std::string &key, const std::string &value, std::size_t hash, uint32_t exptime);
 
     // Maximum number of bytes could be stored in this cache.
-    // i.e all (keys+values) must be less the _max_size
+    // i.e all items footprints (allocation of header + key + value and index share) must be less the _max_size
     std::size_t _max_size;
 
     // Number of bytes storing in the cache
     std::size_t _curr_size = 0;
 
-    // Main storage of lru_nodes, elements in this list ordered descending by "freshness": in the head
-    // element that wasn't used for longest time.
-    //
-    // List owns all nodes
-    std::unique_ptr<lru_node> _lru_head;
+    // Number of key and value bytes, the rest of _curr_size is overhead
+    std::size_t _payload_size = 0;
+
+    // Last version given to an item, key always lives in the same storage so versions are unique per key
+    uint64_t _cas = 0;
 
-    // Index of nodes from list above, allows fast random access to elements by lru_node#key
-    std::map<std::reference_wrapper<const std::string>, std::reference_wrapper<lru_node>, std::less<std::string>>
-        _lru_index;
+    // Counters of lookups and evictions, see Stats
+    std::size_t _hits = 0;
+    std::size_t _misses = 0;
+    std::size_t _evictions = 0;
+
+    // Index of all items, allows fast random access to elements by key. Index owns all items
+    HashIndex<Item, item_traits> _lru_index;
+
+    // Items having expiration time, ordered by it
+    TimingWheel _timers;
+
+    // Second tier for evicted items, optional
+    std::unique_ptr<ColdTier> _cold;
+
+    // Order of items for eviction
+    Policy _policy;
 };
 
+extern template class BasicLRU<LRUPolicy>;
+extern template class BasicLRU<SLRUPolicy>;
+extern template class BasicLRU<TwoQPolicy>;
+extern template class BasicLRU<ARCPolicy>;
+
+// Storage evicting least recently used items
+using SimpleLRU = BasicLRU<LRUPolicy>;
+
 } // namespace Backend
 } // namespace Afina
 
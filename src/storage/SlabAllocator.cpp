@@ -0,0 +1,184 @@
+#include "SlabAllocator.h"
+
+#include <algorithm>
+#include <cassert>
+#include <new>
+#include <stdexcept>
+
+#include <sys/mman.h>
+
+namespace Afina {
+namespace Backend {
+
+constexpr uint8_t SlabAllocator::kNoClass;
+constexpr std::size_t SlabAllocator::kNoPage;
+
+namespace {
+
+// Chunks are aligned so that items placed into them are
+const std::size_t chunk_align = 8;
+
+std::size_t align_down(std::size_t size) { return size & ~(chunk_align - 1); }
+
+} // namespace
+
+SlabAllocator::SlabAllocator(std::size_t region_size, std::size_t page_size, std::size_t min_chunk, double factor)
+    : _page_size(align_down(page_size)) {
+    if (_page_size < min_chunk || min_chunk < sizeof(FreeChunk) || factor <= 1.0) {
+        throw std::invalid_argument("Invalid slab geometry");
+    }
+    std::size_t pages = region_size / _page_size;
+    if (pages == 0) {
+        throw std::invalid_argument("Region is smaller than a page");
+    }
+
+    // The last class is always the whole page
+    std::size_t size = (min_chunk + chunk_align - 1) & ~(chunk_align - 1);
+    while (size < _page_size && _chunk_sizes.size() + 1 < kNoClass) {
+        _chunk_sizes.push_back(size);
+        size = std::max(size + chunk_align, align_down(std::size_t(size * factor)));
+    }
+    _chunk_sizes.push_back(_page_size);
+
+    _region_size = pages * _page_size;
+    void *region =
+        mmap(nullptr, _region_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    if (region == MAP_FAILED) {
+        throw std::bad_alloc();
+    }
+    _region = static_cast<char *>(region);
+
+    _page_class.assign(pages, kNoClass);
+    _class_pages.resize(_chunk_sizes.size());
+    _free.assign(_chunk_sizes.size(), nullptr);
+    _free_pages.reserve(pages);
+    for (std::size_t page = pages; page > 0; page--) {
+        _free_pages.push_back(page - 1);
+    }
+
+    _bitmap_words = (_page_size / _chunk_sizes[0] + 63) / 64;
+    _used.assign(pages * _bitmap_words, 0);
+}
+
+SlabAllocator::~SlabAllocator() { munmap(_region, _region_size); }
+
+// See SlabAllocator.h
+uint8_t SlabAllocator::ClassOf(std::size_t size) const {
+    auto it = std::lower_bound(_chunk_sizes.begin(), _chunk_sizes.end(), size);
+    if (it == _chunk_sizes.end()) {
+        return kNoClass;
+    }
+    return it - _chunk_sizes.begin();
+}
+
+// See SlabAllocator.h
+void *SlabAllocator::Alloc(uint8_t cls) {
+    if (_free[cls] == nullptr) {
+        if (_free_pages.empty()) {
+            return nullptr;
+        }
+        std::size_t page = _free_pages.back();
+        _free_pages.pop_back();
+        assign(page, cls);
+    }
+
+    FreeChunk *chunk = _free[cls];
+    _free[cls] = chunk->next;
+    if (chunk->next != nullptr) {
+        chunk->next->prev = nullptr;
+    }
+
+    std::size_t page = PageOf(chunk);
+    std::size_t index = (reinterpret_cast<char *>(chunk) - _region - page * _page_size) / _chunk_sizes[cls];
+    used(page)[index / 64] |= uint64_t(1) << (index % 64);
+    return chunk;
+}
+
+// See SlabAllocator.h
+void SlabAllocator::Free(void *mem) {
+    std::size_t page = PageOf(mem);
+    uint8_t cls = _page_class[page];
+    std::size_t index = (static_cast<char *>(mem) - _region - page * _page_size) / _chunk_sizes[cls];
+    assert(used(page)[index / 64] & (uint64_t(1) << (index % 64)));
+    used(page)[index / 64] &= ~(uint64_t(1) << (index % 64));
+    push_free(cls, mem);
+}
+
+// See SlabAllocator.h
+void SlabAllocator::MovePage(std::size_t page, uint8_t cls) {
+    release(page);
+    assign(page, cls);
+}
+
+// See SlabAllocator.h
+void SlabAllocator::RetirePage(std::size_t page) {
+    release(page);
+    _retired_pages.push_back(page);
+}
+
+// See SlabAllocator.h
+bool SlabAllocator::RetireFreePage() {
+    if (_free_pages.empty()) {
+        return false;
+    }
+    _retired_pages.push_back(_free_pages.back());
+    _free_pages.pop_back();
+    return true;
+}
+
+// See SlabAllocator.h
+bool SlabAllocator::RestorePage() {
+    if (_retired_pages.empty()) {
+        return false;
+    }
+    _free_pages.push_back(_retired_pages.back());
+    _retired_pages.pop_back();
+    return true;
+}
+
+void SlabAllocator::release(std::size_t page) {
+    uint8_t from = _page_class[page];
+    std::size_t chunk_size = _chunk_sizes[from];
+    char *start = _region + page * _page_size;
+    for (std::size_t i = 0; i < ChunksPerPage(from); i++) {
+        FreeChunk *chunk = reinterpret_cast<FreeChunk *>(start + i * chunk_size);
+        if (chunk->prev != nullptr) {
+            chunk->prev->next = chunk->next;
+        } else {
+            _free[from] = chunk->next;
+        }
+        if (chunk->next != nullptr) {
+            chunk->next->prev = chunk->prev;
+        }
+    }
+
+    std::vector<std::size_t> &pages = _class_pages[from];
+    pages.erase(std::find(pages.begin(), pages.end(), page));
+    _page_class[page] = kNoClass;
+}
+
+void SlabAllocator::assign(std::size_t page, uint8_t cls) {
+    _page_class[page] = cls;
+    _class_pages[cls].push_back(page);
+    std::fill(used(page), used(page) + _bitmap_words, 0);
+
+    // Chunks are pushed from the end, so they are handed out in address order
+    std::size_t chunk_size = _chunk_sizes[cls];
+    char *start = _region + page * _page_size;
+    for (std::size_t i = ChunksPerPage(cls); i > 0; i--) {
+        push_free(cls, start + (i - 1) * chunk_size);
+    }
+}
+
+void SlabAllocator::push_free(uint8_t cls, void *mem) {
+    FreeChunk *chunk = static_cast<FreeChunk *>(mem);
+    chunk->prev = nullptr;
+    chunk->next = _free[cls];
+    if (chunk->next != nullptr) {
+        chunk->next->prev = chunk;
+    }
+    _free[cls] = chunk;
+}
+
+} // namespace Backend
+} // namespace Afina
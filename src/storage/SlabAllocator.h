@@ -0,0 +1,153 @@
+#ifndef AFINA_STORAGE_SLAB_ALLOCATOR_H
+#define AFINA_STORAGE_SLAB_ALLOCATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Slab allocator over a single preallocated region
+ * Region is split into pages of the same size. Page is assigned to one of the slab classes on demand
+ * and carved into chunks of the class size. Sizes of classes grow geometrically from the smallest one
+ * up to the page size, so a chunk wastes at most (factor - 1) of its size.
+ *
+ * Allocation never calls malloc: chunk is taken from the free list of its class, or from a new page
+ * if there is a free one left. Otherwise caller has to free something of that class or move a page
+ * from another class with MovePage.
+ *
+ * Allocator tracks which chunks are used, so that all of them could be found within a page before
+ * the page is moved.
+ *
+ * Pages could be retired, so that the memory caller spends elsewhere fits into the region size. Retired
+ * page is never handed out until it is restored.
+ *
+ * That is NOT thread safe implementation
+ */
+class SlabAllocator {
+public:
+    // Identifies no class at all
+    static constexpr uint8_t kNoClass = 0xFF;
+
+    // Page isn't assigned to any class
+    static constexpr std::size_t kNoPage = SIZE_MAX;
+
+    /**
+     * Allocates region of the given size, all its memory is populated right away
+     *
+     * @param region_size number of bytes in region, rounded down to the whole number of pages
+     * @param page_size size of page, the biggest chunk could be allocated
+     * @param min_chunk size of chunk of the smallest class
+     * @param factor of chunk size growth from class to class
+     */
+    SlabAllocator(std::size_t region_size, std::size_t page_size, std::size_t min_chunk, double factor = 1.25);
+    ~SlabAllocator();
+
+    SlabAllocator(const SlabAllocator &) = delete;
+    SlabAllocator &operator=(const SlabAllocator &) = delete;
+
+    // Number of slab classes
+    uint8_t Classes() const { return _chunk_sizes.size(); }
+
+    // Smallest class with chunks of at least the given size, kNoClass if size exceeds a page
+    uint8_t ClassOf(std::size_t size) const;
+
+    std::size_t ChunkSize(uint8_t cls) const { return _chunk_sizes[cls]; }
+
+    // Number of chunks page of the class is carved into
+    std::size_t ChunksPerPage(uint8_t cls) const { return _page_size / _chunk_sizes[cls]; }
+
+    // Returns free chunk of the given class, nullptr if there is neither free chunk nor free page
+    void *Alloc(uint8_t cls);
+
+    // Returns chunk to the free list of its class
+    void Free(void *chunk);
+
+    std::size_t PageSize() const { return _page_size; }
+    std::size_t Pages() const { return _page_class.size(); }
+    std::size_t FreePages() const { return _free_pages.size(); }
+    std::size_t RetiredPages() const { return _retired_pages.size(); }
+
+    // Number of pages assigned to the class
+    std::size_t Pages(uint8_t cls) const { return _class_pages[cls].size(); }
+
+    // Any page assigned to the class, kNoPage if there is none
+    std::size_t AnyPage(uint8_t cls) const { return _class_pages[cls].empty() ? kNoPage : _class_pages[cls].back(); }
+
+    // Page the chunk belongs to
+    std::size_t PageOf(const void *chunk) const { return (static_cast<const char *>(chunk) - _region) / _page_size; }
+
+    // Calls f for each used chunk of the page, f could free the chunk it gets
+    template <typename F> void ForEachUsed(std::size_t page, F f);
+
+    // Reassigns page to the given class, all chunks of the page must be free
+    void MovePage(std::size_t page, uint8_t cls);
+
+    // Retires page of some class, all chunks of the page must be free
+    void RetirePage(std::size_t page);
+
+    // Retires page not assigned to any class, returns false if there is none
+    bool RetireFreePage();
+
+    // Makes one of retired pages free again, returns false if there is none
+    bool RestorePage();
+
+private:
+    // Header of the free chunk
+    struct FreeChunk {
+        FreeChunk *prev;
+        FreeChunk *next;
+    };
+
+    // Assigns free page to the class and puts all its chunks to the free list
+    void assign(std::size_t page, uint8_t cls);
+
+    // Takes page away from its class, all chunks of the page must be free
+    void release(std::size_t page);
+
+    // Links chunk into the head of the free list of the class
+    void push_free(uint8_t cls, void *chunk);
+
+    // Used chunks bitmap of the page
+    uint64_t *used(std::size_t page) { return &_used[page * _bitmap_words]; }
+
+    char *_region;
+    std::size_t _region_size;
+    const std::size_t _page_size;
+
+    // Chunk size of each class, ascending
+    std::vector<std::size_t> _chunk_sizes;
+
+    // Class of each page, pages of each class, pages not assigned yet and pages not to be assigned
+    std::vector<uint8_t> _page_class;
+    std::vector<std::vector<std::size_t>> _class_pages;
+    std::vector<std::size_t> _free_pages;
+    std::vector<std::size_t> _retired_pages;
+
+    // Head of the free list of each class
+    std::vector<FreeChunk *> _free;
+
+    // Bit per chunk, for each page
+    std::size_t _bitmap_words;
+    std::vector<uint64_t> _used;
+};
+
+template <typename F> void SlabAllocator::ForEachUsed(std::size_t page, F f) {
+    std::size_t chunk_size = _chunk_sizes[_page_class[page]];
+    char *start = _region + page * _page_size;
+    uint64_t *bitmap = used(page);
+    for (std::size_t word = 0; word < _bitmap_words; word++) {
+        // Copy of the word, so that f could free chunks
+        for (uint64_t bits = bitmap[word]; bits != 0; bits &= bits - 1) {
+            std::size_t index = word * 64 + __builtin_ctzll(bits);
+            f(start + index * chunk_size);
+        }
+    }
+}
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_SLAB_ALLOCATOR_H
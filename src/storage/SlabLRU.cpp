@@ -0,0 +1,361 @@
+#include "SlabLRU.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace Afina {
+namespace Backend {
+
+namespace {
+
+// Region is split into at least that many pages, unless page would get smaller than min_page
+const std::size_t min_pages = 16;
+const std::size_t min_page = 1024;
+
+// Smallest chunk fits item with 32 bytes of key and value
+const std::size_t min_chunk = sizeof(Item) + 32;
+
+// Maximum number of expired items reclaimed by a single write operation, see SimpleLRU
+const std::size_t reclaim_slice = 8;
+
+std::size_t page_size_for(std::size_t max_size, std::size_t page_size) {
+    std::size_t page = std::min(page_size, max_size / min_pages);
+    return std::max(page, std::min(max_size, min_page));
+}
+
+} // namespace
+
+SlabLRU::SlabLRU(size_t max_size, size_t page_size)
+    : _slabs(max_size, page_size_for(max_size, page_size), min_chunk), _lru(_slabs.Classes()),
+      _window_evictions(_slabs.Classes(), 0), _timers(TimingWheel::Now()) {}
+
+SlabLRU::~SlabLRU() {
+    // Items live in the slab region, which goes away along with allocator
+    _index.Clear();
+}
+
+// See SlabLRU.h
+bool SlabLRU::Put(const std::string &key, const std::string &value) { return SlabLRU::PutExpiring(key, value, 0); }
+
+// See SlabLRU.h
+bool SlabLRU::PutIfAbsent(const std::string &key, const std::string &value) {
+    return SlabLRU::PutIfAbsentExpiring(key, value, 0);
+}
+
+// See SlabLRU.h
+bool SlabLRU::Set(const std::string &key, const std::string &value) { return SlabLRU::SetExpiring(key, value, 0); }
+
+// See SlabLRU.h
+bool SlabLRU::Delete(const std::string &key) {
+    reclaim(reclaim_slice);
+    Item *item = lookup(key, _index.Hash(key));
+    if (item == nullptr) {
+        return false;
+    }
+    remove(item);
+    return true;
+}
+
+// See SlabLRU.h
+bool SlabLRU::Get(const std::string &key, std::string &value) {
+    Item *item = lookup(key, _index.Hash(key));
+    if (item == nullptr) {
+        return false;
+    }
+    value.assign(item->value(), item->value_size);
+    _lru[item->queue].MoveToFront(item);
+    return true;
+}
+
+// See SlabLRU.h
+bool SlabLRU::PutExpiring(const std::string &key, const std::string &value, uint32_t exptime) {
+    reclaim(reclaim_slice);
+    std::size_t hash = _index.Hash(key);
+    Item *item = lookup(key, hash);
+    if (item == nullptr) {
+        return put(key, value, hash, exptime);
+    }
+    return set(item, key, value, exptime);
+}
+
+// See SlabLRU.h
+bool SlabLRU::PutIfAbsentExpiring(const std::string &key, const std::string &value, uint32_t exptime) {
+    reclaim(reclaim_slice);
+    std::size_t hash = _index.Hash(key);
+    if (lookup(key, hash) != nullptr) {
+        return false;
+    }
+    return put(key, value, hash, exptime);
+}
+
+// See SlabLRU.h
+bool SlabLRU::SetExpiring(const std::string &key, const std::string &value, uint32_t exptime) {
+    reclaim(reclaim_slice);
+    Item *item = lookup(key, _index.Hash(key));
+    if (item == nullptr) {
+        return false;
+    }
+    return set(item, key, value, exptime);
+}
+
+// See SlabLRU.h
+bool SlabLRU::Touch(const std::string &key, uint32_t exptime) {
+    reclaim(reclaim_slice);
+    Item *item = lookup(key, _index.Hash(key));
+    if (item == nullptr) {
+        return false;
+    }
+    expire(item, exptime);
+    _lru[item->queue].MoveToFront(item);
+    return true;
+}
+
+// See SlabLRU.h
+bool SlabLRU::GetAndTouch(const std::string &key, std::string &value, uint32_t exptime) {
+    reclaim(reclaim_slice);
+    Item *item = lookup(key, _index.Hash(key));
+    if (item == nullptr) {
+        return false;
+    }
+    value.assign(item->value(), item->value_size);
+    expire(item, exptime);
+    _lru[item->queue].MoveToFront(item);
+    return true;
+}
+
+// See SlabLRU.h
+bool SlabLRU::Update(const std::string &key, const Updater &updater) {
+    reclaim(reclaim_slice);
+    Item *item = lookup(key, _index.Hash(key));
+    if (item == nullptr) {
+        return false;
+    }
+    std::string value;
+    uint32_t exptime = item->exptime;
+    if (!updater(item->value(), item->value_size, item->cas, value, exptime)) {
+        return false;
+    }
+    return set(item, key, value, exptime);
+}
+
+// See SlabLRU.h
+bool SlabLRU::GetCas(const std::string &key, Value &value, uint64_t &cas) {
+    Item *item = lookup(key, _index.Hash(key));
+    if (item == nullptr) {
+        return false;
+    }
+    value = Value(std::string(item->value(), item->value_size));
+    cas = item->cas;
+    _lru[item->queue].MoveToFront(item);
+    return true;
+}
+
+// See SlabLRU.h
+SlabLRU::CasResult SlabLRU::CompareAndSwap(const std::string &key, const std::string &value, uint64_t cas,
+                                           uint32_t exptime) {
+    reclaim(reclaim_slice);
+    Item *item = lookup(key, _index.Hash(key));
+    if (item == nullptr) {
+        return CasResult::kNotFound;
+    }
+    if (item->cas != cas) {
+        return CasResult::kExists;
+    }
+    return set(item, key, value, exptime) ? CasResult::kStored : CasResult::kNotStored;
+}
+
+// See SlabLRU.h
+void SlabLRU::Stats(std::vector<std::pair<std::string, std::string>> &stats) {
+    stats.emplace_back("evictions", std::to_string(_evictions));
+    stats.emplace_back("slab_pages", std::to_string(_slabs.Pages()));
+    stats.emplace_back("slab_free_pages", std::to_string(_slabs.FreePages()));
+    stats.emplace_back("slab_page_moves", std::to_string(_page_moves));
+    stats.emplace_back("slab_index_pages", std::to_string(_slabs.RetiredPages()));
+    stats.emplace_back("index_bytes", std::to_string(_index.MemoryUsage()));
+}
+
+Item *SlabLRU::lookup(const std::string &key, std::size_t hash) {
+    Item *item = _index.Find(key, hash);
+    if (item != nullptr && TimingWheel::Expired(item)) {
+        remove(item);
+        return nullptr;
+    }
+    return item;
+}
+
+void SlabLRU::reclaim(std::size_t limit) {
+    uint32_t now = TimingWheel::Now();
+    Item *item;
+    for (std::size_t i = 0; i < limit && (item = _timers.Expired(now)) != nullptr; i++) {
+        remove(item);
+    }
+}
+
+void SlabLRU::expire(Item *item, uint32_t exptime) {
+    _timers.Cancel(item);
+    item->exptime = exptime;
+    if (exptime != 0) {
+        _timers.Schedule(item);
+    }
+}
+
+void SlabLRU::remove(Item *item) {
+    bool erased = _index.Erase(item, item->hash);
+    assert(erased);
+    _lru[item->queue].Remove(item);
+    _timers.Cancel(item);
+    item->~Item();
+    _slabs.Free(item);
+}
+
+bool SlabLRU::set(Item *item, const std::string &key, const std::string &value, uint32_t exptime) {
+    uint8_t cls = _slabs.ClassOf(Item::Size(key.size(), value.size()));
+    if (cls == SlabAllocator::kNoClass) {
+        return false;
+    }
+    if (cls == item->queue) {
+        item->SetValue(value);
+        item->cas = ++_cas;
+        expire(item, exptime);
+        _lru[item->queue].MoveToFront(item);
+        return true;
+    }
+
+    // Item has to move to another class, it is removed only once the new chunk is there
+    std::size_t hash = item->hash;
+    uint32_t flags = item->flags;
+    void *chunk = alloc(cls, &item);
+    if (chunk == nullptr) {
+        return false;
+    }
+    if (item != nullptr) {
+        remove(item);
+    }
+    place(chunk, cls, key, value, hash, exptime)->flags = flags;
+    return true;
+}
+
+bool SlabLRU::put(const std::string &key, const std::string &value, std::size_t hash, uint32_t exptime) {
+    uint8_t cls = _slabs.ClassOf(Item::Size(key.size(), value.size()));
+    if (cls == SlabAllocator::kNoClass) {
+        return false;
+    }
+    charge_index();
+    void *chunk = alloc(cls);
+    if (chunk == nullptr) {
+        return false;
+    }
+    place(chunk, cls, key, value, hash, exptime);
+    return true;
+}
+
+Item *SlabLRU::place(void *chunk, uint8_t cls, const std::string &key, const std::string &value, std::size_t hash,
+                     uint32_t exptime) {
+    std::size_t capacity = _slabs.ChunkSize(cls) - sizeof(Item);
+    Item *item = Item::Init(chunk, capacity, key.data(), key.size(), value.data(), value.size(), hash);
+    item->queue = cls;
+    item->cas = ++_cas;
+    _index.Insert(item, hash);
+    _lru[cls].PushFront(item);
+    expire(item, exptime);
+    return item;
+}
+
+void *SlabLRU::alloc(uint8_t cls, Item **keep) {
+    void *chunk = _slabs.Alloc(cls);
+    if (chunk != nullptr) {
+        return chunk;
+    }
+
+    // Class has nothing to evict, or has evicted a page worth of items already: the item size mix has
+    // shifted towards it
+    if (_lru[cls].Empty() || _window_evictions[cls] >= _slabs.ChunksPerPage(cls)) {
+        uint8_t from = donor(cls);
+        if (from != SlabAllocator::kNoClass) {
+            std::size_t page = donor_page(from);
+            if (keep != nullptr && *keep != nullptr && _slabs.PageOf(*keep) == page) {
+                *keep = nullptr;
+            }
+            move_page(page, cls);
+            std::fill(_window_evictions.begin(), _window_evictions.end(), 0);
+            return _slabs.Alloc(cls);
+        }
+        _window_evictions[cls] = 0;
+    }
+
+    if (_lru[cls].Empty()) {
+        return nullptr;
+    }
+    remove(_lru[cls].tail);
+    _evictions++;
+    _window_evictions[cls]++;
+    return _slabs.Alloc(cls);
+}
+
+uint8_t SlabLRU::donor(uint8_t cls) const {
+    uint8_t best = SlabAllocator::kNoClass;
+    for (uint8_t other = 0; other < _slabs.Classes(); other++) {
+        if (other == cls || _slabs.Pages(other) == 0) {
+            continue;
+        }
+        if (_lru[cls].Empty()) {
+            // Any page will do, take it from the richest class
+            if (best == SlabAllocator::kNoClass || _slabs.Pages(other) > _slabs.Pages(best)) {
+                best = other;
+            }
+        } else if (2 * _window_evictions[other] < _window_evictions[cls] &&
+                   (best == SlabAllocator::kNoClass || _window_evictions[other] < _window_evictions[best])) {
+            // Class under lower pressure
+            best = other;
+        }
+    }
+    return best;
+}
+
+std::size_t SlabLRU::donor_page(uint8_t from) const {
+    return _lru[from].Empty() ? _slabs.AnyPage(from) : _slabs.PageOf(_lru[from].tail);
+}
+
+void SlabLRU::move_page(std::size_t page, uint8_t to) {
+    evict_page(page);
+    _slabs.MovePage(page, to);
+    _page_moves++;
+}
+
+void SlabLRU::evict_page(std::size_t page) {
+    _slabs.ForEachUsed(page, [this](void *chunk) {
+        remove(static_cast<Item *>(chunk));
+        _evictions++;
+    });
+}
+
+void SlabLRU::charge_index() {
+    std::size_t index_bytes = _index.MemoryUsage();
+    while (index_bytes > _slabs.RetiredPages() * _slabs.PageSize()) {
+        if (_slabs.RetireFreePage()) {
+            continue;
+        }
+
+        // Page of the richest class goes away, its coldest items go along
+        uint8_t from = SlabAllocator::kNoClass;
+        for (uint8_t cls = 0; cls < _slabs.Classes(); cls++) {
+            if (_slabs.Pages(cls) > 0 && (from == SlabAllocator::kNoClass || _slabs.Pages(cls) > _slabs.Pages(from))) {
+                from = cls;
+            }
+        }
+        if (from == SlabAllocator::kNoClass) {
+            return;
+        }
+        std::size_t page = donor_page(from);
+        evict_page(page);
+        _slabs.RetirePage(page);
+    }
+
+    // Old table is gone once index has grown
+    while (_slabs.RetiredPages() > 0 && index_bytes <= (_slabs.RetiredPages() - 1) * _slabs.PageSize()) {
+        _slabs.RestorePage();
+    }
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,161 @@
+#ifndef AFINA_STORAGE_SLAB_LRU_H
+#define AFINA_STORAGE_SLAB_LRU_H
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <afina/Storage.h>
+
+#include "HashIndex.h"
+#include "Item.h"
+#include "ItemList.h"
+#include "SlabAllocator.h"
+#include "TimingWheel.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # LRU over slab allocator, memcached style
+ * All items live in a single region preallocated by SlabAllocator, item occupies the smallest chunk
+ * its footprint fits into. Each slab class keeps its own LRU list, new item evicts the tail of its
+ * class when there is no free chunk left, so the write path never calls malloc and memory never
+ * fragments.
+ *
+ * Memory follows the item size mix: class that keeps evicting a page worth of items gets a page from
+ * the class that evicts least, all items of the moved page are evicted. Class that has no items at
+ * all gets a page from the class having the most of them.
+ *
+ * Expired items are invisible at once, every write returns chunks of a small slice of them ordered by
+ * the timing wheel, same as SimpleLRU does.
+ *
+ * Memory of the hash index is accounted in max_size: before a new item is stored, as many pages are
+ * retired as the index takes, items of a retired page are evicted. Pages come back once the index gets
+ * smaller. Items bigger than a page could not be stored.
+ *
+ * That is NOT thread safe implementaiton!!
+ */
+class SlabLRU : public Afina::Storage {
+public:
+    // Page size is 1MB for big regions, but smaller ones are split into at least 16 pages
+    SlabLRU(size_t max_size = 1024, size_t page_size = 1024 * 1024);
+    ~SlabLRU();
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutExpiring(const std::string &key, const std::string &value, uint32_t exptime) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsentExpiring(const std::string &key, const std::string &value, uint32_t exptime) override;
+
+    // Implements Afina::Storage interface
+    bool SetExpiring(const std::string &key, const std::string &value, uint32_t exptime) override;
+
+    // Implements Afina::Storage interface
+    bool Touch(const std::string &key, uint32_t exptime) override;
+
+    // Implements Afina::Storage interface
+    bool GetAndTouch(const std::string &key, std::string &value, uint32_t exptime) override;
+
+    // Implements Afina::Storage interface, key is looked up once
+    bool Update(const std::string &key, const Updater &updater) override;
+
+    // Implements Afina::Storage interface, version is kept in the item, value is copied as by Get
+    bool GetCas(const std::string &key, Value &value, uint64_t &cas) override;
+
+    // Implements Afina::Storage interface, key is looked up once
+    CasResult CompareAndSwap(const std::string &key, const std::string &value, uint64_t cas,
+                             uint32_t exptime) override;
+
+    // Reports page distribution, index memory and evictions
+    void Stats(std::vector<std::pair<std::string, std::string>> &stats) override;
+
+private:
+    // Tells HashIndex how to deal with items
+    struct item_traits {
+        static bool Equal(const Item *item, const std::string &key) { return item->KeyEquals(key); }
+        static std::size_t Hash(const Item *item) { return item->hash; }
+    };
+
+    // Returns item for the key, expired one is removed and never returned
+    Item *lookup(const std::string &key, std::size_t hash);
+
+    // Removes at most limit expired items
+    void reclaim(std::size_t limit);
+
+    // Changes expiration time of the item
+    void expire(Item *item, uint32_t exptime);
+
+    // Removes item from its list, index and timing wheel, and returns its chunk
+    void remove(Item *item);
+
+    // Updates existing association, item is reallocated if new value needs another class. Item is left
+    // as is if no memory could be found for the new value
+    bool set(Item *item, const std::string &key, const std::string &value, uint32_t exptime);
+
+    // Stores new association, returns false if no memory could be found for it
+    bool put(const std::string &key, const std::string &value, std::size_t hash, uint32_t exptime);
+
+    // Constructs item in the chunk of the class and links it into the index and the class list
+    Item *place(void *chunk, uint8_t cls, const std::string &key, const std::string &value, std::size_t hash,
+                uint32_t exptime);
+
+    // Returns free chunk of the class, evicting items or moving page if needed. If the item to keep is
+    // evicted along with the page moved to the class, it is reset to nullptr, chunk is returned then
+    void *alloc(uint8_t cls, Item **keep = nullptr);
+
+    // Looks for the class that could give a page to the given one, kNoClass if there is no such
+    uint8_t donor(uint8_t cls) const;
+
+    // Page of the donor class to be moved: the one containing its coldest items
+    std::size_t donor_page(uint8_t from) const;
+
+    // Evicts all items of the page of the donor class and gives the page to the class
+    void move_page(std::size_t page, uint8_t to);
+
+    // Evicts all items of the page
+    void evict_page(std::size_t page);
+
+    // Retires or restores pages so that retired ones cover memory of the index
+    void charge_index();
+
+    SlabAllocator _slabs;
+
+    // LRU list of each class, owns the items
+    std::vector<ItemList> _lru;
+
+    // Index of items from all lists above
+    HashIndex<Item, item_traits> _index;
+
+    // Items having expiration time, ordered by it
+    TimingWheel _timers;
+
+    // Evictions of each class since the last page move decision
+    std::vector<std::size_t> _window_evictions;
+
+    // Last version given to an item
+    uint64_t _cas = 0;
+
+    std::size_t _evictions = 0;
+    std::size_t _page_moves = 0;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_SLAB_LRU_H
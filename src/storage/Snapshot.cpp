@@ -0,0 +1,339 @@
+#include "Snapshot.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __SSE4_2__
+#include <nmmintrin.h>
+#endif
+
+namespace Afina {
+namespace Backend {
+
+namespace {
+
+const char magic[8] = {'A', 'F', 'I', 'N', 'A', 'S', 'N', 'P'};
+const uint32_t version = 1;
+
+// Block is flushed once its payload exceeds that size
+const std::size_t block_size = 64 * 1024;
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+};
+
+struct BlockHeader {
+    uint32_t size;
+    uint32_t records;
+    uint32_t crc;
+};
+
+struct RecordHeader {
+    uint32_t key_size;
+    uint32_t value_size;
+    uint32_t exptime;
+};
+
+#ifndef __SSE4_2__
+// Table of the reflected Castagnoli polynomial for bytewise calculation
+struct CrcTable {
+    uint32_t entries[256];
+
+    CrcTable() {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; bit++) {
+                crc = (crc >> 1) ^ ((crc & 1) ? 0x82F63B78 : 0);
+            }
+            entries[i] = crc;
+        }
+    }
+};
+#endif
+
+std::runtime_error io_error(const std::string &what, const std::string &path) {
+    return std::runtime_error(what + " " + path + ": " + std::strerror(errno));
+}
+
+void write_all(int fd, const char *data, std::size_t size, const std::string &path) {
+    while (size > 0) {
+        ssize_t written = ::write(fd, data, size);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        } else if (written < 0) {
+            throw io_error("Failed to write", path);
+        }
+        data += written;
+        size -= written;
+    }
+}
+
+// Accumulates records into blocks and writes them into the file
+class Writer {
+public:
+    Writer(int fd, const std::string &path) : _fd(fd), _path(path), _records(0) { _block.reserve(2 * block_size); }
+
+    void Add(const char *key, std::size_t key_size, const char *value, std::size_t value_size, uint32_t exptime) {
+        RecordHeader header = {uint32_t(key_size), uint32_t(value_size), exptime};
+        _block.append(reinterpret_cast<const char *>(&header), sizeof(header));
+        _block.append(key, key_size);
+        _block.append(value, value_size);
+        _records++;
+        if (_block.size() >= block_size) {
+            Flush();
+        }
+    }
+
+    // Writes the last block followed by empty one, which marks the end of file
+    void Finish() {
+        if (_records > 0) {
+            Flush();
+        }
+        Flush();
+    }
+
+private:
+    void Flush() {
+        BlockHeader header = {uint32_t(_block.size()), _records, Crc32c(_block.data(), _block.size())};
+        write_all(_fd, reinterpret_cast<const char *>(&header), sizeof(header), _path);
+        write_all(_fd, _block.data(), _block.size(), _path);
+        _block.clear();
+        _records = 0;
+    }
+
+    int _fd;
+    const std::string &_path;
+    std::string _block;
+    uint32_t _records;
+};
+
+// Block of the mapped snapshot file
+struct Block {
+    const char *data;
+    uint32_t size;
+    uint32_t records;
+    uint32_t crc;
+};
+
+// Checks that block is intact and records take exactly the whole payload
+bool verify(const Block &block) {
+    if (Crc32c(block.data, block.size) != block.crc) {
+        return false;
+    }
+    std::size_t offset = 0;
+    for (uint32_t i = 0; i < block.records; i++) {
+        RecordHeader header;
+        if (block.size - offset < sizeof(header)) {
+            return false;
+        }
+        std::memcpy(&header, block.data + offset, sizeof(header));
+        offset += sizeof(header);
+        if (block.size - offset < std::size_t(header.key_size) + header.value_size) {
+            return false;
+        }
+        offset += std::size_t(header.key_size) + header.value_size;
+    }
+    return offset == block.size;
+}
+
+// Splits mapped file into blocks, returns false if file is malformed or truncated
+bool split(const char *data, std::size_t size, std::vector<Block> &blocks) {
+    FileHeader file;
+    if (size < sizeof(file)) {
+        return false;
+    }
+    std::memcpy(&file, data, sizeof(file));
+    if (std::memcmp(file.magic, magic, sizeof(magic)) != 0 || file.version != version) {
+        return false;
+    }
+
+    for (std::size_t offset = sizeof(file);;) {
+        BlockHeader header;
+        if (size - offset < sizeof(header)) {
+            return false;
+        }
+        std::memcpy(&header, data + offset, sizeof(header));
+        offset += sizeof(header);
+        if (header.size == 0 && header.records == 0) {
+            return offset == size;
+        }
+        if (size - offset < header.size) {
+            return false;
+        }
+        blocks.push_back({data + offset, header.size, header.records, header.crc});
+        offset += header.size;
+    }
+}
+
+} // namespace
+
+// See Snapshot.h
+uint32_t Crc32c(const void *data, std::size_t size, uint32_t crc) {
+    const unsigned char *it = static_cast<const unsigned char *>(data);
+    crc = ~crc;
+#ifdef __SSE4_2__
+    uint64_t crc64 = crc;
+    for (; size >= sizeof(uint64_t); size -= sizeof(uint64_t), it += sizeof(uint64_t)) {
+        uint64_t word;
+        std::memcpy(&word, it, sizeof(word));
+        crc64 = _mm_crc32_u64(crc64, word);
+    }
+    crc = uint32_t(crc64);
+    for (; size > 0; size--, it++) {
+        crc = _mm_crc32_u8(crc, *it);
+    }
+#else
+    static const CrcTable table;
+    for (; size > 0; size--, it++) {
+        crc = table.entries[(crc ^ *it) & 0xFF] ^ (crc >> 8);
+    }
+#endif
+    return ~crc;
+}
+
+// See Snapshot.h
+void WriteSnapshot(Afina::Storage &storage, const std::string &path) {
+    std::string tmp_path = path + ".tmp";
+    int fd = ::open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw io_error("Failed to create", tmp_path);
+    }
+
+    try {
+        FileHeader header = {{}, version, 0};
+        std::memcpy(header.magic, magic, sizeof(magic));
+        write_all(fd, reinterpret_cast<const char *>(&header), sizeof(header), tmp_path);
+
+        Writer writer(fd, tmp_path);
+        if (!storage.ForEach(
+                [&writer](const char *key, std::size_t key_size, const char *value, std::size_t value_size,
+                          uint32_t exptime) { writer.Add(key, key_size, value, value_size, exptime); })) {
+            throw std::runtime_error("Storage doesn't support snapshots");
+        }
+        writer.Finish();
+
+        if (::fsync(fd) != 0) {
+            throw io_error("Failed to sync", tmp_path);
+        }
+    } catch (...) {
+        ::close(fd);
+        ::unlink(tmp_path.c_str());
+        throw;
+    }
+
+    ::close(fd);
+    if (::rename(tmp_path.c_str(), path.c_str()) != 0) {
+        throw io_error("Failed to replace", path);
+    }
+}
+
+// See Snapshot.h
+pid_t ForkSnapshot(Afina::Storage &storage, const std::string &path) {
+    pid_t pid = -1;
+    storage.Freeze([&pid]() { pid = ::fork(); });
+    if (pid < 0) {
+        throw std::runtime_error(std::string("Failed to fork: ") + std::strerror(errno));
+    } else if (pid > 0) {
+        return pid;
+    }
+
+    // Child is the only thread left, all storage locks were released on return from Freeze
+    int status = 0;
+    try {
+        WriteSnapshot(storage, path);
+    } catch (...) {
+        status = 1;
+    }
+    ::_exit(status);
+}
+
+// See Snapshot.h
+std::size_t LoadSnapshot(Afina::Storage &storage, const std::string &path, std::size_t threads) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw io_error("Failed to open", path);
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw io_error("Failed to stat", path);
+    }
+    std::size_t size = st.st_size;
+    void *mapped = size > 0 ? ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0) : MAP_FAILED;
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        throw io_error("Failed to map", path);
+    }
+    const char *data = static_cast<const char *>(mapped);
+
+    std::vector<Block> blocks;
+    bool intact = split(data, size, blocks);
+
+    // Checksums take most of the reading time, blocks are verified in parallel
+    if (intact) {
+        std::atomic<bool> failed(false);
+        std::atomic<std::size_t> next(0);
+        auto work = [&blocks, &failed, &next]() {
+            for (std::size_t i; !failed.load(std::memory_order_relaxed) && (i = next.fetch_add(1)) < blocks.size();) {
+                if (!verify(blocks[i])) {
+                    failed.store(true);
+                }
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for (std::size_t i = 1; i < std::min(threads, blocks.size()); i++) {
+            workers.emplace_back(work);
+        }
+        work();
+        for (auto &worker : workers) {
+            worker.join();
+        }
+        intact = !failed.load();
+    }
+    if (!intact) {
+        ::munmap(mapped, size);
+        throw std::runtime_error("Snapshot " + path + " is corrupted");
+    }
+
+    // Records go to storage in the file order to restore LRU order
+    uint32_t now = uint32_t(std::time(nullptr));
+    std::size_t stored = 0;
+    std::string key, value;
+    for (const Block &block : blocks) {
+        const char *it = block.data;
+        for (uint32_t i = 0; i < block.records; i++) {
+            RecordHeader header;
+            std::memcpy(&header, it, sizeof(header));
+            it += sizeof(header);
+            key.assign(it, header.key_size);
+            it += header.key_size;
+            value.assign(it, header.value_size);
+            it += header.value_size;
+
+            if (header.exptime != 0 && header.exptime <= now) {
+                continue;
+            }
+            stored += storage.PutExpiring(key, value, header.exptime);
+        }
+    }
+
+    ::munmap(mapped, size);
+    return stored;
+}
+
+} // namespace Backend
+} // namespace Afina
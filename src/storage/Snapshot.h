@@ -0,0 +1,60 @@
+#ifndef AFINA_STORAGE_SNAPSHOT_H
+#define AFINA_STORAGE_SNAPSHOT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <sys/types.h>
+
+#include <afina/Storage.h>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Storage snapshots
+ * Snapshot file holds all associations of the storage, so that restarted server could be warmed up
+ * from it. File starts with a header followed by blocks of records, the last block is empty:
+ *
+ * [ magic | version ][ size | records | crc ][ record ... ] ... [ 0 | 0 | 0 ]
+ *
+ * Every record is [ key size | value size | exptime ][ key ][ value ], records are written in LRU order
+ * as Storage::ForEach visits them. Block payload is protected by CRC32C and takes about 64KB unless a
+ * single record is bigger. Integers are in native byte order, so snapshot could be loaded on the
+ * same architecture only.
+ */
+
+/**
+ * CRC32C (Castagnoli) of the data, continuing crc of the preceding data. Uses SSE4.2 instruction
+ * when it is available
+ */
+uint32_t Crc32c(const void *data, std::size_t size, uint32_t crc = 0);
+
+/**
+ * Writes snapshot of the storage into the file. Data goes into a temporary file first, which replaces
+ * the given one once it is complete, so the previous snapshot is never lost
+ * @throw std::runtime_error if storage doesn't support iteration or file could not be written
+ */
+void WriteSnapshot(Afina::Storage &storage, const std::string &path);
+
+/**
+ * Forks the process with storage frozen and writes snapshot from the child, see Storage::Freeze.
+ * Storage keeps serving requests while child writes its copy-on-write image. Returns pid of the child,
+ * which exits with 0 status on success
+ * @throw std::runtime_error if process could not be forked
+ */
+pid_t ForkSnapshot(Afina::Storage &storage, const std::string &path);
+
+/**
+ * Puts all associations from the snapshot file into storage, expired ones are skipped. Blocks are
+ * verified by the given number of threads in parallel, then associations are put in the file order.
+ * Returns number of stored associations
+ * @throw std::runtime_error if file could not be read or is corrupted, nothing is stored then
+ */
+std::size_t LoadSnapshot(Afina::Storage &storage, const std::string &path, std::size_t threads = 1);
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_SNAPSHOT_H
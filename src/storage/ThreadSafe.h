@@ -0,0 +1,136 @@
+#ifndef AFINA_STORAGE_THREAD_SAFE_H
+#define AFINA_STORAGE_THREAD_SAFE_H
+
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <afina/Storage.h>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Global lock wrapper
+ * Makes any single threaded storage thread safe by serializing all calls on one mutex,
+ * same as ThreadSafeSimplLRU does for SimpleLRU
+ *
+ * Wrapped storage must implement every method locked here itself: the default implementations of
+ * Afina::Storage call other virtual methods, which would take the lock once again
+ */
+template <typename T> class ThreadSafe : public T {
+public:
+    template <typename... Args> ThreadSafe(Args &&... args) : T(std::forward<Args>(args)...) {}
+    ~ThreadSafe() {}
+
+    // see Afina::Storage
+    bool Put(const std::string &key, const std::string &value) override {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return T::Put(key, value);
+    }
+
+    // see Afina::Storage
+    bool PutIfAbsent(const std::string &key, const std::string &value) override {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return T::PutIfAbsent(key, value);
+    }
+
+    // see Afina::Storage
+    bool Set(const std::string &key, const std::string &value) override {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return T::Set(key, value);
+    }
+
+    // see Afina::Storage
+    bool Delete(const std::string &key) override {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return T::Delete(key);
+    }
+
+    // see Afina::Storage
+    bool Get(const std::string &key, std::string &value) override {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return T::Get(key, value);
+    }
+
+    // see Afina::Storage, values are copied under a single lock
+    std::size_t MultiGet(const std::vector<std::string> &keys, std::vector<Value> &values) override {
+        values.clear();
+        values.resize(keys.size());
+        std::size_t found = 0;
+        std::string value;
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (std::size_t i = 0; i < keys.size(); i++) {
+            if (T::Get(keys[i], value)) {
+                values[i] = Value(std::move(value));
+                found++;
+            }
+        }
+        return found;
+    }
+
+    // see Afina::Storage
+    bool PutExpiring(const std::string &key, const std::string &value, uint32_t exptime) override {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return T::PutExpiring(key, value, exptime);
+    }
+
+    // see Afina::Storage
+    bool PutIfAbsentExpiring(const std::string &key, const std::string &value, uint32_t exptime) override {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return T::PutIfAbsentExpiring(key, value, exptime);
+    }
+
+    // see Afina::Storage
+    bool SetExpiring(const std::string &key, const std::string &value, uint32_t exptime) override {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return T::SetExpiring(key, value, exptime);
+    }
+
+    // see Afina::Storage
+    bool Touch(const std::string &key, uint32_t exptime) override {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return T::Touch(key, exptime);
+    }
+
+    // see Afina::Storage
+    bool GetAndTouch(const std::string &key, std::string &value, uint32_t exptime) override {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return T::GetAndTouch(key, value, exptime);
+    }
+
+    // see Afina::Storage, value is read and stored back under a single lock. Conditional changes, such as
+    // CompareAndSwap and Append, are made by Update, so they are atomic as well
+    bool Update(const std::string &key, const Afina::Storage::Updater &updater) override {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return T::Update(key, updater);
+    }
+
+    // see Afina::Storage
+    bool GetCas(const std::string &key, Value &value, uint64_t &cas) override {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return T::GetCas(key, value, cas);
+    }
+
+    // see Afina::Storage
+    Afina::Storage::CasResult CompareAndSwap(const std::string &key, const std::string &value, uint64_t cas,
+                                             uint32_t exptime) override {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return T::CompareAndSwap(key, value, cas, exptime);
+    }
+
+    // see Afina::Storage
+    void Stats(std::vector<std::pair<std::string, std::string>> &stats) override {
+        std::lock_guard<std::mutex> lock(_mutex);
+        T::Stats(stats);
+    }
+
+private:
+    std::mutex _mutex;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_THREAD_SAFE_H
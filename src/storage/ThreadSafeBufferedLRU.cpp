@@ -0,0 +1,203 @@
+#include "ThreadSafeBufferedLRU.h"
+
+#include <time.h>
+
+namespace Afina {
+namespace Backend {
+
+namespace {
+
+// How often maintenance thread drains buffers
+const std::chrono::milliseconds drain_interval(10);
+
+// Maximum number of expired items maintenance thread reclaims at once
+const std::size_t reclaim_slice = 64;
+
+// Sequential number of the calling thread, used to pick read buffer
+std::size_t thread_index() {
+    static std::atomic<std::size_t> next_index(0);
+    static thread_local std::size_t index = next_index.fetch_add(1);
+    return index;
+}
+
+} // namespace
+
+constexpr std::size_t ThreadSafeBufferedLRU::kBuffers;
+constexpr uint32_t ThreadSafeBufferedLRU::kBufferSize;
+
+// See ThreadSafeBufferedLRU.h
+void ThreadSafeBufferedLRU::Start() {
+    std::lock_guard<std::mutex> lock(_run_mutex);
+    if (_running) {
+        return;
+    }
+    _running = true;
+    _thread = std::thread(&ThreadSafeBufferedLRU::OnRun, this);
+}
+
+// See ThreadSafeBufferedLRU.h
+void ThreadSafeBufferedLRU::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(_run_mutex);
+        _running = false;
+    }
+    _run_condition.notify_all();
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+}
+
+// See ThreadSafeBufferedLRU.h
+bool ThreadSafeBufferedLRU::Get(const std::string &key, std::string &value) {
+    std::size_t hash = key_hash(key);
+    bool need_drain = false;
+    {
+        Concurrency::SharedLock lock(_lock);
+        Item *item = find_shared(key, hash);
+        if (item == nullptr) {
+            return false;
+        }
+        value.assign(item->value(), item->value_size);
+        need_drain = record(item);
+    }
+
+    // Don't wait for the lock, if someone holds it exclusively buffers will be drained anyway
+    if (need_drain && _lock.try_lock()) {
+        drain();
+        _lock.unlock();
+    }
+    return true;
+}
+
+// See ThreadSafeBufferedLRU.h
+bool ThreadSafeBufferedLRU::GetValue(const std::string &key, Value &value) {
+    std::size_t hash = key_hash(key);
+    bool need_drain = false;
+    {
+        Concurrency::SharedLock lock(_lock);
+        Item *item = find_shared(key, hash);
+        if (item == nullptr) {
+            return false;
+        }
+        value = item->Share();
+        need_drain = record(item);
+    }
+
+    if (need_drain && _lock.try_lock()) {
+        drain();
+        _lock.unlock();
+    }
+    return true;
+}
+
+// See ThreadSafeBufferedLRU.h
+std::size_t ThreadSafeBufferedLRU::MultiGet(const std::vector<std::string> &keys, std::vector<Value> &values) {
+    std::vector<std::size_t> hashes(keys.size());
+    std::vector<std::size_t> positions(keys.size());
+    for (std::size_t i = 0; i < keys.size(); i++) {
+        hashes[i] = key_hash(keys[i]);
+        positions[i] = i;
+    }
+    values.clear();
+    values.resize(keys.size());
+
+    std::size_t found = 0;
+    bool need_drain = false;
+    {
+        Concurrency::SharedLock lock(_lock);
+        found = get_many(keys, hashes, positions, values, [&](const std::string &key, std::size_t hash) {
+            Item *item = find_shared(key, hash);
+            if (item != nullptr) {
+                need_drain = record(item) || need_drain;
+            }
+            return item;
+        });
+    }
+
+    if (need_drain && _lock.try_lock()) {
+        drain();
+        _lock.unlock();
+    }
+    return found;
+}
+
+uint32_t ThreadSafeBufferedLRU::now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    return uint32_t(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+ThreadSafeBufferedLRU::ReadBuffer &ThreadSafeBufferedLRU::buffer() { return _buffers[thread_index() & (kBuffers - 1)]; }
+
+Item *ThreadSafeBufferedLRU::find_shared(const std::string &key, std::size_t hash) {
+    Item *item = find(key, hash);
+    if (item == nullptr || TimingWheel::Expired(item)) {
+        buffer().get_misses.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    buffer().get_hits.fetch_add(1, std::memory_order_relaxed);
+    return item;
+}
+
+bool ThreadSafeBufferedLRU::record(Item *item) {
+    // Promoted recently enough, no reason to do that again. Field is changed by drain only, which
+    // can't run concurrently
+    if (promoted_recently(item, now_ms())) {
+        return false;
+    }
+
+    ReadBuffer &buffer = this->buffer();
+    uint32_t head = buffer.read_count.load(std::memory_order_relaxed);
+    uint32_t tail = buffer.write_count.load(std::memory_order_relaxed);
+    if (tail - head >= kBufferSize) {
+        return true;
+    }
+    // Buffer is lossy, on contention just drop the hit
+    if (!buffer.write_count.compare_exchange_strong(tail, tail + 1, std::memory_order_relaxed)) {
+        return false;
+    }
+    buffer.hits[tail & (kBufferSize - 1)].store(item, std::memory_order_relaxed);
+    return tail + 1 - head >= kBufferSize;
+}
+
+void ThreadSafeBufferedLRU::drain() {
+    uint32_t now = now_ms();
+    for (ReadBuffer &buffer : _buffers) {
+        uint32_t head = buffer.read_count.load(std::memory_order_relaxed);
+        uint32_t tail = buffer.write_count.load(std::memory_order_relaxed);
+        for (; head != tail; head++) {
+            Item *item = buffer.hits[head & (kBufferSize - 1)].load(std::memory_order_relaxed);
+            if (!promoted_recently(item, now)) {
+                access(item);
+                if (_promotion_delay != 0) {
+                    item->mark.store(period(now), std::memory_order_relaxed);
+                }
+            }
+        }
+        buffer.read_count.store(tail, std::memory_order_relaxed);
+
+        count_gets(buffer.get_hits.exchange(0, std::memory_order_relaxed),
+                   buffer.get_misses.exchange(0, std::memory_order_relaxed));
+    }
+}
+
+void ThreadSafeBufferedLRU::OnRun() {
+    std::unique_lock<std::mutex> lock(_run_mutex);
+    while (_running) {
+        _run_condition.wait_for(lock, drain_interval);
+        if (!_running) {
+            break;
+        }
+
+        lock.unlock();
+        {
+            std::lock_guard<Concurrency::SharedMutex> storage_lock(_lock);
+            drain();
+            Reclaim(reclaim_slice);
+        }
+        lock.lock();
+    }
+}
+
+} // namespace Backend
+} // namespace Afina
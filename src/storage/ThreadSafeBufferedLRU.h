@@ -0,0 +1,245 @@
+#ifndef AFINA_STORAGE_THREAD_SAFE_BUFFERED_LRU_H
+#define AFINA_STORAGE_THREAD_SAFE_BUFFERED_LRU_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <afina/concurrency/SharedMutex.h>
+
+#include "SimpleLRU.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # SimpleLRU thread safe version with deferred promotion
+ * Get doesn't reorder LRU list, so it runs under shared lock. Instead hit is recorded into one of
+ * the small lossy ring buffers, each thread always writes to the same one. Buffers are drained in
+ * batch by whoever takes the lock exclusively next: writer, reader that has filled a buffer, or
+ * maintenance thread running between Start and Stop.
+ *
+ * If buffer is full, hit is dropped. Item promoted within the current period of promotion_delay isn't
+ * recorded at all, so the hot items cost nothing but the read itself. Period is kept in Item::mark.
+ *
+ * Buffers keep raw pointers to items. It is safe because items are recorded under shared lock only
+ * and every exclusive section starts with the drain, before anything could be removed.
+ *
+ * Get can't remove expired item under shared lock, it just reports a miss. Such items are reclaimed by
+ * writers and maintenance thread.
+ *
+ * Hits and misses of Get are counted in the read buffers as well and added to the storage counters by
+ * drain, so stats see them once the buffers are drained.
+ */
+class ThreadSafeBufferedLRU : public SimpleLRU {
+public:
+    ThreadSafeBufferedLRU(size_t max_size = 1024,
+                          std::chrono::milliseconds promotion_delay = std::chrono::milliseconds(1000))
+        : SimpleLRU(max_size), _promotion_delay(promotion_delay.count()), _running(false) {}
+    ~ThreadSafeBufferedLRU() { Stop(); }
+
+    // Starts maintenance thread that drains read buffers and reclaims expired items periodically
+    void Start() override;
+
+    // Stops maintenance thread
+    void Stop() override;
+
+    // see SimpleLRU.h
+    bool Put(const std::string &key, const std::string &value) override {
+        std::lock_guard<Concurrency::SharedMutex> lock(_lock);
+        drain();
+        return SimpleLRU::Put(key, value);
+    }
+
+    // see SimpleLRU.h
+    bool PutIfAbsent(const std::string &key, const std::string &value) override {
+        std::lock_guard<Concurrency::SharedMutex> lock(_lock);
+        drain();
+        return SimpleLRU::PutIfAbsent(key, value);
+    }
+
+    // see SimpleLRU.h
+    bool Set(const std::string &key, const std::string &value) override {
+        std::lock_guard<Concurrency::SharedMutex> lock(_lock);
+        drain();
+        return SimpleLRU::Set(key, value);
+    }
+
+    // see SimpleLRU.h
+    bool Delete(const std::string &key) override {
+        std::lock_guard<Concurrency::SharedMutex> lock(_lock);
+        drain();
+        return SimpleLRU::Delete(key);
+    }
+
+    // see SimpleLRU.h
+    bool Get(const std::string &key, std::string &value) override;
+
+    // see SimpleLRU.h
+    bool GetValue(const std::string &key, Value &value) override;
+
+    // see SimpleLRU.h, whole batch is looked up under a single shared lock
+    std::size_t MultiGet(const std::vector<std::string> &keys, std::vector<Value> &values) override;
+
+    // see SimpleLRU.h
+    bool ForEach(const Visitor &visitor) override {
+        std::lock_guard<Concurrency::SharedMutex> lock(_lock);
+        drain();
+        return SimpleLRU::ForEach(visitor);
+    }
+
+    // see Afina::Storage
+    void Freeze(const std::function<void()> &action) override {
+        std::lock_guard<Concurrency::SharedMutex> lock(_lock);
+        drain();
+        action();
+    }
+
+    // see SimpleLRU.h
+    void Stats(std::vector<std::pair<std::string, std::string>> &stats) override {
+        std::lock_guard<Concurrency::SharedMutex> lock(_lock);
+        drain();
+        SimpleLRU::Stats(stats);
+    }
+
+    // see SimpleLRU.h
+    bool PutExpiring(const std::string &key, const std::string &value, uint32_t exptime) override {
+        std::lock_guard<Concurrency::SharedMutex> lock(_lock);
+        drain();
+        return SimpleLRU::PutExpiring(key, value, exptime);
+    }
+
+    // see SimpleLRU.h
+    bool PutIfAbsentExpiring(const std::string &key, const std::string &value, uint32_t exptime) override {
+        std::lock_guard<Concurrency::SharedMutex> lock(_lock);
+        drain();
+        return SimpleLRU::PutIfAbsentExpiring(key, value, exptime);
+    }
+
+    // see SimpleLRU.h
+    bool SetExpiring(const std::string &key, const std::string &value, uint32_t exptime) override {
+        std::lock_guard<Concurrency::SharedMutex> lock(_lock);
+        drain();
+        return SimpleLRU::SetExpiring(key, value, exptime);
+    }
+
+    // see SimpleLRU.h
+    bool Touch(const std::string &key, uint32_t exptime) override {
+        std::lock_guard<Concurrency::SharedMutex> lock(_lock);
+        drain();
+        return SimpleLRU::Touch(key, exptime);
+    }
+
+    // see SimpleLRU.h
+    bool GetAndTouch(const std::string &key, std::string &value, uint32_t exptime) override {
+        std::lock_guard<Concurrency::SharedMutex> lock(_lock);
+        drain();
+        return SimpleLRU::GetAndTouch(key, value, exptime);
+    }
+
+    // see SimpleLRU.h
+    bool Update(const std::string &key, const Updater &updater) override {
+        std::lock_guard<Concurrency::SharedMutex> lock(_lock);
+        drain();
+        return SimpleLRU::Update(key, updater);
+    }
+
+    // see SimpleLRU.h, unlike Get it is done under the exclusive lock
+    bool GetCas(const std::string &key, Value &value, uint64_t &cas) override {
+        std::lock_guard<Concurrency::SharedMutex> lock(_lock);
+        drain();
+        return SimpleLRU::GetCas(key, value, cas);
+    }
+
+    // see SimpleLRU.h
+    CasResult CompareAndSwap(const std::string &key, const std::string &value, uint64_t cas,
+                             uint32_t exptime) override {
+        std::lock_guard<Concurrency::SharedMutex> lock(_lock);
+        drain();
+        return SimpleLRU::CompareAndSwap(key, value, cas, exptime);
+    }
+
+    // see SimpleLRU.h
+    bool Append(const std::string &key, const std::string &data) override {
+        std::lock_guard<Concurrency::SharedMutex> lock(_lock);
+        drain();
+        return SimpleLRU::Append(key, data);
+    }
+
+    // see SimpleLRU.h
+    bool Prepend(const std::string &key, const std::string &data) override {
+        std::lock_guard<Concurrency::SharedMutex> lock(_lock);
+        drain();
+        return SimpleLRU::Prepend(key, data);
+    }
+
+private:
+    // Number of read buffers, power of 2
+    static constexpr std::size_t kBuffers = 16;
+
+    // Number of hits each buffer could hold, power of 2
+    static constexpr uint32_t kBufferSize = 32;
+
+    // Lossy single ring buffer. Written by readers under the shared lock, read by drain under the exclusive one
+    struct ReadBuffer {
+        std::atomic<uint32_t> write_count{0};
+        std::atomic<uint32_t> read_count{0};
+        std::atomic<Item *> hits[kBufferSize];
+
+        // Lookups done since the last drain, they are never dropped
+        std::atomic<std::size_t> get_hits{0};
+        std::atomic<std::size_t> get_misses{0};
+
+        // Keeps buffers of different threads on different cache lines
+        char padding[64];
+    };
+
+    // Current coarse monotonic time in milliseconds
+    static uint32_t now_ms();
+
+    // Number of the promotion period, in 1..255 so that zero means item has never been promoted
+    uint8_t period(uint32_t now) const { return uint8_t(now / _promotion_delay % 255 + 1); }
+
+    // Checks if item has been promoted within the current promotion period
+    bool promoted_recently(const Item *item, uint32_t now) const {
+        return _promotion_delay != 0 && item->mark.load(std::memory_order_relaxed) == period(now);
+    }
+
+    // Returns buffer of the calling thread
+    ReadBuffer &buffer();
+
+    // Looks up item under the shared lock and counts the lookup, expired item is reported missing
+    Item *find_shared(const std::string &key, std::size_t hash);
+
+    // Records hit on the item, returns true if buffer gets full and should be drained
+    bool record(Item *item);
+
+    // Applies all recorded hits. Call only under exclusive lock
+    void drain();
+
+    // Maintenance thread body
+    void OnRun();
+
+    // Length of promotion period in milliseconds, items are promoted once per period at most
+    const uint32_t _promotion_delay;
+
+    ReadBuffer _buffers[kBuffers];
+
+    // Get holds it shared, everything else exclusively
+    Concurrency::SharedMutex _lock;
+
+    // Maintenance thread state
+    std::mutex _run_mutex;
+    std::condition_variable _run_condition;
+    bool _running;
+    std::thread _thread;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_THREAD_SAFE_BUFFERED_LRU_H
@@ -1,9 +1,12 @@
 #ifndef AFINA_STORAGE_THREAD_SAFE_SIMPLE_LRU_H
 #define AFINA_STORAGE_THREAD_SAFE_SIMPLE_LRU_H
 
+#include <functional>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <vector>
 
 #include "SimpleLRU.h"
 
@@ -15,45 +18,161 @@ namespace Backend {
  *
  *
  */
-class ThreadSafeSimplLRU : public SimpleLRU {
+template <typename Policy> class ThreadSafeBasicLRU : public BasicLRU<Policy> {
 public:
-    ThreadSafeSimplLRU(size_t max_size = 1024) : SimpleLRU(max_size) {}
-    ~ThreadSafeSimplLRU() {}
+    using typename BasicLRU<Policy>::CasResult;
+    using typename BasicLRU<Policy>::Updater;
+    using typename BasicLRU<Policy>::Visitor;
+
+    ThreadSafeBasicLRU(size_t max_size = 1024, std::unique_ptr<ColdTier> cold = nullptr)
+        : BasicLRU<Policy>(max_size, std::move(cold)) {}
+    ~ThreadSafeBasicLRU() {}
 
     // see SimpleLRU.h
     bool Put(const std::string &key, const std::string &value) override {
         std::lock_guard<std::mutex> lock(_mutex);
-        return SimpleLRU::Put(key, value);
+        return BasicLRU<Policy>::Put(key, value);
     }
 
     // see SimpleLRU.h
     bool PutIfAbsent(const std::string &key, const std::string &value) override {
         std::lock_guard<std::mutex> lock(_mutex);
-        return SimpleLRU::PutIfAbsent(key, value);
+        return BasicLRU<Policy>::PutIfAbsent(key, value);
     }
 
     // see SimpleLRU.h
     bool Set(const std::string &key, const std::string &value) override {
         std::lock_guard<std::mutex> lock(_mutex);
-        return SimpleLRU::Set(key, value);
+        return BasicLRU<Policy>::Set(key, value);
     }
 
     // see SimpleLRU.h
     bool Delete(const std::string &key) override {
         std::lock_guard<std::mutex> lock(_mutex);
-        return SimpleLRU::Delete(key);
+        return BasicLRU<Policy>::Delete(key);
     }
 
     // see SimpleLRU.h
     bool Get(const std::string &key, std::string &value) override {
         std::lock_guard<std::mutex> lock(_mutex);
-        return SimpleLRU::Get(key, value);
+        return BasicLRU<Policy>::Get(key, value);
+    }
+
+    // see SimpleLRU.h
+    bool GetValue(const std::string &key, Value &value) override {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return BasicLRU<Policy>::GetValue(key, value);
+    }
+
+    // see SimpleLRU.h, keys are hashed before the lock is taken
+    std::size_t MultiGet(const std::vector<std::string> &keys, std::vector<Value> &values) override {
+        std::vector<std::size_t> hashes(keys.size());
+        std::vector<std::size_t> positions(keys.size());
+        for (std::size_t i = 0; i < keys.size(); i++) {
+            hashes[i] = this->key_hash(keys[i]);
+            positions[i] = i;
+        }
+        values.clear();
+        values.resize(keys.size());
+        return MultiGet(keys, hashes, positions, values);
+    }
+
+    // see SimpleLRU.h
+    bool ForEach(const Visitor &visitor) override {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return BasicLRU<Policy>::ForEach(visitor);
+    }
+
+    // see SimpleLRU.h
+    void Stats(std::vector<std::pair<std::string, std::string>> &stats) override {
+        std::lock_guard<std::mutex> lock(_mutex);
+        BasicLRU<Policy>::Stats(stats);
+    }
+
+    // see Afina::Storage
+    void Freeze(const std::function<void()> &action) override {
+        std::lock_guard<std::mutex> lock(_mutex);
+        action();
+    }
+
+    /**
+     * Looks up part of the batch under a single lock, for storages that split batch between several
+     * SimpleLRU. Only keys at the given positions are looked up, hashes are precomputed for all keys
+     * and values are resized to the number of keys already
+     */
+    std::size_t MultiGet(const std::vector<std::string> &keys, const std::vector<std::size_t> &hashes,
+                         const std::vector<std::size_t> &positions, std::vector<Value> &values) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return this->get_many(keys, hashes, positions, values);
+    }
+
+    // see SimpleLRU.h
+    bool PutExpiring(const std::string &key, const std::string &value, uint32_t exptime) override {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return BasicLRU<Policy>::PutExpiring(key, value, exptime);
+    }
+
+    // see SimpleLRU.h
+    bool PutIfAbsentExpiring(const std::string &key, const std::string &value, uint32_t exptime) override {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return BasicLRU<Policy>::PutIfAbsentExpiring(key, value, exptime);
+    }
+
+    // see SimpleLRU.h
+    bool SetExpiring(const std::string &key, const std::string &value, uint32_t exptime) override {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return BasicLRU<Policy>::SetExpiring(key, value, exptime);
+    }
+
+    // see SimpleLRU.h
+    bool Touch(const std::string &key, uint32_t exptime) override {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return BasicLRU<Policy>::Touch(key, exptime);
+    }
+
+    // see SimpleLRU.h
+    bool GetAndTouch(const std::string &key, std::string &value, uint32_t exptime) override {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return BasicLRU<Policy>::GetAndTouch(key, value, exptime);
+    }
+
+    // see SimpleLRU.h
+    bool Update(const std::string &key, const Updater &updater) override {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return BasicLRU<Policy>::Update(key, updater);
+    }
+
+    // see SimpleLRU.h
+    bool GetCas(const std::string &key, Value &value, uint64_t &cas) override {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return BasicLRU<Policy>::GetCas(key, value, cas);
+    }
+
+    // see SimpleLRU.h
+    CasResult CompareAndSwap(const std::string &key, const std::string &value, uint64_t cas,
+                             uint32_t exptime) override {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return BasicLRU<Policy>::CompareAndSwap(key, value, cas, exptime);
+    }
+
+    // see SimpleLRU.h
+    bool Append(const std::string &key, const std::string &data) override {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return BasicLRU<Policy>::Append(key, data);
+    }
+
+    // see SimpleLRU.h
+    bool Prepend(const std::string &key, const std::string &data) override {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return BasicLRU<Policy>::Prepend(key, data);
     }
 
 private:
     std::mutex _mutex;
 };
 
+using ThreadSafeSimplLRU = ThreadSafeBasicLRU<LRUPolicy>;
+
 } // namespace Backend
 } // namespace Afina
 
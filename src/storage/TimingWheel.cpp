@@ -0,0 +1,131 @@
+#include "TimingWheel.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include <time.h>
+
+namespace Afina {
+namespace Backend {
+
+constexpr unsigned TimingWheel::kLevels;
+constexpr unsigned TimingWheel::kSlotBits;
+constexpr uint32_t TimingWheel::kSlots;
+constexpr uint32_t TimingWheel::kSlotMask;
+constexpr uint16_t TimingWheel::kOverflow;
+
+TimingWheel::TimingWheel(uint32_t now) : _tick(now), _count(0) {
+    std::fill(_level_count, _level_count + kLevels + 1, 0);
+}
+
+// See TimingWheel.h
+uint32_t TimingWheel::Now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+    return uint32_t(ts.tv_sec);
+}
+
+// See TimingWheel.h
+void TimingWheel::Schedule(Item *item) {
+    assert(item->exptime != 0 && item->timer_slot == Item::kNoTimer);
+    place(item);
+    _count++;
+}
+
+// See TimingWheel.h
+void TimingWheel::Cancel(Item *item) {
+    if (item->timer_slot == Item::kNoTimer) {
+        return;
+    }
+    std::vector<Item *> &slot = _slots[item->timer_slot];
+    Item *last = slot.back();
+    slot[item->timer_index] = last;
+    last->timer_index = item->timer_index;
+    slot.pop_back();
+    _level_count[item->timer_slot / kSlots]--;
+    item->timer_slot = Item::kNoTimer;
+    _count--;
+}
+
+// See TimingWheel.h
+Item *TimingWheel::Expired(uint32_t now) {
+    while (int32_t(now - _tick) >= 0) {
+        if (_count == 0) {
+            _tick = now;
+            break;
+        }
+
+        if ((_tick & kSlotMask) == 0) {
+            cascade();
+        }
+
+        std::vector<Item *> &slot = _slots[_tick & kSlotMask];
+        if (!slot.empty()) {
+            Item *item = slot.back();
+            Cancel(item);
+            return item;
+        }
+
+        // Current tick isn't over yet, more items could be scheduled on it
+        if (_tick == now) {
+            break;
+        }
+
+        // Nothing to expire till the end of the lowest level, jump to the next cascade
+        _tick = _level_count[0] == 0 ? std::min((_tick | kSlotMask) + 1, now) : _tick + 1;
+    }
+    return nullptr;
+}
+
+void TimingWheel::place(Item *item) {
+    uint32_t when = std::max(item->exptime, _tick);
+    for (unsigned level = 0; level < kLevels; level++) {
+        unsigned shift = kSlotBits * (level + 1);
+        if ((when >> shift) == (_tick >> shift)) {
+            link(level * kSlots + ((when >> (kSlotBits * level)) & kSlotMask), item);
+            return;
+        }
+    }
+    link(kOverflow, item);
+}
+
+void TimingWheel::cascade() {
+    // Upper levels go first, so their items could fall through several levels at once. Cascading the
+    // same tick again is harmless: slot contains only items placed after the previous time
+    uint32_t tick = _tick;
+    if ((tick & ((uint32_t(1) << (kSlotBits * kLevels)) - 1)) == 0) {
+        replace_all(kOverflow);
+    }
+    for (unsigned level = kLevels - 1; level > 0; level--) {
+        unsigned shift = kSlotBits * level;
+        if ((tick & ((uint32_t(1) << shift) - 1)) == 0) {
+            replace_all(level * kSlots + ((tick >> shift) & kSlotMask));
+        }
+    }
+}
+
+void TimingWheel::replace_all(uint16_t slot) {
+    // Overflow items could get back into the same slot, so they are placed from a copy
+    std::vector<Item *> items;
+    items.swap(_slots[slot]);
+    _level_count[slot / kSlots] -= items.size();
+    for (Item *item : items) {
+        place(item);
+    }
+
+    // Memory of the slot is kept unless some items are back there
+    if (_slots[slot].empty()) {
+        items.clear();
+        _slots[slot].swap(items);
+    }
+}
+
+void TimingWheel::link(uint16_t slot, Item *item) {
+    item->timer_slot = slot;
+    item->timer_index = _slots[slot].size();
+    _slots[slot].push_back(item);
+    _level_count[slot / kSlots]++;
+}
+
+} // namespace Backend
+} // namespace Afina
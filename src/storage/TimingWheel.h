@@ -0,0 +1,87 @@
+#ifndef AFINA_STORAGE_TIMING_WHEEL_H
+#define AFINA_STORAGE_TIMING_WHEEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Item.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Hierarchical timing wheel of item expiration
+ * Items are scheduled by Item::exptime, absolute time in seconds. There are 4 levels of 64 slots, slot
+ * of level L spans 64^L seconds, so the wheel covers 64^4 seconds (about 194 days) ahead, items expiring
+ * later wait in the overflow list.
+ *
+ * Item goes to the lowest level where its expiration time shares the same higher bits with the current
+ * tick. Once the tick reaches the beginning of a slot on upper level, items of that slot are cascaded
+ * down, so each item is moved at most 4 times before it expires.
+ *
+ * Slots are arrays of items, item knows its slot and position there, see Item::timer_slot/timer_index.
+ * Cancelled item is replaced by the last one of the slot, so scheduling and cancelling are O(1) and
+ * items without expiration time don't pay for the links. Slot memory is kept once allocated.
+ *
+ * That is NOT thread safe implementation
+ */
+class TimingWheel {
+public:
+    // Starts wheel at the given time, items expiring at that time or earlier expire immediately
+    explicit TimingWheel(uint32_t now);
+
+    // Current coarse wall clock time in seconds
+    static uint32_t Now();
+
+    // Checks if item with expiration time is expired already
+    static bool Expired(const Item *item) { return item->exptime != 0 && item->exptime <= Now(); }
+
+    // Schedules item by its exptime, which must not be 0. Item must not be scheduled yet
+    void Schedule(Item *item);
+
+    // Removes item from the wheel, does nothing if item isn't scheduled
+    void Cancel(Item *item);
+
+    /**
+     * Returns next item expired by the given time and removes it from the wheel, nullptr if there are
+     * no more such items. Caller decides how many items to process at once, the rest will be returned
+     * by the following calls
+     */
+    Item *Expired(uint32_t now);
+
+private:
+    static constexpr unsigned kLevels = 4;
+    static constexpr unsigned kSlotBits = 6;
+    static constexpr uint32_t kSlots = 1 << kSlotBits;
+    static constexpr uint32_t kSlotMask = kSlots - 1;
+
+    // Slots of each level go one after another, followed by the overflow slot
+    static constexpr uint16_t kOverflow = kLevels * kSlots;
+
+    // Puts item into the slot appropriate relatively to the current tick
+    void place(Item *item);
+
+    // Moves items of upper level slots starting at the current tick down to the lower levels
+    void cascade();
+
+    // Re-places all items of the given slot
+    void replace_all(uint16_t slot);
+
+    // Adds item to the end of the slot and accounts it on the level of the slot
+    void link(uint16_t slot, Item *item);
+
+    // Earliest tick which isn't processed completely, items expiring earlier are placed on it
+    uint32_t _tick;
+
+    std::vector<Item *> _slots[kOverflow + 1];
+
+    // Number of items on each level and in overflow list, allows to skip empty ones quickly
+    std::size_t _level_count[kLevels + 1];
+    std::size_t _count;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_TIMING_WHEEL_H
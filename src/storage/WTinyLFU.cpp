@@ -0,0 +1,350 @@
+#include "WTinyLFU.h"
+
+#include <cassert>
+
+namespace Afina {
+namespace Backend {
+
+namespace {
+
+// Maximum number of expired items reclaimed by a single write operation, see SimpleLRU
+const std::size_t reclaim_slice = 8;
+
+} // namespace
+
+WTinyLFU::WTinyLFU(size_t max_size)
+    : _max_size(max_size), _window_max(max_size / 100), _protected_max((max_size - max_size / 100) / 5 * 4),
+      _timers(TimingWheel::Now()) {
+    _sketch.EnsureCapacity(0);
+}
+
+WTinyLFU::~WTinyLFU() {
+    _index.Clear();
+    for (ItemList &queue : _queues) {
+        while (!queue.Empty()) {
+            Item *item = queue.head;
+            queue.Remove(item);
+            Item::Destroy(item);
+        }
+    }
+}
+
+// See WTinyLFU.h
+bool WTinyLFU::Put(const std::string &key, const std::string &value) { return WTinyLFU::PutExpiring(key, value, 0); }
+
+// See WTinyLFU.h
+bool WTinyLFU::PutIfAbsent(const std::string &key, const std::string &value) {
+    return WTinyLFU::PutIfAbsentExpiring(key, value, 0);
+}
+
+// See WTinyLFU.h
+bool WTinyLFU::Set(const std::string &key, const std::string &value) { return WTinyLFU::SetExpiring(key, value, 0); }
+
+// See WTinyLFU.h
+bool WTinyLFU::Delete(const std::string &key) {
+    reclaim(reclaim_slice);
+    Item *item = lookup(key, _index.Hash(key));
+    if (item == nullptr) {
+        return false;
+    }
+    remove(item);
+    return true;
+}
+
+// See WTinyLFU.h
+bool WTinyLFU::Get(const std::string &key, std::string &value) {
+    std::size_t hash = _index.Hash(key);
+    // Misses are counted as well, key could deserve to be admitted once it is put
+    _sketch.Increment(hash);
+    Item *item = lookup(key, hash);
+    if (item == nullptr) {
+        return false;
+    }
+    value.assign(item->value(), item->value_size);
+    on_access(item);
+    return true;
+}
+
+// See WTinyLFU.h
+bool WTinyLFU::PutExpiring(const std::string &key, const std::string &value, uint32_t exptime) {
+    if (Item::Footprint(key.size(), value.size()) > _max_size) {
+        return false;
+    }
+    reclaim(reclaim_slice);
+    std::size_t hash = _index.Hash(key);
+    _sketch.Increment(hash);
+    Item *item = lookup(key, hash);
+    if (item == nullptr) {
+        return put(key, value, hash, exptime);
+    }
+    return set(item, value, exptime);
+}
+
+// See WTinyLFU.h
+bool WTinyLFU::PutIfAbsentExpiring(const std::string &key, const std::string &value, uint32_t exptime) {
+    if (Item::Footprint(key.size(), value.size()) > _max_size) {
+        return false;
+    }
+    reclaim(reclaim_slice);
+    std::size_t hash = _index.Hash(key);
+    if (lookup(key, hash) != nullptr) {
+        return false;
+    }
+    _sketch.Increment(hash);
+    return put(key, value, hash, exptime);
+}
+
+// See WTinyLFU.h
+bool WTinyLFU::SetExpiring(const std::string &key, const std::string &value, uint32_t exptime) {
+    if (Item::Footprint(key.size(), value.size()) > _max_size) {
+        return false;
+    }
+    reclaim(reclaim_slice);
+    std::size_t hash = _index.Hash(key);
+    Item *item = lookup(key, hash);
+    if (item == nullptr) {
+        return false;
+    }
+    _sketch.Increment(hash);
+    return set(item, value, exptime);
+}
+
+// See WTinyLFU.h
+bool WTinyLFU::Touch(const std::string &key, uint32_t exptime) {
+    reclaim(reclaim_slice);
+    std::size_t hash = _index.Hash(key);
+    _sketch.Increment(hash);
+    Item *item = lookup(key, hash);
+    if (item == nullptr) {
+        return false;
+    }
+    expire(item, exptime);
+    on_access(item);
+    return true;
+}
+
+// See WTinyLFU.h
+bool WTinyLFU::GetAndTouch(const std::string &key, std::string &value, uint32_t exptime) {
+    reclaim(reclaim_slice);
+    std::size_t hash = _index.Hash(key);
+    _sketch.Increment(hash);
+    Item *item = lookup(key, hash);
+    if (item == nullptr) {
+        return false;
+    }
+    value.assign(item->value(), item->value_size);
+    expire(item, exptime);
+    on_access(item);
+    return true;
+}
+
+// See WTinyLFU.h
+bool WTinyLFU::Update(const std::string &key, const Updater &updater) {
+    reclaim(reclaim_slice);
+    std::size_t hash = _index.Hash(key);
+    Item *item = lookup(key, hash);
+    if (item == nullptr) {
+        return false;
+    }
+    std::string value;
+    uint32_t exptime = item->exptime;
+    if (!updater(item->value(), item->value_size, item->cas, value, exptime) ||
+        Item::Footprint(key.size(), value.size()) > _max_size) {
+        return false;
+    }
+    _sketch.Increment(hash);
+    return set(item, value, exptime);
+}
+
+// See WTinyLFU.h
+bool WTinyLFU::GetCas(const std::string &key, Value &value, uint64_t &cas) {
+    std::size_t hash = _index.Hash(key);
+    _sketch.Increment(hash);
+    Item *item = lookup(key, hash);
+    if (item == nullptr) {
+        return false;
+    }
+    value = Value(std::string(item->value(), item->value_size));
+    cas = item->cas;
+    on_access(item);
+    return true;
+}
+
+// See WTinyLFU.h
+WTinyLFU::CasResult WTinyLFU::CompareAndSwap(const std::string &key, const std::string &value, uint64_t cas,
+                                             uint32_t exptime) {
+    reclaim(reclaim_slice);
+    std::size_t hash = _index.Hash(key);
+    Item *item = lookup(key, hash);
+    if (item == nullptr) {
+        return CasResult::kNotFound;
+    }
+    if (item->cas != cas) {
+        return CasResult::kExists;
+    }
+    if (Item::Footprint(key.size(), value.size()) > _max_size) {
+        return CasResult::kNotStored;
+    }
+    _sketch.Increment(hash);
+    return set(item, value, exptime) ? CasResult::kStored : CasResult::kNotStored;
+}
+
+// See WTinyLFU.h
+void WTinyLFU::Stats(std::vector<std::pair<std::string, std::string>> &stats) {
+    stats.emplace_back("tinylfu_admitted", std::to_string(_admitted));
+    stats.emplace_back("tinylfu_rejected", std::to_string(_rejected));
+    stats.emplace_back("tinylfu_sketch_bytes", std::to_string(_sketch.MemoryUsage()));
+}
+
+Item *WTinyLFU::lookup(const std::string &key, std::size_t hash) {
+    Item *item = _index.Find(key, hash);
+    if (item != nullptr && TimingWheel::Expired(item)) {
+        remove(item);
+        return nullptr;
+    }
+    return item;
+}
+
+void WTinyLFU::reclaim(std::size_t limit) {
+    uint32_t now = TimingWheel::Now();
+    Item *item;
+    for (std::size_t i = 0; i < limit && (item = _timers.Expired(now)) != nullptr; i++) {
+        remove(item);
+    }
+}
+
+void WTinyLFU::expire(Item *item, uint32_t exptime) {
+    _timers.Cancel(item);
+    item->exptime = exptime;
+    if (exptime != 0) {
+        _timers.Schedule(item);
+    }
+}
+
+void WTinyLFU::on_access(Item *item) {
+    switch (item->queue) {
+    case kWindow:
+    case kProtected:
+        _queues[item->queue].MoveToFront(item);
+        break;
+
+    case kProbation:
+        // Second access, item deserves protection. Protected segment overflow goes back on probation
+        _queues[kProbation].Remove(item);
+        item->queue = kProtected;
+        _queues[kProtected].PushFront(item);
+        while (_queues[kProtected].size > _protected_max) {
+            Item *demoted = _queues[kProtected].tail;
+            _queues[kProtected].Remove(demoted);
+            demoted->queue = kProbation;
+            _queues[kProbation].PushFront(demoted);
+        }
+        break;
+
+    default:
+        assert(false);
+    }
+}
+
+void WTinyLFU::remove(Item *item) {
+    bool erased = _index.Erase(item, item->hash);
+    assert(erased);
+    _queues[item->queue].Remove(item);
+    _timers.Cancel(item);
+    _curr_size -= item->Footprint();
+    Item::Destroy(item);
+}
+
+bool WTinyLFU::set(Item *item, const std::string &value, uint32_t exptime) {
+    if (item->FitsInPlace(value.size())) {
+        item->SetValue(value);
+        item->cas = ++_cas;
+        expire(item, exptime);
+        on_access(item);
+        return true;
+    }
+
+    Item *new_item = Item::Create(item->key(), item->key_size, value.data(), value.size(), item->hash);
+    new_item->flags = item->flags;
+    new_item->cas = ++_cas;
+    new_item->queue = item->queue;
+    _index.Replace(item, new_item, item->hash);
+    _queues[item->queue].Replace(item, new_item);
+    _timers.Cancel(item);
+    expire(new_item, exptime);
+    _curr_size += new_item->Footprint() - item->Footprint();
+    Item::Destroy(item);
+
+    on_access(new_item);
+    return evict(new_item, new_item);
+}
+
+bool WTinyLFU::put(const std::string &key, const std::string &value, std::size_t hash, uint32_t exptime) {
+    Item *item = Item::Create(key, value, hash);
+    item->cas = ++_cas;
+    item->queue = kWindow;
+    _index.Insert(item, hash);
+    _queues[kWindow].PushFront(item);
+    expire(item, exptime);
+    _curr_size += item->Footprint();
+
+    _sketch.EnsureCapacity(_index.Size());
+    return evict(item);
+}
+
+bool WTinyLFU::evict(const Item *watch, const Item *keep) {
+    // Window overflow goes to the head of probation, these items are candidates for the main space.
+    // Candidates are kept next to each other, from the oldest one to the head
+    Item *candidate = nullptr;
+    std::size_t candidates = 0;
+    while (_queues[kWindow].size > _window_max) {
+        Item *item = _queues[kWindow].tail;
+        _queues[kWindow].Remove(item);
+        item->queue = kProbation;
+        _queues[kProbation].PushFront(item);
+        if (candidate == nullptr) {
+            candidate = item;
+        }
+        candidates++;
+    }
+
+    bool watch_alive = true;
+    while (_curr_size > _max_size) {
+        // Updated item is in the storage already, so it is admitted without competition
+        if (candidate != nullptr && candidate == keep) {
+            candidate = --candidates > 0 ? candidate->prev : nullptr;
+            _admitted++;
+            continue;
+        }
+
+        // Candidates don't compete with each other: once probation holds nothing but them, the oldest one
+        // competes with the tail of protected segment
+        Item *victim = _queues[kProbation].Last(keep);
+        if (victim == nullptr || victim == candidate) {
+            victim = _queues[kProtected].Last(keep);
+        }
+        if (victim == nullptr) {
+            victim = candidate != nullptr ? candidate : _queues[kWindow].Last(keep);
+        }
+        if (victim == nullptr) {
+            break;
+        }
+
+        // Oldest candidate either has nobody to compete with or loses to the victim
+        if (candidate != nullptr &&
+            (victim == candidate || _sketch.Frequency(candidate->hash) <= _sketch.Frequency(victim->hash))) {
+            victim = candidate;
+            candidate = --candidates > 0 ? candidate->prev : nullptr;
+            _rejected++;
+        }
+
+        watch_alive = watch_alive && victim != watch;
+        remove(victim);
+    }
+
+    _admitted += candidates;
+    return watch_alive;
+}
+
+} // namespace Backend
+} // namespace Afina
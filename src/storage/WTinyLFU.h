@@ -0,0 +1,153 @@
+#ifndef AFINA_STORAGE_W_TINY_LFU_H
+#define AFINA_STORAGE_W_TINY_LFU_H
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <afina/Storage.h>
+
+#include "FrequencySketch.h"
+#include "HashIndex.h"
+#include "Item.h"
+#include "ItemList.h"
+#include "TimingWheel.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # LRU with TinyLFU admission
+ * New items get into a small window LRU (1% of space) first. Items pushed out of the window become
+ * candidates for the main space, which is segmented LRU: probation segment for items accessed once
+ * and protected one (80% of main space) for items accessed again.
+ *
+ * When main space is full candidate competes with the tail of probation segment, or of protected one
+ * if probation holds nothing but candidates: the one with the lower access frequency estimated by
+ * count-min sketch gets evicted. So a long scan over keys never
+ * seen before can't flush frequently used items, while the window lets new items to build some
+ * frequency before they are compared.
+ *
+ * Expired items are invisible at once, every write removes a small slice of them ordered by the
+ * timing wheel, same as SimpleLRU does.
+ *
+ * That is NOT thread safe implementaiton!!
+ */
+class WTinyLFU : public Afina::Storage {
+public:
+    WTinyLFU(size_t max_size = 1024);
+    ~WTinyLFU();
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutExpiring(const std::string &key, const std::string &value, uint32_t exptime) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsentExpiring(const std::string &key, const std::string &value, uint32_t exptime) override;
+
+    // Implements Afina::Storage interface
+    bool SetExpiring(const std::string &key, const std::string &value, uint32_t exptime) override;
+
+    // Implements Afina::Storage interface
+    bool Touch(const std::string &key, uint32_t exptime) override;
+
+    // Implements Afina::Storage interface
+    bool GetAndTouch(const std::string &key, std::string &value, uint32_t exptime) override;
+
+    // Implements Afina::Storage interface, key is looked up once
+    bool Update(const std::string &key, const Updater &updater) override;
+
+    // Implements Afina::Storage interface, version is kept in the item, value is copied as by Get
+    bool GetCas(const std::string &key, Value &value, uint64_t &cas) override;
+
+    // Implements Afina::Storage interface, key is looked up once
+    CasResult CompareAndSwap(const std::string &key, const std::string &value, uint64_t cas,
+                             uint32_t exptime) override;
+
+    // Reports admission decisions
+    void Stats(std::vector<std::pair<std::string, std::string>> &stats) override;
+
+private:
+    // Lists items could be in, stored in Item::queue
+    enum Queue : uint8_t { kWindow = 0, kProbation, kProtected, kQueues };
+
+    // Tells HashIndex how to deal with items
+    struct item_traits {
+        static bool Equal(const Item *item, const std::string &key) { return item->KeyEquals(key); }
+        static std::size_t Hash(const Item *item) { return item->hash; }
+    };
+
+    // Returns item for the key, expired one is removed and never returned
+    Item *lookup(const std::string &key, std::size_t hash);
+
+    // Removes at most limit expired items
+    void reclaim(std::size_t limit);
+
+    // Changes expiration time of the item
+    void expire(Item *item, uint32_t exptime);
+
+    // Moves item according to the access
+    void on_access(Item *item);
+
+    // Removes item from its list, index and timing wheel, and releases its memory
+    void remove(Item *item);
+
+    // Updates existing association. Key is kept whatever eviction its new value causes, as it has been
+    // admitted already
+    bool set(Item *item, const std::string &value, uint32_t exptime);
+
+    // Stores new association, returns false if item was rejected by admission policy
+    bool put(const std::string &key, const std::string &value, std::size_t hash, uint32_t exptime);
+
+    // Restores window and total limits, returns false if the watched item was evicted in process. Item to
+    // keep is never evicted, not even as a candidate
+    bool evict(const Item *watch, const Item *keep = nullptr);
+
+    // Maximum number of bytes could be stored in this cache, see SimpleLRU
+    const std::size_t _max_size;
+
+    // Maximum size of the window and protected segments
+    const std::size_t _window_max;
+    const std::size_t _protected_max;
+
+    // Number of bytes storing in the cache
+    std::size_t _curr_size = 0;
+
+    // Last version given to an item
+    uint64_t _cas = 0;
+
+    // Lists owns all items
+    ItemList _queues[kQueues];
+
+    // Index of items from all lists above
+    HashIndex<Item, item_traits> _index;
+
+    // Items having expiration time, ordered by it
+    TimingWheel _timers;
+
+    // Access frequency of recently used keys, including ones not in the cache
+    FrequencySketch _sketch;
+
+    // Number of candidates admitted into the main space and rejected
+    std::size_t _admitted = 0;
+    std::size_t _rejected = 0;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_W_TINY_LFU_H
@@ -1,4 +1,5 @@
 #include "gtest/gtest.h"
+#include <algorithm>
 #include <iostream>
 #include <set>
 #include <vector>
@@ -28,7 +29,7 @@ TEST(SimpleTest, AllocInRange) {
 static void writeTo(Pointer &p, size_t size) {
     char *v = reinterpret_cast<char *>(p.get());
 
-    for (int i = 0; i < size; i++) {
+    for (size_t i = 0; i < size; i++) {
         v[i] = i % 31;
     }
 }
@@ -36,7 +37,7 @@ static void writeTo(Pointer &p, size_t size) {
 static bool isDataOk(Pointer &p, size_t size) {
     char *v = reinterpret_cast<char *>(p.get());
 
-    for (int i = 0; i < size; i++) {
+    for (size_t i = 0; i < size; i++) {
         if (v[i] != i % 31) {
             return false;
         }
@@ -322,3 +323,120 @@ TEST(SimpleTest, ReallocGrow) {
     a.free(p);
     a.free(p2);
 }
+
+TEST(SimpleTest, DefragStep) {
+    Simple a(buf, sizeof(buf));
+
+    vector<Pointer> ptrs;
+    int size = 135;
+
+    ASSERT_TRUE(fillUp(a, size, ptrs));
+    for (int i = 1; i < 40; i += 3) {
+        a.free(ptrs[i]);
+    }
+    ptrs.erase(remove_if(ptrs.begin(), ptrs.end(), [](const Pointer &p) { return p.get() == nullptr; }), ptrs.end());
+
+    size_t available = a.available();
+    EXPECT_THROW(a.alloc(available), AllocError);
+
+    int steps = 0;
+    while (!a.defrag_step(size)) {
+        steps++;
+        for (Pointer &p : ptrs) {
+            ASSERT_TRUE(isDataOk(p, size));
+        }
+    }
+    EXPECT_LT(1, steps);
+    EXPECT_EQ(available, a.available());
+
+    Pointer p = a.alloc(available);
+    EXPECT_TRUE(isValidMemory(p, available));
+    a.free(p);
+
+    for (Pointer &p : ptrs) {
+        EXPECT_TRUE(isDataOk(p, size));
+        a.free(p);
+    }
+
+    // No blocks left, only unused space
+    string layout = a.dump();
+    EXPECT_EQ(0, layout.find("0 "));
+    EXPECT_EQ(1, count(layout.begin(), layout.end(), '\n'));
+}
+
+TEST(SimpleTest, FreeInvalid) {
+    Simple a(buf, sizeof(buf));
+
+    Pointer p = a.alloc(100);
+    Pointer copy = p;
+    a.free(p);
+    a.free(p);
+
+    try {
+        a.free(copy);
+        EXPECT_TRUE(false);
+    } catch (AllocError &e) {
+        EXPECT_EQ(e.getType(), AllocErrorType::InvalidFree);
+    }
+}
+
+TEST(SimpleTest, RandomOpsKeepData) {
+    Simple a(buf, sizeof(buf));
+
+    vector<Pointer> ptrs(64);
+    vector<size_t> sizes(64, 0);
+    srand(13);
+    for (int i = 0; i < 100000; i++) {
+        size_t k = rand() % ptrs.size();
+        size_t size = 1 + rand() % 2000;
+        try {
+            switch (rand() % 4) {
+            case 0:
+                a.free(ptrs[k]);
+                sizes[k] = 0;
+                break;
+            case 1:
+                a.defrag_step(rand() % 1000);
+                break;
+            default:
+                a.realloc(ptrs[k], size);
+                sizes[k] = size;
+                writeTo(ptrs[k], size);
+            }
+        } catch (AllocError &) {
+        }
+
+        size_t j = rand() % ptrs.size();
+        ASSERT_TRUE(sizes[j] == 0 || isDataOk(ptrs[j], sizes[j]));
+    }
+
+    for (size_t k = 0; k < ptrs.size(); k++) {
+        EXPECT_TRUE(sizes[k] == 0 || isDataOk(ptrs[k], sizes[k]));
+        a.free(ptrs[k]);
+    }
+}
+
+TEST(SimpleTest, ReallocGrowAfterDefrag) {
+    Simple a(buf, sizeof(buf));
+
+    int size = 135;
+    Pointer p1 = a.alloc(size);
+    Pointer p2 = a.alloc(size);
+    a.free(p1);
+    a.defrag();
+
+    // Top block grows in place over compacted area
+    a.realloc(p2, size * 2);
+    writeTo(p2, size * 2);
+
+    Pointer p3 = a.alloc(size);
+    Pointer p4 = a.alloc(size);
+    writeTo(p4, size);
+    a.free(p3);
+    a.defrag();
+
+    EXPECT_TRUE(isDataOk(p2, size * 2));
+    EXPECT_TRUE(isDataOk(p4, size));
+    a.free(p2);
+    a.free(p4);
+}
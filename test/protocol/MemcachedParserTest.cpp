@@ -4,9 +4,15 @@
 #include <string>
 
 #include <afina/execute/Add.h>
+#include <afina/execute/Cas.h>
 #include <afina/execute/Get.h>
+#include <afina/execute/GetAndTouch.h>
+#include <afina/execute/Gets.h>
+#include <afina/execute/Prepend.h>
+#include <afina/execute/Replace.h>
 #include <afina/execute/Set.h>
 #include <afina/execute/Stats.h>
+#include <afina/execute/Touch.h>
 
 #include <protocol/Parser.h>
 
@@ -98,3 +104,155 @@ TEST(MemcachedParserTest, Stats) {
     Execute::Stats *tmp = reinterpret_cast<Execute::Stats *>(cmd.get());
     ASSERT_FALSE(tmp == nullptr);
 }
+
+// Verify expiration time of several digits is parsed as a whole number
+TEST(MemcachedParserTest, SetExpire) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    bool cmd_avail = parser.Parse("set foo 0 3600 6\r\nfooval\r\n", consumed);
+    ASSERT_TRUE(cmd_avail);
+    ASSERT_EQ(18, consumed);
+
+    size_t value_size;
+    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    ASSERT_FALSE(cmd == nullptr);
+    ASSERT_EQ(6, value_size);
+
+    Execute::Set *tmp = reinterpret_cast<Execute::Set *>(cmd.get());
+    ASSERT_EQ(3600, tmp->expire());
+
+    parser.Reset();
+    cmd_avail = parser.Parse("add foo 0 -120 6\r\nfooval\r\n", consumed);
+    ASSERT_TRUE(cmd_avail);
+    cmd = parser.Build(value_size);
+    ASSERT_EQ(-120, reinterpret_cast<Execute::Add *>(cmd.get())->expire());
+}
+
+TEST(MemcachedParserTest, Touch) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    bool cmd_avail = parser.Parse("touch foo 300\r\n", consumed);
+    ASSERT_TRUE(cmd_avail);
+    ASSERT_EQ(15, consumed);
+    ASSERT_EQ("touch", parser.Name());
+
+    size_t value_size;
+    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    ASSERT_FALSE(cmd == nullptr);
+    ASSERT_EQ(0, value_size);
+
+    Execute::Touch *tmp = reinterpret_cast<Execute::Touch *>(cmd.get());
+    ASSERT_EQ("foo", tmp->key());
+    ASSERT_EQ(300, tmp->expire());
+}
+
+TEST(MemcachedParserTest, GetAndTouch) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    bool cmd_avail = parser.Parse("gat 42 ke key2\r\n", consumed);
+    ASSERT_TRUE(cmd_avail);
+    ASSERT_EQ(16, consumed);
+    ASSERT_EQ("gat", parser.Name());
+
+    size_t value_size;
+    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    ASSERT_FALSE(cmd == nullptr);
+    ASSERT_EQ(0, value_size);
+
+    Execute::GetAndTouch *tmp = reinterpret_cast<Execute::GetAndTouch *>(cmd.get());
+    ASSERT_EQ(42, tmp->expire());
+    std::vector<std::string> keys = tmp->keys();
+    ASSERT_EQ(2, keys.size());
+    ASSERT_EQ("ke", keys[0]);
+    ASSERT_EQ("key2", keys[1]);
+}
+
+// Verify cas command carries the unique after the number of bytes
+TEST(MemcachedParserTest, Cas) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    bool cmd_avail = parser.Parse("cas foo 3 0 6 18446744073709551615\r\nfooval\r\n", consumed);
+    ASSERT_TRUE(cmd_avail);
+    ASSERT_EQ(36, consumed);
+    ASSERT_EQ("cas", parser.Name());
+
+    size_t value_size;
+    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    ASSERT_FALSE(cmd == nullptr);
+    ASSERT_EQ(6, value_size);
+
+    Execute::Cas *tmp = reinterpret_cast<Execute::Cas *>(cmd.get());
+    ASSERT_EQ("foo", tmp->key());
+    ASSERT_EQ(3, tmp->flags());
+    ASSERT_EQ(0, tmp->expire());
+    ASSERT_EQ(UINT64_MAX, tmp->cas());
+
+    parser.Reset();
+    ASSERT_THROW(parser.Parse("cas foo 0 0 6 18446744073709551616\r\n", consumed), std::runtime_error);
+}
+
+// Verify gets command builds command returning versions
+TEST(MemcachedParserTest, Gets) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    bool cmd_avail = parser.Parse("gets ke key2\r\n", consumed);
+    ASSERT_TRUE(cmd_avail);
+    ASSERT_EQ("gets", parser.Name());
+
+    size_t value_size;
+    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    ASSERT_FALSE(cmd == nullptr);
+
+    Execute::Gets *tmp = dynamic_cast<Execute::Gets *>(cmd.get());
+    ASSERT_FALSE(tmp == nullptr);
+    std::vector<std::string> keys = tmp->keys();
+    ASSERT_EQ(2, keys.size());
+    ASSERT_EQ("ke", keys[0]);
+    ASSERT_EQ("key2", keys[1]);
+}
+
+// Verify prepend command builds command of its own
+TEST(MemcachedParserTest, Prepend) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    bool cmd_avail = parser.Parse("prepend foo 0 0 3\r\nbar\r\n", consumed);
+    ASSERT_TRUE(cmd_avail);
+    ASSERT_EQ(19, consumed);
+    ASSERT_EQ("prepend", parser.Name());
+
+    size_t value_size;
+    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    ASSERT_FALSE(cmd == nullptr);
+    ASSERT_EQ(3, value_size);
+
+    Execute::Prepend *tmp = dynamic_cast<Execute::Prepend *>(cmd.get());
+    ASSERT_FALSE(tmp == nullptr);
+    ASSERT_EQ("foo", tmp->key());
+}
+
+// Verify replace command builds command of its own
+TEST(MemcachedParserTest, Replace) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    bool cmd_avail = parser.Parse("replace foo 1 0 3\r\nbar\r\n", consumed);
+    ASSERT_TRUE(cmd_avail);
+    ASSERT_EQ(19, consumed);
+    ASSERT_EQ("replace", parser.Name());
+
+    size_t value_size;
+    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    ASSERT_FALSE(cmd == nullptr);
+    ASSERT_EQ(3, value_size);
+
+    Execute::Replace *tmp = dynamic_cast<Execute::Replace *>(cmd.get());
+    ASSERT_FALSE(tmp == nullptr);
+    ASSERT_EQ("foo", tmp->key());
+    ASSERT_EQ(1, tmp->flags());
+}
@@ -0,0 +1,231 @@
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "storage/AppendLog.h"
+#include "storage/LoggedStorage.h"
+#include "storage/SimpleLRU.h"
+#include "storage/ThreadSafeSimpleLRU.h"
+
+using namespace Afina::Backend;
+
+static std::string log_path() { return "/tmp/afina_log_test_" + std::to_string(getpid()); }
+
+static size_t file_size(const std::string &path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 ? st.st_size : 0;
+}
+
+TEST(AppendLogTest, ReplayRestoresChanges) {
+    std::string path = log_path();
+    uint32_t now = uint32_t(std::time(nullptr));
+    {
+        LoggedStorage storage(std::make_shared<SimpleLRU>(1024 * 1024), path);
+        storage.Start();
+        for (int i = 0; i < 1000; ++i) {
+            EXPECT_TRUE(storage.Put("Key " + std::to_string(i), "value " + std::to_string(i)));
+        }
+        EXPECT_TRUE(storage.Set("Key 1", "updated"));
+        EXPECT_FALSE(storage.Set("Missing", "value"));
+        EXPECT_TRUE(storage.Delete("Key 2"));
+        EXPECT_FALSE(storage.PutIfAbsent("Key 3", "value"));
+        EXPECT_TRUE(storage.PutExpiring("Expiring", "value", now + 1000));
+        EXPECT_TRUE(storage.Touch("Key 4", now - 10));
+        EXPECT_TRUE(storage.Append("Key 5", " appended"));
+        EXPECT_TRUE(storage.Prepend("Key 5", "prepended "));
+        EXPECT_FALSE(storage.Append("Missing", "value"));
+        EXPECT_TRUE(storage.Update("Key 6", [](const char *, size_t, uint64_t, std::string &value, uint32_t &) {
+            value = "updated 6";
+            return true;
+        }));
+        storage.Stop();
+    }
+
+    LoggedStorage storage(std::make_shared<SimpleLRU>(1024 * 1024), path);
+    EXPECT_EQ(1007, storage.Replay());
+    std::string value;
+    EXPECT_TRUE(storage.Get("Key 1", value));
+    EXPECT_EQ("updated", value);
+    EXPECT_FALSE(storage.Get("Key 2", value));
+    EXPECT_TRUE(storage.Get("Key 3", value));
+    EXPECT_EQ("value 3", value);
+    EXPECT_FALSE(storage.Get("Key 4", value));
+    EXPECT_TRUE(storage.Get("Expiring", value));
+    EXPECT_TRUE(storage.Get("Key 5", value));
+    EXPECT_EQ("prepended value 5 appended", value);
+    EXPECT_TRUE(storage.Get("Key 6", value));
+    EXPECT_EQ("updated 6", value);
+    EXPECT_FALSE(storage.Get("Missing", value));
+    EXPECT_TRUE(storage.Get("Key 999", value));
+    EXPECT_EQ("value 999", value);
+    std::remove(path.c_str());
+}
+
+TEST(AppendLogTest, ParallelReplay) {
+    std::string path = log_path();
+    {
+        AppendLog log(path);
+        log.Start();
+        for (int round = 0; round < 10; ++round) {
+            for (int i = 0; i < 1000; ++i) {
+                std::string key = "Key " + std::to_string(i);
+                if ((i + round) % 7 == 0) {
+                    log.Append(AppendLog::kDelete, key, "", 0);
+                } else {
+                    log.Append(AppendLog::kPut, key, std::to_string(round), 0);
+                }
+            }
+        }
+        log.Stop();
+    }
+
+    // Every key gets the value of its last change, whatever the thread replaying it
+    ThreadSafeSimplLRU storage(1024 * 1024);
+    AppendLog log(path);
+    EXPECT_EQ(10000, log.Replay(storage, 4));
+    std::string value;
+    for (int i = 0; i < 1000; ++i) {
+        std::string key = "Key " + std::to_string(i);
+        if ((i + 9) % 7 == 0) {
+            EXPECT_FALSE(storage.Get(key, value));
+        } else {
+            EXPECT_TRUE(storage.Get(key, value));
+            EXPECT_EQ("9", value);
+        }
+    }
+    std::remove(path.c_str());
+}
+
+TEST(AppendLogTest, TornTail) {
+    std::string path = log_path();
+    {
+        LoggedStorage storage(std::make_shared<SimpleLRU>(), path);
+        storage.Start();
+        EXPECT_TRUE(storage.Put("Key 1", "value 1"));
+        storage.Stop();
+    }
+    size_t size = file_size(path);
+    {
+        // Block header promising more bytes than there are, as if crash happened during write
+        std::ofstream out(path, std::ios::binary | std::ios::app);
+        out << std::string("\x10\x00\x00\x00\x01\x00\x00\x00", 8) << "garbage";
+    }
+
+    {
+        LoggedStorage storage(std::make_shared<SimpleLRU>(), path);
+        EXPECT_EQ(1, storage.Replay());
+        EXPECT_EQ(size, file_size(path));
+
+        // Changes made after the recovery are appended to the intact part
+        storage.Start();
+        EXPECT_TRUE(storage.Put("Key 2", "value 2"));
+        storage.Stop();
+    }
+
+    SimpleLRU storage;
+    AppendLog log(path);
+    EXPECT_EQ(2, log.Replay(storage));
+    std::string value;
+    EXPECT_TRUE(storage.Get("Key 1", value));
+    EXPECT_TRUE(storage.Get("Key 2", value));
+    std::remove(path.c_str());
+}
+
+TEST(AppendLogTest, Corrupted) {
+    std::string path = log_path();
+    {
+        LoggedStorage storage(std::make_shared<SimpleLRU>(), path, false, std::chrono::milliseconds(1));
+        storage.Start();
+        EXPECT_TRUE(storage.Put("Key 1", "value 1"));
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        EXPECT_TRUE(storage.Put("Key 2", "value 2"));
+        storage.Stop();
+    }
+
+    // Broken block and everything after it is dropped
+    {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(-1, std::ios::end);
+        file.put('X');
+    }
+    SimpleLRU storage;
+    AppendLog log(path);
+    EXPECT_EQ(1, log.Replay(storage));
+    std::string value;
+    EXPECT_TRUE(storage.Get("Key 1", value));
+    EXPECT_FALSE(storage.Get("Key 2", value));
+
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out << "not a log at all";
+    }
+    EXPECT_THROW(log.Replay(storage), std::runtime_error);
+    std::remove(path.c_str());
+}
+
+TEST(AppendLogTest, SyncWaitsForWrite) {
+    std::string path = log_path();
+
+    // Interval is too long to finish the test, so change is written because it is waited for
+    LoggedStorage storage(std::make_shared<SimpleLRU>(), path, true, std::chrono::milliseconds(3600 * 1000));
+    storage.Start();
+    size_t size = file_size(path);
+    EXPECT_TRUE(storage.Put("Key", "value"));
+    EXPECT_LT(size, file_size(path));
+    storage.Stop();
+    std::remove(path.c_str());
+}
+
+TEST(AppendLogTest, Rewrite) {
+    std::string path = log_path();
+    {
+        LoggedStorage storage(std::make_shared<SimpleLRU>(1024 * 1024), path);
+        storage.Start();
+        for (int i = 0; i < 1000; ++i) {
+            EXPECT_TRUE(storage.Put("Key " + std::to_string(i % 10), std::string(100, 'a' + i % 26)));
+        }
+        storage.Stop();
+    }
+    size_t size = file_size(path);
+
+    {
+        LoggedStorage storage(std::make_shared<SimpleLRU>(1024 * 1024), path);
+        EXPECT_EQ(1000, storage.Replay());
+        storage.Start();
+        EXPECT_TRUE(storage.Rewrite());
+
+        // Changes made while child writes the dataset get into the new log too
+        EXPECT_TRUE(storage.Put("Key 0", "new value"));
+        EXPECT_TRUE(storage.Delete("Key 1"));
+        storage.Stop();
+
+        std::vector<std::pair<std::string, std::string>> stats;
+        storage.Stats(stats);
+        EXPECT_NE(stats.end(), std::find(stats.begin(), stats.end(), std::make_pair(std::string("log_rewrites"),
+                                                                                     std::string("1"))));
+    }
+    EXPECT_GT(size / 10, file_size(path));
+
+    SimpleLRU storage(1024 * 1024);
+    AppendLog log(path);
+    EXPECT_EQ(12, log.Replay(storage));
+    std::string value;
+    EXPECT_TRUE(storage.Get("Key 0", value));
+    EXPECT_EQ("new value", value);
+    EXPECT_FALSE(storage.Get("Key 1", value));
+    EXPECT_TRUE(storage.Get("Key 9", value));
+    EXPECT_EQ(std::string(100, 'a' + 999 % 26), value);
+    std::remove(path.c_str());
+}
@@ -0,0 +1,82 @@
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "storage/AsyncStorage.h"
+#include "storage/SimpleLRU.h"
+#include "storage/ThreadSafeSimpleLRU.h"
+
+using namespace Afina::Backend;
+
+TEST(AsyncStorageTest, DefaultRunsInline) {
+    SimpleLRU storage;
+    bool done = false;
+    storage.Async([](Afina::Storage &storage) { EXPECT_TRUE(storage.Put("Key", "value")); },
+                  [&done]() { done = true; });
+    EXPECT_TRUE(done);
+
+    std::string value;
+    EXPECT_TRUE(storage.Get("Key", value));
+    EXPECT_EQ("value", value);
+}
+
+TEST(AsyncStorageTest, RunsOnOtherThreads) {
+    AsyncStorage storage(std::make_shared<ThreadSafeSimplLRU>(64 * 1024), 2);
+    storage.Start();
+
+    // Operations get blocked until the caller lets them go, so caller can't be running them
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool released = false;
+    int done = 0;
+    std::thread::id caller = std::this_thread::get_id();
+    for (int i = 0; i < 10; ++i) {
+        std::string key = "Key " + std::to_string(i);
+        storage.Async(
+            [&, key](Afina::Storage &storage) {
+                EXPECT_NE(caller, std::this_thread::get_id());
+                std::unique_lock<std::mutex> lock(mutex);
+                condition.wait(lock, [&]() { return released; });
+                EXPECT_TRUE(storage.Put(key, "value"));
+            },
+            [&]() {
+                std::lock_guard<std::mutex> lock(mutex);
+                done++;
+                condition.notify_all();
+            });
+    }
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        EXPECT_EQ(0, done);
+        released = true;
+        condition.notify_all();
+        condition.wait(lock, [&]() { return done == 10; });
+    }
+
+    std::string value;
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_TRUE(storage.Get("Key " + std::to_string(i), value));
+    }
+    storage.Stop();
+}
+
+TEST(AsyncStorageTest, FullQueueRunsInline) {
+    AsyncStorage storage(std::make_shared<ThreadSafeSimplLRU>(), 1, 1);
+
+    // Pool isn't started, so nothing gets queued
+    bool done = false;
+    storage.Async([](Afina::Storage &storage) { EXPECT_TRUE(storage.Put("Key", "value")); },
+                  [&done]() { done = true; });
+    EXPECT_TRUE(done);
+
+    std::vector<std::pair<std::string, std::string>> stats;
+    storage.Stats(stats);
+    EXPECT_NE(stats.end(), std::find(stats.begin(), stats.end(),
+                                     std::make_pair(std::string("async_inline"), std::string("1"))));
+}
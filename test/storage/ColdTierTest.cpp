@@ -0,0 +1,110 @@
+#include "gtest/gtest.h"
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+#include "storage/ColdTier.h"
+#include "storage/SimpleLRU.h"
+#include "storage/Snapshot.h"
+
+using namespace Afina::Backend;
+
+static std::string cold_path() { return "/tmp/afina_cold_test_" + std::to_string(getpid()); }
+
+static std::string stat_value(Afina::Storage &storage, const std::string &name) {
+    std::vector<std::pair<std::string, std::string>> stats;
+    storage.Stats(stats);
+    for (auto &stat : stats) {
+        if (stat.first == name) {
+            return stat.second;
+        }
+    }
+    return "";
+}
+
+static std::string value_of(int i) { return std::string(50 + i % 50, 'a' + i % 26); }
+
+TEST(ColdTierTest, EvictedItemsComeBack) {
+    // Memory holds about 20 items, the rest of them live in the cold tier
+    SimpleLRU storage(20 * Item::Footprint(8, 100), std::unique_ptr<ColdTier>(new ColdTier(cold_path(), 1 << 20)));
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_TRUE(storage.Put("Key " + std::to_string(i), value_of(i)));
+    }
+    EXPECT_NE("0", stat_value(storage, "cold_writes"));
+
+    std::string value;
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_TRUE(storage.Get("Key " + std::to_string(i), value));
+        EXPECT_EQ(value_of(i), value);
+    }
+    // Promoted items push the hot ones out, so every read comes from the cold tier
+    EXPECT_EQ("1000", stat_value(storage, "cold_hits"));
+    EXPECT_FALSE(storage.Get("Missing", value));
+}
+
+TEST(ColdTierTest, ChangesOfColdKeys) {
+    SimpleLRU storage(5 * Item::Footprint(5, 10), std::unique_ptr<ColdTier>(new ColdTier(cold_path(), 1 << 20)));
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_TRUE(storage.Put("Key " + std::to_string(i), "old value"));
+    }
+
+    // First keys are cold now
+    std::string value;
+    EXPECT_TRUE(storage.Delete("Key 0"));
+    EXPECT_FALSE(storage.Delete("Key 0"));
+    EXPECT_FALSE(storage.Get("Key 0", value));
+
+    EXPECT_FALSE(storage.PutIfAbsent("Key 1", "new value"));
+    EXPECT_TRUE(storage.Set("Key 2", "new value"));
+    EXPECT_TRUE(storage.Put("Key 3", "new value"));
+
+    // Overwritten keys get cold again, old copies must not come back
+    for (int i = 10; i < 20; ++i) {
+        EXPECT_TRUE(storage.Put("Key " + std::to_string(i), "filler"));
+    }
+    EXPECT_TRUE(storage.Get("Key 1", value));
+    EXPECT_EQ("old value", value);
+    EXPECT_TRUE(storage.Get("Key 2", value));
+    EXPECT_EQ("new value", value);
+    EXPECT_TRUE(storage.Get("Key 3", value));
+    EXPECT_EQ("new value", value);
+    EXPECT_FALSE(storage.Get("Key 0", value));
+}
+
+TEST(ColdTierTest, SegmentsWrapAround) {
+    // Cold tier of two 4KB segments, items of the overwritten segment are lost
+    SimpleLRU storage(Item::Footprint(8, 100), std::unique_ptr<ColdTier>(new ColdTier(cold_path(), 8 * 1024)));
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_TRUE(storage.Put("Key " + std::to_string(i), value_of(i)));
+    }
+    EXPECT_NE("0", stat_value(storage, "cold_dropped"));
+
+    std::string value;
+    EXPECT_FALSE(storage.Get("Key 0", value));
+    for (int i = 990; i < 1000; ++i) {
+        EXPECT_TRUE(storage.Get("Key " + std::to_string(i), value));
+        EXPECT_EQ(value_of(i), value);
+    }
+}
+
+TEST(ColdTierTest, Snapshot) {
+    std::string path = cold_path() + ".snapshot";
+    SimpleLRU source(20 * Item::Footprint(8, 100), std::unique_ptr<ColdTier>(new ColdTier(cold_path(), 1 << 20)));
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_TRUE(source.Put("Key " + std::to_string(i), value_of(i)));
+    }
+    WriteSnapshot(source, path);
+
+    // Cold items go first, so hot ones stay in memory once snapshot is loaded back
+    SimpleLRU target(20 * Item::Footprint(8, 100));
+    EXPECT_EQ(100, LoadSnapshot(target, path));
+    std::string value;
+    EXPECT_TRUE(target.Get("Key 99", value));
+    EXPECT_EQ(value_of(99), value);
+    EXPECT_FALSE(target.Get("Key 0", value));
+    std::remove(path.c_str());
+}
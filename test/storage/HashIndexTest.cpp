@@ -0,0 +1,107 @@
+#include "gtest/gtest.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "storage/HashIndex.h"
+
+using namespace Afina::Backend;
+
+struct Item {
+    std::string key;
+    std::size_t hash;
+};
+
+struct ItemTraits {
+    static bool Equal(const Item *item, const std::string &key) { return item->key == key; }
+    static std::size_t Hash(const Item *item) { return item->hash; }
+};
+
+using Index = HashIndex<Item, ItemTraits>;
+
+static std::vector<std::unique_ptr<Item>> make_items(size_t n) {
+    std::vector<std::unique_ptr<Item>> items;
+    for (size_t i = 0; i < n; i++) {
+        std::string key = "key" + std::to_string(i);
+        items.emplace_back(new Item{key, Index::Hash(key)});
+    }
+    return items;
+}
+
+TEST(HashIndexTest, InsertFind) {
+    Index index;
+    auto items = make_items(10000);
+    for (auto &item : items) {
+        EXPECT_EQ(nullptr, index.Find(item->key, item->hash));
+        index.Insert(item.get(), item->hash);
+    }
+    EXPECT_EQ(items.size(), index.Size());
+
+    for (auto &item : items) {
+        EXPECT_EQ(item.get(), index.Find(item->key, item->hash));
+    }
+    EXPECT_EQ(nullptr, index.Find("absent", Index::Hash("absent")));
+}
+
+TEST(HashIndexTest, EraseReinsert) {
+    Index index;
+    auto items = make_items(10000);
+    for (auto &item : items) {
+        index.Insert(item.get(), item->hash);
+    }
+
+    for (size_t i = 0; i < items.size(); i += 2) {
+        EXPECT_TRUE(index.Erase(items[i].get(), items[i]->hash));
+        EXPECT_FALSE(index.Erase(items[i].get(), items[i]->hash));
+    }
+    for (size_t i = 0; i < items.size(); i++) {
+        Item *expected = (i % 2 == 0) ? nullptr : items[i].get();
+        EXPECT_EQ(expected, index.Find(items[i]->key, items[i]->hash));
+    }
+
+    // Churn must not grow table by tombstones
+    size_t capacity = index.Capacity();
+    for (int round = 0; round < 10; round++) {
+        for (size_t i = 0; i < items.size(); i += 2) {
+            index.Insert(items[i].get(), items[i]->hash);
+        }
+        for (size_t i = 0; i < items.size(); i += 2) {
+            EXPECT_TRUE(index.Erase(items[i].get(), items[i]->hash));
+        }
+    }
+    EXPECT_EQ(capacity, index.Capacity());
+    EXPECT_EQ(items.size() / 2, index.Size());
+}
+
+TEST(HashIndexTest, IncrementalRehash) {
+    Index index;
+    auto items = make_items(100000);
+    bool rehashing = false;
+    for (size_t i = 0; i < items.size(); i++) {
+        index.Insert(items[i].get(), items[i]->hash);
+        rehashing = rehashing || index.Rehashing();
+
+        // Items are spread over both tables, erase some of them while they are being moved
+        if (index.Rehashing() && i % 3 == 0) {
+            ASSERT_TRUE(index.Erase(items[i - 1].get(), items[i - 1]->hash));
+            index.Insert(items[i - 1].get(), items[i - 1]->hash);
+        }
+        if (i % 997 == 0) {
+            for (size_t j = 0; j <= i; j++) {
+                ASSERT_EQ(items[j].get(), index.Find(items[j]->key, items[j]->hash));
+            }
+        }
+    }
+    EXPECT_TRUE(rehashing);
+    EXPECT_EQ(items.size(), index.Size());
+
+    // Lookups don't move items, a few updates finish the growth
+    for (size_t i = 0; index.Rehashing(); i++) {
+        ASSERT_TRUE(index.Erase(items[i].get(), items[i]->hash));
+        index.Insert(items[i].get(), items[i]->hash);
+    }
+    for (auto &item : items) {
+        EXPECT_EQ(item.get(), index.Find(item->key, item->hash));
+    }
+    EXPECT_EQ(items.size(), index.Size());
+}
@@ -0,0 +1,99 @@
+#include "gtest/gtest.h"
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <afina/concurrency/ThreadLocal.h>
+
+#include "storage/NearCache.h"
+#include "storage/ThreadSafeSimpleLRU.h"
+
+using namespace Afina::Backend;
+
+static std::map<std::string, std::string> stats_of(Afina::Storage &storage) {
+    std::vector<std::pair<std::string, std::string>> stats;
+    storage.Stats(stats);
+    return std::map<std::string, std::string>(stats.begin(), stats.end());
+}
+
+TEST(ThreadLocalTest, InstancePerThread) {
+    Afina::Concurrency::ThreadLocal<int> local;
+    local.Get() = 1;
+
+    std::thread other([&local]() {
+        EXPECT_EQ(0, local.Get());
+        local.Get() = 2;
+
+        std::set<int> seen;
+        local.ForEach([&seen](int &value) { seen.insert(value); });
+        EXPECT_EQ(std::set<int>({1, 2}), seen);
+    });
+    other.join();
+
+    // Instance of the thread is gone once it exits
+    int count = 0;
+    local.ForEach([&count](int &value) { count++; });
+    EXPECT_EQ(1, count);
+    EXPECT_EQ(1, local.Get());
+}
+
+TEST(NearCacheTest, HotKeyIsCached) {
+    auto wrapped = std::make_shared<ThreadSafeSimplLRU>(64 * 1024);
+    NearCache storage(wrapped, 16, 4);
+    EXPECT_TRUE(storage.Put("flag", "on"));
+
+    std::string value;
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_TRUE(storage.Get("flag", value));
+        EXPECT_EQ("on", value);
+    }
+    EXPECT_EQ("6", stats_of(storage)["near_cache_hits"]);
+
+    // Change made behind the cache isn't seen until it expires
+    EXPECT_TRUE(wrapped->Put("flag", "off"));
+    EXPECT_TRUE(storage.Get("flag", value));
+    EXPECT_EQ("on", value);
+
+    Afina::Value handle;
+    EXPECT_TRUE(storage.GetValue("flag", handle));
+    EXPECT_EQ("on", std::string(handle.data(), handle.size()));
+}
+
+TEST(NearCacheTest, WriteInvalidates) {
+    NearCache storage(std::make_shared<ThreadSafeSimplLRU>(64 * 1024), 16, 1);
+    EXPECT_TRUE(storage.Put("flag", "on"));
+
+    std::string value;
+    EXPECT_TRUE(storage.Get("flag", value));
+    EXPECT_TRUE(storage.Get("flag", value));
+
+    // Change made by another thread is seen by the cache of this one
+    std::thread writer([&storage]() { EXPECT_TRUE(storage.Put("flag", "off")); });
+    writer.join();
+    EXPECT_TRUE(storage.Get("flag", value));
+    EXPECT_EQ("off", value);
+
+    EXPECT_TRUE(storage.Delete("flag"));
+    EXPECT_FALSE(storage.Get("flag", value));
+}
+
+TEST(NearCacheTest, MultiGetMixesCachedAndMissing) {
+    NearCache storage(std::make_shared<ThreadSafeSimplLRU>(64 * 1024), 16, 1);
+    EXPECT_TRUE(storage.Put("hot", "1"));
+    EXPECT_TRUE(storage.Put("cold", "2"));
+
+    std::string value;
+    EXPECT_TRUE(storage.Get("hot", value));
+
+    std::vector<Afina::Value> values;
+    EXPECT_EQ(2, storage.MultiGet({"hot", "missing", "cold"}, values));
+    ASSERT_EQ(3, values.size());
+    EXPECT_EQ("1", std::string(values[0].data(), values[0].size()));
+    EXPECT_FALSE(values[1]);
+    EXPECT_EQ("2", std::string(values[2].data(), values[2].size()));
+    EXPECT_EQ("1", stats_of(storage)["near_cache_hits"]);
+}
@@ -0,0 +1,162 @@
+#include "gtest/gtest.h"
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "storage/PartitionedLRU.h"
+#include "storage/ShardedLRU.h"
+#include "storage/SimpleLRU.h"
+#include "storage/Snapshot.h"
+#include "storage/ThreadSafeSimpleLRU.h"
+#include "storage/WTinyLFU.h"
+
+using namespace Afina::Backend;
+
+static std::string snapshot_path() { return "/tmp/afina_snapshot_test_" + std::to_string(getpid()); }
+
+TEST(SnapshotTest, Crc32c) {
+    EXPECT_EQ(0u, Crc32c("", 0));
+    EXPECT_EQ(0xE3069283u, Crc32c("123456789", 9));
+
+    // Continuation gives the same result as a single pass, whatever the split
+    std::string data(1000, 'x');
+    for (size_t i = 0; i < data.size(); i += 37) {
+        EXPECT_EQ(Crc32c(data.data(), data.size()), Crc32c(data.data() + i, data.size() - i, Crc32c(data.data(), i)));
+    }
+}
+
+TEST(SnapshotTest, RoundTrip) {
+    std::string path = snapshot_path();
+    uint32_t now = uint32_t(std::time(nullptr));
+
+    SimpleLRU source(1024 * 1024);
+    for (int i = 0; i < 5000; ++i) {
+        std::string key = "Key " + std::to_string(i);
+        EXPECT_TRUE(source.Put(key, std::string(i % 100, 'a' + i % 26)));
+    }
+    EXPECT_TRUE(source.PutExpiring("Expiring", "value", now + 1000));
+    EXPECT_TRUE(source.PutExpiring("Expired", "value", now - 10));
+    WriteSnapshot(source, path);
+
+    SimpleLRU target(1024 * 1024);
+    EXPECT_EQ(5001, LoadSnapshot(target, path, 4));
+    std::string value;
+    for (int i = 0; i < 5000; ++i) {
+        EXPECT_TRUE(target.Get("Key " + std::to_string(i), value));
+        EXPECT_EQ(std::string(i % 100, 'a' + i % 26), value);
+    }
+    EXPECT_TRUE(target.Get("Expiring", value));
+    EXPECT_FALSE(target.Get("Expired", value));
+    std::remove(path.c_str());
+}
+
+TEST(SnapshotTest, KeepsLRUOrder) {
+    std::string path = snapshot_path();
+
+    SimpleLRU source(64 * 1024);
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_TRUE(source.Put("Key " + std::to_string(i), "value"));
+    }
+    std::string value;
+    EXPECT_TRUE(source.Get("Key 0", value));
+    WriteSnapshot(source, path);
+
+    // Smaller storage keeps the most recently used items only
+    SimpleLRU target(10 * Item::Footprint(6, 5));
+    LoadSnapshot(target, path);
+    EXPECT_TRUE(target.Get("Key 0", value));
+    EXPECT_TRUE(target.Get("Key 99", value));
+    EXPECT_FALSE(target.Get("Key 1", value));
+    std::remove(path.c_str());
+}
+
+TEST(SnapshotTest, Corrupted) {
+    std::string path = snapshot_path();
+
+    ThreadSafeSimplLRU source(1024 * 1024);
+    for (int i = 0; i < 10000; ++i) {
+        EXPECT_TRUE(source.Put("Key " + std::to_string(i), std::string(50, 'x')));
+    }
+    WriteSnapshot(source, path);
+
+    std::string data;
+    {
+        std::ifstream in(path, std::ios::binary);
+        data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    // Flipped bit in the middle of some block
+    std::string broken = data;
+    broken[broken.size() / 2] ^= 1;
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << broken;
+    ThreadSafeSimplLRU target(1024 * 1024);
+    EXPECT_THROW(LoadSnapshot(target, path, 4), std::runtime_error);
+
+    // Truncated file
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << data.substr(0, data.size() - 5);
+    EXPECT_THROW(LoadSnapshot(target, path, 4), std::runtime_error);
+
+    std::string value;
+    EXPECT_FALSE(target.Get("Key 0", value));
+    std::remove(path.c_str());
+}
+
+TEST(SnapshotTest, Fork) {
+    std::string path = snapshot_path();
+
+    ShardedLRU source(1024 * 1024, 4);
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_TRUE(source.Put("Key " + std::to_string(i), "value " + std::to_string(i)));
+    }
+    pid_t pid = ForkSnapshot(source, path);
+
+    // Changes made after the fork don't get into snapshot
+    EXPECT_TRUE(source.Put("Key 0", "changed"));
+    int status = -1;
+    ASSERT_EQ(pid, waitpid(pid, &status, 0));
+    EXPECT_TRUE(WIFEXITED(status));
+    EXPECT_EQ(0, WEXITSTATUS(status));
+
+    ShardedLRU target(1024 * 1024, 2);
+    EXPECT_EQ(1000, LoadSnapshot(target, path, 2));
+    std::string value;
+    EXPECT_TRUE(target.Get("Key 0", value));
+    EXPECT_EQ("value 0", value);
+    std::remove(path.c_str());
+}
+
+TEST(SnapshotTest, ForkPartitioned) {
+    std::string path = snapshot_path();
+
+    // Owner threads aren't there in the child, it reads partitions itself
+    PartitionedLRU source(1024 * 1024, 4);
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_TRUE(source.Put("Key " + std::to_string(i), "value " + std::to_string(i)));
+    }
+    pid_t pid = ForkSnapshot(source, path);
+    EXPECT_TRUE(source.Put("Key 0", "changed"));
+    int status = -1;
+    ASSERT_EQ(pid, waitpid(pid, &status, 0));
+    EXPECT_TRUE(WIFEXITED(status));
+    EXPECT_EQ(0, WEXITSTATUS(status));
+
+    PartitionedLRU target(1024 * 1024, 2);
+    EXPECT_EQ(1000, LoadSnapshot(target, path, 2));
+    std::string value;
+    EXPECT_TRUE(target.Get("Key 0", value));
+    EXPECT_EQ("value 0", value);
+    std::remove(path.c_str());
+}
+
+TEST(SnapshotTest, NotSupported) {
+    std::string path = snapshot_path();
+    WTinyLFU storage(1024);
+    EXPECT_THROW(WriteSnapshot(storage, path), std::runtime_error);
+    EXPECT_THROW(LoadSnapshot(storage, path), std::runtime_error);
+}
@@ -0,0 +1,106 @@
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <afina/Storage.h>
+
+#include "storage/ClockLRU.h"
+#include "storage/CombiningLRU.h"
+#include "storage/CuckooStorage.h"
+#include "storage/ShardedLRU.h"
+#include "storage/ThreadSafeBufferedLRU.h"
+#include "storage/ThreadSafeSimpleLRU.h"
+
+using namespace Afina::Backend;
+
+// Number of distinct keys used by benchmark
+const size_t n_keys = 100000;
+
+// Number of operations each thread performs
+const size_t n_ops = 1000000;
+
+// Percent of Get operations in the workload, the rest are Put
+const unsigned read_percent = 95;
+
+static std::string make_key(size_t i) { return "key_" + std::to_string(i); }
+
+/**
+ * Runs mixed Get/Put workload over the storage in the given number of threads and returns
+ * overall throughput in operations per second
+ */
+static double run(Afina::Storage &storage, size_t n_threads) {
+    std::vector<std::string> keys;
+    keys.reserve(n_keys);
+    for (size_t i = 0; i < n_keys; i++) {
+        keys.push_back(make_key(i));
+        storage.Put(keys.back(), "value");
+    }
+
+    std::atomic<bool> start(false);
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < n_threads; t++) {
+        workers.emplace_back([&storage, &keys, &start, t]() {
+            std::minstd_rand rnd(t + 1);
+            std::string value;
+            while (!start.load()) {
+                std::this_thread::yield();
+            }
+            for (size_t i = 0; i < n_ops; i++) {
+                const std::string &key = keys[rnd() % keys.size()];
+                if (rnd() % 100 < read_percent) {
+                    storage.Get(key, value);
+                } else {
+                    storage.Put(key, "other value");
+                }
+            }
+        });
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    start.store(true);
+    for (auto &w : workers) {
+        w.join();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+    return n_threads * n_ops / elapsed.count();
+}
+
+static void bench(const std::string &name, std::function<std::unique_ptr<Afina::Storage>()> factory,
+                  const std::vector<size_t> &threads) {
+    for (size_t n : threads) {
+        std::unique_ptr<Afina::Storage> storage = factory();
+        double ops = run(*storage, n);
+        std::cout << std::setw(16) << std::left << name << std::setw(8) << std::right << n << " threads "
+                  << std::setw(14) << std::fixed << std::setprecision(0) << ops << " ops/sec" << std::endl;
+    }
+}
+
+int main(int argc, char **argv) {
+    const size_t max_size = 64 * 1024 * 1024;
+    const size_t hw = std::max(1u, std::thread::hardware_concurrency());
+
+    // Contention is what combining is about, so thread count goes well above the number of cores
+    std::vector<size_t> threads;
+    for (size_t n = 1; n <= std::max<size_t>(64, 2 * hw); n *= 2) {
+        threads.push_back(n);
+    }
+
+    bench("mt_lru", [=]() { return std::unique_ptr<Afina::Storage>(new ThreadSafeSimplLRU(max_size)); }, threads);
+    bench("combining_lru", [=]() { return std::unique_ptr<Afina::Storage>(new CombiningLRU(max_size)); },
+          threads);
+    bench("sharded_lru", [=]() { return std::unique_ptr<Afina::Storage>(new ShardedLRU(max_size, 4 * hw)); },
+          threads);
+    bench("buffered_lru", [=]() { return std::unique_ptr<Afina::Storage>(new ThreadSafeBufferedLRU(max_size)); },
+          threads);
+    bench("clock_lru", [=]() { return std::unique_ptr<Afina::Storage>(new ClockLRU(max_size)); }, threads);
+    bench("cuckoo_hash", [=]() { return std::unique_ptr<Afina::Storage>(new CuckooStorage(max_size)); },
+          threads);
+    return 0;
+}
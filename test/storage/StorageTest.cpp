@@ -1,23 +1,71 @@
 #include "gtest/gtest.h"
+#include <cstdlib>
 #include <iomanip>
 #include <iostream>
+#include <list>
+#include <map>
 #include <set>
 #include <vector>
 
+#include <malloc.h>
+
 #include <afina/execute/Add.h>
 #include <afina/execute/Append.h>
 #include <afina/execute/Delete.h>
 #include <afina/execute/Get.h>
 #include <afina/execute/Set.h>
 
+#include <atomic>
+#include <thread>
+
+#include "storage/ArenaLRU.h"
+#include "storage/ClockLRU.h"
+#include "storage/CombiningLRU.h"
+#include "storage/CuckooStorage.h"
+#include "storage/Item.h"
+#include "storage/PartitionedLRU.h"
+#include "storage/PolicyStorage.h"
+#include "storage/ShardedLRU.h"
 #include "storage/SimpleLRU.h"
+#include "storage/SlabLRU.h"
+#include "storage/ThreadSafe.h"
+#include "storage/ThreadSafeBufferedLRU.h"
+#include "storage/ThreadSafeSimpleLRU.h"
+#include "storage/TimingWheel.h"
+#include "storage/WTinyLFU.h"
 
 using namespace Afina::Backend;
 using namespace Afina::Execute;
 using namespace std;
 
-TEST(StorageTest, PutGet) {
-    SimpleLRU storage;
+// Semantic tests are run against every storage implementation. Sharded ones split budget between
+// shards, so it has to be big enough for every shard to hold all items of a test
+const size_t storage_size = 64 * 1024;
+
+// Budget for the given number of items of the given sizes. Allocator could round some items up more than
+// expected, so room is left for that, still not enough for one more item
+static size_t budget(size_t items, size_t key_size, size_t value_size) {
+    return items * Item::Footprint(key_size, value_size) + Item::Footprint(key_size, value_size) / 2;
+}
+
+// Room for every item of the given sizes however malloc rounds it: chunk reused from the free list could be
+// up to one alignment step larger than requested, as the rest is too small to split
+static size_t room(size_t items, size_t key_size, size_t value_size) {
+    const size_t chunk_align = 16;
+    return items * (Item::Footprint(key_size, value_size) + chunk_align);
+}
+
+template <typename T> class StorageTest : public ::testing::Test {};
+
+typedef ::testing::Types<SimpleLRU, ThreadSafeSimplLRU, ShardedLRU, ThreadSafeBufferedLRU, ClockLRU, WTinyLFU,
+                         ThreadSafe<WTinyLFU>, PolicyStorage<LRUPolicy>, PolicyStorage<SLRUPolicy>,
+                         PolicyStorage<TwoQPolicy>, PolicyStorage<ARCPolicy>, ThreadSafeBasicLRU<ARCPolicy>, SlabLRU,
+                         ArenaLRU, PartitionedLRU, CombiningLRU, CuckooStorage>
+    StorageTypes;
+TYPED_TEST_CASE(StorageTest, StorageTypes);
+
+TYPED_TEST(StorageTest, PutGet) {
+    TypeParam storage(storage_size);
 
     EXPECT_TRUE(storage.Put("KEY1", "val1"));
     EXPECT_TRUE(storage.Put("KEY2", "val2"));
@@ -30,8 +78,8 @@ TEST(StorageTest, PutGet) {
     EXPECT_TRUE(value == "val2");
 }
 
-TEST(StorageTest, PutOverwrite) {
-    SimpleLRU storage;
+TYPED_TEST(StorageTest, PutOverwrite) {
+    TypeParam storage(storage_size);
 
     EXPECT_TRUE(storage.Put("KEY1", "val1"));
     EXPECT_TRUE(storage.Put("KEY1", "val2"));
@@ -41,8 +89,8 @@ TEST(StorageTest, PutOverwrite) {
     EXPECT_TRUE(value == "val2");
 }
 
-TEST(StorageTest, PutIfAbsent) {
-    SimpleLRU storage;
+TYPED_TEST(StorageTest, PutIfAbsent) {
+    TypeParam storage(storage_size);
 
     EXPECT_TRUE(storage.PutIfAbsent("KEY1", "val1"));
 
@@ -53,8 +101,8 @@ TEST(StorageTest, PutIfAbsent) {
     EXPECT_TRUE(value == "val1");
 }
 
-TEST(StorageTest, PutSetGet) {
-    SimpleLRU storage;
+TYPED_TEST(StorageTest, PutSetGet) {
+    TypeParam storage(storage_size);
 
     EXPECT_TRUE(storage.Put("KEY1", "val1"));
     EXPECT_TRUE(storage.Set("KEY1", "val2"));
@@ -66,8 +114,8 @@ TEST(StorageTest, PutSetGet) {
     EXPECT_TRUE(value == "val2");
 }
 
-TEST(StorageTest, SetIfAbsent) {
-    SimpleLRU storage;
+TYPED_TEST(StorageTest, SetIfAbsent) {
+    TypeParam storage(storage_size);
 
     EXPECT_TRUE(storage.Put("KEY1", "val1"));
 
@@ -77,8 +125,8 @@ TEST(StorageTest, SetIfAbsent) {
     EXPECT_TRUE(value == "val1");
 }
 
-TEST(StorageTest, PutDeleteGet) {
-    SimpleLRU storage;
+TYPED_TEST(StorageTest, PutDeleteGet) {
+    TypeParam storage(storage_size);
 
     EXPECT_TRUE(storage.Put("KEY1", "val1"));
     EXPECT_TRUE(storage.Put("KEY2", "val2"));
@@ -91,8 +139,8 @@ TEST(StorageTest, PutDeleteGet) {
     EXPECT_TRUE(value == "val2");
 }
 
-TEST(StorageTest, GetIfAbsent) {
-    SimpleLRU storage;
+TYPED_TEST(StorageTest, GetIfAbsent) {
+    TypeParam storage(storage_size);
 
     std::string value;
     EXPECT_FALSE(storage.Get("KEY1", value));
@@ -102,8 +150,8 @@ TEST(StorageTest, GetIfAbsent) {
     EXPECT_FALSE(storage.Get("KEY3", value));
 }
 
-TEST(StorageTest, DeleteIfAbsent) {
-    SimpleLRU storage;
+TYPED_TEST(StorageTest, DeleteIfAbsent) {
+    TypeParam storage(storage_size);
     EXPECT_FALSE(storage.Delete("KEY1"));
 
     EXPECT_FALSE(storage.Delete("KEY2"));
@@ -111,8 +159,8 @@ TEST(StorageTest, DeleteIfAbsent) {
     EXPECT_FALSE(storage.Delete("KEY3"));
 }
 
-TEST(StorageTest, DeleteHeadAndTailNode) {
-    SimpleLRU storage;
+TYPED_TEST(StorageTest, DeleteHeadAndTailNode) {
+    TypeParam storage(storage_size);
 
     EXPECT_TRUE(storage.Put("KEY1", "val1"));
     EXPECT_TRUE(storage.Put("KEY2", "val2"));
@@ -130,6 +178,177 @@ TEST(StorageTest, DeleteHeadAndTailNode) {
     EXPECT_TRUE(storage.Delete("KEY1"));
 }
 
+TYPED_TEST(StorageTest, DeleteOnlyNode) {
+    TypeParam storage(storage_size);
+
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_TRUE(storage.Delete("KEY1"));
+
+    std::string value;
+    EXPECT_FALSE(storage.Get("KEY1", value));
+    EXPECT_TRUE(storage.Put("KEY1", "val2"));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_TRUE(value == "val2");
+}
+
+TYPED_TEST(StorageTest, ValueOutlivesAssociation) {
+    TypeParam storage(storage_size);
+
+    Afina::Value value;
+    EXPECT_FALSE(storage.GetValue("KEY1", value));
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_TRUE(storage.GetValue("KEY1", value));
+
+    // Same size value could be written in place, but handle must keep the old one
+    EXPECT_TRUE(storage.Put("KEY1", "val2"));
+    EXPECT_EQ("val1", std::string(value.data(), value.size()));
+
+    Afina::Value second;
+    EXPECT_TRUE(storage.GetValue("KEY1", second));
+    EXPECT_TRUE(storage.Delete("KEY1"));
+    EXPECT_EQ("val1", std::string(value.data(), value.size()));
+    EXPECT_EQ("val2", std::string(second.data(), second.size()));
+
+    value = std::move(second);
+    EXPECT_EQ("val2", std::string(value.data(), value.size()));
+    EXPECT_EQ(0, second.size());
+
+    // Appended data could fit into spare capacity as well
+    EXPECT_TRUE(storage.Put("KEY2", "val"));
+    EXPECT_TRUE(storage.GetValue("KEY2", second));
+    EXPECT_TRUE(storage.Append("KEY2", "3"));
+    EXPECT_EQ("val", std::string(second.data(), second.size()));
+}
+
+TYPED_TEST(StorageTest, MultiGet) {
+    TypeParam storage(storage_size);
+
+    std::vector<std::string> keys;
+    for (int i = 0; i < 50; ++i) {
+        keys.push_back("KEY" + std::to_string(i));
+        if (i % 3 != 0) {
+            EXPECT_TRUE(storage.Put(keys.back(), "val" + std::to_string(i)));
+        }
+    }
+    keys.push_back("KEY1");
+
+    std::vector<Afina::Value> values;
+    EXPECT_EQ(34, storage.MultiGet(keys, values));
+    ASSERT_EQ(keys.size(), values.size());
+    for (int i = 0; i < 50; ++i) {
+        if (i % 3 == 0) {
+            EXPECT_FALSE(values[i]);
+        } else {
+            ASSERT_TRUE(bool(values[i]));
+            EXPECT_EQ("val" + std::to_string(i), std::string(values[i].data(), values[i].size()));
+        }
+    }
+    EXPECT_EQ("val1", std::string(values[50].data(), values[50].size()));
+}
+
+TYPED_TEST(StorageTest, CompareAndSwap) {
+    TypeParam storage(storage_size);
+    using CasResult = Afina::Storage::CasResult;
+
+    Afina::Value value;
+    uint64_t cas = 0;
+    EXPECT_FALSE(storage.GetCas("KEY1", value, cas));
+    EXPECT_EQ(CasResult::kNotFound, storage.CompareAndSwap("KEY1", "val1", cas, 0));
+
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    ASSERT_TRUE(storage.GetCas("KEY1", value, cas));
+    EXPECT_EQ("val1", std::string(value.data(), value.size()));
+    EXPECT_EQ(CasResult::kStored, storage.CompareAndSwap("KEY1", "val2", cas, 0));
+    EXPECT_EQ(CasResult::kExists, storage.CompareAndSwap("KEY1", "val3", cas, 0));
+
+    uint64_t updated = 0;
+    ASSERT_TRUE(storage.GetCas("KEY1", value, updated));
+    EXPECT_EQ("val2", std::string(value.data(), value.size()));
+    EXPECT_NE(cas, updated);
+
+    // Any change in between makes the version stale
+    EXPECT_TRUE(storage.Put("KEY1", "val3"));
+    EXPECT_EQ(CasResult::kExists, storage.CompareAndSwap("KEY1", "val4", updated, 0));
+    std::string current;
+    EXPECT_TRUE(storage.Get("KEY1", current));
+    EXPECT_EQ("val3", current);
+
+    // Version belongs to the change rather than to the value, so the same value written again is a change
+    ASSERT_TRUE(storage.GetCas("KEY1", value, cas));
+    EXPECT_TRUE(storage.Put("KEY1", "val3"));
+    EXPECT_EQ(CasResult::kExists, storage.CompareAndSwap("KEY1", "val4", cas, 0));
+}
+
+TYPED_TEST(StorageTest, Update) {
+    TypeParam storage(storage_size);
+    auto increment = [](const char *value, size_t size, uint64_t, std::string &new_value, uint32_t &) {
+        new_value = std::to_string(std::stoi(std::string(value, size)) + 1);
+        return true;
+    };
+
+    EXPECT_FALSE(storage.Update("KEY1", increment));
+    EXPECT_TRUE(storage.Put("KEY1", "41"));
+    EXPECT_TRUE(storage.Update("KEY1", increment));
+
+    std::string value;
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("42", value);
+
+    // Declined update leaves value as is
+    EXPECT_FALSE(storage.Update("KEY1", [](const char *, size_t, uint64_t, std::string &new_value, uint32_t &) {
+        new_value = "43";
+        return false;
+    }));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("42", value);
+
+    // Updater sees the version returned by GetCas
+    Afina::Value handle;
+    uint64_t cas = 0;
+    ASSERT_TRUE(storage.GetCas("KEY1", handle, cas));
+    uint64_t seen = 0;
+    EXPECT_TRUE(storage.Update("KEY1", [&seen](const char *, size_t, uint64_t current, std::string &new_value,
+                                               uint32_t &) {
+        seen = current;
+        new_value = "val";
+        return true;
+    }));
+    EXPECT_EQ(cas, seen);
+}
+
+TYPED_TEST(StorageTest, AppendPrepend) {
+    TypeParam storage(storage_size);
+
+    EXPECT_FALSE(storage.Append("KEY1", "val"));
+    EXPECT_FALSE(storage.Prepend("KEY1", "val"));
+
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_TRUE(storage.Append("KEY1", "_tail"));
+    EXPECT_TRUE(storage.Prepend("KEY1", "head_"));
+
+    std::string value;
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("head_val1_tail", value);
+
+    // Handle taken before the append keeps seeing the old value
+    Afina::Value handle;
+    EXPECT_TRUE(storage.GetValue("KEY1", handle));
+    std::string expected = value;
+    for (int i = 0; i < 200; ++i) {
+        std::string chunk = std::to_string(i);
+        EXPECT_TRUE(storage.Append("KEY1", chunk));
+        expected += chunk;
+    }
+    EXPECT_EQ("head_val1_tail", std::string(handle.data(), handle.size()));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ(expected, value);
+
+    // Value that doesn't fit into storage is not stored, the old one is kept
+    EXPECT_FALSE(storage.Append("KEY1", std::string(storage_size, 'x')));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ(expected, value);
+}
+
 std::string pad_space(const std::string &s, size_t length) {
     std::string result = s;
     result.resize(length, ' ');
@@ -138,7 +357,7 @@ std::string pad_space(const std::string &s, size_t length) {
 
 TEST(StorageTest, BigTest) {
     const size_t length = 20;
-    SimpleLRU storage(2 * 100000 * length);
+    SimpleLRU storage(room(100000, length, length));
 
     for (long i = 0; i < 100000; ++i) {
         auto key = pad_space("Key " + std::to_string(i), length);
@@ -159,17 +378,24 @@ TEST(StorageTest, BigTest) {
 
 TEST(StorageTest, MaxTest) {
     const size_t length = 20;
-    SimpleLRU storage(2 * 1000 * length);
+    const long n_keys = 1100;
+    SimpleLRU storage(budget(1000, length, length));
 
-    std::stringstream ss;
-
-    for (long i = 0; i < 1100; ++i) {
+    for (long i = 0; i < n_keys; ++i) {
         auto key = pad_space("Key " + std::to_string(i), length);
         auto val = pad_space("Val " + std::to_string(i), length);
         EXPECT_TRUE(storage.Put(key, val));
     }
 
-    for (long i = 100; i < 1100; ++i) {
+    // Some items could take more memory than expected, then a few more of the oldest ones are gone
+    std::vector<std::pair<std::string, std::string>> stats;
+    storage.Stats(stats);
+    std::map<std::string, std::string> named(stats.begin(), stats.end());
+    long items = std::stol(named["curr_items"]);
+    EXPECT_GE(1000, items);
+    EXPECT_LE(900, items);
+
+    for (long i = n_keys - items; i < n_keys; ++i) {
         auto key = pad_space("Key " + std::to_string(i), length);
         auto val = pad_space("Val " + std::to_string(i), length);
 
@@ -179,10 +405,907 @@ TEST(StorageTest, MaxTest) {
         EXPECT_TRUE(val == res);
     }
 
-    for (long i = 0; i < 100; ++i) {
+    for (long i = 0; i < n_keys - items; ++i) {
         auto key = pad_space("Key " + std::to_string(i), length);
 
         std::string res;
         EXPECT_FALSE(storage.Get(key, res));
     }
 }
+
+TEST(ShardedLRUTest, ConcurrentPutGet) {
+    const size_t length = 20;
+    const int n_threads = 4, n_keys = 10000;
+    ShardedLRU storage(4 * n_threads * n_keys * Item::Footprint(length, length), 16);
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < n_threads; t++) {
+        workers.emplace_back([&storage, t]() {
+            for (int i = 0; i < n_keys; ++i) {
+                auto key = pad_space("Key " + std::to_string(t) + " " + std::to_string(i), length);
+                auto val = pad_space("Val " + std::to_string(i), length);
+                EXPECT_TRUE(storage.Put(key, val));
+            }
+        });
+    }
+    for (auto &w : workers) {
+        w.join();
+    }
+
+    for (int t = 0; t < n_threads; t++) {
+        for (int i = 0; i < n_keys; ++i) {
+            auto key = pad_space("Key " + std::to_string(t) + " " + std::to_string(i), length);
+            auto val = pad_space("Val " + std::to_string(i), length);
+
+            std::string res;
+            EXPECT_TRUE(storage.Get(key, res));
+            EXPECT_TRUE(val == res);
+        }
+    }
+}
+
+TEST(ShardedLRUTest, RejectsTooManyShards) {
+    EXPECT_THROW(ShardedLRU(1024, 0), std::invalid_argument);
+    EXPECT_THROW(ShardedLRU(1024, 1024 / Item::Footprint(0, 0) + 1), std::invalid_argument);
+    EXPECT_NO_THROW(ShardedLRU(1024, 1024 / Item::Footprint(0, 0)));
+}
+
+TEST(ShardedLRUTest, Stats) {
+    const size_t length = 10;
+    ShardedLRU storage(4 * 100 * Item::Footprint(length, length), 4);
+    for (int i = 0; i < 20; ++i) {
+        EXPECT_TRUE(storage.Put(pad_space("Key " + std::to_string(i), length), std::string(length, 'v')));
+    }
+
+    std::vector<std::pair<std::string, std::string>> stats;
+    storage.Stats(stats);
+    std::map<std::string, std::string> named(stats.begin(), stats.end());
+    size_t bytes = std::stoul(named["bytes"]);
+    EXPECT_EQ("20", named["curr_items"]);
+    EXPECT_EQ(std::to_string(2 * length * 20), named["payload_bytes"]);
+    EXPECT_EQ(std::to_string((bytes - 2 * length * 20) / 20), named["overhead_per_item"]);
+    EXPECT_EQ(std::to_string(4 * 100 * Item::Footprint(length, length)), named["limit_maxbytes"]);
+    EXPECT_EQ("4", named["shards"]);
+}
+
+TEST(PartitionedLRUTest, ConcurrentPutGet) {
+    const size_t length = 20;
+    const int n_threads = 4, n_keys = 10000;
+    PartitionedLRU storage(4 * n_threads * n_keys * Item::Footprint(length, length), 4);
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < n_threads; t++) {
+        workers.emplace_back([&storage, t]() {
+            for (int i = 0; i < n_keys; ++i) {
+                auto key = pad_space("Key " + std::to_string(t) + " " + std::to_string(i), length);
+                auto val = pad_space("Val " + std::to_string(i), length);
+                EXPECT_TRUE(storage.Put(key, val));
+                if (i % 100 == 0) {
+                    std::string res;
+                    EXPECT_TRUE(storage.Get(key, res));
+                }
+            }
+        });
+    }
+    for (auto &w : workers) {
+        w.join();
+    }
+
+    std::vector<std::string> keys;
+    for (int t = 0; t < n_threads; t++) {
+        for (int i = 0; i < n_keys; ++i) {
+            keys.push_back(pad_space("Key " + std::to_string(t) + " " + std::to_string(i), length));
+        }
+    }
+    std::vector<Afina::Value> values;
+    EXPECT_EQ(keys.size(), storage.MultiGet(keys, values));
+    EXPECT_EQ(pad_space("Val 5", length), std::string(values[5].data(), values[5].size()));
+
+    std::vector<std::pair<std::string, std::string>> stats;
+    storage.Stats(stats);
+    std::map<std::string, std::string> named(stats.begin(), stats.end());
+    EXPECT_EQ(std::to_string(keys.size()), named["curr_items"]);
+    EXPECT_EQ("4", named["partitions"]);
+}
+
+TEST(CombiningLRUTest, ConcurrentPutGetDelete) {
+    const size_t length = 20;
+    const int n_threads = 8, n_keys = 5000;
+    CombiningLRU storage(2 * n_threads * n_keys * Item::Footprint(length, length));
+
+    // Every thread deletes every other key of its own, so the result doesn't depend on the interleaving
+    std::vector<std::thread> workers;
+    for (int t = 0; t < n_threads; t++) {
+        workers.emplace_back([&storage, t]() {
+            for (int i = 0; i < n_keys; ++i) {
+                auto key = pad_space("Key " + std::to_string(t) + " " + std::to_string(i), length);
+                auto val = pad_space("Val " + std::to_string(i), length);
+                EXPECT_TRUE(storage.Put(key, val));
+
+                std::string res;
+                EXPECT_TRUE(storage.Get(key, res));
+                EXPECT_EQ(val, res);
+                if (i % 2 == 1) {
+                    EXPECT_TRUE(storage.Delete(key));
+                }
+            }
+        });
+    }
+    for (auto &w : workers) {
+        w.join();
+    }
+
+    std::vector<std::pair<std::string, std::string>> stats;
+    storage.Stats(stats);
+    std::map<std::string, std::string> named(stats.begin(), stats.end());
+    EXPECT_EQ(std::to_string(n_threads * n_keys / 2), named["curr_items"]);
+    EXPECT_EQ(std::to_string(n_threads * n_keys * 5 / 2), named["combine_operations"]);
+}
+
+TEST(StorageTest, OverwriteGrowEvictsTail) {
+    SimpleLRU storage(budget(3, 4, 4));
+
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_TRUE(storage.Put("KEY2", "val2"));
+    EXPECT_TRUE(storage.Put("KEY3", "val3"));
+
+    // Same size value is written in place
+    EXPECT_TRUE(storage.Put("KEY1", "VAL1"));
+
+    // Bigger one needs more space, so the least recently used KEY2 has to go
+    const std::string longer(100, 'v');
+    EXPECT_TRUE(storage.Put("KEY1", longer));
+
+    std::string value;
+    EXPECT_FALSE(storage.Get("KEY2", value));
+    EXPECT_TRUE(storage.Get("KEY3", value));
+    EXPECT_TRUE(value == "val3");
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_TRUE(value == longer);
+}
+
+TEST(StorageTest, FootprintIsRealMemory) {
+    // Allocator takes one more word than it reports as usable, and could hand out a larger chunk than
+    // requested depending on what was freed before, so footprint is measured on the allocated item
+    for (size_t size : {0, 1, 7, 30, 100, 1000, 5000, 60000}) {
+        Item *item = Item::Create(std::string(size / 2, 'k'), std::string(size - size / 2, 'v'), 0);
+        EXPECT_EQ(malloc_usable_size(item) + sizeof(size_t) + kIndexBytesPerItem, item->Footprint());
+        EXPECT_LE(Item::Footprint(size / 2, size - size / 2), item->Footprint());
+        Item::Destroy(item);
+    }
+}
+
+TEST(StorageTest, SmallItemIsCompact) {
+    // Header takes 64 bytes, so item with 10 bytes of key and 10 bytes of value fits into 96 bytes chunk
+    EXPECT_GE(64, sizeof(Item));
+    EXPECT_GE(96 + kIndexBytesPerItem, Item::Footprint(10, 10));
+}
+
+TEST(StorageTest, MemoryStats) {
+    const size_t length = 10;
+    const size_t max_size = 10 * Item::Footprint(length, length);
+    SimpleLRU storage(max_size);
+    for (int i = 0; i < 20; ++i) {
+        EXPECT_TRUE(storage.Put(pad_space("Key " + std::to_string(i), length), std::string(length, 'v')));
+    }
+
+    std::vector<std::pair<std::string, std::string>> stats;
+    storage.Stats(stats);
+    std::map<std::string, std::string> named(stats.begin(), stats.end());
+    size_t items = std::stoul(named["curr_items"]);
+    size_t bytes = std::stoul(named["bytes"]);
+    EXPECT_LT(0, items);
+    EXPECT_GE(10, items);
+    EXPECT_GE(max_size, bytes);
+    EXPECT_LE(items * Item::Footprint(length, length), bytes);
+    EXPECT_EQ(std::to_string(2 * length * items), named["payload_bytes"]);
+    EXPECT_EQ(std::to_string((bytes - 2 * length * items) / items), named["overhead_per_item"]);
+
+    // Index share is an upper bound of the real index memory
+    EXPECT_GE(items * kIndexBytesPerItem, std::stoul(named["index_bytes"]));
+}
+
+TEST(ClockLRUTest, ReferencedSurvivesEviction) {
+    ClockLRU storage(budget(3, 4, 4));
+
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_TRUE(storage.Put("KEY2", "val2"));
+    EXPECT_TRUE(storage.Put("KEY3", "val3"));
+
+    // KEY1 is the oldest one, but it was accessed recently so KEY2 goes instead
+    std::string value;
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_TRUE(storage.Put("KEY4", "val4"));
+
+    EXPECT_FALSE(storage.Get("KEY2", value));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_TRUE(value == "val1");
+    EXPECT_TRUE(storage.Get("KEY3", value));
+    EXPECT_TRUE(storage.Get("KEY4", value));
+}
+
+TEST(ClockLRUTest, Stats) {
+    const size_t length = 10;
+    const size_t max_size = 10 * Item::Footprint(length, length);
+    ClockLRU storage(max_size);
+    for (int i = 0; i < 20; ++i) {
+        EXPECT_TRUE(storage.Put(pad_space("Key " + std::to_string(i), length), std::string(length, 'v')));
+    }
+    EXPECT_TRUE(storage.Append(pad_space("Key 19", length), "w"));
+
+    std::vector<std::pair<std::string, std::string>> stats;
+    storage.Stats(stats);
+    std::map<std::string, std::string> named(stats.begin(), stats.end());
+    size_t items = std::stoul(named["curr_items"]);
+    size_t bytes = std::stoul(named["bytes"]);
+    EXPECT_LT(0, items);
+    EXPECT_GE(10, items);
+    EXPECT_GE(max_size, bytes);
+    EXPECT_EQ(std::to_string(2 * length * items + 1), named["payload_bytes"]);
+    EXPECT_EQ(std::to_string((bytes - 2 * length * items - 1) / items), named["overhead_per_item"]);
+    EXPECT_EQ(std::to_string(20 - items), named["evictions"]);
+}
+
+TEST(ClockLRUTest, ConcurrentReadWrite) {
+    const size_t length = 20;
+    const int n_readers = 4, n_keys = 1000;
+    ClockLRU storage(n_keys / 2 * Item::Footprint(length, length));
+
+    std::atomic<bool> done(false);
+    std::vector<std::thread> readers;
+    for (int t = 0; t < n_readers; t++) {
+        readers.emplace_back([&storage, &done]() {
+            std::string res;
+            while (!done.load()) {
+                for (int i = 0; i < n_keys; ++i) {
+                    if (storage.Get(pad_space("Key " + std::to_string(i), length), res)) {
+                        EXPECT_EQ(pad_space("Val " + std::to_string(i), length), res);
+                    }
+                }
+            }
+        });
+    }
+
+    for (int round = 0; round < 10; round++) {
+        for (int i = 0; i < n_keys; ++i) {
+            auto key = pad_space("Key " + std::to_string(i), length);
+            auto val = pad_space("Val " + std::to_string(i), length);
+            EXPECT_TRUE(storage.Put(key, val));
+        }
+    }
+    done.store(true);
+    for (auto &r : readers) {
+        r.join();
+    }
+}
+
+TEST(CuckooStorageTest, EvictsWhenFull) {
+    const size_t length = 20;
+    CuckooStorage storage(100 * Item::Footprint(length, length));
+
+    std::string value;
+    for (int i = 0; i < 1000; ++i) {
+        auto key = pad_space("Key " + std::to_string(i), length);
+        EXPECT_TRUE(storage.Put(key, pad_space("Val " + std::to_string(i), length)));
+        EXPECT_TRUE(storage.Get(key, value));
+    }
+
+    std::vector<std::pair<std::string, std::string>> stats;
+    storage.Stats(stats);
+    std::map<std::string, std::string> named(stats.begin(), stats.end());
+    EXPECT_LE(std::stoul(named["bytes"]), std::stoul(named["limit_maxbytes"]));
+    EXPECT_LE(90, std::stoi(named["curr_items"]));
+}
+
+TEST(CuckooStorageTest, FailedWriteDoesntEvict) {
+    const size_t length = 20;
+    CuckooStorage storage(10 * Item::Footprint(length, length));
+
+    for (int i = 0; i < 20; ++i) {
+        auto key = pad_space("Key " + std::to_string(i), length);
+        EXPECT_TRUE(storage.Put(key, key));
+    }
+    auto stored = [&storage]() {
+        std::set<std::string> keys;
+        storage.ForEach([&keys](const char *key, size_t key_size, const char *, size_t, uint32_t) {
+            keys.emplace(key, key_size);
+        });
+        return keys;
+    };
+    std::set<std::string> full = stored();
+    ASSERT_FALSE(full.empty());
+
+    // Writes that don't store anything must leave the full storage as it is
+    auto key = *full.begin();
+    auto missing = pad_space("Missing", length);
+    EXPECT_FALSE(storage.PutIfAbsent(key, key));
+    EXPECT_FALSE(storage.Set(missing, key));
+    EXPECT_EQ(Afina::Storage::CasResult::kNotFound, storage.CompareAndSwap(missing, key, 1, 0));
+    EXPECT_EQ(Afina::Storage::CasResult::kExists, storage.CompareAndSwap(key, key, 0, 0));
+    EXPECT_EQ(full, stored());
+}
+
+TEST(CuckooStorageTest, GrowsIncrementally) {
+    const size_t length = 20;
+    CuckooStorage storage(1000 * Item::Footprint(length, length));
+
+    // Put items until the table starts growing, the old one is still there right after that
+    std::map<std::string, std::string> named;
+    int n_keys = 0;
+    while (named["table_old_buckets"] == "" || named["table_old_buckets"] == "0") {
+        auto key = pad_space("Key " + std::to_string(n_keys++), length);
+        EXPECT_TRUE(storage.Put(key, key));
+
+        std::vector<std::pair<std::string, std::string>> stats;
+        storage.Stats(stats);
+        named = std::map<std::string, std::string>(stats.begin(), stats.end());
+    }
+
+    // Every item is in one of the tables
+    int visited = 0;
+    EXPECT_TRUE(storage.ForEach([&visited](const char *, size_t, const char *, size_t, uint32_t) { visited++; }));
+    EXPECT_EQ(n_keys, visited);
+
+    std::string value;
+    for (int i = 0; i < n_keys; ++i) {
+        auto key = pad_space("Key " + std::to_string(i), length);
+        EXPECT_TRUE(storage.Get(key, value));
+        EXPECT_EQ(key, value);
+    }
+    EXPECT_TRUE(storage.Delete(pad_space("Key 0", length)));
+    EXPECT_FALSE(storage.Get(pad_space("Key 0", length), value));
+}
+
+TEST(CuckooStorageTest, ConcurrentReadWrite) {
+    const size_t length = 20;
+    const int n_readers = 4, n_writers = 2, n_keys = 5000;
+    CuckooStorage storage(4 * (n_writers + 1) * n_keys * Item::Footprint(length, length));
+
+    // Stable keys must be found all the time, while writers move them between buckets and grow table
+    for (int i = 0; i < n_keys; ++i) {
+        EXPECT_TRUE(storage.Put(pad_space("Stable " + std::to_string(i), length), pad_space("Val", length)));
+    }
+
+    std::atomic<bool> done(false);
+    std::vector<std::thread> readers;
+    for (int t = 0; t < n_readers; t++) {
+        readers.emplace_back([&storage, &done]() {
+            std::string res;
+            while (!done.load()) {
+                for (int i = 0; i < n_keys; i += 7) {
+                    EXPECT_TRUE(storage.Get(pad_space("Stable " + std::to_string(i), length), res));
+                    EXPECT_EQ(pad_space("Val", length), res);
+                }
+            }
+        });
+    }
+
+    std::vector<std::thread> writers;
+    for (int t = 0; t < n_writers; t++) {
+        writers.emplace_back([&storage, t]() {
+            for (int i = 0; i < n_keys; ++i) {
+                auto key = pad_space("Key " + std::to_string(t) + " " + std::to_string(i), length);
+                EXPECT_TRUE(storage.Put(key, pad_space("Val " + std::to_string(i), length)));
+                if (i % 2 == 1) {
+                    EXPECT_TRUE(storage.Delete(key));
+                }
+            }
+        });
+    }
+    for (auto &w : writers) {
+        w.join();
+    }
+    done.store(true);
+    for (auto &r : readers) {
+        r.join();
+    }
+
+    std::vector<std::pair<std::string, std::string>> stats;
+    storage.Stats(stats);
+    std::map<std::string, std::string> named(stats.begin(), stats.end());
+    EXPECT_EQ(std::to_string(n_keys + n_writers * n_keys / 2), named["curr_items"]);
+}
+
+TEST(ThreadSafeBufferedLRUTest, PromotionRateLimit) {
+    for (int delay : {0, 3600 * 1000}) {
+        ThreadSafeBufferedLRU storage(budget(3, 4, 4), std::chrono::milliseconds(delay));
+
+        EXPECT_TRUE(storage.Put("KEY1", "val1"));
+        EXPECT_TRUE(storage.Put("KEY2", "val2"));
+        EXPECT_TRUE(storage.Put("KEY3", "val3"));
+
+        // Hit is applied on the next write, so KEY2 becomes the oldest one
+        std::string value;
+        EXPECT_TRUE(storage.Get("KEY1", value));
+        EXPECT_TRUE(storage.Put("KEY4", "val4"));
+        EXPECT_FALSE(storage.Get("KEY2", value));
+
+        // KEY1 has been promoted just now, so with the long delay the second hit is ignored
+        EXPECT_TRUE(storage.Get("KEY3", value));
+        EXPECT_TRUE(storage.Get("KEY1", value));
+        EXPECT_TRUE(storage.Put("KEY5", "val5"));
+        EXPECT_EQ(delay == 0, storage.Get("KEY1", value));
+        EXPECT_EQ(delay != 0, storage.Get("KEY4", value));
+    }
+}
+
+TEST(ThreadSafeBufferedLRUTest, Stats) {
+    ThreadSafeBufferedLRU storage(budget(3, 4, 4));
+
+    std::string value;
+    std::vector<Afina::Value> values;
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_FALSE(storage.Get("KEY2", value));
+    EXPECT_EQ(1, storage.MultiGet({"KEY1", "KEY2", "KEY3"}, values));
+
+    std::vector<std::pair<std::string, std::string>> stats;
+    storage.Stats(stats);
+    std::map<std::string, std::string> named(stats.begin(), stats.end());
+    EXPECT_EQ("1", named["curr_items"]);
+    EXPECT_EQ("2", named["get_hits"]);
+    EXPECT_EQ("3", named["get_misses"]);
+}
+
+// Returns number of hot keys survived single pass over many new keys. Values are large enough for history
+// of evicted keys some policies keep to take a small share of memory
+template <typename T> static int hot_after_scan() {
+    const size_t length = 20, value_length = 200;
+    const int hot = 100;
+    T storage(2 * hot * Item::Footprint(length, value_length));
+
+    std::string res;
+    for (int round = 0; round < 5; round++) {
+        for (int i = 0; i < hot; ++i) {
+            auto key = pad_space("Hot " + std::to_string(i), length);
+            if (!storage.Get(key, res)) {
+                storage.Put(key, pad_space("Val " + std::to_string(i), value_length));
+            }
+        }
+    }
+
+    for (int i = 0; i < 10 * hot; ++i) {
+        storage.Put(pad_space("Scan " + std::to_string(i), length),
+                    pad_space("Val " + std::to_string(i), value_length));
+    }
+
+    int survived = 0;
+    for (int i = 0; i < hot; ++i) {
+        survived += storage.Get(pad_space("Hot " + std::to_string(i), length), res);
+    }
+    return survived;
+}
+
+TEST(WTinyLFUTest, ScanResistance) {
+    EXPECT_EQ(0, hot_after_scan<SimpleLRU>());
+    // Frequency is only estimated, so a few hot keys could lose to colliding scan keys
+    EXPECT_LE(95, hot_after_scan<WTinyLFU>());
+}
+
+TEST(WTinyLFUTest, Stats) {
+    WTinyLFU storage(budget(3, 4, 4));
+
+    std::string value;
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_TRUE(storage.Put("KEY2", "val2"));
+    EXPECT_TRUE(storage.Get("KEY2", value));
+    EXPECT_TRUE(storage.Put("KEY3", "val3"));
+    EXPECT_TRUE(storage.Get("KEY3", value));
+
+    // Never seen before key loses to frequently used ones
+    EXPECT_FALSE(storage.Put("KEY4", "val4"));
+    EXPECT_FALSE(storage.Get("KEY4", value));
+
+    std::vector<std::pair<std::string, std::string>> stats;
+    storage.Stats(stats);
+    std::map<std::string, std::string> named(stats.begin(), stats.end());
+    EXPECT_EQ("3", named["tinylfu_admitted"]);
+    EXPECT_EQ("1", named["tinylfu_rejected"]);
+}
+
+TEST(WTinyLFUTest, CandidateCompetesWithProtected) {
+    WTinyLFU storage(budget(10, 4, 4));
+
+    // Protected segment is full, probation is empty
+    std::string value;
+    for (int i = 0; i < 8; ++i) {
+        EXPECT_TRUE(storage.Put("KEY" + std::to_string(i), "val" + std::to_string(i)));
+        EXPECT_TRUE(storage.Get("KEY" + std::to_string(i), value));
+    }
+
+    // Large candidate is alone in probation, but it is used more often than the tail of protected
+    std::string big(2 * Item::Footprint(4, 4), 'x');
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_FALSE(storage.Get("BIG1", value));
+    }
+    EXPECT_TRUE(storage.Put("BIG1", big));
+    EXPECT_TRUE(storage.Get("BIG1", value));
+    EXPECT_FALSE(storage.Get("KEY0", value));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+}
+
+TEST(WTinyLFUTest, GrowingValueKeepsKey) {
+    WTinyLFU storage(budget(200, 4, 4));
+
+    // Storage is full of keys used more than once, some of them are rejected on the way
+    std::string value;
+    for (int i = 0; i < 300; ++i) {
+        auto key = "K" + std::to_string(i % 10) + std::to_string(i / 10 % 10) + std::to_string(i / 100);
+        storage.Put(key, "val0");
+        storage.Get(key, value);
+        storage.Get(key, value);
+    }
+
+    // Key used less often than any other one outgrows the window and becomes a candidate
+    EXPECT_TRUE(storage.Put("KNEW", "val0"));
+    std::string big(2 * Item::Footprint(4, 4), 'x');
+    EXPECT_TRUE(storage.Set("KNEW", big));
+    EXPECT_TRUE(storage.Get("KNEW", value));
+    EXPECT_EQ(big, value);
+}
+
+// Checks that keys present in the storage are always the most recently used ones, as LRU has to keep them
+// whatever the footprint of each item turns out to be
+template <typename T> static void expect_lru_order() {
+    const size_t length = 10;
+    T storage(20 * Item::Footprint(length, length));
+
+    // Keys from the most recently used one, with the last value put
+    std::list<std::pair<std::string, std::string>> recent;
+    auto touch = [&recent](const std::string &key, const std::string &value) {
+        recent.remove_if([&key](const std::pair<std::string, std::string> &entry) { return entry.first == key; });
+        recent.emplace_front(key, value);
+    };
+
+    srand(42);
+    std::string res;
+    for (int i = 0; i < 10000; ++i) {
+        auto key = pad_space("Key " + std::to_string(rand() % 50), length);
+        if (rand() % 2 == 0) {
+            auto value = pad_space("Val " + std::to_string(i), rand() % length + 1);
+            ASSERT_TRUE(storage.Put(key, value));
+            touch(key, value);
+        } else if (storage.Get(key, res)) {
+            touch(key, res);
+        }
+
+        // Get doesn't evict, so walk from the most recent key and check that the present ones go first
+        if (i % 100 == 0) {
+            size_t present = 0;
+            bool missed = false;
+            std::vector<std::pair<std::string, std::string>> order(recent.begin(), recent.end());
+            for (auto &entry : order) {
+                bool found = storage.Get(entry.first, res);
+                ASSERT_FALSE(found && missed) << entry.first;
+                if (found) {
+                    ASSERT_EQ(entry.second, res);
+                    present++;
+                }
+                missed = missed || !found;
+            }
+            for (size_t k = 0; k < present; k++) {
+                touch(order[k].first, order[k].second);
+            }
+            ASSERT_LE(std::min<size_t>(10, order.size()), present);
+        }
+    }
+}
+
+TEST(PolicyStorageTest, LRUPolicyMatchesSimpleLRU) {
+    expect_lru_order<SimpleLRU>();
+    expect_lru_order<PolicyStorage<LRUPolicy>>();
+}
+
+TEST(PolicyStorageTest, ScanResistance) {
+    EXPECT_EQ(0, hot_after_scan<PolicyStorage<LRUPolicy>>());
+    EXPECT_EQ(100, hot_after_scan<PolicyStorage<SLRUPolicy>>());
+    EXPECT_EQ(100, hot_after_scan<PolicyStorage<ARCPolicy>>());
+}
+
+TEST(PolicyStorageTest, TwoQGhostHitPromotes) {
+    // Values are large enough for A1out to take a small share of memory
+    const size_t length = 10;
+    const std::string value(1000, 'v');
+    PolicyStorage<TwoQPolicy> storage(budget(8, length, value.size()));
+
+    auto hot = pad_space("Hot", length);
+    EXPECT_TRUE(storage.Put(hot, value));
+    for (int i = 0; i < 8; ++i) {
+        auto key = pad_space("Key " + std::to_string(i), length);
+        EXPECT_TRUE(storage.Put(key, value));
+    }
+
+    // Hot key has just been pushed out of A1in, coming back it gets into the main queue
+    std::string res;
+    EXPECT_FALSE(storage.Get(hot, res));
+    EXPECT_TRUE(storage.Put(hot, value));
+
+    for (int i = 0; i < 100; ++i) {
+        auto key = pad_space("Scan " + std::to_string(i), length);
+        EXPECT_TRUE(storage.Put(key, value));
+    }
+    EXPECT_TRUE(storage.Get(hot, res));
+    EXPECT_EQ(value, res);
+}
+
+TEST(PolicyStorageTest, GrowingItemIsKept) {
+    PolicyStorage<TwoQPolicy> storage(budget(2, 4, 4));
+
+    // Accesses in A1in are ignored, so KEY1 stays the oldest one while it grows
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_TRUE(storage.Put("KEY2", "val2"));
+    const std::string longer(100, 'v');
+    EXPECT_TRUE(storage.Put("KEY1", longer));
+
+    std::string value;
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ(longer, value);
+    EXPECT_FALSE(storage.Get("KEY2", value));
+}
+
+TEST(PolicyStorageTest, Stats) {
+    // History of evicted keys takes memory too, values are large enough for it to fit into the spare room
+    const std::string val(1000, 'v');
+    PolicyStorage<ARCPolicy> storage(budget(2, 4, val.size()));
+
+    std::string value;
+    EXPECT_TRUE(storage.Put("KEY1", val));
+    EXPECT_TRUE(storage.Put("KEY2", val));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_TRUE(storage.Put("KEY3", val));
+    EXPECT_FALSE(storage.Get("KEY2", value));
+
+    std::vector<std::pair<std::string, std::string>> stats;
+    storage.Stats(stats);
+    std::map<std::string, std::string> named(stats.begin(), stats.end());
+    EXPECT_EQ("1", named["get_hits"]);
+    EXPECT_EQ("1", named["get_misses"]);
+    EXPECT_EQ("1", named["evictions"]);
+}
+
+// Storages supporting expiration time
+template <typename T> class ExpireTest : public ::testing::Test {};
+
+typedef ::testing::Types<SimpleLRU, ThreadSafeSimplLRU, ShardedLRU, ThreadSafeBufferedLRU, ClockLRU, WTinyLFU,
+                         ThreadSafe<WTinyLFU>, PolicyStorage<SLRUPolicy>, PolicyStorage<TwoQPolicy>,
+                         PolicyStorage<ARCPolicy>, SlabLRU, ThreadSafe<SlabLRU>, ArenaLRU, ThreadSafe<ArenaLRU>,
+                         PartitionedLRU, CombiningLRU, CuckooStorage>
+    ExpireTypes;
+TYPED_TEST_CASE(ExpireTest, ExpireTypes);
+
+TYPED_TEST(ExpireTest, ExpiredIsInvisible) {
+    TypeParam storage(storage_size);
+    uint32_t past = TimingWheel::Now() - 1;
+    uint32_t future = TimingWheel::Now() + 3600;
+
+    std::string value;
+    EXPECT_TRUE(storage.PutExpiring("KEY1", "val1", past));
+    EXPECT_FALSE(storage.Get("KEY1", value));
+    EXPECT_FALSE(storage.SetExpiring("KEY1", "val2", future));
+    EXPECT_FALSE(storage.Touch("KEY1", future));
+
+    EXPECT_TRUE(storage.PutIfAbsentExpiring("KEY1", "val3", future));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("val3", value);
+
+    // Plain put makes item immortal again
+    EXPECT_TRUE(storage.PutExpiring("KEY2", "val1", past));
+    EXPECT_TRUE(storage.Put("KEY2", "val2"));
+    EXPECT_TRUE(storage.Get("KEY2", value));
+    EXPECT_EQ("val2", value);
+}
+
+TYPED_TEST(ExpireTest, Touch) {
+    TypeParam storage(storage_size);
+    uint32_t past = TimingWheel::Now() - 1;
+    uint32_t future = TimingWheel::Now() + 3600;
+
+    std::string value;
+    EXPECT_TRUE(storage.PutExpiring("KEY1", "val1", future));
+    EXPECT_TRUE(storage.Touch("KEY1", 0));
+    EXPECT_TRUE(storage.GetAndTouch("KEY1", value, future));
+    EXPECT_EQ("val1", value);
+    EXPECT_TRUE(storage.Touch("KEY1", past));
+    EXPECT_FALSE(storage.GetAndTouch("KEY1", value, future));
+    EXPECT_FALSE(storage.Touch("KEY2", future));
+}
+
+TEST(ExpireTest, ReclaimKeepsLiveItems) {
+    const size_t length = 20;
+    SimpleLRU storage(budget(10, length, length));
+    uint32_t past = TimingWheel::Now() - 1;
+
+    std::string value;
+    for (int i = 0; i < 5; ++i) {
+        auto key = pad_space("Live " + std::to_string(i), length);
+        EXPECT_TRUE(storage.Put(key, key));
+    }
+    for (int i = 0; i < 100; ++i) {
+        auto key = pad_space("Expired " + std::to_string(i), length);
+        EXPECT_TRUE(storage.PutExpiring(key, key, past));
+    }
+    // Every write reclaims items expired before it, so only the last one is left
+    EXPECT_EQ(1, storage.Reclaim(100));
+    EXPECT_EQ(0, storage.Reclaim(100));
+
+    // No memory is wasted on expired items, so new ones evict nothing alive
+    for (int i = 0; i < 5; ++i) {
+        auto key = pad_space("New " + std::to_string(i), length);
+        EXPECT_TRUE(storage.Put(key, key));
+    }
+    for (int i = 0; i < 5; ++i) {
+        auto key = pad_space("Live " + std::to_string(i), length);
+        EXPECT_TRUE(storage.Get(key, value));
+    }
+}
+
+TEST(SlabLRUTest, PagesFollowSizeMix) {
+    SlabLRU storage(64 * 1024, 4096);
+    std::string value;
+
+    // Small items take all the pages first
+    for (int i = 0; i < 1000; ++i) {
+        auto key = pad_space("Small " + std::to_string(i), 20);
+        EXPECT_TRUE(storage.Put(key, key));
+    }
+
+    const int big = 200;
+    for (int i = 0; i < big; ++i) {
+        auto key = pad_space("Big " + std::to_string(i), 20);
+        EXPECT_TRUE(storage.Put(key, pad_space(key, 1000)));
+    }
+
+    // Most of memory has moved to the big items class
+    for (int i = big - 30; i < big; ++i) {
+        auto key = pad_space("Big " + std::to_string(i), 20);
+        EXPECT_TRUE(storage.Get(key, value));
+        EXPECT_EQ(pad_space(key, 1000), value);
+    }
+
+    std::vector<std::pair<std::string, std::string>> stats;
+    storage.Stats(stats);
+    std::map<std::string, std::string> named(stats.begin(), stats.end());
+    EXPECT_EQ("16", named["slab_pages"]);
+    EXPECT_EQ("0", named["slab_free_pages"]);
+    EXPECT_LE(10, std::stoi(named["slab_page_moves"]));
+}
+
+TEST(SlabLRUTest, ItemChangesClass) {
+    SlabLRU storage(64 * 1024, 4096);
+    std::string value;
+
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_TRUE(storage.Set("KEY1", std::string(2000, 'x')));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ(std::string(2000, 'x'), value);
+    EXPECT_TRUE(storage.Put("KEY1", "val2"));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("val2", value);
+
+    // Doesn't fit into a page
+    EXPECT_FALSE(storage.Put("KEY2", std::string(4096, 'x')));
+    EXPECT_FALSE(storage.Get("KEY2", value));
+    EXPECT_FALSE(storage.Put("KEY1", std::string(4096, 'x')));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("val2", value);
+}
+
+TEST(SlabLRUTest, ItemMovesWithItsPage) {
+    SlabLRU storage(64 * 1024, 4096);
+    std::string value;
+
+    // Item is the coldest one of the only class having pages, so its page goes to the new class
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_TRUE(storage.Put(pad_space("Small " + std::to_string(i), 20), "val"));
+    }
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    for (int i = 0; i < 1000; ++i) {
+        storage.Get(pad_space("Small " + std::to_string(i), 20), value);
+    }
+    EXPECT_TRUE(storage.Set("KEY1", std::string(1000, 'y')));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ(std::string(1000, 'y'), value);
+}
+
+TEST(SlabLRUTest, IndexTakesPages) {
+    SlabLRU storage(64 * 1024, 4096);
+
+    for (int i = 0; i < 2000; ++i) {
+        EXPECT_TRUE(storage.Put(pad_space("Small " + std::to_string(i), 20), "val"));
+    }
+
+    std::vector<std::pair<std::string, std::string>> stats;
+    storage.Stats(stats);
+    std::map<std::string, std::string> named(stats.begin(), stats.end());
+    size_t index_pages = std::stoul(named["slab_index_pages"]);
+    EXPECT_LT(0, index_pages);
+    EXPECT_LE(std::stoul(named["index_bytes"]), index_pages * 4096);
+
+    // Retired pages hold no items, the rest of them are full of small ones
+    size_t items = 0;
+    std::string value;
+    for (int i = 0; i < 2000; ++i) {
+        items += storage.Get(pad_space("Small " + std::to_string(i), 20), value);
+    }
+    EXPECT_GE((16 - index_pages) * 4096 / (sizeof(Item) + 23), items);
+}
+
+TEST(StorageTest, ValueSharesItemMemory) {
+    SimpleLRU storage(4096);
+
+    EXPECT_TRUE(storage.Put("KEY1", std::string(1000, 'x')));
+    Afina::Value first, second;
+    EXPECT_TRUE(storage.GetValue("KEY1", first));
+    EXPECT_TRUE(storage.GetValue("KEY1", second));
+    EXPECT_EQ(first.data(), second.data());
+
+    // Evicted item stays alive while handles exist
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_TRUE(storage.Put("Key " + std::to_string(i), std::string(1000, 'y')));
+    }
+    std::string value;
+    EXPECT_FALSE(storage.Get("KEY1", value));
+    EXPECT_EQ(std::string(1000, 'x'), std::string(first.data(), first.size()));
+    first.Reset();
+    EXPECT_EQ(std::string(1000, 'x'), std::string(second.data(), second.size()));
+}
+
+TEST(ArenaLRUTest, ChurningSizesKeepItems) {
+    ArenaLRU storage(64 * 1024);
+    std::string value;
+
+    // Live data takes about two thirds of the arena, but value sizes keep changing
+    const int keys = 40;
+    std::vector<std::string> expected(keys);
+    std::srand(7);
+    for (int i = 0; i < 20000; ++i) {
+        int k = std::rand() % keys;
+        expected[k] = std::string(100 + std::rand() % 900, 'a' + i % 26);
+        EXPECT_TRUE(storage.Put("Key " + std::to_string(k), expected[k]));
+    }
+
+    for (int k = 0; k < keys; ++k) {
+        EXPECT_TRUE(storage.Get("Key " + std::to_string(k), value));
+        EXPECT_EQ(expected[k], value);
+    }
+
+    std::vector<std::pair<std::string, std::string>> stats;
+    storage.Stats(stats);
+    std::map<std::string, std::string> named(stats.begin(), stats.end());
+    EXPECT_EQ("0", named["evictions"]);
+}
+
+TEST(ArenaLRUTest, EvictsWhenFull) {
+    ArenaLRU storage(4096);
+    std::string value;
+
+    for (int i = 0; i < 20; ++i) {
+        EXPECT_TRUE(storage.Put("Key " + std::to_string(i), std::string(500, 'x')));
+    }
+    EXPECT_FALSE(storage.Get("Key 0", value));
+    EXPECT_TRUE(storage.Get("Key 19", value));
+    EXPECT_EQ(std::string(500, 'x'), value);
+
+    EXPECT_FALSE(storage.Put("Big", std::string(5000, 'x')));
+    EXPECT_TRUE(storage.Get("Key 19", value));
+}
+
+TEST(ArenaLRUTest, IndexIsCharged) {
+    const size_t max_size = 16 * 1024;
+    ArenaLRU storage(max_size);
+
+    for (int i = 0; i < 2000; ++i) {
+        EXPECT_TRUE(storage.Put("Key " + std::to_string(i), "val"));
+    }
+
+    std::vector<std::pair<std::string, std::string>> stats;
+    storage.Stats(stats);
+    std::map<std::string, std::string> named(stats.begin(), stats.end());
+    size_t items = std::stoul(named["curr_items"]);
+    size_t index_bytes = std::stoul(named["index_bytes"]);
+    EXPECT_LT(0, items);
+    EXPECT_LT(0, index_bytes);
+    EXPECT_GE(max_size, std::stoul(named["bytes"]));
+    EXPECT_GE(max_size, index_bytes + items * (sizeof(void *) * 2 + 8));
+}
@@ -0,0 +1,123 @@
+#include "gtest/gtest.h"
+#include <map>
+#include <string>
+#include <vector>
+
+#include "storage/Item.h"
+#include "storage/TimingWheel.h"
+
+using namespace Afina::Backend;
+
+static Item *make_item(uint32_t exptime) {
+    std::string key = "key" + std::to_string(exptime);
+    Item *item = Item::Create(key, "value", 0);
+    item->exptime = exptime;
+    return item;
+}
+
+TEST(TimingWheelTest, ExpiresOnTime) {
+    const uint32_t start = 1000;
+    TimingWheel wheel(start);
+
+    // Offsets hit every level, their boundaries and the overflow list
+    std::vector<uint32_t> offsets = {0, 1, 5, 63, 64, 65, 100, 4095, 4096, 5000, 262143, 262144, 300000, 20000000};
+    std::vector<Item *> items;
+    for (uint32_t offset : offsets) {
+        items.push_back(make_item(start + offset));
+        wheel.Schedule(items.back());
+    }
+    // Expired before the wheel was started
+    items.push_back(make_item(start - 10));
+    wheel.Schedule(items.back());
+
+    std::map<Item *, uint32_t> expired_at;
+    for (uint32_t now = start; now <= start + offsets.back(); now++) {
+        while (Item *item = wheel.Expired(now)) {
+            EXPECT_EQ(0, expired_at.count(item));
+            expired_at[item] = now;
+        }
+    }
+
+    ASSERT_EQ(items.size(), expired_at.size());
+    for (Item *item : items) {
+        EXPECT_EQ(std::max(item->exptime, start), expired_at[item]);
+        Item::Destroy(item);
+    }
+}
+
+TEST(TimingWheelTest, Cancel) {
+    TimingWheel wheel(1000);
+
+    Item *kept = make_item(1100);
+    Item *cancelled = make_item(1100);
+    Item *far = make_item(1000000);
+    wheel.Schedule(kept);
+    wheel.Schedule(cancelled);
+    wheel.Schedule(far);
+    wheel.Cancel(cancelled);
+    wheel.Cancel(far);
+    wheel.Cancel(far);
+
+    EXPECT_EQ(nullptr, wheel.Expired(1099));
+    EXPECT_EQ(kept, wheel.Expired(2000000));
+    EXPECT_EQ(nullptr, wheel.Expired(2000000));
+
+    for (Item *item : {kept, cancelled, far}) {
+        Item::Destroy(item);
+    }
+}
+
+TEST(TimingWheelTest, CancelFromSlot) {
+    TimingWheel wheel(1000);
+
+    // Two slots on different levels
+    std::vector<Item *> items;
+    for (uint32_t i = 0; i < 10; i++) {
+        items.push_back(make_item(1001 + i % 2 * 100));
+        wheel.Schedule(items.back());
+    }
+
+    // Items from the middle, the end and the beginning of the same slot
+    wheel.Cancel(items[4]);
+    wheel.Cancel(items[8]);
+    wheel.Cancel(items[0]);
+    EXPECT_EQ(nullptr, wheel.Expired(1000));
+
+    std::map<Item *, int> seen;
+    while (Item *item = wheel.Expired(1200)) {
+        seen[item]++;
+    }
+    EXPECT_EQ(7, seen.size());
+
+    for (uint32_t i = 0; i < items.size(); i++) {
+        EXPECT_EQ(i % 4 == 0 ? 0 : 1, seen[items[i]]);
+        Item::Destroy(items[i]);
+    }
+}
+
+TEST(TimingWheelTest, BoundedSlices) {
+    TimingWheel wheel(1000);
+
+    std::vector<Item *> items;
+    for (uint32_t i = 0; i < 100; i++) {
+        items.push_back(make_item(1000 + i * 97));
+        wheel.Schedule(items.back());
+    }
+
+    // Jump far ahead and take items few at a time, every one of them comes out exactly once
+    std::map<Item *, int> seen;
+    for (int slice = 0; slice < 50; slice++) {
+        for (int i = 0; i < 3; i++) {
+            if (Item *item = wheel.Expired(100000)) {
+                seen[item]++;
+            }
+        }
+    }
+    EXPECT_EQ(items.size(), seen.size());
+    EXPECT_EQ(nullptr, wheel.Expired(100000));
+
+    for (Item *item : items) {
+        EXPECT_EQ(1, seen[item]);
+        Item::Destroy(item);
+    }
+}